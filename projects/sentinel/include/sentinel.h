@@ -1,14 +1,61 @@
 #pragma once
 
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
 #include <sys/types.h>
 
+/* Spawn latency histogram: bucket upper bounds in microseconds, plus a last +Inf bucket */
+#define SENTINEL_SPAWN_BUCKETS 8
+#define SENTINEL_SPAWN_BUCKET_US { 100, 250, 500, 1000, 2500, 10000, 50000 }
+
+/**
+ * sentinel_stats_t - Supervisor counters, updated with atomics only
+ * @children: Children currently running
+ * @spawns: Children started since init
+ * @spawn_failures: Spawn attempts that failed
+ * @exits: Children that exited or were killed
+ * @restarts: Spawns that replaced an exited child
+ * @spawn_count: Spawn latency observations
+ * @spawn_sum_ns: Sum of spawn latencies in nanoseconds
+ * @spawn_buckets: Observations per bucket (not cumulative)
+ */
+typedef struct
+{
+    atomic_uint_fast64_t children;
+    atomic_uint_fast64_t spawns;
+    atomic_uint_fast64_t spawn_failures;
+    atomic_uint_fast64_t exits;
+    atomic_uint_fast64_t restarts;
+    atomic_uint_fast64_t spawn_count;
+    atomic_uint_fast64_t spawn_sum_ns;
+    atomic_uint_fast64_t spawn_buckets[SENTINEL_SPAWN_BUCKETS];
+} sentinel_stats_t;
+
+/**
+ * sentinel_stats_snapshot_t - Plain copy of sentinel_stats_t for rendering
+ */
+typedef struct
+{
+    uint64_t children;
+    uint64_t spawns;
+    uint64_t spawn_failures;
+    uint64_t exits;
+    uint64_t restarts;
+    uint64_t spawn_count;
+    uint64_t spawn_sum_ns;
+    uint64_t spawn_buckets[SENTINEL_SPAWN_BUCKETS];
+} sentinel_stats_snapshot_t;
+
 /**
  * supervisor_t - Structure to manage process supervision and lifecycle
  * @is_shutting_down: Flag indicating whether the supervisor is in shutdown state (1) or running (0)
+ * @stats: Counters exported by supervisor_render_metrics()
  */
 typedef struct
 {
     int is_shutting_down;
+    sentinel_stats_t stats;
 } supervisor_t;
 
 /**
@@ -23,4 +70,34 @@ void supervisor_init(supervisor_t* supervisor);
  */
 void supervisor_shutdown(supervisor_t* supervisor);
 
+/**
+ * supervisor_record_spawn - Account for one spawn attempt
+ * @supervisor: Pointer to supervisor_t structure
+ * @latency_ns: Time from fork to the child running, in nanoseconds
+ * @ok: Non-zero if the child started
+ * @restart: Non-zero if the child replaces one that exited
+ */
+void supervisor_record_spawn(supervisor_t* supervisor, uint64_t latency_ns, int ok, int restart);
+
+/**
+ * supervisor_record_exit - Account for one child that exited or was killed
+ * @supervisor: Pointer to supervisor_t structure
+ */
+void supervisor_record_exit(supervisor_t* supervisor);
 
+/**
+ * supervisor_stats_snapshot - Copy the counters without stopping the supervisor
+ * @supervisor: Pointer to supervisor_t structure
+ * @out: Snapshot to fill
+ */
+void supervisor_stats_snapshot(const supervisor_t* supervisor, sentinel_stats_snapshot_t* out);
+
+/**
+ * supervisor_render_metrics - Format a snapshot as Prometheus text (version 0.0.4)
+ * @snap: Snapshot from supervisor_stats_snapshot()
+ * @buf: Output buffer
+ * @size: Size of buf in bytes
+ *
+ * Returns the length of the text, or -1 if it does not fit in buf.
+ */
+int supervisor_render_metrics(const sentinel_stats_snapshot_t* snap, char* buf, size_t size);
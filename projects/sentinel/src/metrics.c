@@ -0,0 +1,157 @@
+/**
+ * metrics.c - Supervisor counters and their Prometheus text form
+ *
+ * The spawn and reap paths bump atomic counters; a reader copies them into
+ * a snapshot and formats the copy, so rendering never blocks supervision.
+ * The text can be served by the smartlog metrics exporter as a source.
+ */
+
+#include "sentinel.h"
+#include <stdarg.h>
+#include <stdio.h>
+
+static const uint64_t spawn_bucket_us[SENTINEL_SPAWN_BUCKETS - 1] = SENTINEL_SPAWN_BUCKET_US;
+
+/**
+ * supervisor_record_spawn - Account for one spawn attempt
+ * @supervisor: Pointer to supervisor_t structure
+ * @latency_ns: Time from fork to the child running, in nanoseconds
+ * @ok: Non-zero if the child started
+ * @restart: Non-zero if the child replaces one that exited
+ */
+void supervisor_record_spawn(supervisor_t* supervisor, uint64_t latency_ns, int ok, int restart)
+{
+    sentinel_stats_t* st = &supervisor->stats;
+
+    if(!ok)
+    {
+        atomic_fetch_add_explicit(&st->spawn_failures, 1, memory_order_relaxed);
+        return;
+    }
+
+    // Pick the first bucket whose bound holds the latency; the last one is +Inf
+    size_t b = 0;
+    while(b < SENTINEL_SPAWN_BUCKETS - 1 && latency_ns > spawn_bucket_us[b] * 1000)
+    {
+        b++;
+    }
+
+    atomic_fetch_add_explicit(&st->spawn_buckets[b], 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&st->spawn_sum_ns, latency_ns, memory_order_relaxed);
+    atomic_fetch_add_explicit(&st->spawn_count, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&st->spawns, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&st->children, 1, memory_order_relaxed);
+    if(restart)
+    {
+        atomic_fetch_add_explicit(&st->restarts, 1, memory_order_relaxed);
+    }
+}
+
+/**
+ * supervisor_record_exit - Account for one child that exited or was killed
+ * @supervisor: Pointer to supervisor_t structure
+ */
+void supervisor_record_exit(supervisor_t* supervisor)
+{
+    atomic_fetch_add_explicit(&supervisor->stats.exits, 1, memory_order_relaxed);
+    atomic_fetch_sub_explicit(&supervisor->stats.children, 1, memory_order_relaxed);
+}
+
+/**
+ * supervisor_stats_snapshot - Copy the counters without stopping the supervisor
+ * @supervisor: Pointer to supervisor_t structure
+ * @out: Snapshot to fill
+ */
+void supervisor_stats_snapshot(const supervisor_t* supervisor, sentinel_stats_snapshot_t* out)
+{
+    const sentinel_stats_t* st = &supervisor->stats;
+
+    out->children = atomic_load_explicit(&st->children, memory_order_relaxed);
+    out->spawns = atomic_load_explicit(&st->spawns, memory_order_relaxed);
+    out->spawn_failures = atomic_load_explicit(&st->spawn_failures, memory_order_relaxed);
+    out->exits = atomic_load_explicit(&st->exits, memory_order_relaxed);
+    out->restarts = atomic_load_explicit(&st->restarts, memory_order_relaxed);
+    out->spawn_count = atomic_load_explicit(&st->spawn_count, memory_order_relaxed);
+    out->spawn_sum_ns = atomic_load_explicit(&st->spawn_sum_ns, memory_order_relaxed);
+    for(size_t b = 0; b < SENTINEL_SPAWN_BUCKETS; b++)
+    {
+        out->spawn_buckets[b] = atomic_load_explicit(&st->spawn_buckets[b], memory_order_relaxed);
+    }
+}
+
+// Append to buf at *len; returns -1 once the text no longer fits
+static int append(char* buf, size_t size, size_t* len, const char* fmt, ...)
+{
+    if(*len >= size)
+    {
+        return -1;
+    }
+
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(buf + *len, size - *len, fmt, ap);
+    va_end(ap);
+
+    if(n < 0 || (size_t)n >= size - *len)
+    {
+        *len = size;
+        return -1;
+    }
+    *len += (size_t)n;
+    return 0;
+}
+
+/**
+ * supervisor_render_metrics - Format a snapshot as Prometheus text (version 0.0.4)
+ * @snap: Snapshot from supervisor_stats_snapshot()
+ * @buf: Output buffer
+ * @size: Size of buf in bytes
+ *
+ * Returns the length of the text, or -1 if it does not fit in buf.
+ */
+int supervisor_render_metrics(const sentinel_stats_snapshot_t* snap, char* buf, size_t size)
+{
+    size_t len = 0;
+
+    append(buf, size, &len,
+           "# HELP sentinel_children Children currently running.\n"
+           "# TYPE sentinel_children gauge\n"
+           "sentinel_children %llu\n"
+           "# HELP sentinel_spawns_total Children started.\n"
+           "# TYPE sentinel_spawns_total counter\n"
+           "sentinel_spawns_total %llu\n"
+           "# HELP sentinel_spawn_failures_total Spawn attempts that failed.\n"
+           "# TYPE sentinel_spawn_failures_total counter\n"
+           "sentinel_spawn_failures_total %llu\n"
+           "# HELP sentinel_exits_total Children that exited or were killed.\n"
+           "# TYPE sentinel_exits_total counter\n"
+           "sentinel_exits_total %llu\n"
+           "# HELP sentinel_restarts_total Spawns that replaced an exited child.\n"
+           "# TYPE sentinel_restarts_total counter\n"
+           "sentinel_restarts_total %llu\n"
+           "# HELP sentinel_spawn_seconds Time from fork to the child running.\n"
+           "# TYPE sentinel_spawn_seconds histogram\n",
+           (unsigned long long)snap->children, (unsigned long long)snap->spawns,
+           (unsigned long long)snap->spawn_failures, (unsigned long long)snap->exits,
+           (unsigned long long)snap->restarts);
+
+    // Buckets are stored per range; Prometheus wants them cumulative
+    uint64_t cumulative = 0;
+    for(size_t b = 0; b < SENTINEL_SPAWN_BUCKETS - 1; b++)
+    {
+        cumulative += snap->spawn_buckets[b];
+        append(buf, size, &len, "sentinel_spawn_seconds_bucket{le=\"%g\"} %llu\n",
+               (double)spawn_bucket_us[b] / 1e6, (unsigned long long)cumulative);
+    }
+    cumulative += snap->spawn_buckets[SENTINEL_SPAWN_BUCKETS - 1];
+
+    // Loads are independent: keep +Inf and count at least the bucket sum
+    uint64_t count = snap->spawn_count > cumulative ? snap->spawn_count : cumulative;
+    append(buf, size, &len,
+           "sentinel_spawn_seconds_bucket{le=\"+Inf\"} %llu\n"
+           "sentinel_spawn_seconds_sum %.9f\n"
+           "sentinel_spawn_seconds_count %llu\n",
+           (unsigned long long)count, (double)snap->spawn_sum_ns / 1e9, (unsigned long long)count);
+
+    return len >= size ? -1 : (int)len;
+}
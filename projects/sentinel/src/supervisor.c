@@ -7,6 +7,7 @@
 
 #include "sentinel.h"
 #include <stdio.h>
+#include <string.h>
 
 
 
@@ -15,10 +16,11 @@
  * supervisor_init - Initialize the supervisor to a running state
  * @supervisor: Pointer to supervisor_t structure to initialize
  *
- * Sets the supervisor's shutdown flag to 0 
+ * Sets the supervisor's shutdown flag to 0 and clears its counters
  */
 void supervisor_init(supervisor_t* supervisor)
 {
+    memset(supervisor, 0, sizeof(*supervisor));
     supervisor->is_shutting_down = 0;
     fprintf(stderr, "[supervisor] init\n");
 }
@@ -0,0 +1,822 @@
+/*
+ * bench/bench_smartlog.c
+ *
+ * SmartLog microbenchmarks.
+ *
+ * Command-line usage:
+ *   smartlog_bench mpsc [total_items]
+ *   smartlog_bench wait
+ *   smartlog_bench pages [megabytes]
+ *   smartlog_bench clock
+ *   smartlog_bench lz4 [dir]
+ *   smartlog_bench circ [dir]
+ *   smartlog_bench context
+ *
+ * Modes:
+ *   mpsc: Lock-free MPSC queue vs a mutex + condvar queue of the same
+ *         capacity, with 1..64 producer threads and one consumer that
+ *         drains in batches. Prints items/s and consumer wakeups.
+ *   wait: Async sink writer spin time vs delivery latency and process CPU,
+ *         for a paced (mostly idle) and a back-to-back (hot) producer.
+ *   pages: Regular vs huge-page backed buffers of the given size: first
+ *          touch cost, random access cost (TLB bound) and a burst that
+ *          fills then drains an MPSC queue of that size.
+ *   clock: Cost per timestamp for CLOCK_REALTIME, the anchored
+ *          CLOCK_MONOTONIC_RAW clock and the anchored TSC clock, and the
+ *          largest gap between an anchored reading and CLOCK_REALTIME.
+ *   lz4: The same log lines through an async plain file sink and an async
+ *        LZ4 file sink in dir (default "."): lines/s, bytes on disk,
+ *        compression ratio and process CPU.
+ *   circ: The same log lines through a file sink rotating at a fixed size
+ *         and a circular file sink of that size in dir (default "."),
+ *         plain and durable: lines/s and bytes on disk.
+ *   context: Cost per formatted line when a request ID and tenant are
+ *            formatted into every message vs pushed once as thread
+ *            context (context.h) and copied into each header.
+ *
+ * Author: Aravinthraj Ganesan
+ * Version: 1.0
+ */
+
+#define _GNU_SOURCE
+#define _POSIX_C_SOURCE 199309L
+
+/* Standard includes */
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+/* Project includes */
+#include <smartlog/clock.h>
+#include <smartlog/config.h>
+#include <smartlog/context.h>
+#include <smartlog/logger.h>
+#include <smartlog/sink.h>
+#include <smartlog/smartlog_core.h>
+#include <smartlog/utils.h>
+
+/* ============================================================================
+ * Settings
+ * ============================================================================ */
+
+#define BENCH_CAPACITY      SMARTLOG_QUEUE_DEFAULT_CAP
+#define BENCH_BATCH         SMARTLOG_WRITER_BATCH
+#define BENCH_ELEM_SIZE     128
+#define BENCH_DEFAULT_ITEMS 2000000UL
+
+#define WAIT_PACED_ITEMS    2000
+#define WAIT_PACED_GAP_US   200
+#define WAIT_HOT_ITEMS      200000
+#define PAGES_DEFAULT_MB    256
+#define PAGES_RANDOM_READS  (1u << 22)
+#define CLOCK_READS         (1u << 22)
+#define CLOCK_SAMPLES       2000
+#define LZ4_BENCH_ITEMS     2000000
+#define CIRC_BENCH_ITEMS    1000000
+#define CIRC_DURABLE_ITEMS  5000
+#define CIRC_BENCH_BYTES    (1u << 20)
+#define CONTEXT_BENCH_LINES (1u << 22)
+
+static const int producer_counts[] = { 1, 2, 4, 8, 16, 32, 64 };
+static const unsigned int spin_values[] = { 0, 10, 50, 200 };
+
+/* ============================================================================
+ * Mutex + Condvar Baseline Queue
+ * ============================================================================ */
+
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t not_empty;
+    size_t head;
+    size_t count;
+    uint64_t wakeups;
+    char (*slots)[BENCH_ELEM_SIZE];
+} locked_queue_t;
+
+static int locked_push(locked_queue_t* q, const void* data, size_t len)
+{
+    pthread_mutex_lock(&q->lock);
+    if(q->count == BENCH_CAPACITY)
+    {
+        pthread_mutex_unlock(&q->lock);
+        return -1;
+    }
+    memcpy(q->slots[(q->head + q->count) % BENCH_CAPACITY], data, len);
+    q->count++;
+    if(q->count == 1)
+    {
+        q->wakeups++;
+        pthread_cond_signal(&q->not_empty);
+    }
+    pthread_mutex_unlock(&q->lock);
+    return 0;
+}
+
+static size_t locked_drain(locked_queue_t* q, char* sink)
+{
+    pthread_mutex_lock(&q->lock);
+    while(q->count == 0)
+    {
+        pthread_cond_wait(&q->not_empty, &q->lock);
+    }
+
+    size_t n = q->count < BENCH_BATCH ? q->count : BENCH_BATCH;
+    for(size_t i = 0; i < n; i++)
+    {
+        memcpy(sink, q->slots[(q->head + i) % BENCH_CAPACITY], BENCH_ELEM_SIZE);
+    }
+    q->head = (q->head + n) % BENCH_CAPACITY;
+    q->count -= n;
+    pthread_mutex_unlock(&q->lock);
+    return n;
+}
+
+/* ============================================================================
+ * Producer Threads
+ * ============================================================================ */
+
+typedef struct {
+    smartlog_mpsc_t* mpsc;
+    locked_queue_t* locked;
+    unsigned long items;
+} producer_arg_t;
+
+static void* producer_main(void* arg)
+{
+    producer_arg_t* p = (producer_arg_t*)arg;
+    char line[BENCH_ELEM_SIZE];
+    memset(line, 'x', sizeof(line));
+
+    for(unsigned long i = 0; i < p->items; i++)
+    {
+        memcpy(line, &i, sizeof(i));
+        for(;;)
+        {
+            int rc = p->mpsc != NULL ? smartlog_mpsc_push(p->mpsc, line, sizeof(line))
+                                     : locked_push(p->locked, line, sizeof(line));
+            if(rc == 0)
+            {
+                break;
+            }
+            /* Full: give the consumer the CPU */
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+/* ============================================================================
+ * Benchmark Runs
+ * ============================================================================ */
+
+/**
+ * Run one configuration and return elapsed nanoseconds (0 on error).
+ */
+static uint64_t run_once(int use_mpsc, int producers, unsigned long total, uint64_t* wakeups)
+{
+    smartlog_mpsc_t* mpsc = NULL;
+    locked_queue_t locked;
+    memset(&locked, 0, sizeof(locked));
+
+    if(use_mpsc)
+    {
+        mpsc = smartlog_mpsc_create(BENCH_CAPACITY, BENCH_ELEM_SIZE);
+        if(mpsc == NULL)
+        {
+            perror("smartlog_mpsc_create");
+            return 0;
+        }
+    }
+    else
+    {
+        pthread_mutex_init(&locked.lock, NULL);
+        pthread_cond_init(&locked.not_empty, NULL);
+        locked.slots = malloc(sizeof(*locked.slots) * BENCH_CAPACITY);
+        if(locked.slots == NULL)
+        {
+            perror("malloc");
+            return 0;
+        }
+    }
+
+    unsigned long per_producer = total / (unsigned long)producers;
+    unsigned long expected = per_producer * (unsigned long)producers;
+    pthread_t threads[64];
+    producer_arg_t arg = { mpsc, &locked, per_producer };
+
+    uint64_t start = smartlog_monotonic_ns();
+    for(int t = 0; t < producers; t++)
+    {
+        if(pthread_create(&threads[t], NULL, producer_main, &arg) != 0)
+        {
+            fprintf(stderr, "pthread_create failed\n");
+            exit(1);
+        }
+    }
+
+    /* Consumer: batch claim, touch each element like a writer would */
+    char sink[BENCH_ELEM_SIZE];
+    unsigned long seen = 0;
+    while(seen < expected)
+    {
+        if(use_mpsc)
+        {
+            const void* elems[BENCH_BATCH];
+            size_t lens[BENCH_BATCH];
+            size_t n = smartlog_mpsc_claim(mpsc, elems, lens, BENCH_BATCH);
+            if(n == 0)
+            {
+                smartlog_mpsc_wait(mpsc, 0);
+                continue;
+            }
+            for(size_t i = 0; i < n; i++)
+            {
+                memcpy(sink, elems[i], lens[i]);
+            }
+            smartlog_mpsc_release(mpsc, n);
+            seen += n;
+        }
+        else
+        {
+            seen += locked_drain(&locked, sink);
+        }
+    }
+    uint64_t elapsed = smartlog_monotonic_ns() - start;
+
+    for(int t = 0; t < producers; t++)
+    {
+        pthread_join(threads[t], NULL);
+    }
+
+    if(use_mpsc)
+    {
+        *wakeups = smartlog_mpsc_wakeups(mpsc);
+        smartlog_mpsc_destroy(mpsc);
+    }
+    else
+    {
+        *wakeups = locked.wakeups;
+        free(locked.slots);
+        pthread_cond_destroy(&locked.not_empty);
+        pthread_mutex_destroy(&locked.lock);
+    }
+
+    return elapsed == 0 ? 1 : elapsed;
+}
+
+static int bench_mpsc(unsigned long total)
+{
+    printf("%-10s %-9s %14s %12s\n", "queue", "producers", "items/s", "wakeups");
+
+    for(size_t i = 0; i < sizeof(producer_counts) / sizeof(producer_counts[0]); i++)
+    {
+        for(int use_mpsc = 1; use_mpsc >= 0; use_mpsc--)
+        {
+            uint64_t wakeups = 0;
+            int producers = producer_counts[i];
+            uint64_t ns = run_once(use_mpsc, producers, total, &wakeups);
+            if(ns == 0)
+            {
+                return 1;
+            }
+
+            double items = (double)(total / (unsigned long)producers * (unsigned long)producers);
+            printf("%-10s %-9d %14.0f %12llu\n", use_mpsc ? "mpsc" : "mutex", producers,
+                   items * 1e9 / (double)ns, (unsigned long long)wakeups);
+        }
+    }
+
+    return 0;
+}
+
+/* ============================================================================
+ * Writer Wait Strategy
+ * ============================================================================ */
+
+/* Sink that records enqueue-to-write latency; runs on the writer thread */
+typedef struct {
+    uint64_t* latency;
+    size_t count;
+    size_t cap;
+} latency_sink_t;
+
+static int latency_write(void* ctx, const char* data, size_t len)
+{
+    latency_sink_t* ls = (latency_sink_t*)ctx;
+    uint64_t line_ns = 0;
+    uint64_t now = smartlog_timestamp_ns();
+
+    if(ls->count < ls->cap && smartlog_line_timestamp(data, len, &line_ns) == 0)
+    {
+        ls->latency[ls->count++] = now > line_ns ? now - line_ns : 0;
+    }
+    return 0;
+}
+
+static const smartlog_sink_ops_t latency_ops = { .write = latency_write };
+
+static int compare_u64(const void* a, const void* b)
+{
+    uint64_t x = *(const uint64_t*)a;
+    uint64_t y = *(const uint64_t*)b;
+    return (x > y) - (x < y);
+}
+
+static uint64_t cpu_time_ns(void)
+{
+    struct rusage ru;
+    if(getrusage(RUSAGE_SELF, &ru) != 0)
+    {
+        return 0;
+    }
+    return (uint64_t)(ru.ru_utime.tv_sec + ru.ru_stime.tv_sec) * UINT64_C(1000000000) +
+           (uint64_t)(ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) * UINT64_C(1000);
+}
+
+/**
+ * Log items lines through one async sink with the given spin and print
+ * p50/p99 latency, CPU use (process CPU time / wall time) and wakeups.
+ */
+static int run_wait(const char* name, unsigned int spin_us, size_t items, long gap_us)
+{
+    latency_sink_t ls = { calloc(items, sizeof(uint64_t)), 0, items };
+    smartlog_logger_t* lg = smartlog_logger_create();
+    smartlog_sink_t* sk = smartlog_sink_create(&latency_ops, &ls);
+    if(ls.latency == NULL || lg == NULL || sk == NULL ||
+       smartlog_sink_set_async(sk, 0, OVERFLOW_BLOCK) != 0 ||
+       smartlog_logger_set_writer_spin(lg, spin_us) != 0 ||
+       smartlog_logger_add_sink(lg, sk) != 0)
+    {
+        perror("wait bench setup");
+        return 1;
+    }
+
+    struct timespec gap = { 0, gap_us * 1000L };
+    uint64_t cpu_start = cpu_time_ns();
+    uint64_t wall_start = smartlog_monotonic_ns();
+    for(size_t i = 0; i < items; i++)
+    {
+        smartlog_logger_log(lg, LOG_LEVEL_INFO, "bench-wait");
+        if(gap_us != 0)
+        {
+            nanosleep(&gap, NULL);
+        }
+    }
+    smartlog_logger_flush(lg);
+    uint64_t wall = smartlog_monotonic_ns() - wall_start;
+    uint64_t cpu = cpu_time_ns() - cpu_start;
+
+    smartlog_sink_stats_t st;
+    smartlog_sink_get_stats(sk, &st);
+    qsort(ls.latency, ls.count, sizeof(uint64_t), compare_u64);
+    uint64_t p50 = ls.count != 0 ? ls.latency[ls.count / 2] : 0;
+    uint64_t p99 = ls.count != 0 ? ls.latency[(ls.count * 99) / 100] : 0;
+
+    printf("%-7s %8u %12llu %12llu %7.1f%% %10llu\n", name, spin_us,
+           (unsigned long long)p50, (unsigned long long)p99,
+           wall != 0 ? 100.0 * (double)cpu / (double)wall : 0.0,
+           (unsigned long long)st.wakeups);
+
+    smartlog_logger_destroy(lg);
+    free(ls.latency);
+    return 0;
+}
+
+static int bench_wait(void)
+{
+    printf("%-7s %8s %12s %12s %8s %10s\n", "load", "spin_us", "p50_ns", "p99_ns", "cpu", "wakeups");
+
+    for(size_t i = 0; i < sizeof(spin_values) / sizeof(spin_values[0]); i++)
+    {
+        if(run_wait("paced", spin_values[i], WAIT_PACED_ITEMS, WAIT_PACED_GAP_US) != 0 ||
+           run_wait("hot", spin_values[i], WAIT_HOT_ITEMS, 0) != 0)
+        {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/* ============================================================================
+ * Huge Pages
+ * ============================================================================ */
+
+static const char* page_kind_name(page_kind_t kind)
+{
+    switch(kind)
+    {
+        case PAGES_TRANSPARENT: return "thp";
+        case PAGES_HUGETLB:     return "hugetlb";
+        default:                return "normal";
+    }
+}
+
+/**
+ * Touch, then randomly read, one region; then fill and drain a queue of
+ * about the same size.
+ */
+static int run_pages(feature_state_t huge, size_t bytes)
+{
+    smartlog_mem_opts_t opts = { -1, huge };
+    smartlog_region_t region;
+    if(smartlog_region_alloc(&region, bytes, &opts) != 0)
+    {
+        perror("smartlog_region_alloc");
+        return 1;
+    }
+
+    uint64_t start = smartlog_monotonic_ns();
+    memset(region.addr, 1, bytes);
+    uint64_t touch_ns = smartlog_monotonic_ns() - start;
+
+    /* LCG over 8-byte words: every read is likely a TLB miss on 4 KiB pages */
+    const uint64_t* words = (const uint64_t*)region.addr;
+    size_t nwords = bytes / sizeof(uint64_t);
+    uint64_t x = 88172645463325252ULL;
+    volatile uint64_t sum = 0;
+    start = smartlog_monotonic_ns();
+    for(unsigned int i = 0; i < PAGES_RANDOM_READS; i++)
+    {
+        x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+        sum += words[(x >> 17) % nwords];
+    }
+    uint64_t read_ns = smartlog_monotonic_ns() - start;
+    page_kind_t kind = region.pages;
+    smartlog_region_free(&region);
+
+    /* Burst absorption: fill the queue, then drain it */
+    size_t capacity = 2;
+    while(capacity * 2 * (BENCH_ELEM_SIZE + 64) <= bytes)
+    {
+        capacity <<= 1;
+    }
+    smartlog_mpsc_t* q = smartlog_mpsc_create_with(capacity, BENCH_ELEM_SIZE, &opts);
+    if(q == NULL)
+    {
+        perror("smartlog_mpsc_create_with");
+        return 1;
+    }
+
+    char line[BENCH_ELEM_SIZE];
+    memset(line, 'x', sizeof(line));
+    start = smartlog_monotonic_ns();
+    size_t pushed = 0;
+    while(smartlog_mpsc_push(q, line, sizeof(line)) == 0)
+    {
+        pushed++;
+    }
+    for(;;)
+    {
+        const void* elems[BENCH_BATCH];
+        size_t lens[BENCH_BATCH];
+        size_t n = smartlog_mpsc_claim(q, elems, lens, BENCH_BATCH);
+        if(n == 0)
+        {
+            break;
+        }
+        for(size_t i = 0; i < n; i++)
+        {
+            sum += ((const unsigned char*)elems[i])[lens[i] - 1];
+        }
+        smartlog_mpsc_release(q, n);
+    }
+    uint64_t burst_ns = smartlog_monotonic_ns() - start;
+    page_kind_t queue_kind = smartlog_mpsc_page_kind(q);
+    smartlog_mpsc_destroy(q);
+
+    printf("%-8s %-8s %12.2f %14.2f %-8s %14.2f\n", huge == FEATURE_ENABLED ? "huge" : "regular",
+           page_kind_name(kind), (double)touch_ns / 1e6, (double)read_ns / PAGES_RANDOM_READS,
+           page_kind_name(queue_kind), pushed != 0 ? (double)burst_ns / (double)pushed : 0.0);
+    return 0;
+}
+
+static int bench_pages(size_t megabytes)
+{
+    size_t bytes = megabytes << 20;
+    printf("buffer: %zu MB\n", megabytes);
+    printf("%-8s %-8s %12s %14s %-8s %14s\n", "request", "got", "touch_ms", "rand_read_ns",
+           "queue", "burst_ns/item");
+
+    if(run_pages(FEATURE_DISABLED, bytes) != 0 || run_pages(FEATURE_ENABLED, bytes) != 0)
+    {
+        return 1;
+    }
+    return 0;
+}
+
+/* ============================================================================
+ * Clock Benchmark
+ * ============================================================================ */
+
+static int run_clock(clock_mode_t mode, const char* name)
+{
+    smartlog_clock_t* clk = NULL;
+    if(mode != CLOCK_MODE_REALTIME && (clk = smartlog_clock_create(mode)) == NULL)
+    {
+        printf("%-14s %12s\n", name, errno == ENOTSUP ? "unsupported" : "error");
+        return 0;
+    }
+
+    smartlog_clock_anchor_t anchor;
+    int anchored = 0;
+    volatile uint64_t sum = 0;
+    uint64_t start = smartlog_monotonic_ns();
+    for(unsigned int i = 0; i < CLOCK_READS; i++)
+    {
+        sum += clk != NULL ? smartlog_clock_now(clk, &anchor, &anchored) : smartlog_timestamp_ns();
+    }
+    uint64_t elapsed = smartlog_monotonic_ns() - start;
+
+    /* Gap to CLOCK_REALTIME, sampled across several anchor periods */
+    uint64_t max_gap = 0;
+    struct timespec pause = { 0, 1000000L };
+    for(unsigned int i = 0; clk != NULL && i < CLOCK_SAMPLES; i++)
+    {
+        uint64_t real = smartlog_timestamp_ns();
+        uint64_t value = smartlog_clock_now(clk, &anchor, &anchored);
+        uint64_t gap = value > real ? value - real : real - value;
+        if(gap > max_gap)
+        {
+            max_gap = gap;
+        }
+        nanosleep(&pause, NULL);
+    }
+    smartlog_clock_destroy(clk);
+
+    printf("%-14s %12.2f %14llu\n", name, (double)elapsed / CLOCK_READS, (unsigned long long)max_gap);
+    return 0;
+}
+
+static int bench_clock(void)
+{
+    printf("%-14s %12s %14s\n", "clock", "ns/read", "max_gap_ns");
+    run_clock(CLOCK_MODE_REALTIME, "realtime");
+    run_clock(CLOCK_MODE_MONOTONIC_RAW, "monotonic_raw");
+    run_clock(CLOCK_MODE_TSC, "tsc");
+    return 0;
+}
+
+/* ============================================================================
+ * Compressed Writer Benchmark
+ * ============================================================================ */
+
+static int run_lz4(const char* dir, int compressed)
+{
+    char path[SMARTLOG_PATH_MAX_LEN];
+    snprintf(path, sizeof(path), "%s/smartlog_bench_%d.log%s", dir, (int)getpid(), compressed ? ".lz4" : "");
+
+    smartlog_logger_t* lg = smartlog_logger_create();
+    smartlog_sink_t* sk = compressed ?
+        smartlog_sink_lz4_open(path, FEATURE_DISABLED, FEATURE_DISABLED, 0) :
+        smartlog_sink_file_open(path, FEATURE_DISABLED, FEATURE_DISABLED, 0);
+    if(lg == NULL || sk == NULL ||
+       smartlog_sink_set_async(sk, 0, OVERFLOW_BLOCK) != 0 ||
+       smartlog_logger_add_sink(lg, sk) != 0)
+    {
+        perror("lz4 bench setup");
+        return 1;
+    }
+
+    /* A few templates with changing fields, like real traffic */
+    char msg[SMARTLOG_MSG_MAX_LEN];
+    uint64_t cpu_start = cpu_time_ns();
+    uint64_t wall_start = smartlog_monotonic_ns();
+    for(unsigned long i = 0; i < LZ4_BENCH_ITEMS; i++)
+    {
+        switch(i % 4)
+        {
+            case 0:
+                snprintf(msg, sizeof(msg), "request id=%lu handled in %lu us status=200", i, (i * 7) % 900);
+                break;
+            case 1:
+                snprintf(msg, sizeof(msg), "cache miss for key session:%lu refilling", (i * 31) % 100000);
+                break;
+            case 2:
+                snprintf(msg, sizeof(msg), "worker %lu heartbeat queue_depth=%lu", i % 16, i % 64);
+                break;
+            default:
+                snprintf(msg, sizeof(msg), "db query on orders took %lu ms rows=%lu", i % 50, (i * 13) % 1000);
+                break;
+        }
+        smartlog_logger_log(lg, LOG_LEVEL_INFO, msg);
+    }
+    smartlog_logger_flush(lg);
+    uint64_t wall = smartlog_monotonic_ns() - wall_start;
+    uint64_t cpu = cpu_time_ns() - cpu_start;
+
+    smartlog_sink_stats_t st;
+    smartlog_sink_get_stats(sk, &st);
+    smartlog_logger_destroy(lg);
+
+    struct stat fst;
+    if(stat(path, &fst) != 0)
+    {
+        perror(path);
+        return 1;
+    }
+    unlink(path);
+
+    double secs = (double)wall / 1e9;
+    printf("%-6s %12.0f %10.1f %10.1f %8.2f %7.1f%%\n", compressed ? "lz4" : "plain",
+           secs > 0 ? (double)st.records / secs : 0.0,
+           (double)st.bytes / (1024.0 * 1024.0),
+           (double)fst.st_size / (1024.0 * 1024.0),
+           fst.st_size != 0 ? (double)st.bytes / (double)fst.st_size : 0.0,
+           wall != 0 ? 100.0 * (double)cpu / (double)wall : 0.0);
+    return 0;
+}
+
+static int bench_lz4(const char* dir)
+{
+    printf("%-6s %12s %10s %10s %8s %8s\n", "sink", "lines/s", "raw_MB", "disk_MB", "ratio", "cpu");
+    if(run_lz4(dir, 0) != 0 || run_lz4(dir, 1) != 0)
+    {
+        return 1;
+    }
+    return 0;
+}
+
+/* ============================================================================
+ * Circular File Benchmark
+ * ============================================================================ */
+
+static int run_circ(const char* dir, int circular, feature_state_t durable)
+{
+    char path[SMARTLOG_PATH_MAX_LEN];
+    snprintf(path, sizeof(path), "%s/smartlog_bench_%d.%s", dir, (int)getpid(), circular ? "circ" : "log");
+
+    smartlog_logger_t* lg = smartlog_logger_create();
+    smartlog_sink_t* sk = circular ?
+        smartlog_sink_circ_open(path, CIRC_BENCH_BYTES, durable) :
+        smartlog_sink_file_open(path, durable, FEATURE_ENABLED, CIRC_BENCH_BYTES);
+    if(lg == NULL || sk == NULL || smartlog_logger_add_sink(lg, sk) != 0)
+    {
+        perror("circ bench setup");
+        return 1;
+    }
+
+    unsigned long items = durable == FEATURE_ENABLED ? CIRC_DURABLE_ITEMS : CIRC_BENCH_ITEMS;
+    char msg[SMARTLOG_MSG_MAX_LEN];
+    uint64_t wall_start = smartlog_monotonic_ns();
+    for(unsigned long i = 0; i < items; i++)
+    {
+        snprintf(msg, sizeof(msg), "request id=%lu handled in %lu us status=200", i, (i * 7) % 900);
+        smartlog_logger_log(lg, LOG_LEVEL_INFO, msg);
+    }
+    uint64_t wall = smartlog_monotonic_ns() - wall_start;
+
+    smartlog_sink_stats_t st;
+    smartlog_sink_get_stats(sk, &st);
+    smartlog_logger_destroy(lg);
+
+    /* Rotation keeps one backup, so count it as disk use too */
+    char backup[SMARTLOG_PATH_MAX_LEN + 2];
+    snprintf(backup, sizeof(backup), "%s.1", path);
+    struct stat fst;
+    struct stat bst;
+    if(stat(path, &fst) != 0)
+    {
+        perror(path);
+        return 1;
+    }
+    off_t disk = fst.st_size + (stat(backup, &bst) == 0 ? bst.st_size : 0);
+    unlink(path);
+    unlink(backup);
+
+    double secs = (double)wall / 1e9;
+    printf("%-8s %-8s %12.0f %10.2f %8llu\n", circular ? "circular" : "rotate",
+           durable == FEATURE_ENABLED ? "durable" : "plain",
+           secs > 0 ? (double)st.records / secs : 0.0,
+           (double)disk / (1024.0 * 1024.0), (unsigned long long)st.errors);
+    return 0;
+}
+
+static int bench_circ(const char* dir)
+{
+    printf("%-8s %-8s %12s %10s %8s\n", "sink", "mode", "lines/s", "disk_MB", "errors");
+    if(run_circ(dir, 0, FEATURE_DISABLED) != 0 || run_circ(dir, 1, FEATURE_DISABLED) != 0 ||
+       run_circ(dir, 0, FEATURE_ENABLED) != 0 || run_circ(dir, 1, FEATURE_ENABLED) != 0)
+    {
+        return 1;
+    }
+    return 0;
+}
+
+/* ============================================================================
+ * Context Benchmark
+ * ============================================================================ */
+
+static int bench_context(void)
+{
+    static const char req[] = "9b2e4f2a-7c1d-4e8b-a0f3-5d6c7b8a9e01";
+    static const char tenant[] = "acme-prod";
+    char line[SMARTLOG_LOG_BUFFER_SZ];
+    char msg[SMARTLOG_MSG_MAX_LEN];
+    volatile size_t sink = 0;
+
+    /* Caller formats the fields into every message */
+    uint64_t start = smartlog_monotonic_ns();
+    for(unsigned int i = 0; i < CONTEXT_BENCH_LINES; i++)
+    {
+        snprintf(msg, sizeof(msg), "req=%s tenant=%s cache miss", req, tenant);
+        int n = smartlog_format_record(line, sizeof(line), 1700000000000000000ull + i, 4242, 4243, i + 1, msg);
+        sink += (size_t)n;
+    }
+    uint64_t in_msg = smartlog_monotonic_ns() - start;
+
+    /* Pushed once, copied per line */
+    if(smartlog_context_push("REQ", req) != 0 || smartlog_context_push("TENANT", tenant) != 0)
+    {
+        perror("smartlog_context_push");
+        return 1;
+    }
+    start = smartlog_monotonic_ns();
+    for(unsigned int i = 0; i < CONTEXT_BENCH_LINES; i++)
+    {
+        size_t ctx_len = 0;
+        const char* ctx = smartlog_context_encoded(&ctx_len);
+        int n = smartlog_format_record_ctx(line, sizeof(line), 1700000000000000000ull + i, 4242, 4243, i + 1,
+                                           ctx, ctx_len, "cache miss");
+        sink += (size_t)n;
+    }
+    uint64_t in_ctx = smartlog_monotonic_ns() - start;
+    smartlog_context_clear();
+
+    printf("%-10s %12s\n", "fields", "ns/line");
+    printf("%-10s %12.1f\n", "in_msg", (double)in_msg / CONTEXT_BENCH_LINES);
+    printf("%-10s %12.1f\n", "context", (double)in_ctx / CONTEXT_BENCH_LINES);
+    return 0;
+}
+
+/* ============================================================================
+ * Main Entry Point
+ * ============================================================================ */
+
+int main(int argc, char* argv[])
+{
+    if(argc == 2 && strcmp(argv[1], "wait") == 0)
+    {
+        return bench_wait();
+    }
+    if(argc == 2 && strcmp(argv[1], "clock") == 0)
+    {
+        return bench_clock();
+    }
+    if((argc == 2 || argc == 3) && strcmp(argv[1], "lz4") == 0)
+    {
+        return bench_lz4(argc == 3 ? argv[2] : ".");
+    }
+    if(argc == 2 && strcmp(argv[1], "context") == 0)
+    {
+        return bench_context();
+    }
+    if((argc == 2 || argc == 3) && strcmp(argv[1], "circ") == 0)
+    {
+        return bench_circ(argc == 3 ? argv[2] : ".");
+    }
+    if(argc >= 2 && strcmp(argv[1], "pages") == 0)
+    {
+        unsigned long megabytes = PAGES_DEFAULT_MB;
+        if(argc > 2)
+        {
+            char* endpoint = NULL;
+            errno = 0;
+            megabytes = strtoul(argv[2], &endpoint, 10);
+            if(endpoint == argv[2] || *endpoint != '\0' || errno == ERANGE || megabytes < 4)
+            {
+                fprintf(stderr, "Error: megabytes must be an integer >= 4\n");
+                return 2;
+            }
+        }
+        return bench_pages(megabytes);
+    }
+    if(argc < 2 || strcmp(argv[1], "mpsc") != 0)
+    {
+        fprintf(stderr, "Usage: ./smartlog_bench mpsc [total_items] | wait | pages [megabytes] | clock | lz4 [dir] | circ [dir] | context\n");
+        return 2;
+    }
+
+    unsigned long total = BENCH_DEFAULT_ITEMS;
+    if(argc > 2)
+    {
+        char* endpoint = NULL;
+        errno = 0;
+        total = strtoul(argv[2], &endpoint, 10);
+        if(endpoint == argv[2] || *endpoint != '\0' || errno == ERANGE || total < 64)
+        {
+            fprintf(stderr, "Error: total_items must be an integer >= 64\n");
+            return 2;
+        }
+    }
+
+    return bench_mpsc(total);
+}
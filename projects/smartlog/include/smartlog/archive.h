@@ -0,0 +1,194 @@
+/*
+ * include/smartlog/archive.h
+ *
+ * Seekable compressed archive for rotated SmartLog files.
+ *
+ * A plain log is cut at line boundaries into blocks of about
+ * SMARTLOG_ARCHIVE_BLOCK bytes. Each block is compressed on its own
+ * (zlib), so a reader can decompress any block without the ones before
+ * it. A trailing index lists every block with its timestamp range, so a
+ * time query only touches the blocks it needs, and can decompress them
+ * in parallel.
+ *
+ * File layout (all integers little-endian):
+ *   header   16 bytes  "SLARCHV1", u32 version, u32 block size
+ *   blocks   zlib streams, back to back
+ *   index    40 bytes per block:
+ *              u64 offset, u32 compressed length, u32 raw length,
+ *              u32 lines, u32 crc32 of the raw bytes,
+ *              u64 min timestamp, u64 max timestamp
+ *   trailer  32 bytes  "SLARCIDX", u32 block count, u32 flags,
+ *                      u64 index offset, u32 crc32 of the index,
+ *                      u32 dictionary id
+ *
+ * A block with no "[<ns> ns]" line has min 0 and max UINT64_MAX, so every
+ * query includes it.
+ *
+ * Dictionaries: log lines repeat the same prefixes and templates, which a
+ * small block alone cannot learn. smartlog_archive_train() builds a preset
+ * dictionary (max SMARTLOG_DICT_MAX bytes) from sample logs and stores it
+ * in its own file next to the logs. Blocks packed with it still decode
+ * independently, given the same file. Flags bit 0 marks such an archive
+ * and the dictionary id is the adler32 of the dictionary bytes.
+ *
+ * Author: Aravinthraj Ganesan
+ * Version: 1.0
+ */
+
+#ifndef SMARTLOG_ARCHIVE_H
+#define SMARTLOG_ARCHIVE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* ============================================================================
+ * Types
+ * ============================================================================ */
+
+/** One index entry */
+typedef struct {
+    uint64_t offset;        /* Start of the compressed block in the file */
+    uint32_t comp_len;      /* Compressed bytes */
+    uint32_t raw_len;       /* Bytes after decompression (whole lines) */
+    uint32_t lines;         /* Lines in the block */
+    uint32_t crc;           /* crc32 of the raw bytes */
+    uint64_t min_ns;        /* Smallest line timestamp in the block */
+    uint64_t max_ns;        /* Largest line timestamp in the block */
+} smartlog_archive_block_t;
+
+typedef struct {
+    uint64_t blocks;        /* Blocks written */
+    uint64_t lines;         /* Lines written */
+    uint64_t raw_bytes;     /* Input bytes */
+    uint64_t comp_bytes;    /* Archive bytes, header/index/trailer included */
+} smartlog_archive_stats_t;
+
+typedef struct smartlog_archive smartlog_archive_t;
+
+/* ============================================================================
+ * Writer Functions
+ * ============================================================================ */
+
+/**
+ * Compress a plain log file into a new archive.
+ *
+ * The archive is written to "<dst_path>.tmp", synced and renamed, so
+ * dst_path is either complete or absent.
+ *
+ * Parameters:
+ *   src_path   - Plain log file (e.g. a rotated "<file>.1")
+ *   dst_path   - Archive to create (replaced if it exists)
+ *   block_size - Target raw bytes per block (0 = SMARTLOG_ARCHIVE_BLOCK)
+ *   stats      - Optional counters (may be NULL)
+ *
+ * Return: 0 on success, 1 on error (errno is set)
+ */
+int smartlog_archive_pack(const char* src_path, const char* dst_path, size_t block_size,
+                          smartlog_archive_stats_t* stats);
+
+/**
+ * Like smartlog_archive_pack(), with a preset dictionary for every block.
+ *
+ * Parameters:
+ *   dict_path - Dictionary from smartlog_archive_train() (NULL = none)
+ *
+ * Return: 0 on success, 1 on error (errno is set)
+ */
+int smartlog_archive_pack_dict(const char* src_path, const char* dst_path, size_t block_size,
+                               const char* dict_path, smartlog_archive_stats_t* stats);
+
+/**
+ * Train a compression dictionary from sample logs.
+ *
+ * Lines are split at digit runs and the remaining text pieces are ranked
+ * by count x length over up to SMARTLOG_DICT_SAMPLE bytes. The best pieces
+ * are written best-last (deflate codes near matches cheaper).
+ *
+ * Parameters:
+ *   sample_paths - Logs to sample
+ *   npaths       - Number of sample paths
+ *   dict_path    - Dictionary file to write (replaced if it exists)
+ *   max_size     - Max dictionary bytes (0 = SMARTLOG_DICT_MAX)
+ *   dict_len     - Optional output: dictionary bytes written
+ *
+ * Return: 0 on success, 1 on error (errno is set, ENODATA when nothing
+ *         in the sample repeats)
+ */
+int smartlog_archive_train(const char* const* sample_paths, size_t npaths, const char* dict_path,
+                           size_t max_size, size_t* dict_len);
+
+/* ============================================================================
+ * Reader Functions
+ * ============================================================================ */
+
+/**
+ * Open an archive and load its index.
+ *
+ * Return: New reader, or NULL on error (errno is set, EBADMSG for a file
+ *         that is not a valid archive)
+ */
+smartlog_archive_t* smartlog_archive_open(const char* path);
+
+/**
+ * Open an archive packed with a dictionary.
+ *
+ * The index is readable without the dictionary; block reads need it.
+ *
+ * Return: New reader, or NULL on error (errno is set, ENOKEY when the
+ *         dictionary is not the one the archive was packed with)
+ */
+smartlog_archive_t* smartlog_archive_open_dict(const char* path, const char* dict_path);
+
+/**
+ * Number of blocks in the archive.
+ */
+size_t smartlog_archive_block_count(const smartlog_archive_t* archive);
+
+/**
+ * Copy one index entry.
+ *
+ * Return: 0 on success, 1 on error (errno is set, ERANGE for a bad index)
+ */
+int smartlog_archive_block_info(const smartlog_archive_t* archive, size_t index,
+                                smartlog_archive_block_t* out);
+
+/**
+ * Decompress one block. Safe to call from many threads at once.
+ *
+ * Parameters:
+ *   archive - Archive reader
+ *   index   - Block index
+ *   out     - Output buffer, at least raw_len bytes
+ *   out_sz  - Size of output buffer
+ *
+ * Return: Raw length on success, -1 on error (errno is set, EBADMSG when
+ *         the block fails its checksum, ENOKEY when it needs a dictionary
+ *         that was not given)
+ */
+long smartlog_archive_read_block(const smartlog_archive_t* archive, size_t index, char* out, size_t out_sz);
+
+/**
+ * Write every line with from_ns <= timestamp <= to_ns, in archive order.
+ *
+ * Only blocks whose range overlaps the query are read; they are
+ * decompressed by up to `threads` threads and written in order. Untimed
+ * lines go with the timed line before them.
+ *
+ * Parameters:
+ *   archive - Archive reader
+ *   from_ns - First timestamp to include
+ *   to_ns   - Last timestamp to include (UINT64_MAX = no limit)
+ *   threads - Decompression threads (0 = online CPUs)
+ *   out_fd  - Where matching lines are written
+ *
+ * Return: 0 on success, 1 on error (errno is set)
+ */
+int smartlog_archive_query(const smartlog_archive_t* archive, uint64_t from_ns, uint64_t to_ns,
+                           unsigned int threads, int out_fd);
+
+/**
+ * Close the archive and free the reader.
+ */
+void smartlog_archive_close(smartlog_archive_t* archive);
+
+#endif /* SMARTLOG_ARCHIVE_H */
@@ -0,0 +1,136 @@
+/*
+ * include/smartlog/circfile.h
+ *
+ * Fixed-size circular log files, an alternative to rotation.
+ *
+ * The file is preallocated once and never grows, is never renamed and
+ * never unlinked: when the data area is full, the oldest records are
+ * overwritten. Disk use is bounded and there is no directory churn (no
+ * rename, unlink or directory sync after the file is created). The writer
+ * maps the file, so appending a record is a memcpy and no syscall.
+ *
+ * File layout (all integers little-endian):
+ *   page 0     4096 bytes
+ *     header   64 bytes  "SLCIRC01", u32 version, u32 data offset (4096),
+ *                        u64 capacity (data area bytes), reserved
+ *     state    two 64-byte slots at 64 and 128, written alternately:
+ *                u64 generation, u64 head (oldest record), u64 tail
+ *                (next write), u64 records held, u64 wraps, u64 records
+ *                ever written, u32 crc32 of the first 48 bytes, reserved
+ *   data       capacity bytes
+ *
+ * Records are a 16-byte frame (u32 line length, u32 crc32 of the line,
+ * u64 record number from 0) plus the line, padded to 8 bytes. A record
+ * never wraps: a frame with length 0xFFFFFFFF (or fewer than 16 bytes
+ * left) sends the reader back to the start of the data area.
+ *
+ * The state slot is only rewritten after the record is in place, and
+ * readers take the valid slot with the highest generation, so a writer
+ * that dies half way leaves the previous state readable.
+ *
+ * Author: Aravinthraj Ganesan
+ * Version: 1.0
+ */
+
+#ifndef SMARTLOG_CIRCFILE_H
+#define SMARTLOG_CIRCFILE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* ============================================================================
+ * Types
+ * ============================================================================ */
+
+typedef struct smartlog_circfile smartlog_circfile_t;
+
+typedef struct {
+    uint64_t capacity;      /* Data area bytes */
+    uint64_t head;          /* Data offset of the oldest record */
+    uint64_t tail;          /* Data offset of the next record */
+    uint64_t records;       /* Records held */
+    uint64_t wraps;         /* Times the writer went back to the start */
+    uint64_t written;       /* Records ever written */
+    uint64_t damaged;       /* Held records not returned by a read (see below) */
+} smartlog_circfile_info_t;
+
+/**
+ * Read callback, once per record, oldest first. line ends with '\n' and
+ * is valid only during the call.
+ *
+ * Return: 0 to go on, non-zero to stop the read
+ */
+typedef int (*smartlog_circfile_fn)(const char* line, size_t len, uint64_t number, void* arg);
+
+/* ============================================================================
+ * Writer Functions
+ * ============================================================================ */
+
+/**
+ * Open a circular file for writing, creating and preallocating it.
+ *
+ * An existing circular file is continued where it stopped; it must have
+ * the same capacity. Any other existing file is left untouched.
+ *
+ * Parameters:
+ *   path     - File path
+ *   capacity - Data area bytes, a multiple of 8 and at least
+ *              SMARTLOG_CIRC_MIN_BYTES (the file is 4096 bytes larger)
+ *
+ * Return: New writer, or NULL on error (errno is set; EINVAL for a bad
+ *         capacity or a capacity mismatch, EBADMSG for a file that is not
+ *         a circular file)
+ */
+smartlog_circfile_t* smartlog_circfile_open(const char* path, size_t capacity);
+
+/**
+ * Append one record, overwriting the oldest ones as needed. Single writer
+ * only: callers serialize.
+ *
+ * Return: 0 on success, -1 on error (errno is set; EMSGSIZE when the
+ *         record is larger than SMARTLOG_LOG_BUFFER_SZ)
+ */
+int smartlog_circfile_append(smartlog_circfile_t* cf, const void* data, size_t len);
+
+/**
+ * Write the mapped pages to disk (msync). No directory sync is needed:
+ * the file's size and name never change after creation.
+ *
+ * Return: 0 on success, -1 on error (errno is set)
+ */
+int smartlog_circfile_sync(smartlog_circfile_t* cf);
+
+/**
+ * Copy the current state.
+ */
+void smartlog_circfile_get_info(const smartlog_circfile_t* cf, smartlog_circfile_info_t* out);
+
+/**
+ * Unmap and close the file (no sync).
+ */
+void smartlog_circfile_close(smartlog_circfile_t* cf);
+
+/* ============================================================================
+ * Reader Functions
+ * ============================================================================ */
+
+/**
+ * Unroll a circular file: pass every held record to fn, oldest first.
+ *
+ * The file is copied into memory first, so a writer may keep going. A
+ * record that fails its checks (overwritten while the copy was made, or
+ * corrupt) ends the read; the records not returned are counted in
+ * info->damaged.
+ *
+ * Parameters:
+ *   path - Circular file
+ *   fn   - Callback per record
+ *   arg  - Passed to fn
+ *   info - Optional output: the state the read used (may be NULL)
+ *
+ * Return: 0 on success (also when fn stopped the read), 1 on error (errno
+ *         is set, EBADMSG for a file that is not a valid circular file)
+ */
+int smartlog_circfile_read(const char* path, smartlog_circfile_fn fn, void* arg, smartlog_circfile_info_t* info);
+
+#endif /* SMARTLOG_CIRCFILE_H */
@@ -0,0 +1,95 @@
+/*
+ * include/smartlog/clock.h
+ *
+ * Anchored log clocks for SmartLog.
+ *
+ * Reading CLOCK_REALTIME for every entry is the default. These clocks
+ * read a cheaper counter on the hot path and convert it to wall time:
+ *   - CLOCK_MODE_MONOTONIC_RAW: clock_gettime(CLOCK_MONOTONIC_RAW)
+ *   - CLOCK_MODE_TSC: rdtsc, only on x86 with an invariant TSC
+ *
+ * wall_ns = anchor.real_ns + (((raw - anchor.raw) * anchor.mult) >> 32)
+ *
+ * An anchor pairs a counter reading with a CLOCK_REALTIME reading. A new
+ * anchor is taken every SMARTLOG_CLOCK_ANCHOR_MS, so NTP steps show up
+ * within one period. The rate (mult) is re-measured from each period and
+ * may move at most SMARTLOG_CLOCK_MAX_PPM from the calibrated rate, which
+ * follows NTP slewing but ignores steps. Readers never lock: the anchor is
+ * published under a sequence counter.
+ *
+ * Author: Aravinthraj Ganesan
+ * Version: 1.0
+ */
+
+#ifndef SMARTLOG_CLOCK_H
+#define SMARTLOG_CLOCK_H
+
+#include <stdint.h>
+
+#include <smartlog/config.h>
+
+/* ============================================================================
+ * Types
+ * ============================================================================ */
+
+/** One counter/realtime pair and the conversion rate used after it */
+typedef struct {
+    clock_mode_t mode;
+    uint64_t raw;       /* Counter reading (TSC ticks or raw ns) */
+    uint64_t real_ns;   /* CLOCK_REALTIME at the same moment */
+    uint64_t mult;      /* Nanoseconds per counter unit, 32.32 fixed point */
+} smartlog_clock_anchor_t;
+
+typedef struct smartlog_clock smartlog_clock_t;
+
+/* ============================================================================
+ * Clock Functions
+ * ============================================================================ */
+
+/**
+ * Check for an invariant TSC (CPUID 0x80000007 EDX bit 8).
+ *
+ * Return: 1 if the TSC ticks at a constant rate in all power states, else 0
+ */
+int smartlog_clock_tsc_invariant(void);
+
+/**
+ * Create a clock. CLOCK_MODE_TSC is calibrated against CLOCK_MONOTONIC_RAW
+ * for SMARTLOG_CLOCK_CALIBRATE_MS, so creation takes that long.
+ *
+ * Parameters:
+ *   mode - CLOCK_MODE_MONOTONIC_RAW or CLOCK_MODE_TSC
+ *
+ * Return: New clock, or NULL on error (errno is set: ENOTSUP when the
+ *         TSC is missing or not invariant, EINVAL for other modes)
+ */
+smartlog_clock_t* smartlog_clock_create(clock_mode_t mode);
+
+/**
+ * Read the clock as CLOCK_REALTIME nanoseconds.
+ *
+ * Safe to call from many threads. When the anchor period has passed, one
+ * caller takes a new anchor, gets it in *anchor and sees *anchored = 1, so
+ * it can log the anchor before its own entry. The first call always
+ * anchors.
+ *
+ * Parameters:
+ *   clk      - Clock handle
+ *   anchor   - Output anchor, filled only when *anchored is set
+ *   anchored - Output: 1 if this call took a new anchor, else 0
+ *
+ * Return: Time value in nanoseconds (0 on error, errno is set)
+ */
+uint64_t smartlog_clock_now(smartlog_clock_t* clk, smartlog_clock_anchor_t* anchor, int* anchored);
+
+/**
+ * Get the mode a clock was created with.
+ */
+clock_mode_t smartlog_clock_mode(const smartlog_clock_t* clk);
+
+/**
+ * Free a clock.
+ */
+void smartlog_clock_destroy(smartlog_clock_t* clk);
+
+#endif /* SMARTLOG_CLOCK_H */
@@ -0,0 +1,102 @@
+/*
+ * include/smartlog/collector.h
+ *
+ * Local log collector for SmartLog (used by the smartlogd daemon).
+ *
+ * Many processes send finished lines to one collector, which is the only
+ * writer of the output file:
+ *   - Receives lines on a Unix datagram socket with recvmmsg()
+ *   - Optionally maps per-client shared-memory rings (shm_ring.h)
+ *   - Holds lines for a short reorder window and emits them in
+ *     timestamp order (min-heap)
+ *   - Writes each emit cycle as one batch; in durable mode that batch
+ *     gets one fdatasync (group commit)
+ *   - Rotation happens in one place, so there are no cross-process
+ *     rotation races
+ *
+ * Author: Aravinthraj Ganesan
+ * Version: 1.0
+ */
+
+#ifndef SMARTLOG_COLLECTOR_H
+#define SMARTLOG_COLLECTOR_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <smartlog/config.h>
+
+/* ============================================================================
+ * Types
+ * ============================================================================ */
+
+typedef struct {
+    const char* socket_path;        /* Datagram socket to bind */
+    const char* ring_socket_path;   /* Ring control socket (NULL = off) */
+    const char* output_path;        /* Merged log file */
+    feature_state_t durable;        /* Group commit with fdatasync */
+    feature_state_t max_bytes_config;
+    unsigned long max_byte_val;
+    unsigned int reorder_window_ms; /* How long lines wait for stragglers */
+    size_t capacity;                /* Max lines held (0 = default) */
+    feature_state_t huge_pages;     /* Back line slots with huge pages if possible */
+} smartlog_collector_config_t;
+
+typedef struct {
+    uint64_t received;      /* Lines received from clients */
+    uint64_t written;       /* Lines written to the output file */
+    uint64_t late;          /* Lines older than the last emitted line */
+    uint64_t commits;       /* Output batches (fdatasync calls when durable) */
+    uint64_t ring_clients;  /* Shared-memory clients currently attached */
+    uint64_t ring_dropped;  /* Lines dropped by clients on full rings */
+    uint64_t ring_errors;   /* Clients detached because their ring was corrupt */
+    page_kind_t slot_pages; /* Page kind backing the line slots */
+} smartlog_collector_stats_t;
+
+typedef struct smartlog_collector smartlog_collector_t;
+
+/* ============================================================================
+ * Collector Functions
+ * ============================================================================ */
+
+/**
+ * Fill a config with defaults (window SMARTLOG_COLLECTOR_WINDOW_MS,
+ * capacity SMARTLOG_COLLECTOR_CAP, not durable, no rotation).
+ */
+void smartlog_collector_config_init(smartlog_collector_config_t* cfg);
+
+/**
+ * Bind the socket and open the output file.
+ *
+ * A stale socket file at socket_path is replaced.
+ *
+ * Return: New collector, or NULL on error (errno is set)
+ */
+smartlog_collector_t* smartlog_collector_create(const smartlog_collector_config_t* cfg);
+
+/**
+ * Wait up to timeout_ms for input, receive everything pending, and write
+ * every line whose reorder window has expired.
+ *
+ * Return: 0 on success, 1 on error (errno is set). EINTR is not an error.
+ */
+int smartlog_collector_run_once(smartlog_collector_t* collector, int timeout_ms);
+
+/**
+ * Write every held line now, ignoring the reorder window.
+ *
+ * Return: 0 on success, 1 on error (errno is set)
+ */
+int smartlog_collector_drain(smartlog_collector_t* collector);
+
+/**
+ * Copy current counters.
+ */
+void smartlog_collector_get_stats(const smartlog_collector_t* collector, smartlog_collector_stats_t* out);
+
+/**
+ * Drain, close the output, remove the socket file and free.
+ */
+void smartlog_collector_destroy(smartlog_collector_t* collector);
+
+#endif /* SMARTLOG_COLLECTOR_H */
@@ -0,0 +1,137 @@
+/*
+ * include/smartlog/columns.h
+ *
+ * Columnar files of SmartLog lines, for analytics.
+ *
+ * A log is parsed once (smartlog_parse_file()) and stored column by
+ * column, so a query reads only the columns it needs instead of
+ * re-parsing text. Each column starts on its own page of the file, and
+ * the reader maps the file, so unused columns are never read from disk.
+ *
+ * File layout (all integers little-endian):
+ *   header     48 bytes  "SLCOLUM1", u32 version, u32 column count,
+ *                        u64 rows, u64 untimed rows, u64 min timestamp,
+ *                        u64 max timestamp
+ *   directory  32 bytes per column:
+ *                u32 column id, u32 crc32 of the column bytes,
+ *                u64 offset, u64 length, u64 reserved (0)
+ *   columns    4096-byte aligned
+ *
+ * Column encodings (varints are LEB128, zigzag for signed values):
+ *   TIME         one varint per row: 0 for an untimed row, otherwise
+ *                zigzag(delta from the previous timed row) + 1
+ *   PID, TID     varint n, n zigzag dictionary values, then
+ *                (varint dictionary index, varint run length) runs
+ *   SEQ          zigzag(delta from the previous row) per row
+ *   MSG_OFFSETS  rows + 1 fixed u64 offsets into MSG_BLOB
+ *   MSG_BLOB     message bytes back to back (no separators)
+ *
+ * Untimed rows (lines without "[<ns> ns]") keep pid and tid -1 and seq 0,
+ * as in smartlog_columns_t.
+ *
+ * Author: Aravinthraj Ganesan
+ * Version: 1.0
+ */
+
+#ifndef SMARTLOG_COLUMNS_H
+#define SMARTLOG_COLUMNS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* ============================================================================
+ * Types
+ * ============================================================================ */
+
+/** Column ids (also stored in the directory) */
+typedef enum {
+    SMARTLOG_COL_TIME = 0,
+    SMARTLOG_COL_PID = 1,
+    SMARTLOG_COL_TID = 2,
+    SMARTLOG_COL_SEQ = 3,
+    SMARTLOG_COL_MSG_OFFSETS = 4,
+    SMARTLOG_COL_MSG_BLOB = 5,
+    SMARTLOG_COL_COUNT = 6
+} smartlog_col_id_t;
+
+typedef struct {
+    uint64_t rows;                              /* Lines stored */
+    uint64_t untimed;                           /* Rows without a timestamp */
+    uint64_t min_ns;                            /* Smallest timestamp (0 if none) */
+    uint64_t max_ns;                            /* Largest timestamp (0 if none) */
+    uint64_t raw_bytes;                         /* Source log bytes (export only) */
+    uint64_t file_bytes;                        /* Columnar file bytes */
+    uint64_t column_bytes[SMARTLOG_COL_COUNT];  /* Encoded bytes per column */
+} smartlog_colfile_info_t;
+
+typedef struct smartlog_colfile smartlog_colfile_t;
+
+/* ============================================================================
+ * Writer Functions
+ * ============================================================================ */
+
+/**
+ * Parse a plain log and write it as a columnar file.
+ *
+ * The file is written to "<dst_path>.tmp", synced and renamed, so
+ * dst_path is either complete or absent.
+ *
+ * Parameters:
+ *   src_path - Plain log file
+ *   dst_path - Columnar file to create (replaced if it exists)
+ *   threads  - Parser threads (0 = online CPUs)
+ *   info     - Optional summary of what was written (may be NULL)
+ *
+ * Return: 0 on success, 1 on error (errno is set)
+ */
+int smartlog_colfile_export(const char* src_path, const char* dst_path, unsigned int threads,
+                            smartlog_colfile_info_t* info);
+
+/* ============================================================================
+ * Reader Functions
+ * ============================================================================ */
+
+/**
+ * Map a columnar file and check its header and directory.
+ *
+ * Return: New reader, or NULL on error (errno is set, EBADMSG for a file
+ *         that is not a valid columnar file)
+ */
+smartlog_colfile_t* smartlog_colfile_open(const char* path);
+
+/**
+ * Copy the header summary and column sizes (raw_bytes is 0).
+ */
+void smartlog_colfile_get_info(const smartlog_colfile_t* cf, smartlog_colfile_info_t* out);
+
+/**
+ * Decode a whole column into an array of rows entries. Only that column
+ * is read; its crc32 is checked first.
+ *
+ * Return: 0 on success, 1 on error (errno is set, EBADMSG for a damaged
+ *         column)
+ */
+int smartlog_colfile_read_time(const smartlog_colfile_t* cf, uint64_t* out);
+int smartlog_colfile_read_pid(const smartlog_colfile_t* cf, int32_t* out);
+int smartlog_colfile_read_tid(const smartlog_colfile_t* cf, int32_t* out);
+int smartlog_colfile_read_seq(const smartlog_colfile_t* cf, uint64_t* out);
+
+/**
+ * Message of one row, pointing into the mapped file (not terminated).
+ *
+ * Parameters:
+ *   cf  - Columnar file
+ *   row - Row index
+ *   len - Output: message bytes
+ *
+ * Return: Message start, or NULL on error (errno is set, ERANGE for a bad
+ *         row, EBADMSG for offsets outside the blob)
+ */
+const char* smartlog_colfile_message(const smartlog_colfile_t* cf, size_t row, size_t* len);
+
+/**
+ * Unmap the file and free the reader.
+ */
+void smartlog_colfile_close(smartlog_colfile_t* cf);
+
+#endif /* SMARTLOG_COLUMNS_H */
@@ -7,6 +7,8 @@
  *   - Buffer and file size limits
  *   - File permission settings
  *   - Feature enums for flags
+ *   - Log levels and queue overflow policies
+ *   - Page kinds for large buffers
  *
  * Author: Aravinthraj Ganesan
  * Version: 4.0
@@ -27,6 +29,77 @@
 
 #define SMARTLOG_TIMESTAMP_ENABLED 1  /* Always use timestamps */
 #define SMARTLOG_FILE_MODE (S_IRUSR | S_IWUSR | S_IRGRP)  /* rw-r----- */
+#define SMARTLOG_CACHE_LINE 64        /* Padding unit for shared counters */
+#define SMARTLOG_HUGE_PAGE_SZ (2u << 20)  /* Huge page size used for rounding */
+#define SMARTLOG_FD_CACHE_MAX  64     /* Max descriptors kept by the fd cache */
+#define SMARTLOG_CIRC_MIN_BYTES (16u * SMARTLOG_LOG_BUFFER_SZ)  /* Smallest circular file data area */
+
+/* ============================================================================
+ * Logger and Sink Settings
+ * ============================================================================ */
+
+#define SMARTLOG_MAX_SINKS          8     /* Max sinks attached to one logger */
+#define SMARTLOG_QUEUE_DEFAULT_CAP  1024  /* Default async sink queue depth */
+#define SMARTLOG_WRITER_BATCH       64    /* Max records per writer batch */
+#define SMARTLOG_RECONNECT_MS       100   /* Min gap between socket reconnects */
+#define SMARTLOG_WRITER_SPIN_US     50    /* Idle writer spin before futex_wait */
+#define SMARTLOG_MAX_WRITER_CPUS    64    /* Max CPUs in a logger writer affinity */
+#define SMARTLOG_SPILL_CHUNK        (64u << 10)  /* Spill file write/read size */
+#define SMARTLOG_SPILL_DIR          "/tmp"       /* Default spill file directory */
+#define SMARTLOG_CRASH_MAX_SINKS    32    /* Max sinks drained on a fatal signal */
+#define SMARTLOG_CLOCK_ANCHOR_MS    1000  /* Realtime re-anchor period (TSC/raw clocks) */
+#define SMARTLOG_CLOCK_CALIBRATE_MS 10    /* TSC calibration interval at startup */
+#define SMARTLOG_CLOCK_MAX_PPM      500   /* Max rate correction per anchor (NTP slew bound) */
+#define SMARTLOG_COUNTER_SLOTS      256   /* Counter keys per thread (power of two) */
+#define SMARTLOG_SYNC_BUCKETS       12    /* Sync latency histogram buckets (see sink.h) */
+#define SMARTLOG_RECORDER_MIN_RING  (4u * SMARTLOG_LOG_BUFFER_SZ)  /* Smallest flight recorder ring */
+#define SMARTLOG_RECORDER_SIGNALS   8     /* Loggers that can dump on a signal at once */
+#define SMARTLOG_CONTEXT_MAX_LEN    256   /* Encoded context bytes per thread */
+#define SMARTLOG_CONTEXT_MAX_DEPTH  8     /* Context fields per thread */
+
+/* ============================================================================
+ * Collector Settings
+ * ============================================================================ */
+
+#define SMARTLOG_COLLECTOR_WINDOW_MS  50    /* Default reorder window */
+#define SMARTLOG_COLLECTOR_CAP        8192  /* Default max held lines */
+#define SMARTLOG_COLLECTOR_MAX_RINGS  64    /* Max shared-memory clients */
+#define SMARTLOG_COLLECTOR_HELLO_MS   100   /* Max wait for a ring client's hello */
+#define SMARTLOG_SHM_RING_DEFAULT     (1u << 20)  /* Default client ring bytes */
+
+/* ============================================================================
+ * Merge Settings
+ * ============================================================================ */
+
+#define SMARTLOG_MERGE_BUF  (64u << 10)  /* Read buffer per input, and output buffer */
+
+/* ============================================================================
+ * Archive Settings
+ * ============================================================================ */
+
+#define SMARTLOG_ARCHIVE_BLOCK  (1u << 20)  /* Raw bytes per compressed block */
+#define SMARTLOG_DICT_MAX       (32u << 10) /* Max dictionary size (deflate window) */
+#define SMARTLOG_DICT_SAMPLE    (8u << 20)  /* Max sample bytes read when training */
+#define SMARTLOG_DICT_MIN_SEGMENT 4         /* Shortest text piece worth keeping */
+
+/* ============================================================================
+ * Tail Settings
+ * ============================================================================ */
+
+#define SMARTLOG_TAIL_BUF  (1u << 20)  /* Read size when following a file */
+
+/* ============================================================================
+ * Metrics Settings
+ * ============================================================================ */
+
+#define SMARTLOG_METRICS_MAX_SOURCES  16   /* Loggers + callbacks per exporter */
+#define SMARTLOG_METRICS_IO_MS        100  /* Per-client request/answer timeout */
+
+/* ============================================================================
+ * Parse Settings
+ * ============================================================================ */
+
+#define SMARTLOG_PARSE_CHUNK_MIN  (1u << 20)  /* Smallest chunk per parser thread */
 
 /* ============================================================================
  * Feature Flags
@@ -42,4 +115,29 @@ typedef enum {
     DIR_USER_INPUT = 0xBB        /* User directory */
 } directory_type_t;
 
+typedef enum {
+    LOG_LEVEL_DEBUG = 0,    /* Verbose diagnostics */
+    LOG_LEVEL_INFO = 1,     /* Normal operation */
+    LOG_LEVEL_WARN = 2,     /* Something looks wrong */
+    LOG_LEVEL_ERROR = 3     /* Operation failed */
+} log_level_t;
+
+typedef enum {
+    OVERFLOW_DROP = 0,      /* Drop the record and count it */
+    OVERFLOW_BLOCK = 1,     /* Wait for the writer to make room */
+    OVERFLOW_SPILL = 2      /* Spill to a temp file, replay in order later */
+} overflow_policy_t;
+
+typedef enum {
+    CLOCK_MODE_REALTIME = 0,      /* clock_gettime(CLOCK_REALTIME) per entry */
+    CLOCK_MODE_MONOTONIC_RAW = 1, /* CLOCK_MONOTONIC_RAW, anchored to realtime */
+    CLOCK_MODE_TSC = 2            /* rdtsc (invariant TSC only), anchored to realtime */
+} clock_mode_t;
+
+typedef enum {
+    PAGES_NORMAL = 0,       /* Regular pages */
+    PAGES_TRANSPARENT = 1,  /* Transparent huge pages (madvise) */
+    PAGES_HUGETLB = 2       /* Reserved huge pages (MAP_HUGETLB) */
+} page_kind_t;
+
 #endif /* SMARTLOG_CONFIG_H */
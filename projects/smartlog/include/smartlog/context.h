@@ -0,0 +1,73 @@
+/*
+ * include/smartlog/context.h
+ *
+ * Thread-local logging context for SmartLog.
+ *
+ * Fields such as a request ID or a tenant are pushed once per unit of
+ * work instead of being formatted into every message:
+ *   - A push encodes the field as "[<KEY> = <value>] " right away and
+ *     appends it to the calling thread's context
+ *   - Every logger entry of that thread gets the encoded bytes copied
+ *     into its header, after SEQ and before MESSAGE:
+ *     "... [SEQ = 7] [REQ = 4f2a] [TENANT = acme] [MESSAGE = ...]"
+ *   - Fields are removed in reverse order (a stack), so nested scopes can
+ *     add and drop their own fields
+ *
+ * Context does not count against SMARTLOG_MSG_MAX_LEN. The parser
+ * (parse.h) skips such fields, so messages parse as before.
+ *
+ * Author: Aravinthraj Ganesan
+ * Version: 1.0
+ */
+
+#ifndef SMARTLOG_CONTEXT_H
+#define SMARTLOG_CONTEXT_H
+
+#include <stddef.h>
+
+/* ============================================================================
+ * Context Functions
+ * ============================================================================ */
+
+/**
+ * Push a field onto the calling thread's context.
+ *
+ * Parameters:
+ *   key   - Field name: letters, digits, '_', '-' or '.'
+ *   value - Field value: printable, without '[' or ']' (may be empty)
+ *
+ * Return: 0 on success, 1 on error (errno is set; EINVAL for a bad key
+ *         or value, ENOSPC when SMARTLOG_CONTEXT_MAX_DEPTH fields or
+ *         SMARTLOG_CONTEXT_MAX_LEN encoded bytes are exceeded)
+ */
+int smartlog_context_push(const char* key, const char* value);
+
+/**
+ * Remove the field pushed last.
+ *
+ * Return: 0 on success, 1 on error (errno is set, ENOENT when the
+ *         context is empty)
+ */
+int smartlog_context_pop(void);
+
+/**
+ * Remove every field of the calling thread (e.g. when a pooled thread
+ * picks up new work).
+ */
+void smartlog_context_clear(void);
+
+/** Return: Fields in the calling thread's context */
+size_t smartlog_context_depth(void);
+
+/**
+ * The calling thread's encoded context, for formatting.
+ *
+ * Parameters:
+ *   len - Output: encoded bytes (0 when the context is empty)
+ *
+ * Return: Encoded fields (not terminated), valid until the next push,
+ *         pop or clear on this thread
+ */
+const char* smartlog_context_encoded(size_t* len);
+
+#endif /* SMARTLOG_CONTEXT_H */
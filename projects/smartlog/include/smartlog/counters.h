@@ -0,0 +1,98 @@
+/*
+ * include/smartlog/counters.h
+ *
+ * Per-call-site event counters for SmartLog.
+ *
+ * Many log lines exist only to be counted later. A counter set keeps an
+ * exact count per (message template, level, call site) instead:
+ *   - Each thread counts into its own table, so the hot path is a hash
+ *     probe and a plain store, with no lock and no shared cache line
+ *   - A snapshot merges every thread's table under a mutex and reports
+ *     what was counted since the previous snapshot and in total
+ *
+ * Keys compare by pointer: template and file must be string literals (or
+ * live as long as the counter set), as with __FILE__ and format strings.
+ * Each thread has room for SMARTLOG_COUNTER_SLOTS keys; events for keys
+ * beyond that are counted as overflow. A thread's table is kept after the
+ * thread exits, so its counts are never lost, and the next new thread
+ * counts into it: memory is one table per thread counting at a time.
+ *
+ * The logger uses this for smartlog_logger_enable_counters() (logger.h).
+ *
+ * Author: Aravinthraj Ganesan
+ * Version: 1.0
+ */
+
+#ifndef SMARTLOG_COUNTERS_H
+#define SMARTLOG_COUNTERS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <smartlog/config.h>
+
+/* ============================================================================
+ * Types
+ * ============================================================================ */
+
+/** One merged key of a snapshot */
+typedef struct {
+    const char* tmpl;       /* Message template */
+    const char* file;       /* Call site file */
+    int line;               /* Call site line */
+    log_level_t level;
+    uint64_t delta;         /* Events since the previous snapshot */
+    uint64_t total;         /* Events since the counter set was created */
+} smartlog_counter_t;
+
+typedef struct smartlog_counters smartlog_counters_t;
+
+/* ============================================================================
+ * Counter Functions
+ * ============================================================================ */
+
+/**
+ * Create an empty counter set.
+ *
+ * Return: New counter set, or NULL on error (errno is set)
+ */
+smartlog_counters_t* smartlog_counters_create(void);
+
+/**
+ * Count one event. Safe to call from many threads.
+ *
+ * The first event of a thread allocates its table.
+ *
+ * Return: 0 on success, 1 on error (errno is set)
+ */
+int smartlog_counters_add(smartlog_counters_t* counters, log_level_t level, const char* tmpl,
+                          const char* file, int line);
+
+/**
+ * Merge every thread's counts.
+ *
+ * Only keys counted since the previous snapshot are returned. Safe to call
+ * while other threads count; events racing with the snapshot go to the
+ * next one.
+ *
+ * Parameters:
+ *   counters - Counter set
+ *   out      - Output: array to free(), sorted by file, line, level
+ *              (NULL when count is 0)
+ *   count    - Output: entries in *out
+ *   overflow - Optional output: events since the previous snapshot that
+ *              found their thread's table full, or whose key appeared
+ *              while the snapshot ran and found no room (may be NULL)
+ *
+ * Return: 0 on success, 1 on error (errno is set)
+ */
+int smartlog_counters_snapshot(smartlog_counters_t* counters, smartlog_counter_t** out, size_t* count,
+                               uint64_t* overflow);
+
+/**
+ * Free the counter set and every thread's table. No thread may count
+ * into it any more, nor be exiting while it is freed.
+ */
+void smartlog_counters_destroy(smartlog_counters_t* counters);
+
+#endif /* SMARTLOG_COUNTERS_H */
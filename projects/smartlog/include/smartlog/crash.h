@@ -0,0 +1,61 @@
+/*
+ * include/smartlog/crash.h
+ *
+ * Crash-time flush for SmartLog async sinks (opt-in).
+ *
+ * When the process dies on SIGSEGV, SIGBUS, SIGILL, SIGFPE or SIGABRT,
+ * lines still sitting in async queues (and spill files) are written
+ * straight to each registered sink's file descriptor, then the signal is
+ * re-raised with the previous disposition (core dump, or the handler that
+ * was installed before).
+ *
+ * The drain path only uses async-signal-safe calls: atomic loads to read
+ * the lock-free queue, pread() and a write() loop. It takes no lock, so:
+ *   - Lines the writer thread was writing at the moment of the crash may
+ *     show up twice
+ *   - Sinks without a crash_fd op (see smartlog_sink_ops_t) are skipped
+ *
+ * Author: Aravinthraj Ganesan
+ * Version: 1.0
+ */
+
+#ifndef SMARTLOG_CRASH_H
+#define SMARTLOG_CRASH_H
+
+#include <smartlog/sink.h>
+
+/* ============================================================================
+ * Crash Flush Functions
+ * ============================================================================ */
+
+/**
+ * Install the fatal-signal handlers (idempotent).
+ *
+ * Also gives the calling thread an alternate signal stack, so a stack
+ * overflow on that thread still gets its logs out.
+ *
+ * Return: 0 on success, 1 on error (errno is set)
+ */
+int smartlog_crash_install(void);
+
+/**
+ * Add a sink to the crash drain list (at most SMARTLOG_CRASH_MAX_SINKS).
+ *
+ * smartlog_sink_destroy() removes the sink again.
+ *
+ * Return: 0 on success, 1 on error (errno is set, ENOSPC when full)
+ */
+int smartlog_crash_register(smartlog_sink_t* sink);
+
+/**
+ * Remove a sink from the crash drain list. Unknown sinks are ignored.
+ */
+void smartlog_crash_unregister(smartlog_sink_t* sink);
+
+/**
+ * Drain every registered sink now. Async-signal-safe; this is what the
+ * handler calls. Also usable from a custom handler.
+ */
+void smartlog_crash_drain(void);
+
+#endif /* SMARTLOG_CRASH_H */
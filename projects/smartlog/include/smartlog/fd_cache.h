@@ -0,0 +1,100 @@
+/*
+ * include/smartlog/fd_cache.h
+ *
+ * Process-wide descriptor cache for smartlog_write_log_entry().
+ *
+ * The one-shot API opens and closes the log file on every call. With the
+ * cache enabled it keeps descriptors open across calls instead:
+ *   - Entries are keyed by path and shared by all threads (one mutex
+ *     around lookup; the path check, the open and the writes happen
+ *     outside it, O_APPEND keeps the writes whole)
+ *   - An entry is checked against its path at most every check_ms: if
+ *     stat() of the path no longer gives the device and inode the
+ *     descriptor was opened on (rotated, removed, replaced), it is closed
+ *     and the path is opened again
+ *   - At most max_fds entries are kept; the least recently used idle one
+ *     is closed to make room
+ *
+ * Rotation done by smartlog_write_log_entry() itself drops the entry at
+ * once. Rotation by another process is noticed within check_ms; until
+ * then lines still go to the renamed file.
+ *
+ * Disabled by default: the legacy open/write/close path is unchanged.
+ *
+ * Author: Aravinthraj Ganesan
+ * Version: 1.0
+ */
+
+#ifndef SMARTLOG_FD_CACHE_H
+#define SMARTLOG_FD_CACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* ============================================================================
+ * Types
+ * ============================================================================ */
+
+typedef struct {
+    uint64_t hits;          /* Calls served by an open entry */
+    uint64_t misses;        /* Calls that had to open the path */
+    uint64_t stale;         /* Entries dropped because the path changed */
+    uint64_t evictions;     /* Idle entries closed to make room */
+    uint64_t races;         /* Opens closed again: another thread cached the path first */
+    uint64_t open;          /* Descriptors held right now */
+} smartlog_fd_cache_stats_t;
+
+/** A descriptor lent out by smartlog_fd_cache_acquire() */
+typedef struct {
+    int fd;
+    int slot;               /* Cache entry, -1 = not cached (closed on release) */
+    int created;            /* The open created the file */
+    uint64_t dev;
+    uint64_t ino;
+} smartlog_fd_ref_t;
+
+/* ============================================================================
+ * Cache Functions
+ * ============================================================================ */
+
+/**
+ * Enable the cache, or change its settings while enabled.
+ *
+ * Parameters:
+ *   max_fds  - Descriptors kept open (1 to SMARTLOG_FD_CACHE_MAX)
+ *   check_ms - Min time between path checks of one entry (0 = every call)
+ *
+ * Return: 0 on success, 1 on error (errno is set)
+ */
+int smartlog_fd_cache_enable(size_t max_fds, unsigned int check_ms);
+
+/**
+ * Disable the cache and close its descriptors (those in use are closed
+ * when their write finishes).
+ */
+void smartlog_fd_cache_disable(void);
+
+/** Return: Non-zero if the cache is enabled */
+int smartlog_fd_cache_enabled(void);
+
+/** Copy the cache counters */
+void smartlog_fd_cache_get_stats(smartlog_fd_cache_stats_t* out);
+
+/**
+ * Get a descriptor for path opened with O_WRONLY | O_CREAT | O_APPEND.
+ * Falls back to an uncached descriptor when every entry is in use.
+ *
+ * Return: 0 on success, 1 on error (errno is set, EISDIR for a directory)
+ */
+int smartlog_fd_cache_acquire(const char* path, smartlog_fd_ref_t* ref);
+
+/**
+ * Give a descriptor back.
+ *
+ * Parameters:
+ *   ref  - Descriptor from smartlog_fd_cache_acquire()
+ *   drop - Non-zero to close the entry (write error, file rotated away)
+ */
+void smartlog_fd_cache_release(smartlog_fd_ref_t* ref, int drop);
+
+#endif /* SMARTLOG_FD_CACHE_H */
@@ -0,0 +1,267 @@
+/*
+ * include/smartlog/logger.h
+ *
+ * Long-lived logger handle for SmartLog.
+ *
+ * A logger owns a set of sinks. Each entry is formatted once, into one
+ * buffer, and the same bytes are handed to every sink:
+ *   - Each sink applies its own level/filter
+ *   - Async sinks only copy the line into their queue
+ *
+ * Typical setup:
+ *
+ *   smartlog_logger_t* lg = smartlog_logger_create();
+ *   smartlog_sink_t* all = smartlog_sink_file_open("app.log", ...);
+ *   smartlog_sink_t* err = smartlog_sink_file_open("app.err", ...);
+ *   smartlog_sink_set_level(err, LOG_LEVEL_ERROR);
+ *   smartlog_logger_add_sink(lg, all);
+ *   smartlog_logger_add_sink(lg, err);
+ *   smartlog_logger_log(lg, LOG_LEVEL_INFO, "server started");
+ *   smartlog_logger_destroy(lg);
+ *
+ * Author: Aravinthraj Ganesan
+ * Version: 1.0
+ */
+
+#ifndef SMARTLOG_LOGGER_H
+#define SMARTLOG_LOGGER_H
+
+#include <stddef.h>
+
+#include <smartlog/config.h>
+#include <smartlog/sink.h>
+
+typedef struct smartlog_logger smartlog_logger_t;
+
+/* ============================================================================
+ * Logger Functions
+ * ============================================================================ */
+
+/**
+ * Create an empty logger.
+ *
+ * Return: New logger, or NULL on error (errno is set)
+ */
+smartlog_logger_t* smartlog_logger_create(void);
+
+/**
+ * Attach a sink. The logger takes ownership of the sink.
+ *
+ * Sinks must be attached before the logger is shared between threads.
+ *
+ * Return: 0 on success, 1 on error (errno is set, ENOSPC when
+ *         SMARTLOG_MAX_SINKS is reached)
+ */
+int smartlog_logger_add_sink(smartlog_logger_t* logger, smartlog_sink_t* sink);
+
+/**
+ * Set the idle spin time of every async writer on this logger.
+ *
+ * Applies to the sinks attached now and to sinks attached later (see
+ * smartlog_sink_set_spin()). Use 0 for mostly idle loggers, a larger value
+ * for hot loggers where wakeup latency matters more than CPU.
+ *
+ * Return: 0 on success, 1 on error (errno is set)
+ */
+int smartlog_logger_set_writer_spin(smartlog_logger_t* logger, unsigned int spin_us);
+
+/**
+ * Pin the writer thread of every async sink on this logger.
+ *
+ * Applies to the sinks attached now and to sinks attached later (see
+ * smartlog_sink_set_affinity()). Attach sinks before calling
+ * smartlog_sink_set_async() on them if their queues should follow the
+ * writer's NUMA node.
+ *
+ * Parameters:
+ *   logger - Logger handle
+ *   cpus   - CPU numbers (at most SMARTLOG_MAX_WRITER_CPUS)
+ *   ncpus  - Number of CPUs (0 = remove pinning)
+ *
+ * Return: 0 on success, 1 on error (errno is set)
+ */
+int smartlog_logger_set_writer_affinity(smartlog_logger_t* logger, const int* cpus, size_t ncpus);
+
+/**
+ * Ask every sink attached from now on for huge-page backed queues (see
+ * smartlog_sink_set_huge_pages()). Sinks already async keep their pages.
+ *
+ * Return: 0 on success, 1 on error (errno is set)
+ */
+int smartlog_logger_set_huge_pages(smartlog_logger_t* logger, feature_state_t huge_pages);
+
+/**
+ * Opt in to crash-time flush for this logger (see crash.h).
+ *
+ * Installs the fatal-signal handlers and registers every sink attached now
+ * or later, so queued lines reach their destination if the process dies.
+ *
+ * Return: 0 on success, 1 on error (errno is set)
+ */
+int smartlog_logger_enable_crash_flush(smartlog_logger_t* logger);
+
+/**
+ * Choose how entry timestamps are read (default CLOCK_MODE_REALTIME).
+ *
+ * CLOCK_MODE_MONOTONIC_RAW and CLOCK_MODE_TSC read a cheap counter per
+ * entry and convert it to wall time from a realtime anchor taken every
+ * SMARTLOG_CLOCK_ANCHOR_MS (see clock.h). Each new anchor is written just
+ * before the entry that took it, to every sink whatever its level and
+ * filter, and never into the flight recorder:
+ *   "clock anchor mode=<tsc|monotonic_raw> raw=<n> real_ns=<ns> mult=<n>"
+ * Call before logging starts; it is not safe against concurrent logging.
+ *
+ * Parameters:
+ *   logger - Logger handle
+ *   mode   - Clock mode
+ *
+ * Return: 0 on success, 1 on error (errno is set, ENOTSUP for TSC mode
+ *         without an invariant TSC)
+ */
+int smartlog_logger_set_clock(smartlog_logger_t* logger, clock_mode_t mode);
+
+/**
+ * Keep per-call-site event counters on this logger (see counters.h).
+ *
+ * Counted events (smartlog_logger_count(), smartlog_logger_log_counted())
+ * are summed per thread per (template, level, call site). Every
+ * interval_ms, a counted call writes a summary of what was counted since
+ * the previous summary, at LOG_LEVEL_INFO:
+ *   "counters snap=<n> part=<k> | <LEVEL> <file>:<line> "<template>" +<delta>=<total> | ..."
+ * Keys that did not move are left out. A summary that does not fit in one
+ * message continues in the next part. The final summary is written by
+ * smartlog_logger_destroy(). Call before logging starts.
+ *
+ * Parameters:
+ *   logger      - Logger handle
+ *   interval_ms - Summary period (0 = only smartlog_logger_snapshot_counters()
+ *                 and destroy)
+ *
+ * Return: 0 on success, 1 on error (errno is set)
+ */
+int smartlog_logger_enable_counters(smartlog_logger_t* logger, unsigned int interval_ms);
+
+/**
+ * Count one event without writing a line. Safe to call from many threads.
+ * Does nothing if counters are not enabled.
+ *
+ * Parameters:
+ *   logger - Logger handle
+ *   level  - Event level
+ *   tmpl   - Message template (string literal: keys compare by pointer)
+ *   file   - Call site file (__FILE__)
+ *   line   - Call site line (__LINE__)
+ *
+ * Return: 0 on success, 1 on error (errno is set)
+ */
+int smartlog_logger_count(smartlog_logger_t* logger, log_level_t level, const char* tmpl,
+                          const char* file, int line);
+
+/**
+ * Count one event, then log msg like smartlog_logger_log().
+ *
+ * Return: 0 on success, 1 on error (errno is set)
+ */
+int smartlog_logger_log_counted(smartlog_logger_t* logger, log_level_t level, const char* tmpl,
+                                const char* file, int line, const char* msg);
+
+/**
+ * Write a counter summary now (if any key moved).
+ *
+ * Return: 0 on success, 1 on error (errno is set, ENOTSUP when counters
+ *         are not enabled)
+ */
+int smartlog_logger_snapshot_counters(smartlog_logger_t* logger);
+
+/** Count an event at the current call site */
+#define SMARTLOG_COUNT(logger, level, tmpl) \
+    smartlog_logger_count((logger), (level), (tmpl), __FILE__, __LINE__)
+
+/** Count and log an event at the current call site */
+#define SMARTLOG_LOG_COUNTED(logger, level, tmpl, msg) \
+    smartlog_logger_log_counted((logger), (level), (tmpl), __FILE__, __LINE__, (msg))
+
+/**
+ * Flight recorder mode (see recorder.h): entries below trigger_level are
+ * only kept in memory, in a ring of ring_bytes per thread, overwriting
+ * the oldest. An entry at or above trigger_level first dumps the ring to
+ * every sink (oldest first, through the usual level and filter checks),
+ * then a marker entry at the trigger's level:
+ *   "recorder dump reason=<level|api|signal> lines=<n> lost=<n>"
+ * (lost = entries overwritten since the previous dump), then itself.
+ * Undumped entries are discarded by smartlog_logger_destroy(). Call
+ * before logging starts.
+ *
+ * Parameters:
+ *   logger        - Logger handle
+ *   ring_bytes    - Ring size per logging thread (at least
+ *                   SMARTLOG_RECORDER_MIN_RING)
+ *   trigger_level - Lowest level that is written and dumps the ring
+ *
+ * Return: 0 on success, 1 on error (errno is set)
+ */
+int smartlog_logger_enable_recorder(smartlog_logger_t* logger, size_t ring_bytes, log_level_t trigger_level);
+
+/**
+ * Dump the flight recorder now.
+ *
+ * Return: 0 on success, 1 on error (errno is set, ENOTSUP when the
+ *         recorder is not enabled)
+ */
+int smartlog_logger_dump_recorder(smartlog_logger_t* logger);
+
+/**
+ * Dump the flight recorder whenever signo arrives (e.g. SIGUSR1).
+ *
+ * The handler only writes to an eventfd; a helper thread of this logger
+ * does the dump, so nothing unsafe runs in signal context. The signal's
+ * previous disposition is restored when the last logger waiting on it is
+ * destroyed. At most SMARTLOG_RECORDER_SIGNALS loggers at a time.
+ *
+ * Return: 0 on success, 1 on error (errno is set, ENOTSUP when the
+ *         recorder is not enabled, ENOSPC when too many loggers wait)
+ */
+int smartlog_logger_dump_recorder_on_signal(smartlog_logger_t* logger, int signo);
+
+/**
+ * Format one entry and fan it out to every sink.
+ *
+ * Safe to call from many threads. A failing sink does not stop delivery
+ * to the others. Each entry carries the calling thread's ID, the next
+ * per-logger sequence number (starting at 1) and the thread's context
+ * fields (context.h), see smartlog_format_record_ctx(). Counter summaries,
+ * recorder markers and clock anchors carry no context.
+ *
+ * Parameters:
+ *   logger - Logger handle
+ *   level  - Entry level
+ *   msg    - Log message (max 256 bytes, longer is truncated)
+ *
+ * Return: 0 on success, 1 if any sink failed (errno is set)
+ */
+int smartlog_logger_log(smartlog_logger_t* logger, log_level_t level, const char* msg);
+
+/**
+ * Flush every sink (waits for async queues to drain).
+ *
+ * Return: 0 on success, 1 if any sink failed (errno is set)
+ */
+int smartlog_logger_flush(smartlog_logger_t* logger);
+
+/**
+ * Number of attached sinks.
+ */
+size_t smartlog_logger_sink_count(const smartlog_logger_t* logger);
+
+/**
+ * Borrow an attached sink (for stats). Return: sink or NULL
+ */
+smartlog_sink_t* smartlog_logger_get_sink(const smartlog_logger_t* logger, size_t index);
+
+/**
+ * Write the final counter summary (if enabled), flush and destroy all
+ * sinks, then free the logger. Stops the signal dump thread, if any.
+ */
+void smartlog_logger_destroy(smartlog_logger_t* logger);
+
+#endif /* SMARTLOG_LOGGER_H */
@@ -0,0 +1,149 @@
+/*
+ * include/smartlog/lz4.h
+ *
+ * LZ4 frame encoder and streaming decoder for compressed SmartLog files.
+ *
+ * The encoder writes standard LZ4 frames (readable by `lz4 -dc`) with
+ * 64 KB linked blocks: each block may reference the 64 KB of text before
+ * it, so small blocks cut at every writer batch still compress well.
+ * A block is emitted when 64 KB of text is pending or on flush, so a file
+ * that is still being written is valid up to its last block.
+ *
+ * The decoder takes input in any pieces (e.g. a growing file read as it
+ * is written) and writes each block's text as soon as the block is
+ * complete. It reads any LZ4 frame: linked or independent blocks, block
+ * and content checksums, concatenated and skippable frames.
+ *
+ * Author: Aravinthraj Ganesan
+ * Version: 1.0
+ */
+
+#ifndef SMARTLOG_LZ4_H
+#define SMARTLOG_LZ4_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* ============================================================================
+ * Types
+ * ============================================================================ */
+
+typedef struct smartlog_lz4_encoder smartlog_lz4_encoder_t;
+typedef struct smartlog_lz4_decoder smartlog_lz4_decoder_t;
+
+/* ============================================================================
+ * Encoder Functions
+ * ============================================================================ */
+
+/**
+ * Create an encoder. Call smartlog_lz4_encoder_begin() to start a frame.
+ *
+ * Return: New encoder, or NULL on error (errno is set)
+ */
+smartlog_lz4_encoder_t* smartlog_lz4_encoder_create(void);
+
+/**
+ * Start a new frame: forget the window and queue the frame header.
+ *
+ * Return: 0 on success, 1 on error (errno is set)
+ */
+int smartlog_lz4_encoder_begin(smartlog_lz4_encoder_t* enc);
+
+/**
+ * Add text to the current frame. Every full 64 KB is compressed into a
+ * block and queued as output.
+ *
+ * Return: 0 on success, 1 on error (errno is set)
+ */
+int smartlog_lz4_encoder_write(smartlog_lz4_encoder_t* enc, const void* data, size_t len);
+
+/**
+ * Compress the pending text (if any) into a block and queue it.
+ *
+ * Return: 0 on success, 1 on error (errno is set)
+ */
+int smartlog_lz4_encoder_flush(smartlog_lz4_encoder_t* enc);
+
+/**
+ * Flush and queue the end mark. The next frame needs a new begin.
+ *
+ * Return: 0 on success, 1 on error (errno is set)
+ */
+int smartlog_lz4_encoder_end(smartlog_lz4_encoder_t* enc);
+
+/**
+ * Queued output (frame header, blocks, end mark) not yet taken.
+ *
+ * Parameters:
+ *   enc - Encoder
+ *   len - Output: queued bytes
+ *
+ * Return: Pointer to the queued bytes, valid until the next encoder call
+ */
+const void* smartlog_lz4_encoder_output(const smartlog_lz4_encoder_t* enc, size_t* len);
+
+/**
+ * Drop the first n queued output bytes (after the caller wrote them).
+ */
+void smartlog_lz4_encoder_consume(smartlog_lz4_encoder_t* enc, size_t n);
+
+/**
+ * Text added to the current frame but not yet in a block.
+ */
+size_t smartlog_lz4_encoder_pending(const smartlog_lz4_encoder_t* enc);
+
+/**
+ * Free the encoder (queued output is lost).
+ */
+void smartlog_lz4_encoder_destroy(smartlog_lz4_encoder_t* enc);
+
+/* ============================================================================
+ * Decoder Functions
+ * ============================================================================ */
+
+/**
+ * Create a streaming decoder.
+ *
+ * Return: New decoder, or NULL on error (errno is set)
+ */
+smartlog_lz4_decoder_t* smartlog_lz4_decoder_create(void);
+
+/**
+ * Decode the next piece of input and write the text of every block it
+ * completes to out_fd. An incomplete header or block is kept for the
+ * next call.
+ *
+ * Parameters:
+ *   dec    - Decoder
+ *   data   - Next input bytes
+ *   len    - Number of input bytes
+ *   out_fd - Where decoded text is written
+ *
+ * Return: 0 on success, 1 on error (errno is set, EBADMSG for input that
+ *         is not a valid LZ4 frame; the decoder is then unusable)
+ */
+int smartlog_lz4_decoder_feed(smartlog_lz4_decoder_t* dec, const void* data, size_t len, int out_fd);
+
+/**
+ * Input bytes held back because their header or block is incomplete.
+ * 0 means the input so far ends at a block or frame boundary.
+ */
+size_t smartlog_lz4_decoder_pending(const smartlog_lz4_decoder_t* dec);
+
+/**
+ * Free the decoder.
+ */
+void smartlog_lz4_decoder_destroy(smartlog_lz4_decoder_t* dec);
+
+/**
+ * Decode a whole LZ4 file to out_fd.
+ *
+ * A file that is still being written (no end mark yet) decodes up to its
+ * last complete block.
+ *
+ * Return: 0 on success, 1 on error (errno is set, EBADMSG for a damaged
+ *         file, including one cut inside a block)
+ */
+int smartlog_lz4_decode_file(const char* path, int out_fd);
+
+#endif /* SMARTLOG_LZ4_H */
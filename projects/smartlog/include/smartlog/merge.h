@@ -0,0 +1,55 @@
+/*
+ * include/smartlog/merge.h
+ *
+ * Global ordering merge of SmartLog files (used by the smartlog_merge tool).
+ *
+ * Merges many log files into one stream ordered by timestamp:
+ *   - Each input path is read together with its rotated generations,
+ *     oldest first (<path>.N ... <path>.1, <path>)
+ *   - A min-heap holds one line per input, so memory is bounded by the
+ *     number of inputs, not by file size
+ *   - Ties on the timestamp are broken by the "[SEQ = ]" field, then by
+ *     input order
+ *   - A line whose timestamp is older than the previous line of the same
+ *     input keeps that input's order (clocks can step back across cores)
+ *
+ * Author: Aravinthraj Ganesan
+ * Version: 1.0
+ */
+
+#ifndef SMARTLOG_MERGE_H
+#define SMARTLOG_MERGE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* ============================================================================
+ * Types
+ * ============================================================================ */
+
+typedef struct {
+    uint64_t inputs;    /* Input paths (each with its generations) */
+    uint64_t files;     /* Files opened, generations included */
+    uint64_t lines;     /* Lines written */
+    uint64_t untimed;   /* Lines without a "[<ns> ns]" prefix */
+} smartlog_merge_stats_t;
+
+/* ============================================================================
+ * Merge Functions
+ * ============================================================================ */
+
+/**
+ * Merge log files into one ordered stream.
+ *
+ * Parameters:
+ *   paths  - Input log paths (rotated <path>.N files are found automatically)
+ *   npaths - Number of input paths
+ *   out_fd - Where merged lines are written
+ *   stats  - Optional counters (may be NULL)
+ *
+ * Return: 0 on success, 1 on error (errno is set). A path with neither a
+ *         file nor any generation fails with ENOENT.
+ */
+int smartlog_merge_files(const char* const* paths, size_t npaths, int out_fd, smartlog_merge_stats_t* stats);
+
+#endif /* SMARTLOG_MERGE_H */
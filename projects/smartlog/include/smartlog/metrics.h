@@ -0,0 +1,149 @@
+/*
+ * include/smartlog/metrics.h
+ *
+ * Prometheus text exporter for SmartLog statistics.
+ *
+ * Serves the Prometheus text format (version 0.0.4) on a local Unix
+ * socket and/or a loopback TCP port:
+ *   - Per sink of every registered logger: lines, bytes, filtered,
+ *     dropped, spilled, errors, writer wakeups and the durable sync
+ *     latency histogram (smartlog_sink_* families, labels logger, sink)
+ *   - Anything else through source callbacks, e.g. a supervisor's
+ *     counters
+ *
+ * Rendering copies every counter first (atomic loads only, no sink or
+ * logger lock), then formats the copies, so a scrape never waits on or
+ * delays the log path.
+ *
+ * A client that starts with "GET " gets an HTTP/1.0 response, so a
+ * Prometheus server (or curl) can scrape the TCP port directly; any other
+ * client just gets the text, e.g. `socat - UNIX-CONNECT:<path>`.
+ *
+ * Author: Aravinthraj Ganesan
+ * Version: 1.0
+ */
+
+#ifndef SMARTLOG_METRICS_H
+#define SMARTLOG_METRICS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <smartlog/logger.h>
+
+/* ============================================================================
+ * Types
+ * ============================================================================ */
+
+typedef struct smartlog_metrics smartlog_metrics_t;
+
+/** Text being rendered, appended to with smartlog_metrics_printf() */
+typedef struct smartlog_metrics_buf smartlog_metrics_buf_t;
+
+/**
+ * Source callback: append complete metric families (HELP, TYPE, samples).
+ * Runs on the serving thread; it should read snapshot copies, not locks
+ * held by a hot path.
+ */
+typedef void (*smartlog_metrics_fn)(smartlog_metrics_buf_t* out, void* arg);
+
+/* ============================================================================
+ * Exporter Functions
+ * ============================================================================ */
+
+/**
+ * Create an exporter with nothing registered and no socket.
+ *
+ * Return: New exporter, or NULL on error (errno is set)
+ */
+smartlog_metrics_t* smartlog_metrics_create(void);
+
+/**
+ * Export the sinks of a logger. The logger must outlive the exporter (or
+ * at least its last scrape).
+ *
+ * Parameters:
+ *   metrics - Exporter
+ *   name    - Value of the logger="..." label (copied)
+ *   logger  - Logger to read
+ *
+ * Return: 0 on success, 1 on error (errno is set, ENOSPC when
+ *         SMARTLOG_METRICS_MAX_SOURCES is reached)
+ */
+int smartlog_metrics_add_logger(smartlog_metrics_t* metrics, const char* name, const smartlog_logger_t* logger);
+
+/**
+ * Add a source callback, rendered after the loggers in the order added.
+ *
+ * Return: 0 on success, 1 on error (errno is set, ENOSPC when
+ *         SMARTLOG_METRICS_MAX_SOURCES is reached)
+ */
+int smartlog_metrics_add_source(smartlog_metrics_t* metrics, smartlog_metrics_fn fn, void* arg);
+
+/**
+ * Append formatted text to a render buffer (for source callbacks).
+ *
+ * Return: 0 on success, -1 when out of memory (the scrape then fails)
+ */
+int smartlog_metrics_printf(smartlog_metrics_buf_t* out, const char* fmt, ...)
+    __attribute__((format(printf, 2, 3)));
+
+/**
+ * Render everything now.
+ *
+ * Parameters:
+ *   metrics - Exporter
+ *   text    - Output: text to free() (not terminated by the length)
+ *   len     - Output: text bytes
+ *
+ * Return: 0 on success, 1 on error (errno is set)
+ */
+int smartlog_metrics_render(smartlog_metrics_t* metrics, char** text, size_t* len);
+
+/**
+ * Listen on a Unix stream socket. A stale socket file is replaced; the
+ * file is removed by smartlog_metrics_destroy().
+ *
+ * Return: 0 on success, 1 on error (errno is set)
+ */
+int smartlog_metrics_listen_unix(smartlog_metrics_t* metrics, const char* path);
+
+/**
+ * Listen on 127.0.0.1 (never on other addresses).
+ *
+ * Parameters:
+ *   metrics - Exporter
+ *   port    - TCP port (0 = any free port, see smartlog_metrics_tcp_port())
+ *
+ * Return: 0 on success, 1 on error (errno is set)
+ */
+int smartlog_metrics_listen_tcp(smartlog_metrics_t* metrics, uint16_t port);
+
+/**
+ * Port the TCP listener is bound to. Return: port, or 0 if not listening
+ */
+uint16_t smartlog_metrics_tcp_port(const smartlog_metrics_t* metrics);
+
+/**
+ * Wait up to timeout_ms for clients and answer every pending one. Each
+ * client gets at most SMARTLOG_METRICS_IO_MS to send its request and to
+ * read the answer. For callers with their own loop.
+ *
+ * Return: 0 on success, timeout or signal, 1 on error (errno is set)
+ */
+int smartlog_metrics_serve(smartlog_metrics_t* metrics, int timeout_ms);
+
+/**
+ * Serve from a background thread until smartlog_metrics_destroy().
+ *
+ * Return: 0 on success, 1 on error (errno is set)
+ */
+int smartlog_metrics_start(smartlog_metrics_t* metrics);
+
+/**
+ * Stop the thread, close the sockets, remove the Unix socket file and
+ * free the exporter.
+ */
+void smartlog_metrics_destroy(smartlog_metrics_t* metrics);
+
+#endif /* SMARTLOG_METRICS_H */
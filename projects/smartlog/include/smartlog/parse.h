@@ -0,0 +1,81 @@
+/*
+ * include/smartlog/parse.h
+ *
+ * Parallel parser for SmartLog files, producing columnar arrays.
+ *
+ * Parses lines of the form
+ *   [<ns> ns] [PID = <pid>] [TID = <tid>] [SEQ = <seq>] [MESSAGE = <msg>]
+ * (TID and SEQ are optional, as in smartlog_write_log_entry() lines) into
+ * one array per field, for analytics that should not re-parse text:
+ *   - The file is mmap'ed and cut into chunks at newline boundaries
+ *   - Each chunk is handled by its own thread: first a vectorized (SSE2)
+ *     newline count to place its rows, then the field parse
+ *   - Messages are not copied: each row has an offset and a length into
+ *     the mapped file
+ *
+ * A line that does not start with "[<ns> ns]" (e.g. the continuation of a
+ * multi-line message) is kept as a row with time_ns 0, pid and tid -1,
+ * seq 0 and the whole line as its message, and is counted as untimed.
+ *
+ * Author: Aravinthraj Ganesan
+ * Version: 1.0
+ */
+
+#ifndef SMARTLOG_PARSE_H
+#define SMARTLOG_PARSE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* ============================================================================
+ * Types
+ * ============================================================================ */
+
+/** Parsed lines, one entry per line in every array */
+typedef struct {
+    size_t rows;            /* Lines parsed */
+    uint64_t* time_ns;      /* Timestamp (0 if untimed) */
+    int32_t* pid;           /* Process ID (-1 if absent) */
+    int32_t* tid;           /* Thread ID (-1 if absent) */
+    uint64_t* seq;          /* Sequence number (0 if absent) */
+    uint64_t* msg_offset;   /* Message start, from the start of the data */
+    uint32_t* msg_len;      /* Message bytes (without the closing ']') */
+    uint64_t untimed;       /* Rows without a "[<ns> ns]" prefix */
+
+    const char* data;       /* Parsed bytes (message text lives here) */
+    size_t size;            /* Bytes in data */
+    void* mapping;          /* Set by smartlog_parse_file() (internal) */
+} smartlog_columns_t;
+
+/* ============================================================================
+ * Parse Functions
+ * ============================================================================ */
+
+/**
+ * Map and parse a log file.
+ *
+ * Parameters:
+ *   path    - Log file
+ *   threads - Parser threads (0 = online CPUs); chunks are at least
+ *             SMARTLOG_PARSE_CHUNK_MIN bytes, so small files use fewer
+ *   out     - Columns; the file stays mapped until smartlog_columns_free()
+ *
+ * Return: 0 on success, 1 on error (errno is set)
+ */
+int smartlog_parse_file(const char* path, unsigned int threads, smartlog_columns_t* out);
+
+/**
+ * Parse log text already in memory.
+ *
+ * The columns point into data, which must outlive them.
+ *
+ * Return: 0 on success, 1 on error (errno is set)
+ */
+int smartlog_parse_buffer(const char* data, size_t size, unsigned int threads, smartlog_columns_t* out);
+
+/**
+ * Free the arrays (and the mapping of smartlog_parse_file()).
+ */
+void smartlog_columns_free(smartlog_columns_t* cols);
+
+#endif /* SMARTLOG_PARSE_H */
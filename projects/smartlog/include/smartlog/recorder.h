@@ -0,0 +1,105 @@
+/*
+ * include/smartlog/recorder.h
+ *
+ * Flight recorder: the most recent records, kept in memory only.
+ *
+ * Each thread appends its formatted records to its own fixed-size ring;
+ * once full, the oldest records are overwritten. Nothing reaches a sink
+ * until a dump, which:
+ *   - Takes every thread's ring (each under its own, otherwise
+ *     uncontended, mutex) and empties it
+ *   - Hands the records back in sequence order, oldest first
+ *
+ * So verbose diagnostics cost a memcpy per record until something goes
+ * wrong. Memory use is ring_bytes per thread recording at the same time:
+ * a thread's ring is kept (and dumped) after the thread exits, and the
+ * next new thread records into it.
+ *
+ * The logger uses this for smartlog_logger_enable_recorder() (logger.h).
+ *
+ * Author: Aravinthraj Ganesan
+ * Version: 1.0
+ */
+
+#ifndef SMARTLOG_RECORDER_H
+#define SMARTLOG_RECORDER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <smartlog/sink.h>
+
+/* ============================================================================
+ * Types
+ * ============================================================================ */
+
+typedef struct smartlog_recorder smartlog_recorder_t;
+
+typedef struct {
+    uint64_t recorded;      /* Records appended */
+    uint64_t overwritten;   /* Records lost to newer ones before a dump */
+    uint64_t dumped;        /* Records handed out by dumps */
+    uint64_t dumps;         /* Dumps done */
+    uint64_t rings;         /* Thread rings allocated (exited threads' are reused) */
+} smartlog_recorder_stats_t;
+
+/**
+ * Dump callback, once per record in sequence order. record->msg points
+ * to the message as it appears in the line (possibly truncated) and
+ * record->line to the full line; both are valid only during the call.
+ *
+ * Return: 0 on success, non-zero on error (the dump goes on)
+ */
+typedef int (*smartlog_recorder_fn)(const smartlog_record_t* record, void* arg);
+
+/* ============================================================================
+ * Recorder Functions
+ * ============================================================================ */
+
+/**
+ * Create a recorder.
+ *
+ * Parameters:
+ *   ring_bytes - Ring size per thread (at least SMARTLOG_RECORDER_MIN_RING)
+ *
+ * Return: New recorder, or NULL on error (errno is set)
+ */
+smartlog_recorder_t* smartlog_recorder_create(size_t ring_bytes);
+
+/**
+ * Append a record to the calling thread's ring. Copies record->line and
+ * the header fields; record->msg is not used.
+ *
+ * The first record of a thread takes the ring of an exited thread, or
+ * allocates one.
+ *
+ * Return: 0 on success, 1 on error (errno is set)
+ */
+int smartlog_recorder_add(smartlog_recorder_t* recorder, const smartlog_record_t* record);
+
+/**
+ * Empty every ring and pass the records to fn in sequence order. Safe to
+ * call while other threads record; records added during the dump stay for
+ * the next one. When every ring is empty, returns at once without
+ * allocating.
+ *
+ * Parameters:
+ *   recorder - Recorder
+ *   fn       - Callback per record
+ *   arg      - Passed to fn
+ *   count    - Optional output: records passed to fn (may be NULL)
+ *
+ * Return: 0 on success, 1 on error or if fn failed (errno is set)
+ */
+int smartlog_recorder_dump(smartlog_recorder_t* recorder, smartlog_recorder_fn fn, void* arg, size_t* count);
+
+/** Copy the recorder counters */
+void smartlog_recorder_get_stats(smartlog_recorder_t* recorder, smartlog_recorder_stats_t* out);
+
+/**
+ * Free the recorder and every ring (undumped records are discarded). No
+ * thread may record into it any more, nor be exiting while it is freed.
+ */
+void smartlog_recorder_destroy(smartlog_recorder_t* recorder);
+
+#endif /* SMARTLOG_RECORDER_H */
@@ -0,0 +1,121 @@
+/*
+ * include/smartlog/shm_ring.h
+ *
+ * Shared-memory SPSC ring between one client process and the collector.
+ *
+ * The client creates a memfd-backed ring plus an eventfd and hands both to
+ * the collector over a Unix SOCK_SEQPACKET control socket (SCM_RIGHTS):
+ *   - Client push is a memcpy and a release store; no syscall
+ *   - The collector sets a "waiting" flag only before it goes idle; the
+ *     client writes the eventfd only when that flag is set
+ *   - A full ring drops the line and counts it (the client never blocks)
+ *
+ * Record layout in the data area: 8-byte header (length) + payload padded to
+ * 8 bytes. A record never wraps; a pad marker fills the tail end instead.
+ *
+ * Author: Aravinthraj Ganesan
+ * Version: 1.0
+ */
+
+#ifndef SMARTLOG_SHM_RING_H
+#define SMARTLOG_SHM_RING_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+typedef struct smartlog_shm_ring smartlog_shm_ring_t;
+
+/* ============================================================================
+ * Producer (Client) Side
+ * ============================================================================ */
+
+/**
+ * Create a ring and register it with a collector.
+ *
+ * Parameters:
+ *   control_path - Collector ring control socket (SOCK_SEQPACKET)
+ *   capacity     - Data area size in bytes, power of two
+ *                  (0 = SMARTLOG_SHM_RING_DEFAULT)
+ *
+ * Return: New ring, or NULL on error (errno is set; ECONNREFUSED or ENOENT
+ *         when no collector is listening)
+ */
+smartlog_shm_ring_t* smartlog_shm_ring_connect(const char* control_path, size_t capacity);
+
+/**
+ * Append one record. Single producer only: callers serialize.
+ *
+ * Return: 0 on success, -1 on error (EAGAIN when full, EMSGSIZE when the
+ *         record can never fit)
+ */
+int smartlog_shm_ring_push(smartlog_shm_ring_t* ring, const void* data, size_t len);
+
+/* ============================================================================
+ * Consumer (Collector) Side
+ * ============================================================================ */
+
+/**
+ * Accept one client connection on a listening control socket.
+ *
+ * Never waits for the client's hello: the caller keeps the connection in
+ * its poll set and calls smartlog_shm_ring_attach() once it is readable.
+ *
+ * Parameters:
+ *   listen_fd - Listening SOCK_SEQPACKET socket (non-blocking)
+ *
+ * Return: Connection fd (non-blocking; hangup = client gone), or -1 on
+ *         error (errno is set; EAGAIN when nothing is pending)
+ */
+int smartlog_shm_ring_accept(int listen_fd);
+
+/**
+ * Finish a client registration on an accepted connection.
+ *
+ * Receives the memfd and eventfd with one non-blocking read, then checks
+ * the seals, maps and validates the ring. conn_fd stays owned by the caller.
+ *
+ * Parameters:
+ *   conn_fd - Connection from smartlog_shm_ring_accept()
+ *
+ * Return: Attached ring, or NULL on error (errno is set; EAGAIN when the
+ *         hello has not arrived yet, anything else means drop the client)
+ */
+smartlog_shm_ring_t* smartlog_shm_ring_attach(int conn_fd);
+
+/**
+ * Copy the next record out.
+ *
+ * Return: record length, 0 when empty, -1 on error (errno is set; EPROTO if
+ *         the shared header is corrupt, EMSGSIZE if the record was skipped
+ *         because buf is too small)
+ */
+ssize_t smartlog_shm_ring_pop(smartlog_shm_ring_t* ring, void* buf, size_t buf_sz);
+
+/**
+ * Announce that the consumer is about to sleep on the eventfd.
+ *
+ * Return: 0 if it is safe to sleep, 1 if data arrived meanwhile (the flag
+ *         is cleared again and the caller should keep draining)
+ */
+int smartlog_shm_ring_prepare_wait(smartlog_shm_ring_t* ring);
+
+/**
+ * Clear the waiting flag and reset the eventfd after waking up.
+ */
+void smartlog_shm_ring_finish_wait(smartlog_shm_ring_t* ring);
+
+/* ============================================================================
+ * Common
+ * ============================================================================ */
+
+/** Eventfd the consumer polls on. */
+int smartlog_shm_ring_eventfd(const smartlog_shm_ring_t* ring);
+
+/** Records the producer dropped because the ring was full. */
+uint64_t smartlog_shm_ring_dropped(const smartlog_shm_ring_t* ring);
+
+/** Unmap and close everything owned by this side. */
+void smartlog_shm_ring_destroy(smartlog_shm_ring_t* ring);
+
+#endif /* SMARTLOG_SHM_RING_H */
@@ -0,0 +1,386 @@
+/*
+ * include/smartlog/sink.h
+ *
+ * Output sinks for the SmartLog logger.
+ *
+ * A sink is one destination for formatted log lines. Provides:
+ *   - Generic sink object built from a small ops table
+ *   - Per-sink level and callback filters
+ *   - Optional async mode: the sink drains its own queue on its own
+ *     thread, so a slow destination cannot stall the other sinks
+ *   - Per-sink counters
+ *   - Built-in file, LZ4 file, circular file, Unix socket and
+ *     shared-memory ring sinks
+ *
+ * Author: Aravinthraj Ganesan
+ * Version: 1.0
+ */
+
+#ifndef SMARTLOG_SINK_H
+#define SMARTLOG_SINK_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+
+#include <smartlog/config.h>
+
+/* ============================================================================
+ * Types
+ * ============================================================================ */
+
+/** One log entry, formatted once by the logger and shared by all sinks. */
+typedef struct {
+    log_level_t level;      /* Entry level */
+    uint64_t time_ns;       /* Entry timestamp */
+    pid_t pid;              /* Writer process ID */
+    pid_t tid;              /* Writer kernel thread ID */
+    uint64_t seq;           /* Per-logger sequence number (from 1) */
+    const char* msg;        /* Original message (not truncated) */
+    const char* line;       /* Formatted line, ends with '\n' */
+    size_t line_len;        /* Formatted line length */
+} smartlog_record_t;
+
+/**
+ * Filter callback.
+ *
+ * Return: non-zero to keep the record, 0 to skip it for this sink
+ */
+typedef int (*smartlog_filter_fn)(const smartlog_record_t* record, void* arg);
+
+/**
+ * Sink operations.
+ *
+ * write is required. writev, flush and close are optional. When writev is
+ * set, the async writer hands over whole batches with one call; each iovec
+ * is exactly one formatted line.
+ *
+ * write/flush return 0 on success, -1 on error (errno is set).
+ * writev returns how many lines the destination accepted (0..iovcnt); the
+ * rest are counted as dropped. It returns -1 on error (errno is set).
+ *
+ * crash_fd is optional: it returns the descriptor that crash-time flush
+ * (crash.h) writes raw lines to, or -1. It runs in a signal handler, so it
+ * must not lock or allocate.
+ *
+ * sync_stats is optional: it copies the destination's sync latency
+ * histogram for smartlog_sink_get_stats(). It may run on any thread while
+ * lines are written, so it must only read atomics.
+ */
+typedef struct smartlog_sync_stats smartlog_sync_stats_t;
+
+typedef struct {
+    int  (*write)(void* ctx, const char* data, size_t len);
+    int  (*writev)(void* ctx, const struct iovec* iov, int iovcnt);
+    int  (*flush)(void* ctx);
+    void (*close)(void* ctx);
+    int  (*crash_fd)(void* ctx);
+    void (*sync_stats)(void* ctx, smartlog_sync_stats_t* out);
+} smartlog_sink_ops_t;
+
+/** Upper bounds of the sync latency buckets, in microseconds */
+#define SMARTLOG_SYNC_BUCKET_US { 50, 100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000, 100000, 250000 }
+
+/**
+ * Sync (fdatasync) latency histogram. buckets[i] counts syncs that took
+ * at most bound i (and more than bound i - 1); slower ones are only in
+ * count.
+ */
+struct smartlog_sync_stats {
+    uint64_t count;                         /* Syncs done */
+    uint64_t sum_ns;                        /* Total time spent in them */
+    uint64_t buckets[SMARTLOG_SYNC_BUCKETS];
+};
+
+/** Per-sink counters. */
+typedef struct {
+    uint64_t records;       /* Lines accepted by the destination */
+    uint64_t bytes;         /* Bytes accepted by the destination */
+    uint64_t filtered;      /* Lines skipped by level or filter */
+    uint64_t dropped;       /* Lines lost: queue full or destination away */
+    uint64_t spilled;       /* Lines that went through the spill file */
+    uint64_t errors;        /* Failed write/flush calls */
+    uint64_t wakeups;       /* futex_wake calls for an idle writer (async) */
+    uint64_t affinity_mask; /* Writer pinned to these CPUs (bit n = CPU n < 64, 0 = not pinned) */
+    int writer_cpu;         /* CPU the writer last ran a batch on (-1 = none yet) */
+    int numa_node;          /* Node the queue was placed on (-1 = first touch) */
+    page_kind_t queue_pages;/* Page kind backing the async queue */
+    smartlog_sync_stats_t sync; /* Durable syncs (all 0 if the sink has none) */
+} smartlog_sink_stats_t;
+
+typedef struct smartlog_sink smartlog_sink_t;
+
+/* ============================================================================
+ * Generic Sink Functions
+ * ============================================================================ */
+
+/**
+ * Create a sink from an ops table.
+ *
+ * Parameters:
+ *   ops - Sink operations (must stay valid for the sink lifetime)
+ *   ctx - Opaque pointer passed to every op
+ *
+ * Return: New sink, or NULL on error (errno is set)
+ */
+smartlog_sink_t* smartlog_sink_create(const smartlog_sink_ops_t* ops, void* ctx);
+
+/**
+ * Drop records below a level. Default is LOG_LEVEL_DEBUG (keep all).
+ *
+ * Return: 0 on success, 1 on error (errno is set)
+ */
+int smartlog_sink_set_level(smartlog_sink_t* sink, log_level_t min_level);
+
+/**
+ * Install a filter callback, run after the level check.
+ *
+ * Return: 0 on success, 1 on error (errno is set)
+ */
+int smartlog_sink_set_filter(smartlog_sink_t* sink, smartlog_filter_fn filter, void* arg);
+
+/**
+ * Give the sink its own queue and writer thread.
+ *
+ * Must be called before the sink receives records. The caller thread only
+ * copies the line into the queue; the writer thread hands batches of up to
+ * SMARTLOG_WRITER_BATCH lines to the sink.
+ *
+ * The queue is lock-free; an idle writer spins for the sink's spin time
+ * (see smartlog_sink_set_spin()) and then sleeps in futex_wait.
+ *
+ * Parameters:
+ *   sink     - Sink to switch to async mode
+ *   capacity - Queue depth in records, rounded up to a power of two
+ *              (0 = SMARTLOG_QUEUE_DEFAULT_CAP)
+ *   policy   - What to do when the queue is full. OVERFLOW_SPILL never
+ *              blocks the caller and loses nothing: overflow goes to a
+ *              temporary file (see smartlog_sink_set_spill_dir()) and is
+ *              replayed in order once the writer has caught up
+ *
+ * Return: 0 on success, 1 on error (errno is set)
+ */
+int smartlog_sink_set_async(smartlog_sink_t* sink, size_t capacity, overflow_policy_t policy);
+
+/**
+ * Directory for the OVERFLOW_SPILL temporary file (call before
+ * smartlog_sink_set_async()). Default is SMARTLOG_SPILL_DIR. Use a local
+ * disk; the file is unnamed and disappears with the sink.
+ *
+ * Return: 0 on success, 1 on error (errno is set)
+ */
+int smartlog_sink_set_spill_dir(smartlog_sink_t* sink, const char* dir);
+
+/**
+ * Set how long an idle async writer spins before it sleeps.
+ *
+ * Spinning keeps wakeup latency low and saves producers the futex_wake
+ * syscall while traffic is steady; sleeping frees the core when traffic
+ * stops. Default is SMARTLOG_WRITER_SPIN_US, or 0 on a single-CPU system.
+ * Can be changed at any time.
+ *
+ * Parameters:
+ *   sink    - Sink handle
+ *   spin_us - Spin time in microseconds (0 = sleep at once)
+ *
+ * Return: 0 on success, 1 on error (errno is set)
+ */
+int smartlog_sink_set_spin(smartlog_sink_t* sink, unsigned int spin_us);
+
+/**
+ * Back the async queue with huge pages (call before smartlog_sink_set_async()).
+ *
+ * For large queues (burst absorption) this cuts TLB misses while the writer
+ * drains. Tries reserved huge pages, then transparent huge pages, then
+ * falls back to regular pages; queue_pages in the stats says which.
+ * Queues smaller than SMARTLOG_HUGE_PAGE_SZ always use regular pages.
+ *
+ * Return: 0 on success, 1 on error (errno is set, EINVAL if already async)
+ */
+int smartlog_sink_set_huge_pages(smartlog_sink_t* sink, feature_state_t huge_pages);
+
+/**
+ * Pin the async writer thread to a set of CPUs.
+ *
+ * Call before smartlog_sink_set_async() to also place the queue on the NUMA
+ * node of the lowest listed CPU (mbind before first touch), so the writer
+ * drains node-local memory. Called later, only the thread is moved.
+ *
+ * Parameters:
+ *   sink  - Sink handle
+ *   cpus  - CPU numbers
+ *   ncpus - Number of CPUs (0 = remove pinning)
+ *
+ * Return: 0 on success, 1 on error (errno is set)
+ */
+int smartlog_sink_set_affinity(smartlog_sink_t* sink, const int* cpus, size_t ncpus);
+
+/**
+ * Deliver one record to the sink (filters, then write or enqueue).
+ *
+ * Safe to call from many threads.
+ *
+ * Return: 0 on success or filtered, 1 on error (errno is set)
+ */
+int smartlog_sink_submit(smartlog_sink_t* sink, const smartlog_record_t* record);
+
+/**
+ * Deliver already formatted lines, bypassing level and filter checks.
+ *
+ * Used by relays such as the collector that receive finished lines. Direct
+ * sinks get the whole array in one writev op call (one durable sync for the
+ * batch); async sinks enqueue each line.
+ *
+ * Parameters:
+ *   sink   - Destination sink
+ *   iov    - One iovec per line
+ *   iovcnt - Number of lines
+ *
+ * Return: 0 on success, 1 on error (errno is set)
+ */
+int smartlog_sink_write_lines(smartlog_sink_t* sink, const struct iovec* iov, int iovcnt);
+
+/**
+ * Flush the sink. For async sinks, waits until the queue is drained.
+ *
+ * Return: 0 on success, 1 on error (errno is set)
+ */
+int smartlog_sink_flush(smartlog_sink_t* sink);
+
+/**
+ * Write every line still queued (and spilled) to the sink's crash_fd.
+ *
+ * Async-signal-safe: only atomic loads, pread() and write(); no lock is
+ * taken and nothing is released, so the writer thread is not disturbed.
+ * Called by the crash handler (crash.h).
+ *
+ * Return: Number of lines written
+ */
+size_t smartlog_sink_crash_drain(smartlog_sink_t* sink);
+
+/**
+ * Copy current counters.
+ */
+void smartlog_sink_get_stats(smartlog_sink_t* sink, smartlog_sink_stats_t* out);
+
+/**
+ * Drain, stop the writer thread, close and free the sink.
+ */
+void smartlog_sink_destroy(smartlog_sink_t* sink);
+
+/* ============================================================================
+ * Built-in Sinks
+ * ============================================================================ */
+
+/**
+ * Open a file sink.
+ *
+ * The file is kept open between writes (O_APPEND). Batches are written with
+ * one writev() call.
+ *
+ * Parameters:
+ *   file_path        - Path to log file
+ *   durable          - If on, fdatasync after every write/batch
+ *   max_bytes_config - If on, rotate to "<file>.1" when too big
+ *   max_byte_val     - Max size before rotation
+ *
+ * Return: New sink, or NULL on error (errno is set)
+ */
+smartlog_sink_t* smartlog_sink_file_open(
+    const char* file_path,
+    feature_state_t durable,
+    feature_state_t max_bytes_config,
+    unsigned long max_byte_val
+);
+
+/**
+ * Open an LZ4-compressed file sink.
+ *
+ * Like smartlog_sink_file_open(), but the file is a stream of LZ4 frames
+ * (see lz4.h; `lz4 -dc` reads it). Lines are compressed by whoever calls
+ * the sink, so use it in async mode: the writer thread compresses and
+ * writes a block at the end of every batch, and the live file is always
+ * valid up to the last block. In direct mode, text stays in memory until
+ * smartlog_sink_flush().
+ *
+ * Reopening a file appends a new frame. Rotation happens once the
+ * compressed file has reached max_byte_val, after its frame is closed.
+ * There is no crash-time flush for this sink.
+ *
+ * Parameters:
+ *   file_path        - Path to log file (e.g. "app.log.lz4")
+ *   durable          - If on, fdatasync after every flushed block
+ *   max_bytes_config - If on, rotate to "<file>.1" when too big
+ *   max_byte_val     - Max compressed size before rotation
+ *
+ * Return: New sink, or NULL on error (errno is set)
+ */
+smartlog_sink_t* smartlog_sink_lz4_open(
+    const char* file_path,
+    feature_state_t durable,
+    feature_state_t max_bytes_config,
+    unsigned long max_byte_val
+);
+
+/**
+ * Open a circular file sink, an alternative to rotation.
+ *
+ * Lines are records of a preallocated file of fixed size that overwrites
+ * its oldest records (see circfile.h; smartlog_circ unrolls it). Disk use
+ * is bounded and the file is never renamed or unlinked. An existing
+ * circular file of the same capacity is continued. There is no crash-time
+ * flush for this sink.
+ *
+ * Parameters:
+ *   file_path - Path to the circular file
+ *   capacity  - Data area bytes (multiple of 8, at least
+ *               SMARTLOG_CIRC_MIN_BYTES)
+ *   durable   - If on, msync after every write/batch
+ *
+ * Return: New sink, or NULL on error (errno is set)
+ */
+smartlog_sink_t* smartlog_sink_circ_open(const char* file_path, size_t capacity, feature_state_t durable);
+
+/**
+ * Open a Unix domain socket sink for a local collector.
+ *
+ * The sink is always async with OVERFLOW_DROP, so the caller never waits on
+ * the collector. The writer thread sends each batch with one sendmmsg();
+ * every line is one datagram/packet.
+ *
+ * The socket is non-blocking. While the collector is away (not started,
+ * restarting, or its buffer is full) lines are dropped and counted, and a
+ * reconnect is tried at most every SMARTLOG_RECONNECT_MS.
+ *
+ * Parameters:
+ *   socket_path    - Collector socket path
+ *   sock_type      - SOCK_DGRAM or SOCK_SEQPACKET
+ *   queue_capacity - Async queue depth (0 = SMARTLOG_QUEUE_DEFAULT_CAP)
+ *
+ * Return: New sink, or NULL on error (errno is set). A collector that is
+ *         not running yet is not an error.
+ */
+smartlog_sink_t* smartlog_sink_unix_open(
+    const char* socket_path,
+    int sock_type,
+    size_t queue_capacity
+);
+
+/**
+ * Open a shared-memory ring sink for a local collector.
+ *
+ * Creates a memfd-backed ring and registers it with the collector's ring
+ * control socket. Logging is a memcpy into the ring; the collector is woken
+ * through an eventfd only when it is idle. A full ring drops the line and
+ * counts it. Use in direct mode (do not call smartlog_sink_set_async()).
+ *
+ * Parameters:
+ *   control_path - Collector ring control socket (smartlogd --ring-socket)
+ *   ring_bytes   - Ring size, power of two (0 = SMARTLOG_SHM_RING_DEFAULT)
+ *
+ * Return: New sink, or NULL on error (errno is set)
+ */
+smartlog_sink_t* smartlog_sink_shm_open(const char* control_path, size_t ring_bytes);
+
+#endif /* SMARTLOG_SINK_H */
@@ -18,6 +18,10 @@
 #ifndef SMARTLOG_CORE_H
 #define SMARTLOG_CORE_H
 
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
 #include <smartlog/config.h>
 
 /* ============================================================================
@@ -41,6 +45,9 @@
  *   - Rotate file if it is too big
  *   - Write message with timestamp and process ID
  *   - Sync to disk if durable mode is on
+ *
+ * With smartlog_fd_cache_enable() (fd_cache.h) the file stays open across
+ * calls instead of being opened and closed each time.
  */
 int smartlog_write_log_entry(
     const char* file_path,
@@ -50,4 +57,104 @@ int smartlog_write_log_entry(
     unsigned long max_byte_val
 );
 
+/**
+ * Format one log line into a caller buffer.
+ *
+ * Produces "[<ns> ns] [PID = <pid>] [MESSAGE = <msg>]\n". Messages longer
+ * than SMARTLOG_MSG_MAX_LEN are truncated and end with "...".
+ *
+ * Parameters:
+ *   out     - Output buffer
+ *   out_sz  - Size of output buffer
+ *   time_ns - Timestamp in nanoseconds
+ *   pid     - Process ID to record
+ *   msg     - Log message (must not be empty)
+ *
+ * Return: Line length on success, -1 on error (errno is set)
+ */
+int smartlog_format_entry(
+    char* out,
+    size_t out_sz,
+    uint64_t time_ns,
+    pid_t pid,
+    const char* msg
+);
+
+/**
+ * Format one logger record into a caller buffer.
+ *
+ * Like smartlog_format_entry() with the writer thread and the logger
+ * sequence number added:
+ * "[<ns> ns] [PID = <pid>] [TID = <tid>] [SEQ = <seq>] [MESSAGE = <msg>]\n"
+ *
+ * Parameters:
+ *   out     - Output buffer
+ *   out_sz  - Size of output buffer
+ *   time_ns - Timestamp in nanoseconds
+ *   pid     - Process ID to record
+ *   tid     - Kernel thread ID to record
+ *   seq     - Per-logger sequence number
+ *   msg     - Log message (must not be empty)
+ *
+ * Return: Line length on success, -1 on error (errno is set)
+ */
+int smartlog_format_record(
+    char* out,
+    size_t out_sz,
+    uint64_t time_ns,
+    pid_t pid,
+    pid_t tid,
+    uint64_t seq,
+    const char* msg
+);
+
+/**
+ * Like smartlog_format_record() with encoded context fields (context.h)
+ * copied in, unchanged, between SEQ and MESSAGE:
+ * "[<ns> ns] [PID = <pid>] [TID = <tid>] [SEQ = <seq>] [<KEY> = <value>] ... [MESSAGE = <msg>]\n"
+ *
+ * Parameters:
+ *   ctx     - Encoded fields, each "[<KEY> = <value>] " (may be NULL if
+ *             ctx_len is 0)
+ *   ctx_len - Bytes in ctx
+ *   (others as for smartlog_format_record())
+ *
+ * Return: Line length on success, -1 on error (errno is set)
+ */
+int smartlog_format_record_ctx(
+    char* out,
+    size_t out_sz,
+    uint64_t time_ns,
+    pid_t pid,
+    pid_t tid,
+    uint64_t seq,
+    const char* ctx,
+    size_t ctx_len,
+    const char* msg
+);
+
+/**
+ * Read the timestamp from the start of a formatted line.
+ *
+ * Parameters:
+ *   line    - Line produced by smartlog_format_entry()
+ *   len     - Line length (no terminator needed)
+ *   time_ns - Output timestamp
+ *
+ * Return: 0 on success, -1 if the line does not start with "[<ns> ns]"
+ */
+int smartlog_line_timestamp(const char* line, size_t len, uint64_t* time_ns);
+
+/**
+ * Read the "[SEQ = <n>]" field of a line made by smartlog_format_record().
+ *
+ * Parameters:
+ *   line - Formatted line
+ *   len  - Line length (no terminator needed)
+ *   seq  - Output sequence number
+ *
+ * Return: 0 on success, -1 if the line has no sequence field
+ */
+int smartlog_line_seq(const char* line, size_t len, uint64_t* seq);
+
 #endif /* SMARTLOG_CORE_H */
@@ -0,0 +1,104 @@
+/*
+ * include/smartlog/spill.h
+ *
+ * Spill file for async sinks with the OVERFLOW_SPILL policy.
+ *
+ * When an async queue is full, lines go to an unnamed temporary file
+ * instead of being dropped or blocking the caller:
+ *   - Appends are staged in memory and written in SMARTLOG_SPILL_CHUNK
+ *     sized sequential writes
+ *   - The writer replays the file in order once it has caught up with the
+ *     queue, then truncates it and leaves spill mode
+ *   - The file is created with O_TMPFILE (or unlinked at once), so nothing
+ *     is left behind after a crash
+ *
+ * Record layout in the file: 4-byte length + line bytes.
+ *
+ * Author: Aravinthraj Ganesan
+ * Version: 1.0
+ */
+
+#ifndef SMARTLOG_SPILL_H
+#define SMARTLOG_SPILL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/uio.h>
+
+typedef struct smartlog_spill smartlog_spill_t;
+
+/**
+ * Replay callback: one batch of lines in spill order. The iovecs point into
+ * a buffer that is reused after the call returns.
+ */
+typedef void (*smartlog_spill_fn)(void* arg, const struct iovec* iov, int iovcnt);
+
+/**
+ * Create a spill file in a directory.
+ *
+ * Parameters:
+ *   dir - Directory for the temporary file (NULL = SMARTLOG_SPILL_DIR)
+ *
+ * Return: New spill, or NULL on error (errno is set)
+ */
+smartlog_spill_t* smartlog_spill_open(const char* dir);
+
+/**
+ * Non-zero while the spill holds lines not replayed yet. Lock-free.
+ */
+int smartlog_spill_active(const smartlog_spill_t* spill);
+
+/**
+ * Append one line and enter spill mode. Safe from many threads.
+ *
+ * Return: 0 on success, -1 on error (errno is set). When a staged chunk
+ *         cannot be written, its lines are counted as lost.
+ */
+int smartlog_spill_append(smartlog_spill_t* spill, const void* data, size_t len);
+
+/**
+ * Write out staged lines and fix the replay end (writer only).
+ *
+ * Lines appended after this call wait for the next mark.
+ *
+ * Return: 0 on success, -1 on error (errno is set)
+ */
+int smartlog_spill_mark(smartlog_spill_t* spill);
+
+/**
+ * Replay every line up to the last mark, in order (writer only).
+ *
+ * Lines are handed over in batches of up to SMARTLOG_WRITER_BATCH. When
+ * nothing new was appended meanwhile, the file is truncated and the spill
+ * leaves spill mode.
+ *
+ * Return: Number of lines replayed, or -1 on error (errno is set). After a
+ *         read error the unreplayed lines are counted as lost and the
+ *         spill is reset, so the writer never loops on a bad file.
+ */
+long smartlog_spill_replay(smartlog_spill_t* spill, smartlog_spill_fn fn, void* arg);
+
+/**
+ * Lines appended so far, and lines settled (replayed or lost).
+ */
+void smartlog_spill_counts(const smartlog_spill_t* spill, uint64_t* appended, uint64_t* settled);
+
+/**
+ * Lines lost because a staged chunk could not be written.
+ */
+uint64_t smartlog_spill_lost(const smartlog_spill_t* spill);
+
+/**
+ * Write every unreplayed line to fd from a fatal-signal handler.
+ *
+ * Uses only pread()/write() and takes no lock, so it can race with a
+ * producer appending at the same moment; best effort by design.
+ */
+void smartlog_spill_crash_drain(const smartlog_spill_t* spill, int fd);
+
+/**
+ * Close the file and free. Unreplayed lines are discarded.
+ */
+void smartlog_spill_close(smartlog_spill_t* spill);
+
+#endif /* SMARTLOG_SPILL_H */
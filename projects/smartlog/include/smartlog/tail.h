@@ -0,0 +1,86 @@
+/*
+ * include/smartlog/tail.h
+ *
+ * Follow a SmartLog file across rotation (used by the smartlog_tail tool).
+ *
+ * Works like `tail -F`, driven by inotify instead of polling:
+ *   - The parent directory is watched, so writes, the rename to
+ *     "<file>.1" and the creation of the new file all wake the reader
+ *   - When the path names a new file, the old inode is read to EOF first,
+ *     so lines written just before the rotation are not lost
+ *   - Reads use SMARTLOG_TAIL_BUF-sized buffers to keep up with busy
+ *     loggers
+ *   - A file that shrinks (truncated in place) is read again from the start
+ *   - LZ4 files (smartlog_sink_lz4_open()) are detected by their magic and
+ *     decoded on the fly, one block at a time
+ *
+ * Author: Aravinthraj Ganesan
+ * Version: 1.0
+ */
+
+#ifndef SMARTLOG_TAIL_H
+#define SMARTLOG_TAIL_H
+
+#include <stdint.h>
+
+/* ============================================================================
+ * Types
+ * ============================================================================ */
+
+typedef struct {
+    uint64_t bytes;         /* File bytes read (before decoding) */
+    uint64_t rotations;     /* Switches to a new file at the path */
+    uint64_t truncations;   /* Files read again after shrinking */
+    uint64_t wakeups;       /* Waits ended by inotify events */
+} smartlog_tail_stats_t;
+
+typedef struct smartlog_tail smartlog_tail_t;
+
+/* ============================================================================
+ * Tail Functions
+ * ============================================================================ */
+
+/**
+ * Start following a file. The file does not need to exist yet.
+ *
+ * Parameters:
+ *   path       - File to follow
+ *   from_start - Non-zero to output the current content too; otherwise
+ *                only what is written from now on
+ *
+ * Return: New follower, or NULL on error (errno is set)
+ */
+smartlog_tail_t* smartlog_tail_open(const char* path, int from_start);
+
+/**
+ * Write what is new to out_fd, then wait up to timeout_ms for inotify
+ * events and write what they announced. Rotation and truncation are
+ * handled here.
+ *
+ * Parameters:
+ *   tail       - Follower
+ *   out_fd     - Where new (decoded) text is written
+ *   timeout_ms - Max wait (-1 = until an event or a signal)
+ *
+ * Return: 0 on success, timeout or signal, 1 on error (errno is set,
+ *         EBADMSG for a damaged LZ4 file)
+ */
+int smartlog_tail_poll(smartlog_tail_t* tail, int out_fd, int timeout_ms);
+
+/**
+ * The inotify descriptor, readable when smartlog_tail_poll() has work.
+ * For callers with their own poll loop (then use a 0 timeout).
+ */
+int smartlog_tail_fd(const smartlog_tail_t* tail);
+
+/**
+ * Copy current counters.
+ */
+void smartlog_tail_get_stats(const smartlog_tail_t* tail, smartlog_tail_stats_t* out);
+
+/**
+ * Stop following and free the follower.
+ */
+void smartlog_tail_close(smartlog_tail_t* tail);
+
+#endif /* SMARTLOG_TAIL_H */
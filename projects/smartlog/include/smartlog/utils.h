@@ -4,9 +4,14 @@
  * Helper functions for SmartLog.
  *
  * Provides:
- *   - Get current time in nanoseconds
+ *   - Get current time in nanoseconds (wall clock and monotonic)
  *   - Write data to file (handles interrupts)
+ *   - Gather-write a batch of buffers (handles short writes)
  *   - Sync directory changes to disk
+ *   - Futex wait/wake and a spin-loop hint
+ *   - NUMA-aware, huge-page capable buffer allocation
+ *   - Bounded lock-free multi-producer / single-consumer queue
+ *   - Little-endian integer encoding for the on-disk formats
  *
  * Author: Aravinthraj Ganesan
  * Version: 4.0
@@ -15,8 +20,12 @@
 #ifndef SMARTLOG_UTILS_H
 #define SMARTLOG_UTILS_H
 
+#include <stdatomic.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <sys/uio.h>
+
+#include <smartlog/config.h>
 
 /* ============================================================================
  * Helper Functions
@@ -31,6 +40,15 @@
  */
 uint64_t smartlog_timestamp_ns(void);
 
+/**
+ * Get monotonic time in nanoseconds.
+ *
+ * Uses CLOCK_MONOTONIC. For intervals and timeouts, not for log lines.
+ *
+ * Return: Time value in nanoseconds (0 on error)
+ */
+uint64_t smartlog_monotonic_ns(void);
+
 /**
  * Write data to file descriptor, handle interrupts.
  *
@@ -44,6 +62,21 @@ uint64_t smartlog_timestamp_ns(void);
  * Return: 0 on success, -1 on error
  */
 int smartlog_write_all(int fd, const void* data, size_t size);
+
+/**
+ * Write a batch of buffers with writev(), handle interrupts and short writes.
+ *
+ * The iovec array is used as scratch space and is modified on short writes.
+ *
+ * Parameters:
+ *   fd     - File descriptor to write to
+ *   iov    - Buffers to write
+ *   iovcnt - Number of buffers (at most IOV_MAX)
+ *
+ * Return: 0 on success, -1 on error
+ */
+int smartlog_writev_all(int fd, struct iovec* iov, int iovcnt);
+
 /**
  * Sync directory changes to disk.
  *
@@ -56,4 +89,282 @@ int smartlog_write_all(int fd, const void* data, size_t size);
  */
 int smartlog_fsync_parent_dir(const char* path);
 
+/**
+ * Open the parent directory of a file path.
+ *
+ * For code that keeps the directory open and works relative to it
+ * (openat, renameat, fsync) instead of resolving the path every time.
+ *
+ * Parameters:
+ *   path - Path to a file
+ *   name - Optional output: last component of path (points into path)
+ *
+ * Return: Directory fd (O_RDONLY | O_DIRECTORY | O_CLOEXEC), -1 on error
+ */
+int smartlog_open_parent_dir(const char* path, const char** name);
+
+/* ============================================================================
+ * Wait Helpers
+ * ============================================================================ */
+
+/**
+ * Sleep while *addr still equals expected (process-private futex).
+ *
+ * Parameters:
+ *   addr       - Futex word
+ *   expected   - Value seen before deciding to sleep
+ *   timeout_ns - Max sleep, 0 = no limit
+ *
+ * Return: 0 when woken or the value already changed, -1 on timeout or
+ *         signal (errno ETIMEDOUT / EINTR)
+ */
+int smartlog_futex_wait(atomic_uint* addr, unsigned int expected, uint64_t timeout_ns);
+
+/**
+ * Wake up to count threads sleeping on addr.
+ */
+void smartlog_futex_wake(atomic_uint* addr, int count);
+
+/**
+ * CPU hint for spin loops (pause/yield instruction, no syscall).
+ */
+void smartlog_cpu_relax(void);
+
+/* ============================================================================
+ * Memory Placement
+ * ============================================================================ */
+
+/** Where and how to back a large buffer. */
+typedef struct {
+    int numa_node;              /* Preferred node, -1 = first touch */
+    feature_state_t huge_pages; /* Try huge pages, fall back to normal */
+} smartlog_mem_opts_t;
+
+/** A mapped buffer and what backs it. */
+typedef struct {
+    void* addr;
+    size_t size;                /* Mapped bytes (>= requested) */
+    page_kind_t pages;          /* Page kind actually obtained */
+} smartlog_region_t;
+
+/**
+ * Map a zeroed, page-aligned anonymous region.
+ *
+ * With a node, the region gets a preferred-node policy (mbind) before any
+ * page is touched, so pages land on that node. Without one, pages land
+ * where they are first touched.
+ *
+ * With huge_pages on and size >= SMARTLOG_HUGE_PAGE_SZ, tries MAP_HUGETLB
+ * first, then a huge-page aligned mapping with madvise(MADV_HUGEPAGE),
+ * then regular pages. region->pages tells which one worked.
+ *
+ * Parameters:
+ *   region - Output region
+ *   size   - Bytes needed
+ *   opts   - Placement options (NULL = defaults: first touch, no huge pages)
+ *
+ * Return: 0 on success, -1 on error (errno is set)
+ */
+int smartlog_region_alloc(smartlog_region_t* region, size_t size, const smartlog_mem_opts_t* opts);
+
+/**
+ * Unmap a region from smartlog_region_alloc().
+ */
+void smartlog_region_free(smartlog_region_t* region);
+
+/**
+ * NUMA node of a CPU (from /sys/devices/system/cpu).
+ *
+ * Return: Node number, or -1 if unknown
+ */
+int smartlog_cpu_numa_node(int cpu);
+
+/* ============================================================================
+ * Little-Endian Encoding
+ * ============================================================================ */
+
+/*
+ * Byte-wise, so they work on any host byte order and alignment. Shared by
+ * the archive, LZ4 frame, columnar and circular file formats.
+ */
+
+/** Store v at p, least significant byte first. */
+static inline void smartlog_put_le32(unsigned char* p, uint32_t v)
+{
+    for(int i = 0; i < 4; i++)
+    {
+        p[i] = (unsigned char)(v >> (8 * i));
+    }
+}
+
+/** Store v at p, least significant byte first. */
+static inline void smartlog_put_le64(unsigned char* p, uint64_t v)
+{
+    for(int i = 0; i < 8; i++)
+    {
+        p[i] = (unsigned char)(v >> (8 * i));
+    }
+}
+
+/** Load a little-endian 32-bit value from p. */
+static inline uint32_t smartlog_get_le32(const unsigned char* p)
+{
+    uint32_t v = 0;
+    for(int i = 3; i >= 0; i--)
+    {
+        v = (v << 8) | p[i];
+    }
+    return v;
+}
+
+/** Load a little-endian 64-bit value from p. */
+static inline uint64_t smartlog_get_le64(const unsigned char* p)
+{
+    uint64_t v = 0;
+    for(int i = 7; i >= 0; i--)
+    {
+        v = (v << 8) | p[i];
+    }
+    return v;
+}
+
+/* ============================================================================
+ * MPSC Queue
+ * ============================================================================ */
+
+/*
+ * Bounded multi-producer / single-consumer queue of fixed-size slots.
+ *
+ *   - Producers claim a slot with one CAS on the head and publish it with
+ *     a per-slot sequence number (no lock, no syscall on the fast path)
+ *   - Head and tail live on separate cache lines; slots are padded to a
+ *     cache line so neighbouring producers do not false-share
+ *   - The consumer claims whole batches of ready slots and reads them in
+ *     place, then releases them in one step
+ *   - The consumer can block in futex_wait; producers only call futex_wake
+ *     when the consumer has advertised that it is sleeping
+ */
+typedef struct smartlog_mpsc smartlog_mpsc_t;
+
+/**
+ * Create a queue.
+ *
+ * Parameters:
+ *   capacity  - Number of slots, power of two (>= 2)
+ *   elem_size - Max bytes per element
+ *
+ * Return: New queue, or NULL on error (errno is set)
+ */
+smartlog_mpsc_t* smartlog_mpsc_create(size_t capacity, size_t elem_size);
+
+/**
+ * Create a queue with placement options for its slots (see
+ * smartlog_region_alloc()). smartlog_mpsc_create() is this with NULL opts.
+ */
+smartlog_mpsc_t* smartlog_mpsc_create_with(size_t capacity, size_t elem_size, const smartlog_mem_opts_t* opts);
+
+/**
+ * Node the slots were placed on (-1 = first touch).
+ */
+int smartlog_mpsc_numa_node(const smartlog_mpsc_t* q);
+
+/**
+ * Page kind backing the slots.
+ */
+page_kind_t smartlog_mpsc_page_kind(const smartlog_mpsc_t* q);
+
+/**
+ * Copy one element in. Safe from any number of threads.
+ *
+ * Return: 0 on success, -1 on error (EAGAIN when full, EMSGSIZE when
+ *         len > elem_size)
+ */
+int smartlog_mpsc_push(smartlog_mpsc_t* q, const void* data, size_t len);
+
+/**
+ * Claim up to max ready elements, oldest first (consumer only).
+ *
+ * The pointers stay valid until smartlog_mpsc_release(). Claiming again
+ * without releasing returns the same elements.
+ *
+ * Parameters:
+ *   q     - Queue
+ *   elems - Output element pointers
+ *   lens  - Output element lengths
+ *   max   - Capacity of both output arrays
+ *
+ * Return: Number of elements claimed (0 if empty)
+ */
+size_t smartlog_mpsc_claim(smartlog_mpsc_t* q, const void** elems, size_t* lens, size_t max);
+
+/**
+ * Read ready elements starting skip places after the oldest, without
+ * claiming anything. Only atomic loads: safe from a signal handler.
+ *
+ * Return: Number of elements returned
+ */
+size_t smartlog_mpsc_peek(const smartlog_mpsc_t* q, size_t skip, const void** elems, size_t* lens, size_t max);
+
+/**
+ * Give the first count claimed slots back to producers (consumer only).
+ */
+void smartlog_mpsc_release(smartlog_mpsc_t* q, size_t count);
+
+/**
+ * Copy out and release one element (consumer only).
+ *
+ * Return: 1 if an element was copied, 0 if empty, -1 if it did not fit in
+ *         out_sz (errno EMSGSIZE, element stays queued)
+ */
+int smartlog_mpsc_pop(smartlog_mpsc_t* q, void* out, size_t out_sz, size_t* len);
+
+/**
+ * Sleep until an element is ready, the timeout expires, or someone calls
+ * smartlog_mpsc_wake() (consumer only).
+ *
+ * Parameters:
+ *   q          - Queue
+ *   timeout_ns - Max sleep, 0 = no limit
+ *
+ * Return: 1 if an element is ready, 0 otherwise (timeout or wake)
+ *
+ * Callers that want to avoid the syscall under load should spin on
+ * smartlog_mpsc_claim() for a while before calling this.
+ */
+int smartlog_mpsc_wait(smartlog_mpsc_t* q, uint64_t timeout_ns);
+
+/**
+ * Make the consumer's current or next smartlog_mpsc_wait() return (used
+ * for shutdown). Safe from any thread.
+ */
+void smartlog_mpsc_wake(smartlog_mpsc_t* q);
+
+/**
+ * Number of elements ready or being written (approximate under load).
+ */
+size_t smartlog_mpsc_size(const smartlog_mpsc_t* q);
+
+/**
+ * Total elements ever reserved by producers (monotonic position).
+ */
+size_t smartlog_mpsc_head(const smartlog_mpsc_t* q);
+
+/**
+ * Total elements ever released by the consumer (monotonic position).
+ *
+ * Once it reaches a value read from smartlog_mpsc_head(), everything pushed
+ * before that read has been consumed.
+ */
+size_t smartlog_mpsc_tail(const smartlog_mpsc_t* q);
+
+/**
+ * Count of futex_wake calls producers made (to measure wakeup cost).
+ */
+uint64_t smartlog_mpsc_wakeups(const smartlog_mpsc_t* q);
+
+/**
+ * Free the queue.
+ */
+void smartlog_mpsc_destroy(smartlog_mpsc_t* q);
+
 #endif /* SMARTLOG_UTILS_H */
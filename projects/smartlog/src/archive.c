@@ -0,0 +1,1169 @@
+/*
+ * src/archive.c
+ *
+ * Seekable compressed archive for rotated SmartLog files.
+ *
+ * Implements:
+ *   - Packing a plain log into independently compressed blocks cut at
+ *     line boundaries, plus a trailing block index
+ *   - Loading and checking the index
+ *   - Single-block reads with pread() (thread-safe)
+ *   - Time-range queries that decompress overlapping blocks in parallel
+ *   - Preset dictionaries trained from sample logs, so small blocks
+ *     compress well and still decode on their own
+ *
+ * Author: Aravinthraj Ganesan
+ * Version: 1.0
+ */
+
+#define _GNU_SOURCE
+#define _POSIX_C_SOURCE 199309L
+
+/* Standard includes */
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <zlib.h>
+
+/* Project includes */
+#include <smartlog/archive.h>
+#include <smartlog/config.h>
+#include <smartlog/smartlog_core.h>
+#include <smartlog/utils.h>
+
+/* ============================================================================
+ * Format Constants
+ * ============================================================================ */
+
+#define ARCHIVE_MAGIC         "SLARCHV1"
+#define ARCHIVE_INDEX_MAGIC   "SLARCIDX"
+#define ARCHIVE_VERSION       1u
+#define ARCHIVE_HEADER_SZ     16
+#define ARCHIVE_ENTRY_SZ      40
+#define ARCHIVE_TRAILER_SZ    32
+#define ARCHIVE_FLAG_DICT     1u    /* Blocks need the preset dictionary */
+#define DICT_TABLE_SLOTS      (1u << 16)
+
+/* ============================================================================
+ * Internal Types
+ * ============================================================================ */
+
+struct smartlog_archive {
+    int fd;
+    uint32_t block_size;
+    uint32_t flags;
+    uint32_t dict_id;           /* adler32 of the dictionary, if ARCHIVE_FLAG_DICT */
+    size_t nblocks;
+    smartlog_archive_block_t* blocks;
+    unsigned char* dict;        /* Loaded dictionary (NULL if none) */
+    size_t dict_len;
+};
+
+/** Pack state shared by the block writer */
+typedef struct {
+    int fd;
+    uint64_t offset;                    /* Next write position */
+    z_stream strm;                      /* Reset per block */
+    const unsigned char* dict;          /* Preset dictionary (NULL if none) */
+    size_t dict_len;
+    smartlog_archive_block_t* blocks;
+    size_t nblocks;
+    size_t cap;
+    unsigned char* comp;
+    size_t comp_cap;
+    smartlog_archive_stats_t stats;
+} archive_writer_t;
+
+/** One block decompressed by a query worker */
+typedef struct {
+    const smartlog_archive_t* archive;
+    size_t index;
+    char* buf;
+    size_t buf_sz;
+    long len;
+    int error;
+    int threaded;           /* Running on its own thread this round */
+} archive_job_t;
+
+/** One distinct text segment seen while training */
+typedef struct {
+    char* text;
+    uint32_t len;
+    uint32_t count;
+} dict_segment_t;
+
+/* ============================================================================
+ * Encoding Helpers
+ * ============================================================================ */
+
+static void encode_entry(unsigned char* p, const smartlog_archive_block_t* b)
+{
+    smartlog_put_le64(p, b->offset);
+    smartlog_put_le32(p + 8, b->comp_len);
+    smartlog_put_le32(p + 12, b->raw_len);
+    smartlog_put_le32(p + 16, b->lines);
+    smartlog_put_le32(p + 20, b->crc);
+    smartlog_put_le64(p + 24, b->min_ns);
+    smartlog_put_le64(p + 32, b->max_ns);
+}
+
+static void decode_entry(const unsigned char* p, smartlog_archive_block_t* b)
+{
+    b->offset = smartlog_get_le64(p);
+    b->comp_len = smartlog_get_le32(p + 8);
+    b->raw_len = smartlog_get_le32(p + 12);
+    b->lines = smartlog_get_le32(p + 16);
+    b->crc = smartlog_get_le32(p + 20);
+    b->min_ns = smartlog_get_le64(p + 24);
+    b->max_ns = smartlog_get_le64(p + 32);
+}
+
+/**
+ * pread() the whole range, retrying on EINTR and short reads.
+ *
+ * Return: 0 on success, -1 on error (errno is set, EBADMSG at EOF)
+ */
+static int pread_all(int fd, void* buf, size_t len, uint64_t offset)
+{
+    size_t done = 0;
+    while(done < len)
+    {
+        ssize_t n = pread(fd, (char*)buf + done, len - done, (off_t)(offset + done));
+        if(n < 0)
+        {
+            if(errno == EINTR)
+            {
+                continue;
+            }
+            return -1;
+        }
+        if(n == 0)
+        {
+            errno = EBADMSG;
+            return -1;
+        }
+        done += (size_t)n;
+    }
+    return 0;
+}
+
+/**
+ * Read a dictionary file (at most SMARTLOG_DICT_MAX bytes).
+ *
+ * Return: 0 on success, -1 on error (errno is set, EFBIG if too large)
+ */
+static int dict_load(const char* path, unsigned char** out, size_t* out_len)
+{
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if(fd < 0)
+    {
+        return -1;
+    }
+
+    struct stat st;
+    unsigned char* dict = NULL;
+    int rc = -1;
+    if(fstat(fd, &st) == 0)
+    {
+        if(st.st_size <= 0 || st.st_size > SMARTLOG_DICT_MAX)
+        {
+            errno = st.st_size <= 0 ? EINVAL : EFBIG;
+        }
+        else if((dict = malloc((size_t)st.st_size)) != NULL &&
+                pread_all(fd, dict, (size_t)st.st_size, 0) == 0)
+        {
+            rc = 0;
+        }
+    }
+
+    int saved_errno = errno;
+    close(fd);
+    if(rc != 0)
+    {
+        free(dict);
+        errno = saved_errno;
+        return -1;
+    }
+    *out = dict;
+    *out_len = (size_t)st.st_size;
+    return 0;
+}
+
+/* ============================================================================
+ * Pack Helpers
+ * ============================================================================ */
+
+/**
+ * Compress one run of whole lines and append it with its index entry.
+ *
+ * Return: 0 on success, -1 on error (errno is set)
+ */
+static int writer_add_block(archive_writer_t* w, const char* data, size_t len)
+{
+    if(len > UINT32_MAX)
+    {
+        errno = EFBIG;
+        return -1;
+    }
+
+    if(w->nblocks == w->cap)
+    {
+        size_t cap = w->cap == 0 ? 64 : w->cap * 2;
+        smartlog_archive_block_t* blocks = realloc(w->blocks, cap * sizeof(*blocks));
+        if(blocks == NULL)
+        {
+            return -1;
+        }
+        w->blocks = blocks;
+        w->cap = cap;
+    }
+
+    size_t bound = deflateBound(&w->strm, (uLong)len);
+    if(bound > w->comp_cap)
+    {
+        unsigned char* comp = realloc(w->comp, bound);
+        if(comp == NULL)
+        {
+            return -1;
+        }
+        w->comp = comp;
+        w->comp_cap = bound;
+    }
+
+    /* Every block is a complete zlib stream; the dictionary is preset again */
+    if(deflateReset(&w->strm) != Z_OK ||
+       (w->dict != NULL && deflateSetDictionary(&w->strm, w->dict, (uInt)w->dict_len) != Z_OK))
+    {
+        errno = EINVAL;
+        return -1;
+    }
+    w->strm.next_in = (Bytef*)data;
+    w->strm.avail_in = (uInt)len;
+    w->strm.next_out = w->comp;
+    w->strm.avail_out = (uInt)bound;
+    if(deflate(&w->strm, Z_FINISH) != Z_STREAM_END)
+    {
+        errno = ENOBUFS;
+        return -1;
+    }
+    size_t comp_len = bound - w->strm.avail_out;
+    if(smartlog_write_all(w->fd, w->comp, comp_len) != 0)
+    {
+        return -1;
+    }
+
+    /* Timestamp range and line count */
+    smartlog_archive_block_t* b = &w->blocks[w->nblocks];
+    b->offset = w->offset;
+    b->comp_len = (uint32_t)comp_len;
+    b->raw_len = (uint32_t)len;
+    b->lines = 0;
+    b->crc = (uint32_t)crc32(0L, (const Bytef*)data, (uInt)len);
+    b->min_ns = UINT64_MAX;
+    b->max_ns = 0;
+
+    const char* line = data;
+    const char* end = data + len;
+    while(line < end)
+    {
+        const char* nl = memchr(line, '\n', (size_t)(end - line));
+        const char* next = nl != NULL ? nl + 1 : end;
+        uint64_t time_ns = 0;
+        if(smartlog_line_timestamp(line, (size_t)(next - line), &time_ns) == 0)
+        {
+            b->min_ns = time_ns < b->min_ns ? time_ns : b->min_ns;
+            b->max_ns = time_ns > b->max_ns ? time_ns : b->max_ns;
+        }
+        b->lines++;
+        line = next;
+    }
+    if(b->min_ns > b->max_ns)
+    {
+        b->min_ns = 0;
+        b->max_ns = UINT64_MAX;
+    }
+
+    w->offset += comp_len;
+    w->nblocks++;
+    w->stats.blocks++;
+    w->stats.lines += b->lines;
+    w->stats.raw_bytes += len;
+    return 0;
+}
+
+/**
+ * Read the source and cut it into blocks.
+ *
+ * Return: 0 on success, -1 on error (errno is set)
+ */
+static int writer_pack_blocks(archive_writer_t* w, int src_fd, size_t block_size)
+{
+    size_t cap = block_size * 2;
+    char* buf = malloc(cap);
+    if(buf == NULL)
+    {
+        return -1;
+    }
+
+    size_t len = 0;
+    size_t want = block_size;
+    int eof = 0;
+    int rc = 0;
+
+    for(;;)
+    {
+        while(eof == 0 && len < want)
+        {
+            ssize_t n = read(src_fd, buf + len, cap - len);
+            if(n < 0)
+            {
+                if(errno == EINTR)
+                {
+                    continue;
+                }
+                rc = -1;
+                break;
+            }
+            if(n == 0)
+            {
+                eof = 1;
+            }
+            len += (size_t)n;
+        }
+        if(rc != 0 || len == 0)
+        {
+            break;
+        }
+
+        /* Cut after the last newline that fits, else after the first one */
+        size_t cut = 0;
+        if(eof != 0 && len <= block_size)
+        {
+            cut = len;
+        }
+        else
+        {
+            const char* nl = memrchr(buf, '\n', len < block_size ? len : block_size);
+            if(nl == NULL && len > block_size)
+            {
+                nl = memchr(buf + block_size, '\n', len - block_size);
+            }
+            if(nl != NULL)
+            {
+                cut = (size_t)(nl - buf) + 1;
+            }
+            else if(eof != 0)
+            {
+                cut = len;
+            }
+        }
+
+        if(cut == 0)
+        {
+            /* One line longer than the buffer: grow and keep reading */
+            char* grown = realloc(buf, cap * 2);
+            if(grown == NULL)
+            {
+                rc = -1;
+                break;
+            }
+            buf = grown;
+            cap *= 2;
+            want = cap;
+            continue;
+        }
+
+        if(writer_add_block(w, buf, cut) != 0)
+        {
+            rc = -1;
+            break;
+        }
+        memmove(buf, buf + cut, len - cut);
+        len -= cut;
+        want = block_size;
+    }
+
+    free(buf);
+    return rc;
+}
+
+/**
+ * Write header, blocks, index and trailer to w->fd.
+ *
+ * Return: 0 on success, -1 on error (errno is set)
+ */
+static int writer_pack(archive_writer_t* w, int src_fd, size_t block_size)
+{
+    unsigned char header[ARCHIVE_HEADER_SZ];
+    memcpy(header, ARCHIVE_MAGIC, 8);
+    smartlog_put_le32(header + 8, ARCHIVE_VERSION);
+    smartlog_put_le32(header + 12, (uint32_t)block_size);
+    if(smartlog_write_all(w->fd, header, sizeof(header)) != 0)
+    {
+        return -1;
+    }
+    w->offset = ARCHIVE_HEADER_SZ;
+
+    if(writer_pack_blocks(w, src_fd, block_size) != 0)
+    {
+        return -1;
+    }
+
+    size_t index_len = w->nblocks * ARCHIVE_ENTRY_SZ;
+    unsigned char* index = malloc(index_len + ARCHIVE_TRAILER_SZ);
+    if(index == NULL)
+    {
+        return -1;
+    }
+    for(size_t i = 0; i < w->nblocks; i++)
+    {
+        encode_entry(index + (i * ARCHIVE_ENTRY_SZ), &w->blocks[i]);
+    }
+
+    unsigned char* trailer = index + index_len;
+    memcpy(trailer, ARCHIVE_INDEX_MAGIC, 8);
+    smartlog_put_le32(trailer + 8, (uint32_t)w->nblocks);
+    smartlog_put_le32(trailer + 12, w->dict != NULL ? ARCHIVE_FLAG_DICT : 0);
+    smartlog_put_le64(trailer + 16, w->offset);
+    smartlog_put_le32(trailer + 24, (uint32_t)crc32(0L, index, (uInt)index_len));
+    smartlog_put_le32(trailer + 28, w->dict != NULL ? (uint32_t)adler32(adler32(0L, NULL, 0), w->dict, (uInt)w->dict_len) : 0);
+
+    int rc = smartlog_write_all(w->fd, index, index_len + ARCHIVE_TRAILER_SZ);
+    free(index);
+    w->stats.comp_bytes = w->offset + index_len + ARCHIVE_TRAILER_SZ;
+    return rc;
+}
+
+/* ============================================================================
+ * Query Helpers
+ * ============================================================================ */
+
+static void* query_worker(void* arg)
+{
+    archive_job_t* job = (archive_job_t*)arg;
+    job->len = smartlog_archive_read_block(job->archive, job->index, job->buf, job->buf_sz);
+    job->error = job->len < 0 ? errno : 0;
+    return NULL;
+}
+
+/**
+ * Write the lines of one decompressed block that fall in [from_ns, to_ns].
+ *
+ * Return: 0 on success, -1 on error (errno is set)
+ */
+static int query_emit(const char* data, size_t len, int untimed_block, uint64_t from_ns, uint64_t to_ns,
+                      int out_fd)
+{
+    const char* run = NULL;
+    const char* line = data;
+    const char* end = data + len;
+    int keep = untimed_block;
+
+    while(line < end)
+    {
+        const char* nl = memchr(line, '\n', (size_t)(end - line));
+        const char* next = nl != NULL ? nl + 1 : end;
+
+        uint64_t time_ns = 0;
+        if(smartlog_line_timestamp(line, (size_t)(next - line), &time_ns) == 0)
+        {
+            keep = time_ns >= from_ns && time_ns <= to_ns;
+        }
+
+        /* Write runs of kept lines with one call */
+        if(keep != 0 && run == NULL)
+        {
+            run = line;
+        }
+        else if(keep == 0 && run != NULL)
+        {
+            if(smartlog_write_all(out_fd, run, (size_t)(line - run)) != 0)
+            {
+                return -1;
+            }
+            run = NULL;
+        }
+        line = next;
+    }
+
+    if(run != NULL && smartlog_write_all(out_fd, run, (size_t)(end - run)) != 0)
+    {
+        return -1;
+    }
+    return 0;
+}
+
+/* ============================================================================
+ * Dictionary Training
+ * ============================================================================ */
+
+static uint32_t dict_hash(const char* text, size_t len)
+{
+    uint32_t h = 2166136261u;
+    for(size_t i = 0; i < len; i++)
+    {
+        h = (h ^ (unsigned char)text[i]) * 16777619u;
+    }
+    return h;
+}
+
+/**
+ * Count one segment. New segments are dropped once the table is 3/4 full.
+ *
+ * Return: 0 on success, -1 on allocation failure
+ */
+static int dict_count(dict_segment_t* table, size_t* used, const char* text, size_t len)
+{
+    size_t slot = dict_hash(text, len) & (DICT_TABLE_SLOTS - 1);
+    while(table[slot].text != NULL)
+    {
+        if(table[slot].len == len && memcmp(table[slot].text, text, len) == 0)
+        {
+            table[slot].count++;
+            return 0;
+        }
+        slot = (slot + 1) & (DICT_TABLE_SLOTS - 1);
+    }
+    if(*used >= (DICT_TABLE_SLOTS / 4) * 3)
+    {
+        return 0;
+    }
+
+    if((table[slot].text = malloc(len)) == NULL)
+    {
+        return -1;
+    }
+    memcpy(table[slot].text, text, len);
+    table[slot].len = (uint32_t)len;
+    table[slot].count = 1;
+    (*used)++;
+    return 0;
+}
+
+/**
+ * Split lines into the text between digit runs and count every piece of
+ * at least SMARTLOG_DICT_MIN_SEGMENT bytes. Prefixes, field names and
+ * message templates survive; timestamps, IDs and counters do not.
+ *
+ * Return: 0 on success, -1 on error (errno is set)
+ */
+static int dict_scan(dict_segment_t* table, size_t* used, const char* data, size_t len)
+{
+    size_t start = 0;
+    for(size_t i = 0; i <= len; i++)
+    {
+        int boundary = i == len || data[i] == '\n' || (data[i] >= '0' && data[i] <= '9');
+        if(!boundary)
+        {
+            continue;
+        }
+        if(i - start >= SMARTLOG_DICT_MIN_SEGMENT && dict_count(table, used, data + start, i - start) != 0)
+        {
+            return -1;
+        }
+        start = i + 1;
+    }
+    return 0;
+}
+
+static int dict_score_cmp(const void* a, const void* b)
+{
+    const dict_segment_t* x = (const dict_segment_t*)a;
+    const dict_segment_t* y = (const dict_segment_t*)b;
+    uint64_t sx = (uint64_t)x->count * x->len;
+    uint64_t sy = (uint64_t)y->count * y->len;
+    return sx < sy ? 1 : (sx > sy ? -1 : 0);
+}
+
+/**
+ * Pick the best-scoring segments and lay them out best-last, since
+ * deflate codes nearer matches in fewer bits.
+ *
+ * Return: Dictionary length (0 if nothing repeats)
+ */
+static size_t dict_build(dict_segment_t* table, size_t* order, unsigned char* dict, size_t max_size)
+{
+    size_t n = 0;
+    for(size_t i = 0; i < DICT_TABLE_SLOTS; i++)
+    {
+        if(table[i].text != NULL && table[i].count >= 2)
+        {
+            table[n++] = table[i];
+            if(n - 1 != i)
+            {
+                table[i].text = NULL;
+            }
+        }
+        else if(table[i].text != NULL)
+        {
+            free(table[i].text);
+            table[i].text = NULL;
+        }
+    }
+    qsort(table, n, sizeof(*table), dict_score_cmp);
+
+    /* Greedy: skip pieces already contained in what was picked */
+    size_t picked = 0;
+    size_t used = 0;
+    for(size_t i = 0; i < n; i++)
+    {
+        if(used + table[i].len > max_size ||
+           (used > 0 && memmem(dict, used, table[i].text, table[i].len) != NULL))
+        {
+            continue;
+        }
+        memcpy(dict + used, table[i].text, table[i].len);
+        used += table[i].len;
+        order[picked++] = i;
+    }
+
+    /* Rewrite in reverse pick order: the highest score ends up last */
+    size_t pos = 0;
+    for(size_t k = picked; k > 0; k--)
+    {
+        const dict_segment_t* seg = &table[order[k - 1]];
+        memcpy(dict + pos, seg->text, seg->len);
+        pos += seg->len;
+    }
+    return pos;
+}
+
+/* ============================================================================
+ * Public API
+ * ============================================================================ */
+
+int smartlog_archive_train(const char* const* sample_paths, size_t npaths, const char* dict_path,
+                           size_t max_size, size_t* dict_len)
+{
+    if(sample_paths == NULL || npaths == 0 || dict_path == NULL || max_size > SMARTLOG_DICT_MAX)
+    {
+        errno = EINVAL;
+        return 1;
+    }
+    if(max_size == 0)
+    {
+        max_size = SMARTLOG_DICT_MAX;
+    }
+
+    dict_segment_t* table = calloc(DICT_TABLE_SLOTS, sizeof(*table));
+    size_t* order = calloc(DICT_TABLE_SLOTS, sizeof(*order));
+    unsigned char* dict = malloc(max_size);
+    char* buf = malloc(SMARTLOG_MERGE_BUF);
+    size_t used = 0;
+    size_t sampled = 0;
+    int rc = table != NULL && order != NULL && dict != NULL && buf != NULL ? 0 : 1;
+
+    /* ====================================================================
+     * STEP 1: Count Segments Over a Bounded Sample
+     * ==================================================================== */
+    for(size_t p = 0; rc == 0 && p < npaths && sampled < SMARTLOG_DICT_SAMPLE; p++)
+    {
+        int fd = open(sample_paths[p], O_RDONLY | O_CLOEXEC);
+        if(fd < 0)
+        {
+            rc = 1;
+            break;
+        }
+
+        size_t carry = 0;
+        while(sampled < SMARTLOG_DICT_SAMPLE)
+        {
+            ssize_t n = read(fd, buf + carry, SMARTLOG_MERGE_BUF - carry);
+            if(n < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if(n < 0)
+            {
+                rc = 1;
+                break;
+            }
+            size_t len = carry + (size_t)n;
+            if(len == 0)
+            {
+                break;
+            }
+
+            /* Scan whole lines only; keep the partial tail for the next read */
+            const char* nl = memrchr(buf, '\n', len);
+            size_t whole = n == 0 || nl == NULL ? len : (size_t)(nl - buf) + 1;
+            if(dict_scan(table, &used, buf, whole) != 0)
+            {
+                rc = 1;
+                break;
+            }
+            sampled += whole;
+            carry = len - whole;
+            memmove(buf, buf + whole, carry);
+            if(n == 0)
+            {
+                break;
+            }
+        }
+
+        int saved_errno = errno;
+        close(fd);
+        errno = saved_errno;
+    }
+
+    /* ====================================================================
+     * STEP 2: Build and Store the Dictionary
+     * ==================================================================== */
+    size_t len = 0;
+    if(rc == 0)
+    {
+        len = dict_build(table, order, dict, max_size);
+        if(len == 0)
+        {
+            errno = ENODATA;
+            rc = 1;
+        }
+    }
+    if(rc == 0)
+    {
+        int fd = open(dict_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, SMARTLOG_FILE_MODE);
+        if(fd < 0 || smartlog_write_all(fd, dict, len) != 0 || fdatasync(fd) != 0)
+        {
+            rc = 1;
+        }
+        int saved_errno = errno;
+        if(fd >= 0)
+        {
+            close(fd);
+        }
+        errno = saved_errno;
+    }
+
+    int saved_errno = errno;
+    for(size_t i = 0; table != NULL && i < DICT_TABLE_SLOTS; i++)
+    {
+        free(table[i].text);
+    }
+    free(table);
+    free(order);
+    free(dict);
+    free(buf);
+    if(rc == 0 && dict_len != NULL)
+    {
+        *dict_len = len;
+    }
+    errno = saved_errno;
+    return rc;
+}
+
+int smartlog_archive_pack(const char* src_path, const char* dst_path, size_t block_size,
+                          smartlog_archive_stats_t* stats)
+{
+    return smartlog_archive_pack_dict(src_path, dst_path, block_size, NULL, stats);
+}
+
+int smartlog_archive_pack_dict(const char* src_path, const char* dst_path, size_t block_size,
+                               const char* dict_path, smartlog_archive_stats_t* stats)
+{
+    if(src_path == NULL || dst_path == NULL || block_size > UINT32_MAX / 2)
+    {
+        errno = EINVAL;
+        return 1;
+    }
+    if(block_size == 0)
+    {
+        block_size = SMARTLOG_ARCHIVE_BLOCK;
+    }
+
+    char tmp_path[SMARTLOG_PATH_MAX_LEN];
+    int n = snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", dst_path);
+    if(n < 0 || n >= (int)sizeof(tmp_path))
+    {
+        errno = ENAMETOOLONG;
+        return 1;
+    }
+
+    archive_writer_t w;
+    memset(&w, 0, sizeof(w));
+    unsigned char* dict = NULL;
+    if(dict_path != NULL && dict_load(dict_path, &dict, &w.dict_len) != 0)
+    {
+        return 1;
+    }
+    w.dict = dict;
+
+    int src_fd = open(src_path, O_RDONLY | O_CLOEXEC);
+    if(src_fd < 0 || deflateInit(&w.strm, Z_DEFAULT_COMPRESSION) != Z_OK)
+    {
+        int saved_errno = src_fd < 0 ? errno : ENOMEM;
+        if(src_fd >= 0)
+        {
+            close(src_fd);
+        }
+        free(dict);
+        errno = saved_errno;
+        return 1;
+    }
+    (void)posix_fadvise(src_fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    w.fd = open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, SMARTLOG_FILE_MODE);
+
+    int rc = 1;
+    if(w.fd >= 0 &&
+       writer_pack(&w, src_fd, block_size) == 0 &&
+       fdatasync(w.fd) == 0)
+    {
+        rc = 0;
+    }
+
+    int saved_errno = errno;
+    close(src_fd);
+    (void)deflateEnd(&w.strm);
+    free(dict);
+    if(w.fd >= 0 && close(w.fd) != 0 && rc == 0)
+    {
+        rc = 1;
+        saved_errno = errno;
+    }
+    if(rc == 0 && (rename(tmp_path, dst_path) != 0 || smartlog_fsync_parent_dir(dst_path) != 0))
+    {
+        rc = 1;
+        saved_errno = errno;
+    }
+    if(rc != 0 && w.fd >= 0)
+    {
+        (void)unlink(tmp_path);
+    }
+
+    if(stats != NULL)
+    {
+        *stats = w.stats;
+    }
+    free(w.blocks);
+    free(w.comp);
+    errno = saved_errno;
+    return rc;
+}
+
+smartlog_archive_t* smartlog_archive_open(const char* path)
+{
+    return smartlog_archive_open_dict(path, NULL);
+}
+
+smartlog_archive_t* smartlog_archive_open_dict(const char* path, const char* dict_path)
+{
+    if(path == NULL)
+    {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    smartlog_archive_t* archive = calloc(1, sizeof(*archive));
+    if(archive == NULL)
+    {
+        return NULL;
+    }
+    archive->fd = open(path, O_RDONLY | O_CLOEXEC);
+    if(archive->fd < 0)
+    {
+        int saved_errno = errno;
+        free(archive);
+        errno = saved_errno;
+        return NULL;
+    }
+
+    /* ====================================================================
+     * STEP 1: Header and Trailer
+     * ==================================================================== */
+    struct stat st;
+    unsigned char header[ARCHIVE_HEADER_SZ];
+    unsigned char trailer[ARCHIVE_TRAILER_SZ];
+    unsigned char* index = NULL;
+    int ok = 0;
+
+    errno = 0;
+    if(fstat(archive->fd, &st) == 0 &&
+       st.st_size >= ARCHIVE_HEADER_SZ + ARCHIVE_TRAILER_SZ &&
+       pread_all(archive->fd, header, sizeof(header), 0) == 0 &&
+       pread_all(archive->fd, trailer, sizeof(trailer), (uint64_t)st.st_size - ARCHIVE_TRAILER_SZ) == 0)
+    {
+        uint64_t nblocks = smartlog_get_le32(trailer + 8);
+        uint64_t index_off = smartlog_get_le64(trailer + 16);
+        uint64_t index_len = nblocks * ARCHIVE_ENTRY_SZ;
+
+        ok = memcmp(header, ARCHIVE_MAGIC, 8) == 0 &&
+             smartlog_get_le32(header + 8) == ARCHIVE_VERSION &&
+             memcmp(trailer, ARCHIVE_INDEX_MAGIC, 8) == 0 &&
+             index_off >= ARCHIVE_HEADER_SZ &&
+             index_off + index_len + ARCHIVE_TRAILER_SZ == (uint64_t)st.st_size;
+
+        /* ================================================================
+         * STEP 2: Index
+         * ================================================================ */
+        if(ok)
+        {
+            archive->block_size = smartlog_get_le32(header + 12);
+            archive->flags = smartlog_get_le32(trailer + 12);
+            archive->dict_id = smartlog_get_le32(trailer + 28);
+            archive->nblocks = (size_t)nblocks;
+            index = malloc(index_len + 1);
+            archive->blocks = calloc(nblocks + 1, sizeof(*archive->blocks));
+            ok = index != NULL && archive->blocks != NULL &&
+                 pread_all(archive->fd, index, index_len, index_off) == 0 &&
+                 (uint32_t)crc32(0L, index, (uInt)index_len) == smartlog_get_le32(trailer + 24);
+        }
+        for(size_t i = 0; ok && i < archive->nblocks; i++)
+        {
+            smartlog_archive_block_t* b = &archive->blocks[i];
+            decode_entry(index + (i * ARCHIVE_ENTRY_SZ), b);
+            ok = b->offset >= ARCHIVE_HEADER_SZ && b->offset + b->comp_len <= index_off;
+        }
+    }
+    if(!ok && errno == 0)
+    {
+        errno = EBADMSG;
+    }
+
+    free(index);
+
+    /* ====================================================================
+     * STEP 3: Dictionary (Must Be the One the Archive Was Packed With)
+     * ==================================================================== */
+    if(ok && dict_path != NULL)
+    {
+        ok = dict_load(dict_path, &archive->dict, &archive->dict_len) == 0;
+        if(ok && ((archive->flags & ARCHIVE_FLAG_DICT) == 0 ||
+                  (uint32_t)adler32(adler32(0L, NULL, 0), archive->dict, (uInt)archive->dict_len) != archive->dict_id))
+        {
+            errno = ENOKEY;
+            ok = 0;
+        }
+    }
+
+    if(!ok)
+    {
+        int saved_errno = errno;
+        smartlog_archive_close(archive);
+        errno = saved_errno;
+        return NULL;
+    }
+    return archive;
+}
+
+size_t smartlog_archive_block_count(const smartlog_archive_t* archive)
+{
+    return archive != NULL ? archive->nblocks : 0;
+}
+
+int smartlog_archive_block_info(const smartlog_archive_t* archive, size_t index,
+                                smartlog_archive_block_t* out)
+{
+    if(archive == NULL || out == NULL)
+    {
+        errno = EINVAL;
+        return 1;
+    }
+    if(index >= archive->nblocks)
+    {
+        errno = ERANGE;
+        return 1;
+    }
+    *out = archive->blocks[index];
+    return 0;
+}
+
+long smartlog_archive_read_block(const smartlog_archive_t* archive, size_t index, char* out, size_t out_sz)
+{
+    if(archive == NULL || out == NULL)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+    if(index >= archive->nblocks)
+    {
+        errno = ERANGE;
+        return -1;
+    }
+
+    const smartlog_archive_block_t* b = &archive->blocks[index];
+    if(out_sz < b->raw_len)
+    {
+        errno = ENOBUFS;
+        return -1;
+    }
+
+    unsigned char* comp = malloc(b->comp_len != 0 ? b->comp_len : 1);
+    if(comp == NULL)
+    {
+        return -1;
+    }
+    if(pread_all(archive->fd, comp, b->comp_len, b->offset) != 0)
+    {
+        int saved_errno = errno;
+        free(comp);
+        errno = saved_errno;
+        return -1;
+    }
+
+    z_stream strm;
+    memset(&strm, 0, sizeof(strm));
+    if(inflateInit(&strm) != Z_OK)
+    {
+        free(comp);
+        errno = ENOMEM;
+        return -1;
+    }
+    strm.next_in = comp;
+    strm.avail_in = b->comp_len;
+    strm.next_out = (Bytef*)out;
+    strm.avail_out = b->raw_len;
+
+    int zrc = inflate(&strm, Z_FINISH);
+    if(zrc == Z_NEED_DICT)
+    {
+        zrc = archive->dict == NULL ? Z_NEED_DICT :
+              inflateSetDictionary(&strm, archive->dict, (uInt)archive->dict_len);
+        if(zrc == Z_OK)
+        {
+            zrc = inflate(&strm, Z_FINISH);
+        }
+    }
+    size_t raw_len = b->raw_len - strm.avail_out;
+    (void)inflateEnd(&strm);
+    free(comp);
+
+    if(zrc != Z_STREAM_END || raw_len != b->raw_len ||
+       (uint32_t)crc32(0L, (const Bytef*)out, (uInt)raw_len) != b->crc)
+    {
+        errno = zrc == Z_MEM_ERROR ? ENOMEM : (zrc == Z_NEED_DICT ? ENOKEY : EBADMSG);
+        return -1;
+    }
+
+    return (long)raw_len;
+}
+
+int smartlog_archive_query(const smartlog_archive_t* archive, uint64_t from_ns, uint64_t to_ns,
+                           unsigned int threads, int out_fd)
+{
+    if(archive == NULL || out_fd < 0 || from_ns > to_ns)
+    {
+        errno = EINVAL;
+        return 1;
+    }
+    if(threads == 0)
+    {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cpus > 0 ? (unsigned int)cpus : 1u;
+    }
+
+    /* ====================================================================
+     * STEP 1: Pick Blocks From the Index
+     * ==================================================================== */
+    size_t* picked = malloc((archive->nblocks + 1) * sizeof(*picked));
+    if(picked == NULL)
+    {
+        return 1;
+    }
+    size_t npicked = 0;
+    size_t max_raw = 1;
+    for(size_t i = 0; i < archive->nblocks; i++)
+    {
+        const smartlog_archive_block_t* b = &archive->blocks[i];
+        if(b->max_ns >= from_ns && b->min_ns <= to_ns)
+        {
+            picked[npicked++] = i;
+            max_raw = b->raw_len > max_raw ? b->raw_len : max_raw;
+        }
+    }
+    if(threads > npicked)
+    {
+        threads = npicked > 0 ? (unsigned int)npicked : 1u;
+    }
+
+    archive_job_t* jobs = calloc(threads, sizeof(*jobs));
+    pthread_t* tids = calloc(threads, sizeof(*tids));
+    int rc = jobs != NULL && tids != NULL ? 0 : 1;
+    for(unsigned int t = 0; rc == 0 && t < threads; t++)
+    {
+        jobs[t].archive = archive;
+        jobs[t].buf_sz = max_raw;
+        if((jobs[t].buf = malloc(max_raw)) == NULL)
+        {
+            rc = 1;
+        }
+    }
+
+    /* ====================================================================
+     * STEP 2: Decompress a Round of Blocks in Parallel, Write in Order
+     * ==================================================================== */
+    int saved_errno = errno;
+    for(size_t next = 0; rc == 0 && next < npicked; next += threads)
+    {
+        size_t round = npicked - next < threads ? npicked - next : threads;
+        for(size_t t = 0; t < round; t++)
+        {
+            jobs[t].index = picked[next + t];
+            jobs[t].threaded = 0;
+        }
+        for(size_t t = 1; t < round; t++)
+        {
+            /* If a thread cannot start, its block is decoded here instead */
+            jobs[t].threaded = pthread_create(&tids[t], NULL, query_worker, &jobs[t]) == 0;
+        }
+        for(size_t t = 0; t < round; t++)
+        {
+            if(!jobs[t].threaded)
+            {
+                query_worker(&jobs[t]);
+            }
+        }
+        for(size_t t = 1; t < round; t++)
+        {
+            if(jobs[t].threaded)
+            {
+                pthread_join(tids[t], NULL);
+            }
+        }
+
+        for(size_t t = 0; rc == 0 && t < round; t++)
+        {
+            const smartlog_archive_block_t* b = &archive->blocks[jobs[t].index];
+            if(jobs[t].len < 0)
+            {
+                rc = 1;
+                saved_errno = jobs[t].error;
+            }
+            else if(query_emit(jobs[t].buf, (size_t)jobs[t].len, b->min_ns == 0 && b->max_ns == UINT64_MAX,
+                               from_ns, to_ns, out_fd) != 0)
+            {
+                rc = 1;
+                saved_errno = errno;
+            }
+        }
+    }
+
+    for(unsigned int t = 0; jobs != NULL && t < threads; t++)
+    {
+        free(jobs[t].buf);
+    }
+    free(jobs);
+    free(tids);
+    free(picked);
+    errno = saved_errno;
+    return rc;
+}
+
+void smartlog_archive_close(smartlog_archive_t* archive)
+{
+    if(archive == NULL)
+    {
+        return;
+    }
+    if(archive->fd >= 0)
+    {
+        close(archive->fd);
+    }
+    free(archive->blocks);
+    free(archive->dict);
+    free(archive);
+}
@@ -0,0 +1,563 @@
+/*
+ * src/circfile.c
+ *
+ * Fixed-size circular log files for SmartLog.
+ *
+ * Implements:
+ *   - Create and preallocate (fallocate, ftruncate where unsupported),
+ *     or continue an existing circular file
+ *   - Writer: the file is mapped; a record is a frame plus a memcpy, and
+ *     the oldest records in its way are dropped by walking their frames
+ *   - Two alternating, checksummed state slots, rewritten after every
+ *     record, so the state on disk always describes whole records
+ *   - Reader: unrolls a copy of the file from the oldest record, checking
+ *     every frame's crc32 and record number
+ *
+ * Author: Aravinthraj Ganesan
+ * Version: 1.0
+ */
+
+#define _GNU_SOURCE
+#define _POSIX_C_SOURCE 199309L
+
+/* Standard includes */
+#include <errno.h>
+#include <fcntl.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <zlib.h>
+
+/* Project includes */
+#include <smartlog/circfile.h>
+#include <smartlog/config.h>
+#include <smartlog/utils.h>
+
+/* ============================================================================
+ * Format Constants
+ * ============================================================================ */
+
+#define CIRC_MAGIC          "SLCIRC01"
+#define CIRC_VERSION        1u
+#define CIRC_DATA_OFF       4096u
+#define CIRC_SLOT_OFF       64u     /* Slot i at CIRC_SLOT_OFF + i * CIRC_SLOT_SZ */
+#define CIRC_SLOT_SZ        64u
+#define CIRC_SLOT_CRC_LEN   48u     /* Slot bytes covered by its crc */
+#define CIRC_FRAME_HDR      16u
+#define CIRC_PAD            0xFFFFFFFFu
+
+#define CIRC_ALIGN8(n)      (((n) + 7u) & ~(uint64_t)7u)
+
+/* ============================================================================
+ * Internal Types
+ * ============================================================================ */
+
+typedef struct {
+    uint64_t generation;
+    uint64_t head;
+    uint64_t tail;
+    uint64_t records;
+    uint64_t wraps;
+    uint64_t written;
+} circ_state_t;
+
+struct smartlog_circfile {
+    int fd;
+    unsigned char* map;     /* Whole file */
+    size_t map_size;
+    unsigned char* data;    /* map + CIRC_DATA_OFF */
+    uint64_t capacity;
+    circ_state_t st;
+};
+
+/* ============================================================================
+ * Encoding Helpers
+ * ============================================================================ */
+
+static uint32_t line_crc(const void* data, size_t len)
+{
+    /* Lines are at most SMARTLOG_LOG_BUFFER_SZ, well within uInt */
+    return (uint32_t)crc32(crc32(0L, Z_NULL, 0), (const Bytef*)data, (uInt)len);
+}
+
+static uint64_t frame_size(uint64_t len)
+{
+    return CIRC_FRAME_HDR + CIRC_ALIGN8(len);
+}
+
+static void header_encode(unsigned char* page, uint64_t capacity)
+{
+    memset(page, 0, CIRC_SLOT_OFF);
+    memcpy(page, CIRC_MAGIC, 8);
+    smartlog_put_le32(page + 8, CIRC_VERSION);
+    smartlog_put_le32(page + 12, CIRC_DATA_OFF);
+    smartlog_put_le64(page + 16, capacity);
+}
+
+/**
+ * Check the fixed header against the file size.
+ *
+ * Return: 0 on success, -1 on error (errno is set: EBADMSG)
+ */
+static int header_decode(const unsigned char* page, uint64_t file_size, uint64_t* capacity)
+{
+    if(memcmp(page, CIRC_MAGIC, 8) != 0 || smartlog_get_le32(page + 8) != CIRC_VERSION ||
+       smartlog_get_le32(page + 12) != CIRC_DATA_OFF)
+    {
+        errno = EBADMSG;
+        return -1;
+    }
+
+    *capacity = smartlog_get_le64(page + 16);
+    if(*capacity < SMARTLOG_CIRC_MIN_BYTES || *capacity % 8 != 0 || file_size != CIRC_DATA_OFF + *capacity)
+    {
+        errno = EBADMSG;
+        return -1;
+    }
+    return 0;
+}
+
+/** Write st into its slot (the one the previous generation did not use) */
+static void state_encode(unsigned char* page, const circ_state_t* st)
+{
+    unsigned char* slot = page + CIRC_SLOT_OFF + (st->generation % 2) * CIRC_SLOT_SZ;
+    smartlog_put_le64(slot, st->generation);
+    smartlog_put_le64(slot + 8, st->head);
+    smartlog_put_le64(slot + 16, st->tail);
+    smartlog_put_le64(slot + 24, st->records);
+    smartlog_put_le64(slot + 32, st->wraps);
+    smartlog_put_le64(slot + 40, st->written);
+    smartlog_put_le32(slot + CIRC_SLOT_CRC_LEN, line_crc(slot, CIRC_SLOT_CRC_LEN));
+}
+
+/**
+ * Load the newest valid state slot.
+ *
+ * Return: 0 on success, -1 on error (errno is set: EBADMSG)
+ */
+static int state_decode(const unsigned char* page, uint64_t capacity, circ_state_t* out)
+{
+    int found = 0;
+    for(unsigned int i = 0; i < 2; i++)
+    {
+        const unsigned char* slot = page + CIRC_SLOT_OFF + i * CIRC_SLOT_SZ;
+        if(smartlog_get_le32(slot + CIRC_SLOT_CRC_LEN) != line_crc(slot, CIRC_SLOT_CRC_LEN))
+        {
+            continue;
+        }
+
+        circ_state_t st;
+        st.generation = smartlog_get_le64(slot);
+        st.head = smartlog_get_le64(slot + 8);
+        st.tail = smartlog_get_le64(slot + 16);
+        st.records = smartlog_get_le64(slot + 24);
+        st.wraps = smartlog_get_le64(slot + 32);
+        st.written = smartlog_get_le64(slot + 40);
+        if(st.head >= capacity || st.tail > capacity || st.head % 8 != 0 || st.tail % 8 != 0 ||
+           st.records > capacity / CIRC_FRAME_HDR || st.records > st.written)
+        {
+            continue;
+        }
+        if(found == 0 || st.generation > out->generation)
+        {
+            *out = st;
+            found = 1;
+        }
+    }
+
+    if(found == 0)
+    {
+        errno = EBADMSG;
+        return -1;
+    }
+    return 0;
+}
+
+/** Data offset of the record at pos, after following a pad or the end */
+static uint64_t record_start(const unsigned char* data, uint64_t capacity, uint64_t pos)
+{
+    if(capacity - pos < CIRC_FRAME_HDR || smartlog_get_le32(data + pos) == CIRC_PAD)
+    {
+        return 0;
+    }
+    return pos;
+}
+
+/* ============================================================================
+ * Writer Helpers
+ * ============================================================================ */
+
+/** Drop the oldest records while the oldest starts in [from, from + len) */
+static void circ_drop_range(smartlog_circfile_t* cf, uint64_t from, uint64_t len)
+{
+    circ_state_t* st = &cf->st;
+    while(st->records > 0 && st->head >= from && st->head < from + len)
+    {
+        st->head += frame_size(smartlog_get_le32(cf->data + st->head));
+        st->records--;
+        if(st->records > 0)
+        {
+            st->head = record_start(cf->data, cf->capacity, st->head);
+        }
+    }
+}
+
+/**
+ * Create the file at its full size and write an empty state.
+ *
+ * Return: 0 on success, -1 on error (errno is set)
+ */
+static int circ_init(int fd, const char* path, uint64_t capacity)
+{
+    /* Blocks are reserved now, so later page writes cannot hit ENOSPC */
+    int rc = posix_fallocate(fd, 0, (off_t)(CIRC_DATA_OFF + capacity));
+    if(rc == EOPNOTSUPP || rc == EINVAL)
+    {
+        rc = ftruncate(fd, (off_t)(CIRC_DATA_OFF + capacity)) == 0 ? 0 : errno;
+    }
+    if(rc != 0)
+    {
+        errno = rc;
+        return -1;
+    }
+
+    unsigned char page[CIRC_DATA_OFF];
+    memset(page, 0, sizeof(page));
+    header_encode(page, capacity);
+    circ_state_t st;
+    memset(&st, 0, sizeof(st));
+    st.generation = 1;
+    state_encode(page, &st);
+
+    if(pwrite(fd, page, sizeof(page), 0) != (ssize_t)sizeof(page))
+    {
+        if(errno == 0)
+        {
+            errno = EIO;
+        }
+        return -1;
+    }
+
+    /* The only metadata change in the file's life */
+    if(fdatasync(fd) != 0 || smartlog_fsync_parent_dir(path) != 0)
+    {
+        return -1;
+    }
+    return 0;
+}
+
+/* ============================================================================
+ * Public API
+ * ============================================================================ */
+
+smartlog_circfile_t* smartlog_circfile_open(const char* path, size_t capacity)
+{
+    if(path == NULL || capacity < SMARTLOG_CIRC_MIN_BYTES || capacity % 8 != 0 ||
+       (uint64_t)capacity > (uint64_t)SIZE_MAX - CIRC_DATA_OFF)
+    {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    smartlog_circfile_t* cf = calloc(1, sizeof(*cf));
+    if(cf == NULL)
+    {
+        return NULL;
+    }
+    cf->fd = -1;
+    cf->map = MAP_FAILED;
+    cf->capacity = capacity;
+    cf->map_size = CIRC_DATA_OFF + capacity;
+
+    /* ====================================================================
+     * STEP 1: Open, Creating and Preallocating a New File
+     * ==================================================================== */
+    cf->fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, SMARTLOG_FILE_MODE);
+    struct stat st;
+    if(cf->fd < 0 || fstat(cf->fd, &st) != 0)
+    {
+        goto fail;
+    }
+    if(S_ISREG(st.st_mode) == 0)
+    {
+        errno = EINVAL;
+        goto fail;
+    }
+    if(st.st_size == 0 && circ_init(cf->fd, path, capacity) != 0)
+    {
+        goto fail;
+    }
+
+    /* ====================================================================
+     * STEP 2: Map and Check the Header and State
+     * ==================================================================== */
+    unsigned char page[CIRC_DATA_OFF];
+    if(pread(cf->fd, page, sizeof(page), 0) != (ssize_t)sizeof(page))
+    {
+        errno = EBADMSG;
+        goto fail;
+    }
+    if(fstat(cf->fd, &st) != 0)
+    {
+        goto fail;
+    }
+    uint64_t file_capacity = 0;
+    if(header_decode(page, (uint64_t)st.st_size, &file_capacity) != 0 ||
+       state_decode(page, file_capacity, &cf->st) != 0)
+    {
+        goto fail;
+    }
+    if(file_capacity != capacity)
+    {
+        errno = EINVAL;
+        goto fail;
+    }
+
+    cf->map = mmap(NULL, cf->map_size, PROT_READ | PROT_WRITE, MAP_SHARED, cf->fd, 0);
+    if(cf->map == MAP_FAILED)
+    {
+        goto fail;
+    }
+    cf->data = cf->map + CIRC_DATA_OFF;
+    return cf;
+
+fail:
+    {
+        int saved_errno = errno;
+        smartlog_circfile_close(cf);
+        errno = saved_errno;
+    }
+    return NULL;
+}
+
+int smartlog_circfile_append(smartlog_circfile_t* cf, const void* data, size_t len)
+{
+    if(cf == NULL || (data == NULL && len != 0))
+    {
+        errno = EINVAL;
+        return -1;
+    }
+    if(len > SMARTLOG_LOG_BUFFER_SZ)
+    {
+        errno = EMSGSIZE;
+        return -1;
+    }
+
+    circ_state_t* st = &cf->st;
+    uint64_t cap = cf->capacity;
+    uint64_t need = frame_size(len);
+
+    /* ====================================================================
+     * STEP 1: Go Back to the Start if the Record Does Not Fit Before the End
+     * ==================================================================== */
+    if(st->tail + need > cap)
+    {
+        /* Whatever starts between here and the end is skipped, so it is lost */
+        circ_drop_range(cf, st->tail, cap - st->tail);
+        if(cap - st->tail >= CIRC_FRAME_HDR)
+        {
+            smartlog_put_le32(cf->data + st->tail, CIRC_PAD);
+        }
+        st->tail = 0;
+        st->wraps++;
+    }
+
+    /* ====================================================================
+     * STEP 2: Drop the Oldest Records in the Way
+     * ==================================================================== */
+    circ_drop_range(cf, st->tail, need);
+    if(st->records == 0)
+    {
+        st->head = st->tail;
+    }
+
+    /* ====================================================================
+     * STEP 3: Write the Frame and the Line
+     * ==================================================================== */
+    unsigned char* frame = cf->data + st->tail;
+    smartlog_put_le32(frame, (uint32_t)len);
+    smartlog_put_le32(frame + 4, line_crc(data, len));
+    smartlog_put_le64(frame + 8, st->written);
+    if(len != 0)
+    {
+        memcpy(frame + CIRC_FRAME_HDR, data, len);
+    }
+    memset(frame + CIRC_FRAME_HDR + len, 0, (size_t)(need - CIRC_FRAME_HDR - len));
+
+    st->tail += need;
+    st->records++;
+    st->written++;
+
+    /* ====================================================================
+     * STEP 4: Publish the State (After the Record, Never Before)
+     * ==================================================================== */
+    atomic_thread_fence(memory_order_release);
+    st->generation++;
+    state_encode(cf->map, st);
+    return 0;
+}
+
+int smartlog_circfile_sync(smartlog_circfile_t* cf)
+{
+    if(cf == NULL)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+    return msync(cf->map, cf->map_size, MS_SYNC) == 0 ? 0 : -1;
+}
+
+void smartlog_circfile_get_info(const smartlog_circfile_t* cf, smartlog_circfile_info_t* out)
+{
+    if(cf == NULL || out == NULL)
+    {
+        return;
+    }
+
+    memset(out, 0, sizeof(*out));
+    out->capacity = cf->capacity;
+    out->head = cf->st.head;
+    out->tail = cf->st.tail;
+    out->records = cf->st.records;
+    out->wraps = cf->st.wraps;
+    out->written = cf->st.written;
+}
+
+void smartlog_circfile_close(smartlog_circfile_t* cf)
+{
+    if(cf == NULL)
+    {
+        return;
+    }
+
+    if(cf->map != MAP_FAILED)
+    {
+        munmap(cf->map, cf->map_size);
+    }
+    if(cf->fd >= 0)
+    {
+        close(cf->fd);
+    }
+    free(cf);
+}
+
+int smartlog_circfile_read(const char* path, smartlog_circfile_fn fn, void* arg, smartlog_circfile_info_t* info)
+{
+    if(path == NULL || fn == NULL)
+    {
+        errno = EINVAL;
+        return 1;
+    }
+
+    /* ====================================================================
+     * STEP 1: Copy the File
+     * ==================================================================== */
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if(fd < 0)
+    {
+        return 1;
+    }
+    struct stat sb;
+    if(fstat(fd, &sb) != 0)
+    {
+        int saved_errno = errno;
+        close(fd);
+        errno = saved_errno;
+        return 1;
+    }
+    if(sb.st_size < (off_t)CIRC_DATA_OFF || (uint64_t)sb.st_size > (uint64_t)SIZE_MAX)
+    {
+        close(fd);
+        errno = EBADMSG;
+        return 1;
+    }
+
+    size_t size = (size_t)sb.st_size;
+    unsigned char* copy = malloc(size);
+    if(copy == NULL)
+    {
+        close(fd);
+        errno = ENOMEM;
+        return 1;
+    }
+
+    /* State first, so records written during the copy are at worst extra */
+    size_t done = 0;
+    while(done < size)
+    {
+        ssize_t n = pread(fd, copy + done, size - done, (off_t)done);
+        if(n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if(n <= 0)
+        {
+            int saved_errno = n < 0 ? errno : EBADMSG;
+            free(copy);
+            close(fd);
+            errno = saved_errno;
+            return 1;
+        }
+        done += (size_t)n;
+    }
+    close(fd);
+
+    /* ====================================================================
+     * STEP 2: Check the Header and Pick the State
+     * ==================================================================== */
+    uint64_t cap = 0;
+    circ_state_t st;
+    if(header_decode(copy, (uint64_t)size, &cap) != 0 || state_decode(copy, cap, &st) != 0)
+    {
+        free(copy);
+        errno = EBADMSG;
+        return 1;
+    }
+    if(info != NULL)
+    {
+        info->capacity = cap;
+        info->head = st.head;
+        info->tail = st.tail;
+        info->records = st.records;
+        info->wraps = st.wraps;
+        info->written = st.written;
+        info->damaged = 0;
+    }
+
+    /* ====================================================================
+     * STEP 3: Walk From the Oldest Record
+     * ==================================================================== */
+    const unsigned char* data = copy + CIRC_DATA_OFF;
+    uint64_t pos = st.head;
+    uint64_t number = st.written - st.records;
+    for(uint64_t i = 0; i < st.records; i++, number++)
+    {
+        pos = record_start(data, cap, pos);
+        const unsigned char* frame = data + pos;
+        uint32_t len = smartlog_get_le32(frame);
+
+        /* Overwritten while copying, or damaged: nothing after it can be trusted */
+        if(len > SMARTLOG_LOG_BUFFER_SZ || pos + frame_size(len) > cap ||
+           smartlog_get_le64(frame + 8) != number ||
+           smartlog_get_le32(frame + 4) != line_crc(frame + CIRC_FRAME_HDR, len))
+        {
+            if(info != NULL)
+            {
+                info->damaged = st.records - i;
+            }
+            break;
+        }
+
+        if(fn((const char*)frame + CIRC_FRAME_HDR, len, number, arg) != 0)
+        {
+            break;
+        }
+        pos += frame_size(len);
+    }
+
+    free(copy);
+    return 0;
+}
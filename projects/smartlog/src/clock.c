@@ -0,0 +1,343 @@
+/*
+ * src/clock.c
+ *
+ * Anchored log clocks for SmartLog.
+ *
+ * Implements:
+ *   - Invariant TSC detection and TSC calibration against
+ *     CLOCK_MONOTONIC_RAW
+ *   - Periodic realtime anchors published under a sequence counter
+ *   - Rate tracking between anchors, bounded to follow NTP slewing only
+ *   - Overflow-free 32.32 fixed-point conversion to wall time
+ *
+ * Author: Aravinthraj Ganesan
+ * Version: 1.0
+ */
+
+#define _GNU_SOURCE
+#define _POSIX_C_SOURCE 199309L
+
+/* Standard includes */
+#include <errno.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#include <x86intrin.h>
+#define SMARTLOG_HAVE_TSC 1
+#else
+#define SMARTLOG_HAVE_TSC 0
+#endif
+
+/* Project includes */
+#include <smartlog/clock.h>
+#include <smartlog/config.h>
+#include <smartlog/utils.h>
+
+/* ============================================================================
+ * Internal Types
+ * ============================================================================ */
+
+struct smartlog_clock {
+    clock_mode_t mode;
+    uint64_t cal_mult;              /* Calibrated rate, 32.32 */
+    uint64_t period_raw;            /* Anchor period in counter units */
+
+    /* Current anchor, odd seq while it is being replaced */
+    atomic_uint seq;
+    atomic_uint_fast64_t base_raw;
+    atomic_uint_fast64_t base_real;
+    atomic_uint_fast64_t mult;
+
+    atomic_uint_fast64_t next_raw;  /* Counter value that triggers a re-anchor */
+    atomic_int anchoring;           /* One thread re-anchors at a time */
+};
+
+/* ============================================================================
+ * Counter Helpers
+ * ============================================================================ */
+
+static uint64_t raw_ns(clockid_t id)
+{
+    struct timespec ts;
+    if(clock_gettime(id, &ts) != 0)
+    {
+        return 0;
+    }
+    return ((uint64_t)ts.tv_sec * UINT64_C(1000000000)) + (uint64_t)ts.tv_nsec;
+}
+
+static uint64_t counter_read(clock_mode_t mode)
+{
+#if SMARTLOG_HAVE_TSC
+    if(mode == CLOCK_MODE_TSC)
+    {
+        return (uint64_t)__rdtsc();
+    }
+#else
+    (void)mode;
+#endif
+    return raw_ns(CLOCK_MONOTONIC_RAW);
+}
+
+/**
+ * (delta * mult) >> 32 without overflowing 64 bits.
+ */
+static uint64_t scale(uint64_t delta, uint64_t mult)
+{
+    uint64_t mult_hi = mult >> 32;
+    uint64_t mult_lo = mult & UINT64_C(0xffffffff);
+    uint64_t delta_hi = delta >> 32;
+    uint64_t delta_lo = delta & UINT64_C(0xffffffff);
+
+    return (delta * mult_hi) + (delta_hi * mult_lo) + ((delta_lo * mult_lo) >> 32);
+}
+
+/**
+ * Measure TSC ticks against CLOCK_MONOTONIC_RAW.
+ *
+ * Return: Nanoseconds per tick in 32.32, 0 on error (errno is set)
+ */
+static uint64_t tsc_calibrate(void)
+{
+    struct timespec pause = { 0, SMARTLOG_CLOCK_CALIBRATE_MS * 1000000L };
+
+    uint64_t ns0 = raw_ns(CLOCK_MONOTONIC_RAW);
+    uint64_t tsc0 = counter_read(CLOCK_MODE_TSC);
+    while(nanosleep(&pause, &pause) != 0 && errno == EINTR)
+    {
+    }
+    uint64_t ns1 = raw_ns(CLOCK_MONOTONIC_RAW);
+    uint64_t tsc1 = counter_read(CLOCK_MODE_TSC);
+
+    if(ns0 == 0 || ns1 <= ns0 || tsc1 <= tsc0)
+    {
+        errno = ENOTSUP;
+        return 0;
+    }
+
+    return ((ns1 - ns0) << 32) / (tsc1 - tsc0);
+}
+
+/* ============================================================================
+ * Anchor Helpers
+ * ============================================================================ */
+
+/**
+ * Take a new anchor (caller holds clk->anchoring).
+ *
+ * Return: 0 on success, -1 on error (errno is set)
+ */
+static int clock_anchor(smartlog_clock_t* clk, smartlog_clock_anchor_t* out)
+{
+    /* Bracket the realtime read and use the midpoint of the counter */
+    uint64_t raw0 = counter_read(clk->mode);
+    uint64_t real = raw_ns(CLOCK_REALTIME);
+    uint64_t raw1 = counter_read(clk->mode);
+    if(real == 0 || raw1 < raw0)
+    {
+        if(errno == 0)
+        {
+            errno = EIO;
+        }
+        return -1;
+    }
+    uint64_t raw = raw0 + ((raw1 - raw0) / 2);
+
+    uint64_t old_raw = atomic_load_explicit(&clk->base_raw, memory_order_relaxed);
+    uint64_t old_real = atomic_load_explicit(&clk->base_real, memory_order_relaxed);
+    uint64_t mult = atomic_load_explicit(&clk->mult, memory_order_relaxed);
+
+    /*
+     * Re-measure the rate over the last period. A slew stays within
+     * SMARTLOG_CLOCK_MAX_PPM of the calibrated rate; anything larger is a
+     * step (or suspend), which the new anchor absorbs without a rate change.
+     */
+    if(old_real != 0 && raw - old_raw >= clk->period_raw / 2 && real > old_real)
+    {
+        double measured = ((double)(real - old_real) / (double)(raw - old_raw)) * 4294967296.0;
+        double bound = (double)clk->cal_mult * (SMARTLOG_CLOCK_MAX_PPM / 1e6);
+        if(measured >= (double)clk->cal_mult - bound && measured <= (double)clk->cal_mult + bound)
+        {
+            mult = (uint64_t)measured;
+        }
+    }
+
+    unsigned int seq = atomic_load_explicit(&clk->seq, memory_order_relaxed);
+    atomic_store_explicit(&clk->seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&clk->base_raw, raw, memory_order_relaxed);
+    atomic_store_explicit(&clk->base_real, real, memory_order_relaxed);
+    atomic_store_explicit(&clk->mult, mult, memory_order_relaxed);
+    atomic_store_explicit(&clk->seq, seq + 2, memory_order_release);
+
+    atomic_store_explicit(&clk->next_raw, raw + clk->period_raw, memory_order_relaxed);
+
+    out->mode = clk->mode;
+    out->raw = raw;
+    out->real_ns = real;
+    out->mult = mult;
+    return 0;
+}
+
+/* ============================================================================
+ * Public API
+ * ============================================================================ */
+
+int smartlog_clock_tsc_invariant(void)
+{
+#ifdef SMARTLOG_TEST_FAULTS
+    const char* force_variant = getenv("SMARTLOG_FAKE_TSC_VARIANT");
+    if(force_variant != NULL && strcmp(force_variant, "1") == 0)
+    {
+        return 0;
+    }
+#endif
+
+#if SMARTLOG_HAVE_TSC
+    unsigned int eax = 0;
+    unsigned int ebx = 0;
+    unsigned int ecx = 0;
+    unsigned int edx = 0;
+
+    if(__get_cpuid(0x80000000u, &eax, &ebx, &ecx, &edx) == 0 || eax < 0x80000007u)
+    {
+        return 0;
+    }
+    if(__get_cpuid(0x80000007u, &eax, &ebx, &ecx, &edx) == 0)
+    {
+        return 0;
+    }
+    return (edx & (1u << 8)) != 0;
+#else
+    return 0;
+#endif
+}
+
+smartlog_clock_t* smartlog_clock_create(clock_mode_t mode)
+{
+    if(mode != CLOCK_MODE_MONOTONIC_RAW && mode != CLOCK_MODE_TSC)
+    {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    uint64_t cal_mult = UINT64_C(1) << 32;
+    if(mode == CLOCK_MODE_TSC)
+    {
+        if(!smartlog_clock_tsc_invariant())
+        {
+            errno = ENOTSUP;
+            return NULL;
+        }
+        if((cal_mult = tsc_calibrate()) == 0)
+        {
+            return NULL;
+        }
+    }
+    else if(raw_ns(CLOCK_MONOTONIC_RAW) == 0)
+    {
+        return NULL;
+    }
+
+    smartlog_clock_t* clk = calloc(1, sizeof(*clk));
+    if(clk == NULL)
+    {
+        return NULL;
+    }
+
+    clk->mode = mode;
+    clk->cal_mult = cal_mult;
+    clk->period_raw = ((uint64_t)SMARTLOG_CLOCK_ANCHOR_MS * UINT64_C(1000000) << 32) / cal_mult;
+    atomic_init(&clk->seq, 0);
+    atomic_init(&clk->base_raw, 0);
+    atomic_init(&clk->base_real, 0);
+    atomic_init(&clk->mult, cal_mult);
+    atomic_init(&clk->next_raw, 0);
+    atomic_init(&clk->anchoring, 0);
+
+    /* Valid base for every reader; next_raw = 0 makes the first read anchor again and report it */
+    smartlog_clock_anchor_t first;
+    if(clock_anchor(clk, &first) != 0)
+    {
+        int saved_errno = errno;
+        free(clk);
+        errno = saved_errno;
+        return NULL;
+    }
+    atomic_store_explicit(&clk->next_raw, 0, memory_order_relaxed);
+
+    return clk;
+}
+
+uint64_t smartlog_clock_now(smartlog_clock_t* clk, smartlog_clock_anchor_t* anchor, int* anchored)
+{
+    if(clk == NULL || anchor == NULL || anchored == NULL)
+    {
+        errno = EINVAL;
+        return 0;
+    }
+    *anchored = 0;
+
+    uint64_t raw = counter_read(clk->mode);
+    if(raw == 0 && clk->mode != CLOCK_MODE_TSC)
+    {
+        return 0;
+    }
+
+    /* ====================================================================
+     * STEP 1: Re-anchor When the Period Has Passed (One Thread Only)
+     * ==================================================================== */
+    if(raw >= atomic_load_explicit(&clk->next_raw, memory_order_relaxed))
+    {
+        int expected = 0;
+        if(atomic_compare_exchange_strong_explicit(&clk->anchoring, &expected, 1,
+                                                   memory_order_acquire, memory_order_relaxed))
+        {
+            int rc = clock_anchor(clk, anchor);
+            atomic_store_explicit(&clk->anchoring, 0, memory_order_release);
+            if(rc != 0)
+            {
+                return 0;
+            }
+            *anchored = 1;
+            return anchor->real_ns;
+        }
+    }
+
+    /* ====================================================================
+     * STEP 2: Convert Against the Current Anchor
+     * ==================================================================== */
+    uint64_t base_raw;
+    uint64_t base_real;
+    uint64_t mult;
+    unsigned int seq;
+    do
+    {
+        seq = atomic_load_explicit(&clk->seq, memory_order_acquire);
+        base_raw = atomic_load_explicit(&clk->base_raw, memory_order_relaxed);
+        base_real = atomic_load_explicit(&clk->base_real, memory_order_relaxed);
+        mult = atomic_load_explicit(&clk->mult, memory_order_relaxed);
+        atomic_thread_fence(memory_order_acquire);
+    } while((seq & 1u) != 0 || seq != atomic_load_explicit(&clk->seq, memory_order_relaxed));
+
+    /* Another thread may have anchored after this thread read the counter */
+    if(raw < base_raw)
+    {
+        return base_real - scale(base_raw - raw, mult);
+    }
+    return base_real + scale(raw - base_raw, mult);
+}
+
+clock_mode_t smartlog_clock_mode(const smartlog_clock_t* clk)
+{
+    return clk != NULL ? clk->mode : CLOCK_MODE_REALTIME;
+}
+
+void smartlog_clock_destroy(smartlog_clock_t* clk)
+{
+    free(clk);
+}
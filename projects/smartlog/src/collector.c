@@ -0,0 +1,881 @@
+/*
+ * src/collector.c
+ *
+ * Local log collector implementation.
+ *
+ * Implements:
+ *   - recvmmsg() straight into free line slots (no extra copy)
+ *   - Shared-memory ring clients: accept, drain, idle-only wakeups
+ *   - Min-heap ordered by (timestamp, arrival) for the reorder window
+ *   - One output batch per emit cycle (group commit in durable mode)
+ *
+ * Author: Aravinthraj Ganesan
+ * Version: 1.0
+ */
+
+#define _GNU_SOURCE
+#define _POSIX_C_SOURCE 199309L
+
+/* Standard includes */
+#include <errno.h>
+#include <poll.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+/* Project includes */
+#include <smartlog/collector.h>
+#include <smartlog/config.h>
+#include <smartlog/shm_ring.h>
+#include <smartlog/sink.h>
+#include <smartlog/smartlog_core.h>
+#include <smartlog/utils.h>
+
+/* ============================================================================
+ * Internal Types
+ * ============================================================================ */
+
+/** One held line. */
+typedef struct {
+    size_t len;
+    char data[SMARTLOG_LOG_BUFFER_SZ];
+} collector_slot_t;
+
+/** Heap entry: order key plus slot index. */
+typedef struct {
+    uint64_t time_ns;
+    uint64_t seq;               /* Arrival order, breaks timestamp ties */
+    uint32_t slot;
+} collector_entry_t;
+
+/** One shared-memory client. */
+typedef struct {
+    smartlog_shm_ring_t* ring;
+    int conn_fd;                /* Hangup here means the client exited */
+} collector_ring_t;
+
+/** One accepted ring client still owing its hello. */
+typedef struct {
+    int conn_fd;
+    uint64_t deadline_ns;       /* Dropped if the hello is not in by then */
+} collector_pending_t;
+
+struct smartlog_collector {
+    int sock_fd;
+    char socket_path[sizeof(((struct sockaddr_un*)0)->sun_path)];
+
+    /* Shared-memory clients */
+    int ring_listen_fd;
+    char ring_socket_path[sizeof(((struct sockaddr_un*)0)->sun_path)];
+    collector_ring_t rings[SMARTLOG_COLLECTOR_MAX_RINGS];
+    size_t ring_count;
+    collector_pending_t pending[SMARTLOG_COLLECTOR_MAX_RINGS];
+    size_t pending_count;
+    uint64_t ring_dropped_gone; /* Drops from clients already detached */
+
+    smartlog_sink_t* out;
+    uint64_t window_ns;
+
+    /* Line storage */
+    collector_slot_t* slots;
+    smartlog_region_t slots_region;
+    size_t capacity;
+    uint32_t* free_list;
+    size_t free_count;
+
+    /* Reorder heap */
+    collector_entry_t* heap;
+    size_t heap_len;
+    uint64_t next_seq;
+    uint64_t last_emitted_ns;
+
+    /* Scratch for one emit cycle */
+    struct iovec* iov;
+
+    smartlog_collector_stats_t stats;
+};
+
+/* ============================================================================
+ * Heap Helpers
+ * ============================================================================ */
+
+static int entry_less(const collector_entry_t* a, const collector_entry_t* b)
+{
+    if(a->time_ns != b->time_ns)
+    {
+        return a->time_ns < b->time_ns;
+    }
+    return a->seq < b->seq;
+}
+
+static void heap_push(smartlog_collector_t* c, collector_entry_t e)
+{
+    size_t i = c->heap_len++;
+    while(i > 0)
+    {
+        size_t parent = (i - 1) / 2;
+        if(!entry_less(&e, &c->heap[parent]))
+        {
+            break;
+        }
+        c->heap[i] = c->heap[parent];
+        i = parent;
+    }
+    c->heap[i] = e;
+}
+
+static collector_entry_t heap_pop(smartlog_collector_t* c)
+{
+    collector_entry_t top = c->heap[0];
+    collector_entry_t last = c->heap[--c->heap_len];
+
+    size_t i = 0;
+    for(;;)
+    {
+        size_t child = (2 * i) + 1;
+        if(child >= c->heap_len)
+        {
+            break;
+        }
+        if(child + 1 < c->heap_len && entry_less(&c->heap[child + 1], &c->heap[child]))
+        {
+            child++;
+        }
+        if(!entry_less(&c->heap[child], &last))
+        {
+            break;
+        }
+        c->heap[i] = c->heap[child];
+        i = child;
+    }
+    if(c->heap_len > 0)
+    {
+        c->heap[i] = last;
+    }
+
+    return top;
+}
+
+/* ============================================================================
+ * Receive and Emit
+ * ============================================================================ */
+
+/**
+ * Add a received slot to the reorder heap.
+ */
+static void collector_hold(smartlog_collector_t* c, uint32_t slot, uint64_t now_ns)
+{
+    collector_entry_t e;
+    if(smartlog_line_timestamp(c->slots[slot].data, c->slots[slot].len, &e.time_ns) != 0)
+    {
+        /* Foreign line: order it by arrival time */
+        e.time_ns = now_ns;
+    }
+    e.seq = c->next_seq++;
+    e.slot = slot;
+
+    heap_push(c, e);
+    c->stats.received++;
+}
+
+/**
+ * Write lines from the heap top while they are due (or all if force).
+ * One batch per call; the file sink syncs once for the whole batch.
+ */
+static int collector_emit(smartlog_collector_t* c, int force, size_t min_free)
+{
+    uint64_t now_ns = smartlog_timestamp_ns();
+    uint64_t cutoff = now_ns > c->window_ns ? now_ns - c->window_ns : 0;
+
+    int count = 0;
+    uint32_t* emitted = c->free_list + c->free_count;
+
+    while(c->heap_len > 0)
+    {
+        /* Emit when due, when forced, or when storage is running low */
+        int due = c->heap[0].time_ns <= cutoff;
+        if(!due && !force && c->free_count + (size_t)count >= min_free)
+        {
+            break;
+        }
+
+        collector_entry_t e = heap_pop(c);
+        if(e.time_ns < c->last_emitted_ns)
+        {
+            c->stats.late++;
+        }
+        else
+        {
+            c->last_emitted_ns = e.time_ns;
+        }
+
+        c->iov[count].iov_base = c->slots[e.slot].data;
+        c->iov[count].iov_len = c->slots[e.slot].len;
+        emitted[count] = e.slot;
+        count++;
+    }
+
+    if(count == 0)
+    {
+        return 0;
+    }
+
+    int rc = smartlog_sink_write_lines(c->out, c->iov, count);
+    int saved_errno = errno;
+
+    /* Slots are free again whether or not the write worked */
+    c->free_count += (size_t)count;
+    c->stats.commits++;
+    if(rc == 0)
+    {
+        c->stats.written += (uint64_t)count;
+    }
+
+    errno = saved_errno;
+    return rc;
+}
+
+/**
+ * Receive every pending datagram with recvmmsg() into free slots.
+ */
+static int collector_receive(smartlog_collector_t* c)
+{
+    struct mmsghdr msgs[SMARTLOG_WRITER_BATCH];
+    struct iovec iov[SMARTLOG_WRITER_BATCH];
+    uint32_t taken[SMARTLOG_WRITER_BATCH];
+
+    for(;;)
+    {
+        /* Keep a batch worth of free slots; emit early if storage is low */
+        if(c->free_count < SMARTLOG_WRITER_BATCH &&
+           collector_emit(c, 0, SMARTLOG_WRITER_BATCH) != 0)
+        {
+            return -1;
+        }
+
+        size_t want = c->free_count < SMARTLOG_WRITER_BATCH ? c->free_count : SMARTLOG_WRITER_BATCH;
+        if(want == 0)
+        {
+            return 0;
+        }
+
+        memset(msgs, 0, sizeof(msgs[0]) * want);
+        for(size_t i = 0; i < want; i++)
+        {
+            taken[i] = c->free_list[--c->free_count];
+            iov[i].iov_base = c->slots[taken[i]].data;
+            iov[i].iov_len = sizeof(c->slots[taken[i]].data);
+            msgs[i].msg_hdr.msg_iov = &iov[i];
+            msgs[i].msg_hdr.msg_iovlen = 1;
+        }
+
+        int got = recvmmsg(c->sock_fd, msgs, (unsigned int)want, MSG_DONTWAIT, NULL);
+        int saved_errno = errno;
+        int used = got > 0 ? got : 0;
+
+        uint64_t now_ns = smartlog_timestamp_ns();
+        for(int i = 0; i < used; i++)
+        {
+            c->slots[taken[i]].len = msgs[i].msg_len;
+            if(msgs[i].msg_len == 0)
+            {
+                c->free_list[c->free_count++] = taken[i];
+                continue;
+            }
+            collector_hold(c, taken[i], now_ns);
+        }
+
+        /* Return the slots recvmmsg did not fill */
+        for(size_t i = (size_t)used; i < want; i++)
+        {
+            c->free_list[c->free_count++] = taken[i];
+        }
+
+        if(got < 0)
+        {
+            if(saved_errno == EAGAIN || saved_errno == EWOULDBLOCK || saved_errno == EINTR)
+            {
+                return 0;
+            }
+            errno = saved_errno;
+            return -1;
+        }
+        if((size_t)got < want)
+        {
+            return 0;
+        }
+    }
+}
+
+/* ============================================================================
+ * Shared-Memory Clients
+ * ============================================================================ */
+
+/**
+ * Bind a listening SOCK_SEQPACKET or SOCK_DGRAM socket, replacing a stale
+ * socket file.
+ */
+static int collector_bind(const char* path, int type)
+{
+    int fd = socket(AF_UNIX, type | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if(fd < 0)
+    {
+        return -1;
+    }
+
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    memcpy(addr.sun_path, path, strlen(path) + 1);
+
+    struct stat st;
+    if(lstat(path, &st) == 0 && S_ISSOCK(st.st_mode))
+    {
+        (void)unlink(path);
+    }
+
+    if(bind(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 ||
+       (type == SOCK_SEQPACKET && listen(fd, SOMAXCONN) != 0))
+    {
+        int saved_errno = errno;
+        close(fd);
+        errno = saved_errno;
+        return -1;
+    }
+
+    return fd;
+}
+
+/**
+ * Free one client and close its connection (no drain).
+ */
+static void collector_detach_ring(smartlog_collector_t* c, size_t index)
+{
+    c->ring_dropped_gone += smartlog_shm_ring_dropped(c->rings[index].ring);
+    smartlog_shm_ring_destroy(c->rings[index].ring);
+    close(c->rings[index].conn_fd);
+
+    c->rings[index] = c->rings[c->ring_count - 1];
+    c->ring_count--;
+}
+
+/**
+ * Move everything one client has published into the reorder heap.
+ *
+ * Return: 0 on success, 1 if the ring is corrupt, -1 on write error
+ */
+static int collector_drain_ring(smartlog_collector_t* c, size_t index, uint64_t now_ns)
+{
+    for(;;)
+    {
+        if(c->free_count == 0 && collector_emit(c, 0, SMARTLOG_WRITER_BATCH) != 0)
+        {
+            return -1;
+        }
+
+        uint32_t slot = c->free_list[c->free_count - 1];
+        ssize_t len = smartlog_shm_ring_pop(c->rings[index].ring, c->slots[slot].data,
+                                            sizeof(c->slots[slot].data));
+        if(len == 0)
+        {
+            return 0;
+        }
+        if(len < 0)
+        {
+            if(errno == EMSGSIZE)
+            {
+                continue;
+            }
+            return 1;
+        }
+
+        c->free_count--;
+        c->slots[slot].len = (size_t)len;
+        collector_hold(c, slot, now_ns);
+    }
+}
+
+/**
+ * Drain every client. A corrupt ring never advances, so it would keep the
+ * loop from sleeping: that client is detached at once.
+ */
+static int collector_drain_rings(smartlog_collector_t* c)
+{
+    uint64_t now_ns = smartlog_timestamp_ns();
+
+    size_t r = 0;
+    while(r < c->ring_count)
+    {
+        int rc = collector_drain_ring(c, r, now_ns);
+        if(rc < 0)
+        {
+            return -1;
+        }
+        if(rc > 0)
+        {
+            /* The last ring moves into slot r: look at r again */
+            c->stats.ring_errors++;
+            collector_detach_ring(c, r);
+            continue;
+        }
+        r++;
+    }
+
+    return 0;
+}
+
+/**
+ * Drain and detach one client.
+ */
+static void collector_drop_ring(smartlog_collector_t* c, size_t index)
+{
+    if(collector_drain_ring(c, index, smartlog_timestamp_ns()) > 0)
+    {
+        c->stats.ring_errors++;
+    }
+    collector_detach_ring(c, index);
+}
+
+/**
+ * Attach a registered client, or turn it away when all slots are taken.
+ */
+static void collector_add_ring(smartlog_collector_t* c, smartlog_shm_ring_t* ring, int conn_fd)
+{
+    if(c->ring_count >= SMARTLOG_COLLECTOR_MAX_RINGS)
+    {
+        smartlog_shm_ring_destroy(ring);
+        close(conn_fd);
+        return;
+    }
+
+    c->rings[c->ring_count].ring = ring;
+    c->rings[c->ring_count].conn_fd = conn_fd;
+    c->ring_count++;
+}
+
+/**
+ * Forget one pending connection (the caller owns or closed its fd).
+ */
+static void collector_remove_pending(smartlog_collector_t* c, size_t index)
+{
+    c->pending[index] = c->pending[c->pending_count - 1];
+    c->pending_count--;
+}
+
+/**
+ * Try to finish one pending handshake.
+ *
+ * Return: 1 if the connection left the pending set, 0 if it still waits
+ */
+static int collector_attach_pending(smartlog_collector_t* c, size_t index)
+{
+    int conn_fd = c->pending[index].conn_fd;
+    smartlog_shm_ring_t* ring = smartlog_shm_ring_attach(conn_fd);
+    if(ring == NULL)
+    {
+        if(errno == EAGAIN || errno == EWOULDBLOCK)
+        {
+            return 0;
+        }
+        close(conn_fd);
+        collector_remove_pending(c, index);
+        return 1;
+    }
+
+    collector_remove_pending(c, index);
+    collector_add_ring(c, ring, conn_fd);
+    return 1;
+}
+
+/**
+ * Accept every queued connection. The hello normally arrives with the
+ * connection, so each one gets one attach attempt right away; the rest
+ * wait in the pending set and never block the event loop.
+ */
+static void collector_accept_rings(smartlog_collector_t* c)
+{
+    for(;;)
+    {
+        int conn_fd = smartlog_shm_ring_accept(c->ring_listen_fd);
+        if(conn_fd < 0)
+        {
+            /* EAGAIN: no more pending; anything else: try again next round */
+            return;
+        }
+
+        if(c->pending_count >= SMARTLOG_COLLECTOR_MAX_RINGS)
+        {
+            close(conn_fd);
+            continue;
+        }
+
+        size_t index = c->pending_count++;
+        c->pending[index].conn_fd = conn_fd;
+        c->pending[index].deadline_ns = smartlog_timestamp_ns() +
+                                        ((uint64_t)SMARTLOG_COLLECTOR_HELLO_MS * UINT64_C(1000000));
+        (void)collector_attach_pending(c, index);
+    }
+}
+
+/**
+ * Drop pending connections whose hello is overdue.
+ */
+static void collector_expire_pending(smartlog_collector_t* c)
+{
+    uint64_t now_ns = smartlog_timestamp_ns();
+    for(size_t p = c->pending_count; p > 0; p--)
+    {
+        if(now_ns >= c->pending[p - 1].deadline_ns)
+        {
+            close(c->pending[p - 1].conn_fd);
+            collector_remove_pending(c, p - 1);
+        }
+    }
+}
+
+/* ============================================================================
+ * Public API
+ * ============================================================================ */
+
+void smartlog_collector_config_init(smartlog_collector_config_t* cfg)
+{
+    if(cfg == NULL)
+    {
+        return;
+    }
+
+    memset(cfg, 0, sizeof(*cfg));
+    cfg->durable = FEATURE_DISABLED;
+    cfg->max_bytes_config = FEATURE_DISABLED;
+    cfg->reorder_window_ms = SMARTLOG_COLLECTOR_WINDOW_MS;
+    cfg->capacity = SMARTLOG_COLLECTOR_CAP;
+}
+
+smartlog_collector_t* smartlog_collector_create(const smartlog_collector_config_t* cfg)
+{
+    if(cfg == NULL || cfg->socket_path == NULL || cfg->output_path == NULL)
+    {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    smartlog_collector_t* c = calloc(1, sizeof(*c));
+    if(c == NULL)
+    {
+        return NULL;
+    }
+    c->sock_fd = -1;
+    c->ring_listen_fd = -1;
+
+    size_t path_len = strlen(cfg->socket_path);
+    if(path_len == 0 || path_len >= sizeof(c->socket_path))
+    {
+        free(c);
+        errno = ENAMETOOLONG;
+        return NULL;
+    }
+    memcpy(c->socket_path, cfg->socket_path, path_len + 1);
+
+    c->capacity = cfg->capacity != 0 ? cfg->capacity : SMARTLOG_COLLECTOR_CAP;
+    if(c->capacity < SMARTLOG_WRITER_BATCH || c->capacity > UINT32_MAX)
+    {
+        free(c);
+        errno = EINVAL;
+        return NULL;
+    }
+    c->window_ns = (uint64_t)cfg->reorder_window_ms * UINT64_C(1000000);
+
+    /* Slot storage is the bulk of the footprint: huge pages if asked */
+    smartlog_mem_opts_t mem = { -1, cfg->huge_pages };
+    if(smartlog_region_alloc(&c->slots_region, c->capacity * sizeof(*c->slots), &mem) == 0)
+    {
+        c->slots = c->slots_region.addr;
+        c->stats.slot_pages = c->slots_region.pages;
+    }
+    c->free_list = calloc(c->capacity, sizeof(*c->free_list));
+    c->heap = calloc(c->capacity, sizeof(*c->heap));
+    c->iov = calloc(c->capacity, sizeof(*c->iov));
+    if(c->slots == NULL || c->free_list == NULL || c->heap == NULL || c->iov == NULL)
+    {
+        smartlog_collector_destroy(c);
+        errno = ENOMEM;
+        return NULL;
+    }
+    for(size_t i = 0; i < c->capacity; i++)
+    {
+        c->free_list[i] = (uint32_t)(c->capacity - 1 - i);
+    }
+    c->free_count = c->capacity;
+
+    c->out = smartlog_sink_file_open(cfg->output_path, cfg->durable,
+                                     cfg->max_bytes_config, cfg->max_byte_val);
+    if(c->out == NULL)
+    {
+        int saved_errno = errno;
+        smartlog_collector_destroy(c);
+        errno = saved_errno;
+        return NULL;
+    }
+
+    /* Bind the datagram socket, replacing a stale socket file */
+    c->sock_fd = collector_bind(c->socket_path, SOCK_DGRAM);
+    if(c->sock_fd < 0)
+    {
+        int saved_errno = errno;
+        smartlog_collector_destroy(c);
+        errno = saved_errno;
+        return NULL;
+    }
+
+    if(cfg->ring_socket_path != NULL)
+    {
+        size_t ring_len = strlen(cfg->ring_socket_path);
+        if(ring_len == 0 || ring_len >= sizeof(c->ring_socket_path))
+        {
+            smartlog_collector_destroy(c);
+            errno = ENAMETOOLONG;
+            return NULL;
+        }
+        memcpy(c->ring_socket_path, cfg->ring_socket_path, ring_len + 1);
+
+        c->ring_listen_fd = collector_bind(c->ring_socket_path, SOCK_SEQPACKET);
+        if(c->ring_listen_fd < 0)
+        {
+            int saved_errno = errno;
+            smartlog_collector_destroy(c);
+            errno = saved_errno;
+            return NULL;
+        }
+    }
+
+    return c;
+}
+
+int smartlog_collector_run_once(smartlog_collector_t* c, int timeout_ms)
+{
+    if(c == NULL)
+    {
+        errno = EINVAL;
+        return 1;
+    }
+
+    /* ====================================================================
+     * STEP 1: Pick the Sleep Time
+     * ==================================================================== */
+    if(collector_drain_rings(c) != 0)
+    {
+        return 1;
+    }
+
+    /* Do not sleep past the moment the oldest held line becomes due */
+    if(c->heap_len > 0)
+    {
+        uint64_t now_ns = smartlog_timestamp_ns();
+        uint64_t due_ns = c->heap[0].time_ns + c->window_ns;
+        int due_ms = 0;
+        if(due_ns > now_ns)
+        {
+            due_ms = (int)((due_ns - now_ns) / UINT64_C(1000000)) + 1;
+        }
+        if(timeout_ms < 0 || due_ms < timeout_ms)
+        {
+            timeout_ms = due_ms;
+        }
+    }
+
+    /* Wake up in time to drop a client that never sends its hello */
+    if(c->pending_count > 0)
+    {
+        uint64_t now_ns = smartlog_timestamp_ns();
+        uint64_t due_ns = c->pending[0].deadline_ns;
+        for(size_t p = 1; p < c->pending_count; p++)
+        {
+            if(c->pending[p].deadline_ns < due_ns)
+            {
+                due_ns = c->pending[p].deadline_ns;
+            }
+        }
+        int due_ms = 0;
+        if(due_ns > now_ns)
+        {
+            due_ms = (int)((due_ns - now_ns) / UINT64_C(1000000)) + 1;
+        }
+        if(timeout_ms < 0 || due_ms < timeout_ms)
+        {
+            timeout_ms = due_ms;
+        }
+    }
+
+    /* Only now tell ring clients we are idle; they wake us via eventfd */
+    for(size_t r = 0; r < c->ring_count; r++)
+    {
+        if(smartlog_shm_ring_prepare_wait(c->rings[r].ring) != 0)
+        {
+            timeout_ms = 0;
+        }
+    }
+
+    /* ====================================================================
+     * STEP 2: Wait for Datagrams, Ring Wakeups or New Clients
+     * ==================================================================== */
+    struct pollfd pfd[2 + (3 * SMARTLOG_COLLECTOR_MAX_RINGS)];
+    nfds_t nfds = 0;
+
+    pfd[nfds].fd = c->sock_fd;
+    pfd[nfds].events = POLLIN;
+    nfds++;
+
+    pfd[nfds].fd = c->ring_listen_fd;   /* -1 is ignored by poll() */
+    pfd[nfds].events = POLLIN;
+    nfds++;
+
+    for(size_t r = 0; r < c->ring_count; r++)
+    {
+        pfd[nfds].fd = smartlog_shm_ring_eventfd(c->rings[r].ring);
+        pfd[nfds].events = POLLIN;
+        nfds++;
+        pfd[nfds].fd = c->rings[r].conn_fd;
+        pfd[nfds].events = POLLIN;
+        nfds++;
+    }
+    for(size_t p = 0; p < c->pending_count; p++)
+    {
+        pfd[nfds].fd = c->pending[p].conn_fd;
+        pfd[nfds].events = POLLIN;
+        nfds++;
+    }
+    for(nfds_t i = 0; i < nfds; i++)
+    {
+        pfd[i].revents = 0;
+    }
+
+    int ready = poll(pfd, nfds, timeout_ms);
+    if(ready < 0 && errno != EINTR)
+    {
+        return 1;
+    }
+
+    /* ====================================================================
+     * STEP 3: Collect Input
+     * ==================================================================== */
+    for(size_t r = 0; r < c->ring_count; r++)
+    {
+        smartlog_shm_ring_finish_wait(c->rings[r].ring);
+    }
+
+    /* Detach clients that hung up (walk backwards: removal swaps in the last) */
+    size_t polled_rings = c->ring_count;
+    for(size_t r = polled_rings; r > 0; r--)
+    {
+        if((pfd[2 + (2 * (r - 1)) + 1].revents & (POLLHUP | POLLERR | POLLIN)) != 0)
+        {
+            collector_drop_ring(c, r - 1);
+        }
+    }
+
+    /* Finish handshakes whose hello arrived (or whose client hung up) */
+    size_t polled_pending = c->pending_count;
+    for(size_t p = polled_pending; p > 0; p--)
+    {
+        if((pfd[2 + (2 * polled_rings) + (p - 1)].revents & (POLLHUP | POLLERR | POLLIN)) != 0)
+        {
+            (void)collector_attach_pending(c, p - 1);
+        }
+    }
+    collector_expire_pending(c);
+
+    if((pfd[1].revents & POLLIN) != 0)
+    {
+        collector_accept_rings(c);
+    }
+
+    if(collector_drain_rings(c) != 0)
+    {
+        return 1;
+    }
+    if((pfd[0].revents & POLLIN) != 0 && collector_receive(c) != 0)
+    {
+        return 1;
+    }
+
+    return collector_emit(c, 0, 0) == 0 ? 0 : 1;
+}
+
+int smartlog_collector_drain(smartlog_collector_t* c)
+{
+    if(c == NULL)
+    {
+        errno = EINVAL;
+        return 1;
+    }
+
+    if(collector_drain_rings(c) != 0 || collector_receive(c) != 0)
+    {
+        return 1;
+    }
+    return collector_emit(c, 1, 0) == 0 ? 0 : 1;
+}
+
+void smartlog_collector_get_stats(const smartlog_collector_t* c, smartlog_collector_stats_t* out)
+{
+    if(c == NULL || out == NULL)
+    {
+        return;
+    }
+    *out = c->stats;
+    out->ring_clients = c->ring_count;
+    out->ring_dropped = c->ring_dropped_gone;
+    for(size_t r = 0; r < c->ring_count; r++)
+    {
+        out->ring_dropped += smartlog_shm_ring_dropped(c->rings[r].ring);
+    }
+}
+
+void smartlog_collector_destroy(smartlog_collector_t* c)
+{
+    if(c == NULL)
+    {
+        return;
+    }
+
+    if(c->out != NULL)
+    {
+        if(c->sock_fd >= 0 && c->heap != NULL)
+        {
+            (void)smartlog_collector_drain(c);
+        }
+        smartlog_sink_destroy(c->out);
+    }
+    while(c->ring_count > 0)
+    {
+        smartlog_shm_ring_destroy(c->rings[c->ring_count - 1].ring);
+        close(c->rings[c->ring_count - 1].conn_fd);
+        c->ring_count--;
+    }
+    while(c->pending_count > 0)
+    {
+        close(c->pending[c->pending_count - 1].conn_fd);
+        c->pending_count--;
+    }
+    if(c->ring_listen_fd >= 0)
+    {
+        close(c->ring_listen_fd);
+        (void)unlink(c->ring_socket_path);
+    }
+    if(c->sock_fd >= 0)
+    {
+        close(c->sock_fd);
+        (void)unlink(c->socket_path);
+    }
+
+    smartlog_region_free(&c->slots_region);
+    free(c->free_list);
+    free(c->heap);
+    free(c->iov);
+    free(c);
+}
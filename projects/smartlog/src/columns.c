@@ -0,0 +1,879 @@
+/*
+ * src/columns.c
+ *
+ * Columnar files of SmartLog lines, for analytics.
+ *
+ * Implements:
+ *   - Export: parallel parse, then one encoder per column (delta varint
+ *     timestamps, dictionary + run-length pids/tids, message offsets and
+ *     blob), written page-aligned through a temp file and rename
+ *   - Reader: the file is mmap'ed and each column is checked and decoded
+ *     only when asked for, so a query touches only its own pages
+ *
+ * Author: Aravinthraj Ganesan
+ * Version: 1.0
+ */
+
+#define _GNU_SOURCE
+#define _POSIX_C_SOURCE 199309L
+
+/* Standard includes */
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <zlib.h>
+
+/* Project includes */
+#include <smartlog/columns.h>
+#include <smartlog/config.h>
+#include <smartlog/parse.h>
+#include <smartlog/utils.h>
+
+/* ============================================================================
+ * Format Constants
+ * ============================================================================ */
+
+#define COLFILE_MAGIC       "SLCOLUM1"
+#define COLFILE_VERSION     1u
+#define COLFILE_HEADER_SZ   48
+#define COLFILE_DIR_SZ      32
+#define COLFILE_ALIGN       4096u
+#define COLFILE_MAX_COLS    64u     /* Directory sanity limit on open */
+#define ID_TABLE_MIN        256u    /* Initial dictionary hash slots */
+#define COLFILE_IOV_BATCH   1024    /* Messages per writev() (IOV_MAX) */
+
+/* ============================================================================
+ * Internal Types
+ * ============================================================================ */
+
+typedef struct {
+    uint64_t offset;
+    uint64_t len;
+    uint32_t crc;
+    int present;
+} colfile_column_t;
+
+struct smartlog_colfile {
+    const unsigned char* map;
+    size_t size;
+    uint64_t rows;
+    uint64_t untimed;
+    uint64_t min_ns;
+    uint64_t max_ns;
+    colfile_column_t cols[SMARTLOG_COL_COUNT];
+};
+
+/** Growable encode buffer */
+typedef struct {
+    unsigned char* p;
+    size_t len;
+    size_t cap;
+} col_buf_t;
+
+/** Dictionary hash slot (index is stored + 1, 0 = empty) */
+typedef struct {
+    int32_t value;
+    uint32_t index;
+} id_slot_t;
+
+/* ============================================================================
+ * Encoding Helpers
+ * ============================================================================ */
+
+static uint64_t zigzag(int64_t v)
+{
+    return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63);
+}
+
+static int64_t unzigzag(uint64_t v)
+{
+    return (int64_t)(v >> 1) ^ -(int64_t)(v & 1u);
+}
+
+/** crc32 over any length (zlib takes uInt) */
+static uint32_t crc_update(uint32_t crc, const unsigned char* p, size_t len)
+{
+    while(len > 0)
+    {
+        uInt part = len > (1u << 30) ? (uInt)(1u << 30) : (uInt)len;
+        crc = (uint32_t)crc32(crc, p, part);
+        p += part;
+        len -= part;
+    }
+    return crc;
+}
+
+static int buf_reserve(col_buf_t* b, size_t more)
+{
+    if(b->cap - b->len >= more)
+    {
+        return 0;
+    }
+
+    size_t cap = b->cap != 0 ? b->cap : 4096;
+    while(cap - b->len < more)
+    {
+        cap *= 2;
+    }
+    unsigned char* p = realloc(b->p, cap);
+    if(p == NULL)
+    {
+        errno = ENOMEM;
+        return -1;
+    }
+    b->p = p;
+    b->cap = cap;
+    return 0;
+}
+
+static int buf_put_varint(col_buf_t* b, uint64_t v)
+{
+    if(buf_reserve(b, 10) != 0)
+    {
+        return -1;
+    }
+    while(v >= 0x80u)
+    {
+        b->p[b->len++] = (unsigned char)(v | 0x80u);
+        v >>= 7;
+    }
+    b->p[b->len++] = (unsigned char)v;
+    return 0;
+}
+
+/**
+ * Read one varint.
+ *
+ * Return: 0 on success, -1 if truncated or longer than 10 bytes
+ */
+static int get_varint(const unsigned char** p, const unsigned char* end, uint64_t* out)
+{
+    uint64_t v = 0;
+    for(unsigned int shift = 0; shift < 70 && *p < end; shift += 7)
+    {
+        unsigned char byte = *(*p)++;
+        v |= (uint64_t)(byte & 0x7fu) << shift;
+        if((byte & 0x80u) == 0)
+        {
+            *out = v;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+/* ============================================================================
+ * Column Encoders
+ * ============================================================================ */
+
+static int encode_time(const smartlog_columns_t* cols, col_buf_t* out)
+{
+    uint64_t last = 0;
+    for(size_t i = 0; i < cols->rows; i++)
+    {
+        uint64_t t = cols->time_ns[i];
+        uint64_t v = t == 0 ? 0 : zigzag((int64_t)(t - last)) + 1;
+        if(t != 0)
+        {
+            last = t;
+        }
+        if(buf_put_varint(out, v) != 0)
+        {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static int encode_seq(const smartlog_columns_t* cols, col_buf_t* out)
+{
+    uint64_t last = 0;
+    for(size_t i = 0; i < cols->rows; i++)
+    {
+        if(buf_put_varint(out, zigzag((int64_t)(cols->seq[i] - last))) != 0)
+        {
+            return -1;
+        }
+        last = cols->seq[i];
+    }
+    return 0;
+}
+
+static uint32_t id_hash(int32_t value, size_t mask)
+{
+    return (uint32_t)(((uint32_t)value * 2654435761u) & mask);
+}
+
+/**
+ * Find or add a dictionary value; grows the table at half load.
+ *
+ * Return: Dictionary index, or UINT32_MAX on allocation failure
+ */
+static uint32_t id_lookup(id_slot_t** table, size_t* cap, int32_t** values, size_t* nvalues, int32_t value)
+{
+    size_t mask = *cap - 1;
+    size_t slot = id_hash(value, mask);
+    while((*table)[slot].index != 0)
+    {
+        if((*table)[slot].value == value)
+        {
+            return (*table)[slot].index - 1;
+        }
+        slot = (slot + 1) & mask;
+    }
+
+    if((*nvalues + 1) * 2 > *cap)
+    {
+        size_t new_cap = *cap * 2;
+        id_slot_t* grown = calloc(new_cap, sizeof(*grown));
+        int32_t* new_values = realloc(*values, (new_cap / 2) * sizeof(**values));
+        if(grown == NULL || new_values == NULL)
+        {
+            free(grown);
+            if(new_values != NULL)
+            {
+                *values = new_values;
+            }
+            errno = ENOMEM;
+            return UINT32_MAX;
+        }
+        *values = new_values;
+        for(size_t i = 0; i < *nvalues; i++)
+        {
+            size_t s = id_hash((*values)[i], new_cap - 1);
+            while(grown[s].index != 0)
+            {
+                s = (s + 1) & (new_cap - 1);
+            }
+            grown[s].value = (*values)[i];
+            grown[s].index = (uint32_t)i + 1;
+        }
+        free(*table);
+        *table = grown;
+        *cap = new_cap;
+        mask = new_cap - 1;
+        slot = id_hash(value, mask);
+        while((*table)[slot].index != 0)
+        {
+            slot = (slot + 1) & mask;
+        }
+    }
+
+    (*values)[*nvalues] = value;
+    (*table)[slot].value = value;
+    (*table)[slot].index = (uint32_t)(++(*nvalues));
+    return (uint32_t)(*nvalues - 1);
+}
+
+/** Dictionary + run-length encoding of a pid or tid column */
+static int encode_ids(const int32_t* ids, size_t rows, col_buf_t* out)
+{
+    size_t cap = ID_TABLE_MIN;
+    size_t nvalues = 0;
+    id_slot_t* table = calloc(cap, sizeof(*table));
+    int32_t* values = malloc((cap / 2) * sizeof(*values));
+    col_buf_t runs;
+    memset(&runs, 0, sizeof(runs));
+    int rc = -1;
+
+    if(table == NULL || values == NULL)
+    {
+        errno = ENOMEM;
+        goto done;
+    }
+
+    for(size_t i = 0; i < rows;)
+    {
+        size_t run = 1;
+        while(i + run < rows && ids[i + run] == ids[i])
+        {
+            run++;
+        }
+        uint32_t index = id_lookup(&table, &cap, &values, &nvalues, ids[i]);
+        if(index == UINT32_MAX || buf_put_varint(&runs, index) != 0 || buf_put_varint(&runs, run) != 0)
+        {
+            goto done;
+        }
+        i += run;
+    }
+
+    if(buf_put_varint(out, nvalues) != 0)
+    {
+        goto done;
+    }
+    for(size_t i = 0; i < nvalues; i++)
+    {
+        if(buf_put_varint(out, zigzag(values[i])) != 0)
+        {
+            goto done;
+        }
+    }
+    if(buf_reserve(out, runs.len) != 0)
+    {
+        goto done;
+    }
+    if(runs.len != 0)
+    {
+        memcpy(out->p + out->len, runs.p, runs.len);
+        out->len += runs.len;
+    }
+    rc = 0;
+
+done:
+    free(table);
+    free(values);
+    free(runs.p);
+    return rc;
+}
+
+static int encode_offsets(const smartlog_columns_t* cols, col_buf_t* out)
+{
+    if(buf_reserve(out, (cols->rows + 1) * 8) != 0)
+    {
+        return -1;
+    }
+    uint64_t offset = 0;
+    for(size_t i = 0; i <= cols->rows; i++)
+    {
+        smartlog_put_le64(out->p + out->len, offset);
+        out->len += 8;
+        if(i < cols->rows)
+        {
+            offset += cols->msg_len[i];
+        }
+    }
+    return 0;
+}
+
+/* ============================================================================
+ * File Writer
+ * ============================================================================ */
+
+static int write_padding(int fd, uint64_t len)
+{
+    static const unsigned char zeros[COLFILE_ALIGN];
+    uint64_t pad = (COLFILE_ALIGN - (len % COLFILE_ALIGN)) % COLFILE_ALIGN;
+    return pad == 0 ? 0 : smartlog_write_all(fd, zeros, (size_t)pad);
+}
+
+/** Messages back to back, straight from the parsed text */
+static int write_blob(int fd, const smartlog_columns_t* cols)
+{
+    struct iovec iov[COLFILE_IOV_BATCH];
+    int n = 0;
+    for(size_t i = 0; i < cols->rows; i++)
+    {
+        if(cols->msg_len[i] == 0)
+        {
+            continue;
+        }
+        iov[n].iov_base = (void*)(uintptr_t)(cols->data + cols->msg_offset[i]);
+        iov[n].iov_len = cols->msg_len[i];
+        if(++n == COLFILE_IOV_BATCH)
+        {
+            if(smartlog_writev_all(fd, iov, n) != 0)
+            {
+                return -1;
+            }
+            n = 0;
+        }
+    }
+    return n == 0 ? 0 : smartlog_writev_all(fd, iov, n);
+}
+
+static int write_colfile(int fd, const smartlog_columns_t* cols, col_buf_t* bufs, smartlog_colfile_info_t* info)
+{
+    unsigned char head[COLFILE_HEADER_SZ + (COLFILE_DIR_SZ * SMARTLOG_COL_COUNT)];
+    memset(head, 0, sizeof(head));
+
+    /* Blob is not buffered: its size and crc come from the parsed rows */
+    uint64_t blob_len = 0;
+    uint32_t blob_crc = (uint32_t)crc32(0L, Z_NULL, 0);
+    for(size_t i = 0; i < cols->rows; i++)
+    {
+        blob_len += cols->msg_len[i];
+        blob_crc = crc_update(blob_crc, (const unsigned char*)cols->data + cols->msg_offset[i], cols->msg_len[i]);
+    }
+
+    memcpy(head, COLFILE_MAGIC, 8);
+    smartlog_put_le32(head + 8, COLFILE_VERSION);
+    smartlog_put_le32(head + 12, SMARTLOG_COL_COUNT);
+    smartlog_put_le64(head + 16, info->rows);
+    smartlog_put_le64(head + 24, info->untimed);
+    smartlog_put_le64(head + 32, info->min_ns);
+    smartlog_put_le64(head + 40, info->max_ns);
+
+    uint64_t offset = COLFILE_ALIGN;
+    for(unsigned int id = 0; id < SMARTLOG_COL_COUNT; id++)
+    {
+        unsigned char* entry = head + COLFILE_HEADER_SZ + (id * COLFILE_DIR_SZ);
+        uint64_t len = id == SMARTLOG_COL_MSG_BLOB ? blob_len : bufs[id].len;
+        uint32_t crc = id == SMARTLOG_COL_MSG_BLOB ?
+                       blob_crc : crc_update((uint32_t)crc32(0L, Z_NULL, 0), bufs[id].p, bufs[id].len);
+        smartlog_put_le32(entry, id);
+        smartlog_put_le32(entry + 4, crc);
+        smartlog_put_le64(entry + 8, offset);
+        smartlog_put_le64(entry + 16, len);
+        info->column_bytes[id] = len;
+        offset += len + ((COLFILE_ALIGN - (len % COLFILE_ALIGN)) % COLFILE_ALIGN);
+    }
+
+    if(smartlog_write_all(fd, head, sizeof(head)) != 0 || write_padding(fd, sizeof(head)) != 0)
+    {
+        return -1;
+    }
+    for(unsigned int id = 0; id < SMARTLOG_COL_MSG_BLOB; id++)
+    {
+        if((bufs[id].len != 0 && smartlog_write_all(fd, bufs[id].p, bufs[id].len) != 0) ||
+           write_padding(fd, bufs[id].len) != 0)
+        {
+            return -1;
+        }
+    }
+    if(write_blob(fd, cols) != 0)
+    {
+        return -1;
+    }
+
+    info->file_bytes = offset - ((COLFILE_ALIGN - (blob_len % COLFILE_ALIGN)) % COLFILE_ALIGN);
+    return 0;
+}
+
+/* ============================================================================
+ * Reader Helpers
+ * ============================================================================ */
+
+/**
+ * Checked bytes of one column.
+ *
+ * Return: 0 on success, -1 with errno EBADMSG on a crc mismatch
+ */
+static int column_bytes(const smartlog_colfile_t* cf, smartlog_col_id_t id,
+                        const unsigned char** p, const unsigned char** end)
+{
+    const colfile_column_t* col = &cf->cols[id];
+    *p = cf->map + col->offset;
+    *end = *p + col->len;
+    if(crc_update((uint32_t)crc32(0L, Z_NULL, 0), *p, (size_t)col->len) != col->crc)
+    {
+        errno = EBADMSG;
+        return -1;
+    }
+    return 0;
+}
+
+static int decode_ids(const smartlog_colfile_t* cf, smartlog_col_id_t id, int32_t* out)
+{
+    const unsigned char* p = NULL;
+    const unsigned char* end = NULL;
+    if(column_bytes(cf, id, &p, &end) != 0)
+    {
+        return -1;
+    }
+
+    uint64_t nvalues = 0;
+    if(get_varint(&p, end, &nvalues) != 0 || nvalues > (uint64_t)(end - p))
+    {
+        errno = EBADMSG;
+        return -1;
+    }
+
+    int32_t* values = malloc(((size_t)nvalues + 1) * sizeof(*values));
+    if(values == NULL)
+    {
+        errno = ENOMEM;
+        return -1;
+    }
+
+    int ok = 1;
+    for(uint64_t i = 0; ok && i < nvalues; i++)
+    {
+        uint64_t v = 0;
+        ok = get_varint(&p, end, &v) == 0;
+        values[i] = (int32_t)unzigzag(v);
+    }
+
+    uint64_t row = 0;
+    while(ok && row < cf->rows)
+    {
+        uint64_t index = 0;
+        uint64_t run = 0;
+        ok = get_varint(&p, end, &index) == 0 && get_varint(&p, end, &run) == 0 &&
+             index < nvalues && run != 0 && run <= cf->rows - row;
+        for(uint64_t i = 0; ok && i < run; i++)
+        {
+            out[row++] = values[index];
+        }
+    }
+
+    free(values);
+    if(!ok || p != end)
+    {
+        errno = EBADMSG;
+        return -1;
+    }
+    return 0;
+}
+
+/* ============================================================================
+ * Public API
+ * ============================================================================ */
+
+int smartlog_colfile_export(const char* src_path, const char* dst_path, unsigned int threads,
+                            smartlog_colfile_info_t* info)
+{
+    if(src_path == NULL || dst_path == NULL)
+    {
+        errno = EINVAL;
+        return 1;
+    }
+
+    char tmp_path[SMARTLOG_PATH_MAX_LEN];
+    int n = snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", dst_path);
+    if(n < 0 || n >= (int)sizeof(tmp_path))
+    {
+        errno = ENAMETOOLONG;
+        return 1;
+    }
+
+    /* ====================================================================
+     * STEP 1: Parse
+     * ==================================================================== */
+    smartlog_columns_t cols;
+    if(smartlog_parse_file(src_path, threads, &cols) != 0)
+    {
+        return 1;
+    }
+
+    smartlog_colfile_info_t summary;
+    memset(&summary, 0, sizeof(summary));
+    summary.rows = cols.rows;
+    summary.untimed = cols.untimed;
+    summary.raw_bytes = cols.size;
+    for(size_t i = 0; i < cols.rows; i++)
+    {
+        uint64_t t = cols.time_ns[i];
+        if(t != 0 && (summary.min_ns == 0 || t < summary.min_ns))
+        {
+            summary.min_ns = t;
+        }
+        if(t > summary.max_ns)
+        {
+            summary.max_ns = t;
+        }
+    }
+
+    /* ====================================================================
+     * STEP 2: Encode Every Column but the Blob
+     * ==================================================================== */
+    col_buf_t bufs[SMARTLOG_COL_COUNT];
+    memset(bufs, 0, sizeof(bufs));
+    int rc = 1;
+    int saved_errno = 0;
+    int fd = -1;
+
+    if(encode_time(&cols, &bufs[SMARTLOG_COL_TIME]) != 0 ||
+       encode_ids(cols.pid, cols.rows, &bufs[SMARTLOG_COL_PID]) != 0 ||
+       encode_ids(cols.tid, cols.rows, &bufs[SMARTLOG_COL_TID]) != 0 ||
+       encode_seq(&cols, &bufs[SMARTLOG_COL_SEQ]) != 0 ||
+       encode_offsets(&cols, &bufs[SMARTLOG_COL_MSG_OFFSETS]) != 0)
+    {
+        saved_errno = errno;
+        goto done;
+    }
+
+    /* ====================================================================
+     * STEP 3: Write Through a Temp File
+     * ==================================================================== */
+    fd = open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, SMARTLOG_FILE_MODE);
+    if(fd >= 0 && write_colfile(fd, &cols, bufs, &summary) == 0 && fdatasync(fd) == 0)
+    {
+        rc = 0;
+    }
+    saved_errno = errno;
+    if(fd >= 0 && close(fd) != 0 && rc == 0)
+    {
+        rc = 1;
+        saved_errno = errno;
+    }
+    if(rc == 0 && (rename(tmp_path, dst_path) != 0 || smartlog_fsync_parent_dir(dst_path) != 0))
+    {
+        rc = 1;
+        saved_errno = errno;
+    }
+    if(rc != 0 && fd >= 0)
+    {
+        (void)unlink(tmp_path);
+    }
+
+done:
+    for(unsigned int id = 0; id < SMARTLOG_COL_COUNT; id++)
+    {
+        free(bufs[id].p);
+    }
+    smartlog_columns_free(&cols);
+    if(info != NULL)
+    {
+        *info = summary;
+    }
+    errno = saved_errno;
+    return rc;
+}
+
+smartlog_colfile_t* smartlog_colfile_open(const char* path)
+{
+    if(path == NULL)
+    {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if(fd < 0)
+    {
+        return NULL;
+    }
+
+    struct stat st;
+    if(fstat(fd, &st) != 0)
+    {
+        int saved_errno = errno;
+        close(fd);
+        errno = saved_errno;
+        return NULL;
+    }
+    if(st.st_size < COLFILE_HEADER_SZ)
+    {
+        close(fd);
+        errno = EBADMSG;
+        return NULL;
+    }
+
+    size_t size = (size_t)st.st_size;
+    void* map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    int saved_errno = errno;
+    close(fd);
+    if(map == MAP_FAILED)
+    {
+        errno = saved_errno;
+        return NULL;
+    }
+
+    smartlog_colfile_t* cf = calloc(1, sizeof(*cf));
+    if(cf == NULL)
+    {
+        munmap(map, size);
+        errno = ENOMEM;
+        return NULL;
+    }
+    cf->map = map;
+    cf->size = size;
+
+    /* ====================================================================
+     * STEP 1: Header
+     * ==================================================================== */
+    const unsigned char* head = cf->map;
+    uint32_t ncols = smartlog_get_le32(head + 12);
+    cf->rows = smartlog_get_le64(head + 16);
+    cf->untimed = smartlog_get_le64(head + 24);
+    cf->min_ns = smartlog_get_le64(head + 32);
+    cf->max_ns = smartlog_get_le64(head + 40);
+
+    int ok = memcmp(head, COLFILE_MAGIC, 8) == 0 &&
+             smartlog_get_le32(head + 8) == COLFILE_VERSION &&
+             ncols <= COLFILE_MAX_COLS &&
+             COLFILE_HEADER_SZ + ((uint64_t)ncols * COLFILE_DIR_SZ) <= size &&
+             cf->rows < size && cf->untimed <= cf->rows;
+
+    /* ====================================================================
+     * STEP 2: Directory (Unknown Columns Are Ignored)
+     * ==================================================================== */
+    for(uint32_t i = 0; ok && i < ncols; i++)
+    {
+        const unsigned char* entry = head + COLFILE_HEADER_SZ + ((size_t)i * COLFILE_DIR_SZ);
+        uint32_t id = smartlog_get_le32(entry);
+        uint64_t offset = smartlog_get_le64(entry + 8);
+        uint64_t len = smartlog_get_le64(entry + 16);
+        if(id >= SMARTLOG_COL_COUNT)
+        {
+            continue;
+        }
+        ok = !cf->cols[id].present && offset <= size && len <= size - offset;
+        cf->cols[id].offset = offset;
+        cf->cols[id].len = len;
+        cf->cols[id].crc = smartlog_get_le32(entry + 4);
+        cf->cols[id].present = 1;
+    }
+    for(unsigned int id = 0; ok && id < SMARTLOG_COL_COUNT; id++)
+    {
+        ok = cf->cols[id].present;
+    }
+    ok = ok && cf->cols[SMARTLOG_COL_MSG_OFFSETS].len == (cf->rows + 1) * 8;
+
+    if(!ok)
+    {
+        smartlog_colfile_close(cf);
+        errno = EBADMSG;
+        return NULL;
+    }
+    return cf;
+}
+
+void smartlog_colfile_get_info(const smartlog_colfile_t* cf, smartlog_colfile_info_t* out)
+{
+    if(cf == NULL || out == NULL)
+    {
+        return;
+    }
+
+    memset(out, 0, sizeof(*out));
+    out->rows = cf->rows;
+    out->untimed = cf->untimed;
+    out->min_ns = cf->min_ns;
+    out->max_ns = cf->max_ns;
+    out->file_bytes = cf->size;
+    for(unsigned int id = 0; id < SMARTLOG_COL_COUNT; id++)
+    {
+        out->column_bytes[id] = cf->cols[id].len;
+    }
+}
+
+int smartlog_colfile_read_time(const smartlog_colfile_t* cf, uint64_t* out)
+{
+    if(cf == NULL || out == NULL)
+    {
+        errno = EINVAL;
+        return 1;
+    }
+
+    const unsigned char* p = NULL;
+    const unsigned char* end = NULL;
+    if(column_bytes(cf, SMARTLOG_COL_TIME, &p, &end) != 0)
+    {
+        return 1;
+    }
+
+    uint64_t last = 0;
+    for(uint64_t row = 0; row < cf->rows; row++)
+    {
+        uint64_t v = 0;
+        if(get_varint(&p, end, &v) != 0)
+        {
+            errno = EBADMSG;
+            return 1;
+        }
+        if(v != 0)
+        {
+            last += (uint64_t)unzigzag(v - 1);
+            out[row] = last;
+        }
+        else
+        {
+            out[row] = 0;
+        }
+    }
+    if(p != end)
+    {
+        errno = EBADMSG;
+        return 1;
+    }
+    return 0;
+}
+
+int smartlog_colfile_read_pid(const smartlog_colfile_t* cf, int32_t* out)
+{
+    if(cf == NULL || out == NULL)
+    {
+        errno = EINVAL;
+        return 1;
+    }
+    return decode_ids(cf, SMARTLOG_COL_PID, out) == 0 ? 0 : 1;
+}
+
+int smartlog_colfile_read_tid(const smartlog_colfile_t* cf, int32_t* out)
+{
+    if(cf == NULL || out == NULL)
+    {
+        errno = EINVAL;
+        return 1;
+    }
+    return decode_ids(cf, SMARTLOG_COL_TID, out) == 0 ? 0 : 1;
+}
+
+int smartlog_colfile_read_seq(const smartlog_colfile_t* cf, uint64_t* out)
+{
+    if(cf == NULL || out == NULL)
+    {
+        errno = EINVAL;
+        return 1;
+    }
+
+    const unsigned char* p = NULL;
+    const unsigned char* end = NULL;
+    if(column_bytes(cf, SMARTLOG_COL_SEQ, &p, &end) != 0)
+    {
+        return 1;
+    }
+
+    uint64_t last = 0;
+    for(uint64_t row = 0; row < cf->rows; row++)
+    {
+        uint64_t v = 0;
+        if(get_varint(&p, end, &v) != 0)
+        {
+            errno = EBADMSG;
+            return 1;
+        }
+        last += (uint64_t)unzigzag(v);
+        out[row] = last;
+    }
+    if(p != end)
+    {
+        errno = EBADMSG;
+        return 1;
+    }
+    return 0;
+}
+
+const char* smartlog_colfile_message(const smartlog_colfile_t* cf, size_t row, size_t* len)
+{
+    if(cf == NULL || len == NULL)
+    {
+        errno = EINVAL;
+        return NULL;
+    }
+    if(row >= cf->rows)
+    {
+        errno = ERANGE;
+        return NULL;
+    }
+
+    const unsigned char* offsets = cf->map + cf->cols[SMARTLOG_COL_MSG_OFFSETS].offset;
+    uint64_t begin = smartlog_get_le64(offsets + (row * 8));
+    uint64_t end = smartlog_get_le64(offsets + ((row + 1) * 8));
+    if(begin > end || end > cf->cols[SMARTLOG_COL_MSG_BLOB].len)
+    {
+        errno = EBADMSG;
+        return NULL;
+    }
+
+    *len = (size_t)(end - begin);
+    return (const char*)cf->map + cf->cols[SMARTLOG_COL_MSG_BLOB].offset + begin;
+}
+
+void smartlog_colfile_close(smartlog_colfile_t* cf)
+{
+    if(cf == NULL)
+    {
+        return;
+    }
+
+    munmap((void*)(uintptr_t)cf->map, cf->size);
+    free(cf);
+}
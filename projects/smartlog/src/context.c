@@ -0,0 +1,142 @@
+/*
+ * src/context.c
+ *
+ * Thread-local logging context for SmartLog.
+ *
+ * Implements:
+ *   - One fixed buffer per thread holding the encoded fields back to
+ *     back, plus the end offset of each field for pops
+ *   - Field checks at push time, so formatting only copies bytes
+ *
+ * Author: Aravinthraj Ganesan
+ * Version: 1.0
+ */
+
+#define _GNU_SOURCE
+#define _POSIX_C_SOURCE 199309L
+
+/* Standard includes */
+#include <errno.h>
+#include <string.h>
+
+/* Project includes */
+#include <smartlog/config.h>
+#include <smartlog/context.h>
+
+/* ============================================================================
+ * Internal Types
+ * ============================================================================ */
+
+typedef struct {
+    char buf[SMARTLOG_CONTEXT_MAX_LEN];
+    size_t len;
+    size_t ends[SMARTLOG_CONTEXT_MAX_DEPTH];   /* buf length after field i */
+    size_t depth;
+} context_stack_t;
+
+static _Thread_local context_stack_t tls_context;
+
+/* ============================================================================
+ * Helpers
+ * ============================================================================ */
+
+static int key_char_ok(char c)
+{
+    return (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') ||
+           c == '_' || c == '-' || c == '.';
+}
+
+/** Printable ASCII except the field brackets */
+static int value_char_ok(char c)
+{
+    return c >= ' ' && c <= '~' && c != '[' && c != ']';
+}
+
+/* ============================================================================
+ * Public API
+ * ============================================================================ */
+
+int smartlog_context_push(const char* key, const char* value)
+{
+    if(key == NULL || value == NULL || key[0] == '\0')
+    {
+        errno = EINVAL;
+        return 1;
+    }
+
+    size_t key_len = 0;
+    for(; key[key_len] != '\0'; key_len++)
+    {
+        if(!key_char_ok(key[key_len]))
+        {
+            errno = EINVAL;
+            return 1;
+        }
+    }
+    size_t value_len = 0;
+    for(; value[value_len] != '\0'; value_len++)
+    {
+        if(!value_char_ok(value[value_len]))
+        {
+            errno = EINVAL;
+            return 1;
+        }
+    }
+
+    /* "[" key " = " value "] " */
+    context_stack_t* ctx = &tls_context;
+    size_t field_len = key_len + value_len + 6;
+    if(ctx->depth == SMARTLOG_CONTEXT_MAX_DEPTH || field_len > SMARTLOG_CONTEXT_MAX_LEN - ctx->len)
+    {
+        errno = ENOSPC;
+        return 1;
+    }
+
+    char* p = ctx->buf + ctx->len;
+    *p++ = '[';
+    memcpy(p, key, key_len);
+    p += key_len;
+    memcpy(p, " = ", 3);
+    p += 3;
+    memcpy(p, value, value_len);
+    p += value_len;
+    memcpy(p, "] ", 2);
+
+    ctx->len += field_len;
+    ctx->ends[ctx->depth++] = ctx->len;
+    return 0;
+}
+
+int smartlog_context_pop(void)
+{
+    context_stack_t* ctx = &tls_context;
+    if(ctx->depth == 0)
+    {
+        errno = ENOENT;
+        return 1;
+    }
+
+    ctx->depth--;
+    ctx->len = ctx->depth != 0 ? ctx->ends[ctx->depth - 1] : 0;
+    return 0;
+}
+
+void smartlog_context_clear(void)
+{
+    tls_context.depth = 0;
+    tls_context.len = 0;
+}
+
+size_t smartlog_context_depth(void)
+{
+    return tls_context.depth;
+}
+
+const char* smartlog_context_encoded(size_t* len)
+{
+    if(len != NULL)
+    {
+        *len = tls_context.len;
+    }
+    return tls_context.buf;
+}
@@ -0,0 +1,404 @@
+/*
+ * src/counters.c
+ *
+ * Per-call-site event counters for SmartLog.
+ *
+ * Implements:
+ *   - One fixed-size hash table per thread and counter set, found through
+ *     a small thread-local cache
+ *   - Tables of exited threads adopted by new threads (pthread key
+ *     destructor), so thread churn does not grow memory or merge cost
+ *   - Single-writer counting (relaxed load + store, no locked instruction)
+ *   - Snapshots that merge all tables into per-key deltas and totals
+ *
+ * Author: Aravinthraj Ganesan
+ * Version: 1.0
+ */
+
+#define _GNU_SOURCE
+#define _POSIX_C_SOURCE 199309L
+
+/* Standard includes */
+#include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+/* Project includes */
+#include <smartlog/config.h>
+#include <smartlog/counters.h>
+
+/* ============================================================================
+ * Internal Types
+ * ============================================================================ */
+
+#define COUNTER_TLS_CACHE  4    /* Counter sets one thread can switch between cheaply */
+
+/** One key of one thread (tmpl is published last; NULL = free) */
+typedef struct {
+    _Atomic(const char*) tmpl;
+    const char* file;
+    int line;
+    log_level_t level;
+    atomic_uint_fast64_t count;     /* Written by the owning thread only */
+    uint64_t reported;              /* Count at the previous snapshot */
+} counter_slot_t;
+
+typedef struct counter_table {
+    struct counter_table* next;
+    struct smartlog_counters* counters;
+    pid_t owner;                    /* Counting thread, 0 once it exited (set lock) */
+    atomic_uint_fast64_t overflow;  /* Written by the owning thread only */
+    uint64_t overflow_reported;
+    counter_slot_t slots[SMARTLOG_COUNTER_SLOTS];
+} counter_table_t;
+
+struct smartlog_counters {
+    uint64_t id;                    /* Unique, so stale thread caches never match */
+    pthread_key_t exit_key;         /* Per thread: its table, released at thread exit */
+    pthread_mutex_t lock;           /* Table list, table owners and snapshots */
+    counter_table_t* tables;
+};
+
+typedef struct {
+    uint64_t id;
+    counter_table_t* table;
+} counter_tls_t;
+
+static atomic_uint_fast64_t next_counters_id = 1;
+static _Thread_local counter_tls_t tls_cache[COUNTER_TLS_CACHE];
+static _Thread_local unsigned int tls_next;
+
+/* ============================================================================
+ * Helpers
+ * ============================================================================ */
+
+static size_t key_hash(const char* tmpl, const char* file, int line, log_level_t level)
+{
+    uint64_t h = (uint64_t)(uintptr_t)tmpl * 0x9E3779B97F4A7C15ull;
+    h ^= ((uint64_t)(uintptr_t)file + ((uint64_t)(unsigned int)line << 2) + (uint64_t)level) * 0xC2B2AE3D27D4EB4Full;
+    return (size_t)(h >> 32);
+}
+
+/**
+ * Thread exit: the table keeps its counts for the merge and is handed to
+ * the next thread that needs one.
+ */
+static void table_release(void* value)
+{
+    counter_table_t* table = (counter_table_t*)value;
+    pthread_mutex_lock(&table->counters->lock);
+    table->owner = 0;
+    pthread_mutex_unlock(&table->counters->lock);
+}
+
+/**
+ * This thread's table: from the cache, else the table this thread already
+ * owns (evicted from the cache), else a table left by an exited thread,
+ * else a new one.
+ *
+ * Return: Table, or NULL on allocation failure
+ */
+static counter_table_t* thread_table(smartlog_counters_t* counters)
+{
+    for(unsigned int i = 0; i < COUNTER_TLS_CACHE; i++)
+    {
+        if(tls_cache[i].id == counters->id)
+        {
+            return tls_cache[i].table;
+        }
+    }
+
+    pid_t tid = (pid_t)syscall(SYS_gettid);
+    counter_table_t* table = NULL;
+    counter_table_t* spare = NULL;
+
+    pthread_mutex_lock(&counters->lock);
+    for(counter_table_t* t = counters->tables; t != NULL && table == NULL; t = t->next)
+    {
+        if(t->owner == tid)
+        {
+            table = t;
+        }
+        else if(t->owner == 0 && spare == NULL)
+        {
+            spare = t;
+        }
+    }
+    if(table == NULL && spare != NULL)
+    {
+        /* Its writer is gone; the counts carry on under the new owner */
+        table = spare;
+        table->owner = tid;
+    }
+    pthread_mutex_unlock(&counters->lock);
+
+    if(table == NULL)
+    {
+        table = calloc(1, sizeof(*table));
+        if(table == NULL)
+        {
+            errno = ENOMEM;
+            return NULL;
+        }
+        table->counters = counters;
+        table->owner = tid;
+
+        pthread_mutex_lock(&counters->lock);
+        table->next = counters->tables;
+        counters->tables = table;
+        pthread_mutex_unlock(&counters->lock);
+    }
+
+    if(pthread_getspecific(counters->exit_key) != table &&
+       pthread_setspecific(counters->exit_key, table) != 0)
+    {
+        /* Without the exit hook the table is never handed on */
+        pthread_mutex_lock(&counters->lock);
+        table->owner = 0;
+        pthread_mutex_unlock(&counters->lock);
+        errno = ENOMEM;
+        return NULL;
+    }
+
+    /* An evicted table stays linked, owned and merged */
+    counter_tls_t* entry = &tls_cache[tls_next++ % COUNTER_TLS_CACHE];
+    entry->id = counters->id;
+    entry->table = table;
+    return table;
+}
+
+static int counter_cmp(const void* a, const void* b)
+{
+    const smartlog_counter_t* ca = (const smartlog_counter_t*)a;
+    const smartlog_counter_t* cb = (const smartlog_counter_t*)b;
+    int rc = strcmp(ca->file, cb->file);
+    if(rc == 0)
+    {
+        rc = (ca->line > cb->line) - (ca->line < cb->line);
+    }
+    if(rc == 0)
+    {
+        rc = (ca->level > cb->level) - (ca->level < cb->level);
+    }
+    if(rc == 0)
+    {
+        rc = strcmp(ca->tmpl, cb->tmpl);
+    }
+    return rc;
+}
+
+/* ============================================================================
+ * Public API
+ * ============================================================================ */
+
+smartlog_counters_t* smartlog_counters_create(void)
+{
+    smartlog_counters_t* counters = calloc(1, sizeof(*counters));
+    if(counters == NULL)
+    {
+        return NULL;
+    }
+
+    int rc = pthread_key_create(&counters->exit_key, table_release);
+    if(rc != 0)
+    {
+        free(counters);
+        errno = rc;
+        return NULL;
+    }
+
+    counters->id = atomic_fetch_add_explicit(&next_counters_id, 1, memory_order_relaxed);
+    pthread_mutex_init(&counters->lock, NULL);
+    return counters;
+}
+
+int smartlog_counters_add(smartlog_counters_t* counters, log_level_t level, const char* tmpl,
+                          const char* file, int line)
+{
+    if(counters == NULL || tmpl == NULL || file == NULL)
+    {
+        errno = EINVAL;
+        return 1;
+    }
+
+    counter_table_t* table = thread_table(counters);
+    if(table == NULL)
+    {
+        return 1;
+    }
+
+    size_t mask = SMARTLOG_COUNTER_SLOTS - 1;
+    size_t slot = key_hash(tmpl, file, line, level) & mask;
+    for(size_t probe = 0; probe < SMARTLOG_COUNTER_SLOTS; probe++)
+    {
+        counter_slot_t* s = &table->slots[slot];
+        const char* key = atomic_load_explicit(&s->tmpl, memory_order_relaxed);
+        if(key == NULL)
+        {
+            /* Key fields first, then publish: snapshots read tmpl with acquire */
+            s->file = file;
+            s->line = line;
+            s->level = level;
+            atomic_store_explicit(&s->count, 1, memory_order_relaxed);
+            atomic_store_explicit(&s->tmpl, tmpl, memory_order_release);
+            return 0;
+        }
+        if(key == tmpl && s->file == file && s->line == line && s->level == level)
+        {
+            uint64_t n = atomic_load_explicit(&s->count, memory_order_relaxed);
+            atomic_store_explicit(&s->count, n + 1, memory_order_relaxed);
+            return 0;
+        }
+        slot = (slot + 1) & mask;
+    }
+
+    uint64_t n = atomic_load_explicit(&table->overflow, memory_order_relaxed);
+    atomic_store_explicit(&table->overflow, n + 1, memory_order_relaxed);
+    return 0;
+}
+
+int smartlog_counters_snapshot(smartlog_counters_t* counters, smartlog_counter_t** out, size_t* count,
+                               uint64_t* overflow)
+{
+    if(counters == NULL || out == NULL || count == NULL)
+    {
+        errno = EINVAL;
+        return 1;
+    }
+    *out = NULL;
+    *count = 0;
+
+    pthread_mutex_lock(&counters->lock);
+
+    /* ====================================================================
+     * STEP 1: Size the Merge Table
+     * ==================================================================== */
+    size_t keys = 0;
+    for(counter_table_t* t = counters->tables; t != NULL; t = t->next)
+    {
+        for(size_t i = 0; i < SMARTLOG_COUNTER_SLOTS; i++)
+        {
+            keys += atomic_load_explicit(&t->slots[i].tmpl, memory_order_acquire) != NULL;
+        }
+    }
+
+    size_t cap = 16;
+    while(cap < keys * 2)
+    {
+        cap *= 2;
+    }
+    smartlog_counter_t* merged = calloc(cap, sizeof(*merged));
+    if(merged == NULL)
+    {
+        pthread_mutex_unlock(&counters->lock);
+        errno = ENOMEM;
+        return 1;
+    }
+
+    /* ====================================================================
+     * STEP 2: Sum Every Thread's Slots per Key
+     * ==================================================================== */
+    uint64_t overflow_delta = 0;
+    for(counter_table_t* t = counters->tables; t != NULL; t = t->next)
+    {
+        uint64_t of = atomic_load_explicit(&t->overflow, memory_order_relaxed);
+        overflow_delta += of - t->overflow_reported;
+        t->overflow_reported = of;
+
+        for(size_t i = 0; i < SMARTLOG_COUNTER_SLOTS; i++)
+        {
+            counter_slot_t* s = &t->slots[i];
+            const char* tmpl = atomic_load_explicit(&s->tmpl, memory_order_acquire);
+            if(tmpl == NULL)
+            {
+                continue;
+            }
+
+            /* Keys published after step 1 can fill the table: bound the probe */
+            uint64_t n = atomic_load_explicit(&s->count, memory_order_relaxed);
+            size_t m = key_hash(tmpl, s->file, s->line, s->level) & (cap - 1);
+            size_t probes = 0;
+            while(probes < cap && merged[m].tmpl != NULL &&
+                  (merged[m].tmpl != tmpl || merged[m].file != s->file ||
+                   merged[m].line != s->line || merged[m].level != s->level))
+            {
+                m = (m + 1) & (cap - 1);
+                probes++;
+            }
+            if(probes == cap)
+            {
+                overflow_delta += n - s->reported;
+                s->reported = n;
+                continue;
+            }
+            if(merged[m].tmpl == NULL)
+            {
+                merged[m].tmpl = tmpl;
+                merged[m].file = s->file;
+                merged[m].line = s->line;
+                merged[m].level = s->level;
+            }
+            merged[m].delta += n - s->reported;
+            merged[m].total += n;
+            s->reported = n;
+        }
+    }
+
+    pthread_mutex_unlock(&counters->lock);
+
+    /* ====================================================================
+     * STEP 3: Keep Keys That Moved, in a Stable Order
+     * ==================================================================== */
+    size_t used = 0;
+    for(size_t i = 0; i < cap; i++)
+    {
+        if(merged[i].tmpl != NULL && merged[i].delta != 0)
+        {
+            merged[used++] = merged[i];
+        }
+    }
+    if(used == 0)
+    {
+        free(merged);
+        merged = NULL;
+    }
+    else
+    {
+        qsort(merged, used, sizeof(*merged), counter_cmp);
+    }
+
+    *out = merged;
+    *count = used;
+    if(overflow != NULL)
+    {
+        *overflow = overflow_delta;
+    }
+    return 0;
+}
+
+void smartlog_counters_destroy(smartlog_counters_t* counters)
+{
+    if(counters == NULL)
+    {
+        return;
+    }
+
+    /* Live threads must not run table_release() on freed tables */
+    pthread_key_delete(counters->exit_key);
+
+    counter_table_t* t = counters->tables;
+    while(t != NULL)
+    {
+        counter_table_t* next = t->next;
+        free(t);
+        t = next;
+    }
+    pthread_mutex_destroy(&counters->lock);
+    free(counters);
+}
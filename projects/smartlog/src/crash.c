@@ -0,0 +1,172 @@
+/*
+ * src/crash.c
+ *
+ * Crash-time flush implementation for SmartLog.
+ *
+ * Implements:
+ *   - Lock-free registry of sinks to drain
+ *   - Fatal-signal handler on an alternate stack
+ *   - Re-raise with the previous disposition after the drain
+ *
+ * Author: Aravinthraj Ganesan
+ * Version: 1.0
+ */
+
+#define _GNU_SOURCE
+#define _POSIX_C_SOURCE 199309L
+
+/* Standard includes */
+#include <errno.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <string.h>
+
+/* Project includes */
+#include <smartlog/config.h>
+#include <smartlog/crash.h>
+#include <smartlog/sink.h>
+
+/* ============================================================================
+ * Global Variables
+ * ============================================================================ */
+
+static const int crash_signals[] = { SIGSEGV, SIGBUS, SIGILL, SIGFPE, SIGABRT };
+#define CRASH_SIGNAL_COUNT (sizeof(crash_signals) / sizeof(crash_signals[0]))
+
+/** Registered sinks; NULL = free entry. */
+static _Atomic(smartlog_sink_t*) crash_sinks[SMARTLOG_CRASH_MAX_SINKS];
+
+/** Dispositions in place before smartlog_crash_install(). */
+static struct sigaction crash_previous[CRASH_SIGNAL_COUNT];
+
+/** Set once by the first fatal signal; a second one skips the drain. */
+static atomic_int crash_draining;
+
+static atomic_int crash_installed;
+
+/** Alternate stack for the installing thread (stack overflow case). */
+static char crash_stack[64 * 1024];
+
+/* ============================================================================
+ * Signal Handler
+ * ============================================================================ */
+
+static void crash_handler(int sig)
+{
+    if(atomic_exchange(&crash_draining, 1) == 0)
+    {
+        smartlog_crash_drain();
+    }
+
+    /* Put the previous disposition back and let it run */
+    for(size_t i = 0; i < CRASH_SIGNAL_COUNT; i++)
+    {
+        if(crash_signals[i] == sig)
+        {
+            (void)sigaction(sig, &crash_previous[i], NULL);
+            break;
+        }
+    }
+    (void)raise(sig);
+}
+
+/* ============================================================================
+ * Public API
+ * ============================================================================ */
+
+int smartlog_crash_install(void)
+{
+    if(atomic_exchange(&crash_installed, 1) != 0)
+    {
+        return 0;
+    }
+
+    stack_t ss;
+    memset(&ss, 0, sizeof(ss));
+    ss.ss_sp = crash_stack;
+    ss.ss_size = sizeof(crash_stack);
+    if(sigaltstack(&ss, NULL) != 0)
+    {
+        atomic_store(&crash_installed, 0);
+        return 1;
+    }
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = crash_handler;
+    sa.sa_flags = SA_ONSTACK;
+
+    /* A peer that went away must not kill us half way through the drain */
+    if(sigemptyset(&sa.sa_mask) != 0 || sigaddset(&sa.sa_mask, SIGPIPE) != 0)
+    {
+        atomic_store(&crash_installed, 0);
+        return 1;
+    }
+
+    for(size_t i = 0; i < CRASH_SIGNAL_COUNT; i++)
+    {
+        if(sigaction(crash_signals[i], &sa, &crash_previous[i]) != 0)
+        {
+            int saved_errno = errno;
+            while(i-- > 0)
+            {
+                (void)sigaction(crash_signals[i], &crash_previous[i], NULL);
+            }
+            atomic_store(&crash_installed, 0);
+            errno = saved_errno;
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+int smartlog_crash_register(smartlog_sink_t* sink)
+{
+    if(sink == NULL)
+    {
+        errno = EINVAL;
+        return 1;
+    }
+
+    for(size_t i = 0; i < SMARTLOG_CRASH_MAX_SINKS; i++)
+    {
+        if(atomic_load(&crash_sinks[i]) == sink)
+        {
+            return 0;
+        }
+    }
+    for(size_t i = 0; i < SMARTLOG_CRASH_MAX_SINKS; i++)
+    {
+        smartlog_sink_t* expected = NULL;
+        if(atomic_compare_exchange_strong(&crash_sinks[i], &expected, sink))
+        {
+            return 0;
+        }
+    }
+
+    errno = ENOSPC;
+    return 1;
+}
+
+void smartlog_crash_unregister(smartlog_sink_t* sink)
+{
+    for(size_t i = 0; i < SMARTLOG_CRASH_MAX_SINKS; i++)
+    {
+        smartlog_sink_t* expected = sink;
+        (void)atomic_compare_exchange_strong(&crash_sinks[i], &expected, NULL);
+    }
+}
+
+void smartlog_crash_drain(void)
+{
+    for(size_t i = 0; i < SMARTLOG_CRASH_MAX_SINKS; i++)
+    {
+        smartlog_sink_t* sink = atomic_load(&crash_sinks[i]);
+        if(sink != NULL)
+        {
+            (void)smartlog_sink_crash_drain(sink);
+        }
+    }
+}
@@ -0,0 +1,419 @@
+/*
+ * src/fd_cache.c
+ *
+ * Process-wide descriptor cache for smartlog_write_log_entry().
+ *
+ * Implements:
+ *   - Path-keyed table of open descriptors under one mutex, with a
+ *     reference count per entry so a descriptor is never closed while a
+ *     write is using it
+ *   - Path checks (stat device/inode against the descriptor's) on a time
+ *     budget per entry
+ *   - LRU eviction of idle entries when the table is full
+ *
+ * Author: Aravinthraj Ganesan
+ * Version: 1.0
+ */
+
+#define _GNU_SOURCE
+#define _POSIX_C_SOURCE 199309L
+
+/* Standard includes */
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* Project includes */
+#include <smartlog/config.h>
+#include <smartlog/fd_cache.h>
+#include <smartlog/utils.h>
+
+/* ============================================================================
+ * Internal Types
+ * ============================================================================ */
+
+typedef struct {
+    char* path;             /* NULL = free slot */
+    uint64_t hash;
+    int fd;
+    dev_t dev;
+    ino_t ino;
+    uint64_t checked_ns;    /* Last path check (monotonic) */
+    uint64_t used;          /* LRU tick */
+    unsigned int refs;      /* Writes using fd right now */
+    int dead;               /* Closed when refs drops to 0, never matched again */
+} fd_entry_t;
+
+static pthread_mutex_t cache_lock = PTHREAD_MUTEX_INITIALIZER;
+static fd_entry_t cache[SMARTLOG_FD_CACHE_MAX];
+static atomic_int cache_enabled;
+static size_t cache_max;
+static uint64_t cache_check_ns;
+static uint64_t cache_tick;
+static smartlog_fd_cache_stats_t cache_stats;
+
+/* ============================================================================
+ * Helpers
+ * ============================================================================ */
+
+static uint64_t path_hash(const char* path)
+{
+    uint64_t h = 0xcbf29ce484222325ull;   /* FNV-1a */
+    for(; *path != '\0'; path++)
+    {
+        h = (h ^ (unsigned char)*path) * 0x100000001b3ull;
+    }
+    return h;
+}
+
+/** Free a slot whose descriptor nobody uses (caller holds cache_lock) */
+static void entry_close(fd_entry_t* e)
+{
+    close(e->fd);
+    free(e->path);
+    memset(e, 0, sizeof(*e));
+    cache_stats.open--;
+}
+
+/** Close now if idle, else when the last user releases (caller holds cache_lock) */
+static void entry_kill(fd_entry_t* e)
+{
+    e->dead = 1;
+    if(e->refs == 0)
+    {
+        entry_close(e);
+    }
+}
+
+/**
+ * A slot for a new entry: a free one while fewer than cache_max entries
+ * are live, else the least recently used idle entry (closed first).
+ *
+ * Return: Slot, or NULL if every entry is in use (caller holds cache_lock)
+ */
+static fd_entry_t* entry_slot(void)
+{
+    fd_entry_t* free_slot = NULL;
+    fd_entry_t* lru = NULL;
+    size_t live = 0;
+    for(size_t i = 0; i < SMARTLOG_FD_CACHE_MAX; i++)
+    {
+        fd_entry_t* e = &cache[i];
+        if(e->path == NULL)
+        {
+            free_slot = free_slot != NULL ? free_slot : e;
+            continue;
+        }
+        if(e->dead)
+        {
+            continue;
+        }
+        live++;
+        if(e->refs == 0 && (lru == NULL || e->used < lru->used))
+        {
+            lru = e;
+        }
+    }
+
+    if(live < cache_max && free_slot != NULL)
+    {
+        return free_slot;
+    }
+    if(lru == NULL)
+    {
+        return NULL;
+    }
+    entry_close(lru);
+    cache_stats.evictions++;
+    return lru;
+}
+
+/**
+ * Open path for appending and read its identity.
+ *
+ * Return: 0 on success, -1 on error (errno is set)
+ */
+static int open_path(const char* path, smartlog_fd_ref_t* ref)
+{
+    struct stat st;
+    ref->created = 0;
+    if(stat(path, &st) == 0)
+    {
+        if(S_ISDIR(st.st_mode))
+        {
+            errno = EISDIR;
+            return -1;
+        }
+    }
+    else if(errno == ENOENT)
+    {
+        ref->created = 1;
+    }
+    else
+    {
+        return -1;
+    }
+
+    int fd = open(path, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, SMARTLOG_FILE_MODE);
+    if(fd < 0)
+    {
+        return -1;
+    }
+    if(fstat(fd, &st) != 0)
+    {
+        int saved_errno = errno;
+        close(fd);
+        errno = saved_errno;
+        return -1;
+    }
+
+    ref->fd = fd;
+    ref->slot = -1;
+    ref->dev = (uint64_t)st.st_dev;
+    ref->ino = (uint64_t)st.st_ino;
+    return 0;
+}
+
+/* ============================================================================
+ * Public API
+ * ============================================================================ */
+
+int smartlog_fd_cache_enable(size_t max_fds, unsigned int check_ms)
+{
+    if(max_fds == 0 || max_fds > SMARTLOG_FD_CACHE_MAX)
+    {
+        errno = EINVAL;
+        return 1;
+    }
+
+    pthread_mutex_lock(&cache_lock);
+
+    /* Shrinking: drop least recently used entries over the new limit */
+    size_t live = 0;
+    for(size_t i = 0; i < SMARTLOG_FD_CACHE_MAX; i++)
+    {
+        live += cache[i].path != NULL && !cache[i].dead;
+    }
+    while(live > max_fds)
+    {
+        fd_entry_t* lru = NULL;
+        for(size_t i = 0; i < SMARTLOG_FD_CACHE_MAX; i++)
+        {
+            if(cache[i].path != NULL && !cache[i].dead && (lru == NULL || cache[i].used < lru->used))
+            {
+                lru = &cache[i];
+            }
+        }
+        entry_kill(lru);
+        cache_stats.evictions++;
+        live--;
+    }
+
+    cache_max = max_fds;
+    cache_check_ns = (uint64_t)check_ms * 1000000ull;
+    atomic_store(&cache_enabled, 1);
+    pthread_mutex_unlock(&cache_lock);
+    return 0;
+}
+
+void smartlog_fd_cache_disable(void)
+{
+    pthread_mutex_lock(&cache_lock);
+    atomic_store(&cache_enabled, 0);
+    for(size_t i = 0; i < SMARTLOG_FD_CACHE_MAX; i++)
+    {
+        if(cache[i].path != NULL && !cache[i].dead)
+        {
+            entry_kill(&cache[i]);
+        }
+    }
+    pthread_mutex_unlock(&cache_lock);
+}
+
+int smartlog_fd_cache_enabled(void)
+{
+    return atomic_load_explicit(&cache_enabled, memory_order_relaxed);
+}
+
+void smartlog_fd_cache_get_stats(smartlog_fd_cache_stats_t* out)
+{
+    if(out == NULL)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&cache_lock);
+    *out = cache_stats;
+    pthread_mutex_unlock(&cache_lock);
+}
+
+/**
+ * Live entry for path, or NULL (caller holds cache_lock).
+ */
+static fd_entry_t* entry_find(const char* path, uint64_t hash)
+{
+    for(size_t i = 0; atomic_load(&cache_enabled) && i < SMARTLOG_FD_CACHE_MAX; i++)
+    {
+        fd_entry_t* e = &cache[i];
+        if(e->path != NULL && !e->dead && e->hash == hash && strcmp(e->path, path) == 0)
+        {
+            return e;
+        }
+    }
+    return NULL;
+}
+
+/** Hand out a cached descriptor (caller holds cache_lock) */
+static void entry_ref(fd_entry_t* e, smartlog_fd_ref_t* ref)
+{
+    e->refs++;
+    e->used = ++cache_tick;
+    ref->fd = e->fd;
+    ref->slot = (int)(e - cache);
+    ref->created = 0;
+    ref->dev = (uint64_t)e->dev;
+    ref->ino = (uint64_t)e->ino;
+}
+
+int smartlog_fd_cache_acquire(const char* path, smartlog_fd_ref_t* ref)
+{
+    if(path == NULL || ref == NULL)
+    {
+        errno = EINVAL;
+        return 1;
+    }
+
+    uint64_t hash = path_hash(path);
+    pthread_mutex_lock(&cache_lock);
+
+    /* ====================================================================
+     * STEP 1: Look Up, Checking the Path When the Budget Is Spent
+     * ==================================================================== */
+    fd_entry_t* e = entry_find(path, hash);
+    if(e != NULL)
+    {
+        uint64_t now = smartlog_monotonic_ns();
+        if(now - e->checked_ns < cache_check_ns)
+        {
+            entry_ref(e, ref);
+            cache_stats.hits++;
+            pthread_mutex_unlock(&cache_lock);
+            return 0;
+        }
+
+        /* stat() can block: check unlocked, with a ref pinning the slot */
+        dev_t dev = e->dev;
+        ino_t ino = e->ino;
+        e->refs++;
+        pthread_mutex_unlock(&cache_lock);
+
+        struct stat st;
+        int same = stat(path, &st) == 0 && st.st_dev == dev && st.st_ino == ino;
+
+        pthread_mutex_lock(&cache_lock);
+        e->refs--;
+        if(e->dead)
+        {
+            /* Killed (evicted or disabled) meanwhile */
+            if(e->refs == 0)
+            {
+                entry_close(e);
+            }
+        }
+        else if(!same)
+        {
+            entry_kill(e);
+            cache_stats.stale++;
+        }
+        else
+        {
+            e->checked_ns = now;
+            entry_ref(e, ref);
+            cache_stats.hits++;
+            pthread_mutex_unlock(&cache_lock);
+            return 0;
+        }
+    }
+    cache_stats.misses++;
+    pthread_mutex_unlock(&cache_lock);
+
+    /* ====================================================================
+     * STEP 2: Open Unlocked
+     * ==================================================================== */
+    if(open_path(path, ref) != 0)
+    {
+        return 1;
+    }
+
+    /* ====================================================================
+     * STEP 3: Keep the Descriptor if There Is Room and No Other Thread Won
+     * ==================================================================== */
+    pthread_mutex_lock(&cache_lock);
+    e = entry_find(path, hash);
+    if(e != NULL && (uint64_t)e->dev == ref->dev && (uint64_t)e->ino == ref->ino)
+    {
+        int created = ref->created;
+        close(ref->fd);
+        entry_ref(e, ref);
+        ref->created = created;
+        cache_stats.races++;
+        pthread_mutex_unlock(&cache_lock);
+        return 0;
+    }
+    if(e != NULL)
+    {
+        /* The other thread opened a file that has been replaced since */
+        entry_kill(e);
+        cache_stats.stale++;
+    }
+
+    e = atomic_load(&cache_enabled) ? entry_slot() : NULL;
+    char* copy = e != NULL ? strdup(path) : NULL;
+    if(copy != NULL)
+    {
+        e->path = copy;
+        e->hash = hash;
+        e->fd = ref->fd;
+        e->dev = (dev_t)ref->dev;
+        e->ino = (ino_t)ref->ino;
+        e->checked_ns = smartlog_monotonic_ns();
+        e->used = ++cache_tick;
+        e->refs = 1;
+        e->dead = 0;
+        ref->slot = (int)(e - cache);
+        cache_stats.open++;
+    }
+    pthread_mutex_unlock(&cache_lock);
+    return 0;
+}
+
+void smartlog_fd_cache_release(smartlog_fd_ref_t* ref, int drop)
+{
+    if(ref == NULL || ref->fd < 0)
+    {
+        return;
+    }
+
+    if(ref->slot < 0)
+    {
+        close(ref->fd);
+    }
+    else
+    {
+        pthread_mutex_lock(&cache_lock);
+        fd_entry_t* e = &cache[ref->slot];
+        e->refs--;
+        if(drop || e->dead)
+        {
+            entry_kill(e);
+        }
+        pthread_mutex_unlock(&cache_lock);
+    }
+    ref->fd = -1;
+}
@@ -0,0 +1,951 @@
+/*
+ * src/logger.c
+ *
+ * Logger handle implementation for SmartLog.
+ *
+ * Implements:
+ *   - Sink registration
+ *   - Writer spin, CPU affinity and huge pages for all sinks
+ *   - Opt-in crash-time flush
+ *   - Per-logger sequence numbers and per-thread IDs in every record
+ *   - The thread's context fields (context.h) copied into every entry
+ *   - Optional anchored TSC/raw clock with anchor records
+ *   - Optional per-call-site counters with periodic summary records
+ *   - Optional flight recorder, dumped on a level, an API call or a signal
+ *   - Format-once, fan-out-to-all-sinks log path
+ *   - Flush and teardown
+ *
+ * Author: Aravinthraj Ganesan
+ * Version: 1.0
+ */
+
+#define _GNU_SOURCE
+#define _POSIX_C_SOURCE 199309L
+
+/* Standard includes */
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+/* Project includes */
+#include <smartlog/clock.h>
+#include <smartlog/context.h>
+#include <smartlog/config.h>
+#include <smartlog/counters.h>
+#include <smartlog/crash.h>
+#include <smartlog/logger.h>
+#include <smartlog/recorder.h>
+#include <smartlog/sink.h>
+#include <smartlog/smartlog_core.h>
+#include <smartlog/utils.h>
+
+/* ============================================================================
+ * Internal Types
+ * ============================================================================ */
+
+struct smartlog_logger {
+    smartlog_sink_t* sinks[SMARTLOG_MAX_SINKS];
+    size_t sink_count;
+    int spin_set;               /* smartlog_logger_set_writer_spin() called */
+    unsigned int spin_us;
+    feature_state_t huge_pages; /* Applied to sinks as they are attached */
+    int crash_flush;            /* smartlog_logger_enable_crash_flush() called */
+    int affinity_set;           /* smartlog_logger_set_writer_affinity() called */
+    int affinity_cpus[SMARTLOG_MAX_WRITER_CPUS];
+    size_t affinity_count;
+    atomic_uint_fast64_t next_seq; /* Last sequence number handed out */
+    smartlog_clock_t* clock;       /* NULL = CLOCK_REALTIME per entry */
+    smartlog_counters_t* counters; /* NULL = counters not enabled */
+    uint64_t counter_interval_ns;  /* 0 = no periodic summaries */
+    atomic_uint_fast64_t next_summary_ns; /* Monotonic time of the next summary */
+    atomic_uint_fast64_t summaries;       /* Summaries written */
+    smartlog_recorder_t* recorder; /* NULL = flight recorder off */
+    log_level_t recorder_trigger;  /* Lowest level written (and dumping) */
+    atomic_uint_fast64_t recorder_lost;   /* Overwritten count at the last dump */
+    int recorder_efd;              /* Signal dump eventfd (-1 = none) */
+    pthread_t recorder_thread;     /* Does the signal dumps */
+    atomic_int recorder_stop;
+};
+
+#define COUNTER_CHECK_EVERY  64  /* Count-only calls per thread between clock reads */
+#define COUNTER_TMPL_SHOWN   40  /* Template bytes shown in a summary */
+
+static const char* const level_names[] = { "DEBUG", "INFO", "WARN", "ERROR" };
+static _Thread_local unsigned int counted_calls;
+
+/* Loggers waiting for a dump signal: eventfd + 1 (0 = free) and signal */
+static atomic_int recorder_signal_fds[SMARTLOG_RECORDER_SIGNALS];
+static atomic_int recorder_signal_nos[SMARTLOG_RECORDER_SIGNALS];
+static struct sigaction recorder_signal_old[SMARTLOG_RECORDER_SIGNALS]; /* Restored by the last slot */
+static atomic_int recorder_signal_busy;     /* Handlers running right now */
+static pthread_mutex_t recorder_signal_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* ============================================================================
+ * PID Cache
+ * ============================================================================ */
+
+/*
+ * getpid() is a real syscall on current glibc. Cache it once per process
+ * and refresh it in the child after fork(). The thread ID is cached per
+ * thread; the forking thread is the child's only thread and gets a new ID.
+ */
+static pid_t cached_pid;
+static _Thread_local pid_t cached_tid;
+static pthread_once_t pid_once = PTHREAD_ONCE_INIT;
+
+static void pid_refresh(void)
+{
+    cached_pid = getpid();
+    cached_tid = 0;
+}
+
+static pid_t current_tid(void)
+{
+    if(cached_tid == 0)
+    {
+        cached_tid = (pid_t)syscall(SYS_gettid);
+    }
+    return cached_tid;
+}
+
+static void pid_init(void)
+{
+    pid_refresh();
+    (void)pthread_atfork(NULL, NULL, pid_refresh);
+}
+
+/* ============================================================================
+ * Log Path Helpers
+ * ============================================================================ */
+
+static int logger_log(smartlog_logger_t* logger, log_level_t level, const char* msg, int with_context);
+
+/**
+ * Format one record into line. With with_context, the thread's encoded
+ * context is copied into the header.
+ *
+ * Return: 0 on success, 1 on error (errno is set)
+ */
+static int logger_format(smartlog_logger_t* logger, log_level_t level, uint64_t time_ns, const char* msg,
+                         int with_context, char* line, size_t line_sz, smartlog_record_t* record)
+{
+    /* Orders entries of this logger even when timestamps tie or step back */
+    uint64_t seq = atomic_fetch_add_explicit(&logger->next_seq, 1, memory_order_relaxed) + 1;
+    pid_t tid = current_tid();
+
+    size_t ctx_len = 0;
+    const char* ctx = with_context ? smartlog_context_encoded(&ctx_len) : NULL;
+
+    int line_len = smartlog_format_record_ctx(line, line_sz, time_ns, cached_pid, tid, seq,
+                                              ctx, ctx_len, msg);
+    if(line_len < 0)
+    {
+        return 1;
+    }
+
+    record->level = level;
+    record->time_ns = time_ns;
+    record->pid = cached_pid;
+    record->tid = tid;
+    record->seq = seq;
+    record->msg = msg;
+    record->line = line;
+    record->line_len = (size_t)line_len;
+    return 0;
+}
+
+/**
+ * Format one record and submit it to every sink. With with_context, the
+ * thread's encoded context is copied into the header.
+ *
+ * Return: 0 on success, 1 if formatting or any sink failed (errno is set)
+ */
+static int logger_emit(smartlog_logger_t* logger, log_level_t level, uint64_t time_ns, const char* msg,
+                       int with_context)
+{
+    char line[SMARTLOG_LOG_BUFFER_SZ];
+    smartlog_record_t record;
+    if(logger_format(logger, level, time_ns, msg, with_context, line, sizeof(line), &record) != 0)
+    {
+        return 1;
+    }
+
+    /* Flight recorder: below the trigger level, memory only */
+    if(logger->recorder != NULL && level < logger->recorder_trigger)
+    {
+        return smartlog_recorder_add(logger->recorder, &record);
+    }
+
+    int rc = 0;
+    int first_errno = 0;
+    for(size_t i = 0; i < logger->sink_count; i++)
+    {
+        if(smartlog_sink_submit(logger->sinks[i], &record) != 0 && rc == 0)
+        {
+            rc = 1;
+            first_errno = errno;
+        }
+    }
+
+    if(rc != 0)
+    {
+        errno = first_errno;
+    }
+    return rc;
+}
+
+/**
+ * Format one record and write it to every sink, past sink levels, sink
+ * filters and the flight recorder: for records every output must carry
+ * (clock anchors), whatever level the entry that caused them has.
+ *
+ * Return: 0 on success, 1 if formatting or any sink failed (errno is set)
+ */
+static int logger_emit_always(smartlog_logger_t* logger, log_level_t level, uint64_t time_ns, const char* msg)
+{
+    char line[SMARTLOG_LOG_BUFFER_SZ];
+    smartlog_record_t record;
+    if(logger_format(logger, level, time_ns, msg, 0, line, sizeof(line), &record) != 0)
+    {
+        return 1;
+    }
+
+    struct iovec iov;
+    iov.iov_base = line;
+    iov.iov_len = record.line_len;
+
+    int rc = 0;
+    int first_errno = 0;
+    for(size_t i = 0; i < logger->sink_count; i++)
+    {
+        if(smartlog_sink_write_lines(logger->sinks[i], &iov, 1) != 0 && rc == 0)
+        {
+            rc = 1;
+            first_errno = errno;
+        }
+    }
+
+    if(rc != 0)
+    {
+        errno = first_errno;
+    }
+    return rc;
+}
+
+/* ============================================================================
+ * Counter Summaries
+ * ============================================================================ */
+
+/**
+ * Write what the counters moved since the last summary, packed into as
+ * few records as SMARTLOG_MSG_MAX_LEN allows.
+ *
+ * Return: 0 on success, 1 on error (errno is set)
+ */
+static int logger_write_summary(smartlog_logger_t* logger)
+{
+    smartlog_counter_t* keys = NULL;
+    size_t nkeys = 0;
+    uint64_t overflow = 0;
+    if(smartlog_counters_snapshot(logger->counters, &keys, &nkeys, &overflow) != 0)
+    {
+        return 1;
+    }
+    if(nkeys == 0 && overflow == 0)
+    {
+        return 0;
+    }
+
+    unsigned long long snap = (unsigned long long)
+        atomic_fetch_add_explicit(&logger->summaries, 1, memory_order_relaxed) + 1;
+    unsigned int part = 1;
+    char msg[SMARTLOG_MSG_MAX_LEN + 1];
+    int header_len = snprintf(msg, sizeof(msg), "counters snap=%llu part=%u", snap, part);
+    size_t len = (size_t)header_len;
+    int rc = 0;
+    int first_errno = 0;
+
+    for(size_t i = 0; i <= nkeys; i++)
+    {
+        char entry[SMARTLOG_MSG_MAX_LEN];
+        int entry_len = 0;
+        if(i < nkeys)
+        {
+            const smartlog_counter_t* k = &keys[i];
+            const char* base = strrchr(k->file, '/');
+            entry_len = snprintf(entry, sizeof(entry), " | %s %.40s:%d \"%.*s\" +%llu=%llu",
+                                 level_names[k->level & 3], base != NULL ? base + 1 : k->file, k->line,
+                                 COUNTER_TMPL_SHOWN, k->tmpl,
+                                 (unsigned long long)k->delta, (unsigned long long)k->total);
+        }
+        else if(overflow != 0)
+        {
+            entry_len = snprintf(entry, sizeof(entry), " | overflow +%llu", (unsigned long long)overflow);
+        }
+
+        /* Full: write this part and start the next one */
+        if(len + (size_t)entry_len > SMARTLOG_MSG_MAX_LEN && len > (size_t)header_len)
+        {
+            if(logger_log(logger, LOG_LEVEL_INFO, msg, 0) != 0 && rc == 0)
+            {
+                rc = 1;
+                first_errno = errno;
+            }
+            header_len = snprintf(msg, sizeof(msg), "counters snap=%llu part=%u", snap, ++part);
+            len = (size_t)header_len;
+        }
+        if(entry_len > 0)
+        {
+            memcpy(msg + len, entry, (size_t)entry_len + 1);
+            len += (size_t)entry_len;
+        }
+    }
+    if(len > (size_t)header_len && logger_log(logger, LOG_LEVEL_INFO, msg, 0) != 0 && rc == 0)
+    {
+        rc = 1;
+        first_errno = errno;
+    }
+
+    free(keys);
+    if(rc != 0)
+    {
+        errno = first_errno;
+    }
+    return rc;
+}
+
+/**
+ * Write a summary if the period has passed; one caller wins the race.
+ */
+static void logger_summary_tick(smartlog_logger_t* logger)
+{
+    if(logger->counter_interval_ns == 0)
+    {
+        return;
+    }
+
+    uint64_t now = smartlog_monotonic_ns();
+    uint64_t due = atomic_load_explicit(&logger->next_summary_ns, memory_order_relaxed);
+    if(now < due ||
+       !atomic_compare_exchange_strong_explicit(&logger->next_summary_ns, &due, now + logger->counter_interval_ns,
+                                                memory_order_relaxed, memory_order_relaxed))
+    {
+        return;
+    }
+    (void)logger_write_summary(logger);
+}
+
+/* ============================================================================
+ * Flight Recorder
+ * ============================================================================ */
+
+/** Dump callback: one recorded entry to every sink */
+static int recorder_replay(const smartlog_record_t* record, void* arg)
+{
+    smartlog_logger_t* logger = (smartlog_logger_t*)arg;
+    int rc = 0;
+    for(size_t i = 0; i < logger->sink_count; i++)
+    {
+        if(smartlog_sink_submit(logger->sinks[i], record) != 0)
+        {
+            rc = -1;
+        }
+    }
+    return rc;
+}
+
+/**
+ * Dump the ring to the sinks, then log the marker entry at level.
+ *
+ * Return: 0 on success, 1 on error (errno is set)
+ */
+static int logger_dump_recorder(smartlog_logger_t* logger, const char* reason, log_level_t level)
+{
+    size_t lines = 0;
+    int rc = smartlog_recorder_dump(logger->recorder, recorder_replay, logger, &lines);
+    int saved_errno = errno;
+
+    smartlog_recorder_stats_t st;
+    smartlog_recorder_get_stats(logger->recorder, &st);
+    uint64_t lost = st.overwritten -
+        atomic_exchange_explicit(&logger->recorder_lost, st.overwritten, memory_order_relaxed);
+    if(lines == 0 && lost == 0)
+    {
+        errno = saved_errno;
+        return rc;
+    }
+
+    /* At the trigger level or above, so the marker never goes to the ring */
+    char marker[SMARTLOG_MSG_MAX_LEN];
+    snprintf(marker, sizeof(marker), "recorder dump reason=%s lines=%zu lost=%llu",
+             reason, lines, (unsigned long long)lost);
+    if(logger_log(logger, level, marker, 0) != 0 && rc == 0)
+    {
+        return 1;
+    }
+    errno = saved_errno;
+    return rc;
+}
+
+static void recorder_signal_handler(int sig)
+{
+    int saved_errno = errno;
+    uint64_t one = 1;
+    atomic_fetch_add(&recorder_signal_busy, 1);
+    for(size_t i = 0; i < SMARTLOG_RECORDER_SIGNALS; i++)
+    {
+        int fd = atomic_load(&recorder_signal_fds[i]) - 1;
+        if(fd >= 0 && atomic_load(&recorder_signal_nos[i]) == sig)
+        {
+            ssize_t n = write(fd, &one, sizeof(one));
+            (void)n;
+        }
+    }
+    atomic_fetch_sub(&recorder_signal_busy, 1);
+    errno = saved_errno;
+}
+
+static void* recorder_signal_main(void* arg)
+{
+    smartlog_logger_t* logger = (smartlog_logger_t*)arg;
+    for(;;)
+    {
+        uint64_t pending = 0;
+        ssize_t n = read(logger->recorder_efd, &pending, sizeof(pending));
+        if(n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if(n != (ssize_t)sizeof(pending) || atomic_load(&logger->recorder_stop))
+        {
+            break;
+        }
+        (void)logger_dump_recorder(logger, "signal", logger->recorder_trigger);
+    }
+    return NULL;
+}
+
+/* ============================================================================
+ * Public API
+ * ============================================================================ */
+
+smartlog_logger_t* smartlog_logger_create(void)
+{
+    smartlog_logger_t* logger = calloc(1, sizeof(*logger));
+    if(logger == NULL)
+    {
+        return NULL;
+    }
+    atomic_init(&logger->next_seq, 0);
+    logger->recorder_efd = -1;
+
+    pthread_once(&pid_once, pid_init);
+    return logger;
+}
+
+int smartlog_logger_add_sink(smartlog_logger_t* logger, smartlog_sink_t* sink)
+{
+    if(logger == NULL || sink == NULL)
+    {
+        errno = EINVAL;
+        return 1;
+    }
+    if(logger->sink_count >= SMARTLOG_MAX_SINKS)
+    {
+        errno = ENOSPC;
+        return 1;
+    }
+
+    if(logger->spin_set != 0)
+    {
+        (void)smartlog_sink_set_spin(sink, logger->spin_us);
+    }
+    if(logger->huge_pages == FEATURE_ENABLED)
+    {
+        /* Fails only for sinks that are async already: keep their pages */
+        (void)smartlog_sink_set_huge_pages(sink, FEATURE_ENABLED);
+    }
+    if(logger->crash_flush != 0 && smartlog_crash_register(sink) != 0)
+    {
+        return 1;
+    }
+    if(logger->affinity_set != 0 &&
+       smartlog_sink_set_affinity(sink, logger->affinity_cpus, logger->affinity_count) != 0)
+    {
+        return 1;
+    }
+
+    logger->sinks[logger->sink_count++] = sink;
+    return 0;
+}
+
+int smartlog_logger_set_writer_spin(smartlog_logger_t* logger, unsigned int spin_us)
+{
+    if(logger == NULL)
+    {
+        errno = EINVAL;
+        return 1;
+    }
+
+    logger->spin_set = 1;
+    logger->spin_us = spin_us;
+    for(size_t i = 0; i < logger->sink_count; i++)
+    {
+        (void)smartlog_sink_set_spin(logger->sinks[i], spin_us);
+    }
+    return 0;
+}
+
+int smartlog_logger_enable_crash_flush(smartlog_logger_t* logger)
+{
+    if(logger == NULL)
+    {
+        errno = EINVAL;
+        return 1;
+    }
+
+    if(smartlog_crash_install() != 0)
+    {
+        return 1;
+    }
+    for(size_t i = 0; i < logger->sink_count; i++)
+    {
+        if(smartlog_crash_register(logger->sinks[i]) != 0)
+        {
+            return 1;
+        }
+    }
+
+    logger->crash_flush = 1;
+    return 0;
+}
+
+int smartlog_logger_set_huge_pages(smartlog_logger_t* logger, feature_state_t huge_pages)
+{
+    if(logger == NULL || (huge_pages != FEATURE_DISABLED && huge_pages != FEATURE_ENABLED))
+    {
+        errno = EINVAL;
+        return 1;
+    }
+
+    logger->huge_pages = huge_pages;
+    return 0;
+}
+
+int smartlog_logger_set_writer_affinity(smartlog_logger_t* logger, const int* cpus, size_t ncpus)
+{
+    if(logger == NULL || (cpus == NULL && ncpus != 0) || ncpus > SMARTLOG_MAX_WRITER_CPUS)
+    {
+        errno = EINVAL;
+        return 1;
+    }
+    for(size_t i = 0; i < ncpus; i++)
+    {
+        if(cpus[i] < 0)
+        {
+            errno = EINVAL;
+            return 1;
+        }
+    }
+
+    for(size_t i = 0; i < logger->sink_count; i++)
+    {
+        if(smartlog_sink_set_affinity(logger->sinks[i], cpus, ncpus) != 0)
+        {
+            return 1;
+        }
+    }
+
+    for(size_t i = 0; i < ncpus; i++)
+    {
+        logger->affinity_cpus[i] = cpus[i];
+    }
+    logger->affinity_count = ncpus;
+    logger->affinity_set = 1;
+    return 0;
+}
+
+int smartlog_logger_set_clock(smartlog_logger_t* logger, clock_mode_t mode)
+{
+    if(logger == NULL)
+    {
+        errno = EINVAL;
+        return 1;
+    }
+
+    smartlog_clock_t* clk = NULL;
+    if(mode != CLOCK_MODE_REALTIME && (clk = smartlog_clock_create(mode)) == NULL)
+    {
+        return 1;
+    }
+
+    smartlog_clock_destroy(logger->clock);
+    logger->clock = clk;
+    return 0;
+}
+
+int smartlog_logger_enable_counters(smartlog_logger_t* logger, unsigned int interval_ms)
+{
+    if(logger == NULL)
+    {
+        errno = EINVAL;
+        return 1;
+    }
+
+    if(logger->counters == NULL && (logger->counters = smartlog_counters_create()) == NULL)
+    {
+        return 1;
+    }
+    logger->counter_interval_ns = (uint64_t)interval_ms * 1000000ull;
+    atomic_store_explicit(&logger->next_summary_ns, smartlog_monotonic_ns() + logger->counter_interval_ns,
+                          memory_order_relaxed);
+    return 0;
+}
+
+int smartlog_logger_count(smartlog_logger_t* logger, log_level_t level, const char* tmpl,
+                          const char* file, int line)
+{
+    if(logger == NULL || tmpl == NULL || file == NULL)
+    {
+        errno = EINVAL;
+        return 1;
+    }
+    if(logger->counters == NULL)
+    {
+        return 0;
+    }
+
+    if(smartlog_counters_add(logger->counters, level, tmpl, file, line) != 0)
+    {
+        return 1;
+    }
+    if(++counted_calls % COUNTER_CHECK_EVERY == 0)
+    {
+        logger_summary_tick(logger);
+    }
+    return 0;
+}
+
+int smartlog_logger_log_counted(smartlog_logger_t* logger, log_level_t level, const char* tmpl,
+                                const char* file, int line, const char* msg)
+{
+    if(logger == NULL || tmpl == NULL || file == NULL)
+    {
+        errno = EINVAL;
+        return 1;
+    }
+
+    if(logger->counters != NULL)
+    {
+        if(smartlog_counters_add(logger->counters, level, tmpl, file, line) != 0)
+        {
+            return 1;
+        }
+        logger_summary_tick(logger);
+    }
+    return smartlog_logger_log(logger, level, msg);
+}
+
+int smartlog_logger_snapshot_counters(smartlog_logger_t* logger)
+{
+    if(logger == NULL)
+    {
+        errno = EINVAL;
+        return 1;
+    }
+    if(logger->counters == NULL)
+    {
+        errno = ENOTSUP;
+        return 1;
+    }
+    return logger_write_summary(logger);
+}
+
+int smartlog_logger_enable_recorder(smartlog_logger_t* logger, size_t ring_bytes, log_level_t trigger_level)
+{
+    if(logger == NULL || logger->recorder != NULL)
+    {
+        errno = EINVAL;
+        return 1;
+    }
+
+    if((logger->recorder = smartlog_recorder_create(ring_bytes)) == NULL)
+    {
+        return 1;
+    }
+    logger->recorder_trigger = trigger_level;
+    return 0;
+}
+
+int smartlog_logger_dump_recorder(smartlog_logger_t* logger)
+{
+    if(logger == NULL)
+    {
+        errno = EINVAL;
+        return 1;
+    }
+    if(logger->recorder == NULL)
+    {
+        errno = ENOTSUP;
+        return 1;
+    }
+    return logger_dump_recorder(logger, "api", logger->recorder_trigger);
+}
+
+int smartlog_logger_dump_recorder_on_signal(smartlog_logger_t* logger, int signo)
+{
+    if(logger == NULL || signo <= 0 || logger->recorder_efd >= 0)
+    {
+        errno = EINVAL;
+        return 1;
+    }
+    if(logger->recorder == NULL)
+    {
+        errno = ENOTSUP;
+        return 1;
+    }
+
+    int efd = eventfd(0, EFD_CLOEXEC);
+    if(efd < 0)
+    {
+        return 1;
+    }
+    logger->recorder_efd = efd;
+    atomic_store(&logger->recorder_stop, 0);
+    int rc = pthread_create(&logger->recorder_thread, NULL, recorder_signal_main, logger);
+    if(rc != 0)
+    {
+        close(efd);
+        logger->recorder_efd = -1;
+        errno = rc;
+        return 1;
+    }
+
+    pthread_mutex_lock(&recorder_signal_lock);
+    size_t slot = 0;
+    while(slot < SMARTLOG_RECORDER_SIGNALS && atomic_load(&recorder_signal_fds[slot]) != 0)
+    {
+        slot++;
+    }
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = recorder_signal_handler;
+    sa.sa_flags = SA_RESTART;
+    sigemptyset(&sa.sa_mask);
+    /* Keep the disposition from before the first slot on this signal */
+    size_t peer = 0;
+    while(peer < SMARTLOG_RECORDER_SIGNALS &&
+          (atomic_load(&recorder_signal_fds[peer]) == 0 || atomic_load(&recorder_signal_nos[peer]) != signo))
+    {
+        peer++;
+    }
+    struct sigaction old;
+    int saved_errno = ENOSPC;
+    if(slot < SMARTLOG_RECORDER_SIGNALS && (saved_errno = EINVAL, sigaction(signo, &sa, &old) == 0))
+    {
+        recorder_signal_old[slot] = peer < SMARTLOG_RECORDER_SIGNALS ? recorder_signal_old[peer] : old;
+        atomic_store(&recorder_signal_nos[slot], signo);
+        atomic_store(&recorder_signal_fds[slot], efd + 1);
+        pthread_mutex_unlock(&recorder_signal_lock);
+        return 0;
+    }
+    if(slot < SMARTLOG_RECORDER_SIGNALS)
+    {
+        saved_errno = errno;
+    }
+    pthread_mutex_unlock(&recorder_signal_lock);
+
+    /* Undo: stop the thread again */
+    uint64_t one = 1;
+    atomic_store(&logger->recorder_stop, 1);
+    ssize_t n = write(efd, &one, sizeof(one));
+    (void)n;
+    pthread_join(logger->recorder_thread, NULL);
+    close(efd);
+    logger->recorder_efd = -1;
+    errno = saved_errno;
+    return 1;
+}
+
+/**
+ * smartlog_logger_log(); summaries and markers leave out the thread's
+ * context, since they are not about the work that thread is doing.
+ */
+static int logger_log(smartlog_logger_t* logger, log_level_t level, const char* msg, int with_context)
+{
+    if(logger == NULL || msg == NULL || msg[0] == '\0')
+    {
+        errno = EINVAL;
+        return 1;
+    }
+
+    /* A triggering entry comes after the context that led to it */
+    if(logger->recorder != NULL && level >= logger->recorder_trigger)
+    {
+        (void)logger_dump_recorder(logger, "level", level);
+    }
+
+    /* ====================================================================
+     * STEP 1: Read the Clock
+     * ==================================================================== */
+    smartlog_clock_anchor_t anchor;
+    int anchored = 0;
+    errno = 0;
+    uint64_t time_ns = logger->clock != NULL ?
+        smartlog_clock_now(logger->clock, &anchor, &anchored) :
+        smartlog_timestamp_ns();
+    if(time_ns == 0 && errno != 0)
+    {
+        return 1;
+    }
+
+    /* ====================================================================
+     * STEP 2: Anchor Record First, to Every Sink, So Readers Can Map Back
+     * ==================================================================== */
+    int rc = 0;
+    int first_errno = 0;
+    if(anchored)
+    {
+        char anchor_msg[SMARTLOG_MSG_MAX_LEN];
+        snprintf(anchor_msg, sizeof(anchor_msg), "clock anchor mode=%s raw=%llu real_ns=%llu mult=%llu",
+                 anchor.mode == CLOCK_MODE_TSC ? "tsc" : "monotonic_raw",
+                 (unsigned long long)anchor.raw,
+                 (unsigned long long)anchor.real_ns,
+                 (unsigned long long)anchor.mult);
+        if(logger_emit_always(logger, level, time_ns, anchor_msg) != 0)
+        {
+            rc = 1;
+            first_errno = errno;
+        }
+    }
+
+    /* ====================================================================
+     * STEP 3: Format Once and Fan Out
+     * ==================================================================== */
+    if(logger_emit(logger, level, time_ns, msg, with_context) != 0 && rc == 0)
+    {
+        rc = 1;
+        first_errno = errno;
+    }
+
+    if(rc != 0)
+    {
+        errno = first_errno;
+    }
+    return rc;
+}
+
+int smartlog_logger_log(smartlog_logger_t* logger, log_level_t level, const char* msg)
+{
+    return logger_log(logger, level, msg, 1);
+}
+
+int smartlog_logger_flush(smartlog_logger_t* logger)
+{
+    if(logger == NULL)
+    {
+        errno = EINVAL;
+        return 1;
+    }
+
+    int rc = 0;
+    int first_errno = 0;
+    for(size_t i = 0; i < logger->sink_count; i++)
+    {
+        if(smartlog_sink_flush(logger->sinks[i]) != 0 && rc == 0)
+        {
+            rc = 1;
+            first_errno = errno;
+        }
+    }
+
+    if(rc != 0)
+    {
+        errno = first_errno;
+    }
+    return rc;
+}
+
+size_t smartlog_logger_sink_count(const smartlog_logger_t* logger)
+{
+    return logger == NULL ? 0 : logger->sink_count;
+}
+
+smartlog_sink_t* smartlog_logger_get_sink(const smartlog_logger_t* logger, size_t index)
+{
+    if(logger == NULL || index >= logger->sink_count)
+    {
+        return NULL;
+    }
+    return logger->sinks[index];
+}
+
+void smartlog_logger_destroy(smartlog_logger_t* logger)
+{
+    if(logger == NULL)
+    {
+        return;
+    }
+
+    if(logger->recorder_efd >= 0)
+    {
+        pthread_mutex_lock(&recorder_signal_lock);
+        for(size_t i = 0; i < SMARTLOG_RECORDER_SIGNALS; i++)
+        {
+            if(atomic_load(&recorder_signal_fds[i]) != logger->recorder_efd + 1)
+            {
+                continue;
+            }
+            atomic_store(&recorder_signal_fds[i], 0);
+
+            /* Last logger on this signal: give it back its old disposition */
+            int signo = atomic_load(&recorder_signal_nos[i]);
+            int shared = 0;
+            for(size_t j = 0; j < SMARTLOG_RECORDER_SIGNALS; j++)
+            {
+                shared |= atomic_load(&recorder_signal_fds[j]) != 0 &&
+                          atomic_load(&recorder_signal_nos[j]) == signo;
+            }
+            if(!shared)
+            {
+                (void)sigaction(signo, &recorder_signal_old[i], NULL);
+            }
+        }
+        pthread_mutex_unlock(&recorder_signal_lock);
+
+        /* A handler may still hold the old fd number: let it finish first */
+        while(atomic_load(&recorder_signal_busy) != 0)
+        {
+            sched_yield();
+        }
+
+        uint64_t one = 1;
+        atomic_store(&logger->recorder_stop, 1);
+        ssize_t n = write(logger->recorder_efd, &one, sizeof(one));
+        (void)n;
+        pthread_join(logger->recorder_thread, NULL);
+        close(logger->recorder_efd);
+    }
+
+    if(logger->counters != NULL)
+    {
+        (void)logger_write_summary(logger);
+    }
+    for(size_t i = 0; i < logger->sink_count; i++)
+    {
+        smartlog_sink_destroy(logger->sinks[i]);
+    }
+    smartlog_clock_destroy(logger->clock);
+    smartlog_counters_destroy(logger->counters);
+    smartlog_recorder_destroy(logger->recorder);
+    free(logger);
+}
@@ -0,0 +1,947 @@
+/*
+ * src/lz4.c
+ *
+ * LZ4 frame encoder and streaming decoder for SmartLog.
+ *
+ * Implements:
+ *   - LZ4 block compression with a single-probe hash table (the fast
+ *     greedy parse), matching into the previous 64 KB of the frame
+ *   - Frame header, block and end mark encoding
+ *   - Bounds-checked block decompression
+ *   - A decoder that accepts input in arbitrary pieces
+ *   - xxHash32 for the frame header and block checksums
+ *
+ * Only the format is shared with liblz4; no library is needed to build or
+ * read the files.
+ *
+ * Author: Aravinthraj Ganesan
+ * Version: 1.0
+ */
+
+#define _GNU_SOURCE
+#define _POSIX_C_SOURCE 199309L
+
+/* Standard includes */
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* Project includes */
+#include <smartlog/config.h>
+#include <smartlog/lz4.h>
+#include <smartlog/utils.h>
+
+/* ============================================================================
+ * Format Constants
+ * ============================================================================ */
+
+#define LZ4_FRAME_MAGIC      0x184D2204u
+#define LZ4_SKIP_MAGIC       0x184D2A50u    /* 0x184D2A50..0x184D2A5F */
+#define LZ4_BLOCK_RAW        0x80000000u    /* Block size flag: stored uncompressed */
+#define LZ4_WINDOW           65536u         /* Max match distance + 1 */
+#define LZ4_BLOCK_MAX        65536u         /* Encoder block size (BD id 4) */
+#define LZ4_MIN_MATCH        4
+#define LZ4_LAST_LITERALS    5              /* Block always ends with literals */
+#define LZ4_MF_LIMIT         12             /* Last match starts this far from the end */
+#define LZ4_HASH_LOG         12
+#define LZ4_FLG_VERSION      0x40u
+#define LZ4_FLG_INDEPENDENT  0x20u
+#define LZ4_FLG_BLOCK_SUM    0x10u
+#define LZ4_FLG_CONTENT_SIZE 0x08u
+#define LZ4_FLG_CONTENT_SUM  0x04u
+#define LZ4_FLG_DICT_ID      0x01u
+
+/* Encoder window: 64 KB history, the pending block and room to append */
+#define ENC_WIN_SIZE         (3u * LZ4_WINDOW)
+#define DEC_READ_SIZE        (64u << 10)
+
+/* ============================================================================
+ * Internal Types
+ * ============================================================================ */
+
+struct smartlog_lz4_encoder {
+    unsigned char* win;         /* History, then pending text */
+    size_t win_len;             /* Valid bytes in win */
+    size_t block_start;         /* First pending byte */
+    uint32_t base_pos;          /* Stream position of win[0] (0 = empty slot) */
+    int in_frame;
+    unsigned char* out;         /* Queued output */
+    size_t out_len;
+    size_t out_cap;
+    uint32_t table[1u << LZ4_HASH_LOG];
+};
+
+typedef enum {
+    DEC_MAGIC = 0,
+    DEC_BLOCK,
+    DEC_SKIP,
+    DEC_BROKEN
+} dec_state_t;
+
+struct smartlog_lz4_decoder {
+    dec_state_t state;
+    uint32_t skip_left;         /* Bytes left in a skippable frame */
+    int independent;            /* Blocks do not reference each other */
+    int block_sum;              /* Blocks carry an xxHash32 */
+    int content_sum;            /* End mark is followed by an xxHash32 */
+    size_t block_max;
+    unsigned char* in;          /* Held back input */
+    size_t in_len;
+    size_t in_cap;
+    unsigned char* win;         /* 64 KB history, then the block being decoded */
+    size_t win_len;
+    size_t win_cap;
+};
+
+/* ============================================================================
+ * Encoding Helpers
+ * ============================================================================ */
+
+/** Unaligned native read, for hashing and match compares only */
+static uint32_t read32(const unsigned char* p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static uint32_t rotl32(uint32_t v, int bits)
+{
+    return (v << bits) | (v >> (32 - bits));
+}
+
+/**
+ * xxHash32 of a buffer (seed 0), as used by the LZ4 frame format.
+ */
+static uint32_t xxh32(const unsigned char* p, size_t len)
+{
+    const uint32_t prime1 = 2654435761u;
+    const uint32_t prime2 = 2246822519u;
+    const uint32_t prime3 = 3266489917u;
+    const uint32_t prime4 = 668265263u;
+    const uint32_t prime5 = 374761393u;
+    const unsigned char* end = p + len;
+    uint32_t h;
+
+    if(len >= 16)
+    {
+        uint32_t v[4] = { prime1 + prime2, prime2, 0, 0u - prime1 };
+        while(end - p >= 16)
+        {
+            for(int i = 0; i < 4; i++)
+            {
+                v[i] = rotl32(v[i] + (smartlog_get_le32(p) * prime2), 13) * prime1;
+                p += 4;
+            }
+        }
+        h = rotl32(v[0], 1) + rotl32(v[1], 7) + rotl32(v[2], 12) + rotl32(v[3], 18);
+    }
+    else
+    {
+        h = prime5;
+    }
+
+    h += (uint32_t)len;
+    for(; end - p >= 4; p += 4)
+    {
+        h = rotl32(h + (smartlog_get_le32(p) * prime3), 17) * prime4;
+    }
+    for(; p < end; p++)
+    {
+        h = rotl32(h + (*p * prime5), 11) * prime1;
+    }
+
+    h ^= h >> 15;
+    h *= prime2;
+    h ^= h >> 13;
+    h *= prime3;
+    h ^= h >> 16;
+    return h;
+}
+
+/** Frame header checksum: second byte of xxHash32 over the descriptor */
+static unsigned char header_checksum(const unsigned char* desc, size_t len)
+{
+    return (unsigned char)(xxh32(desc, len) >> 8);
+}
+
+/* ============================================================================
+ * Block Compression
+ * ============================================================================ */
+
+static uint32_t lz4_hash(uint32_t seq)
+{
+    return (seq * 2654435761u) >> (32 - LZ4_HASH_LOG);
+}
+
+/** Largest compressed size of len input bytes */
+static size_t lz4_bound(size_t len)
+{
+    return len + (len / 255) + 16;
+}
+
+static unsigned char* put_length(unsigned char* op, size_t len)
+{
+    for(; len >= 255; len -= 255)
+    {
+        *op++ = 255;
+    }
+    *op++ = (unsigned char)len;
+    return op;
+}
+
+/**
+ * Write one sequence: literals, then a match (match_len 0 = last literals).
+ */
+static unsigned char* put_sequence(unsigned char* op, const unsigned char* lit, size_t lit_len,
+                                   size_t offset, size_t match_len)
+{
+    unsigned char* token = op++;
+    *token = (unsigned char)((lit_len >= 15 ? 15 : lit_len) << 4);
+    if(lit_len >= 15)
+    {
+        op = put_length(op, lit_len - 15);
+    }
+    memcpy(op, lit, lit_len);
+    op += lit_len;
+
+    if(match_len == 0)
+    {
+        return op;
+    }
+
+    *op++ = (unsigned char)offset;
+    *op++ = (unsigned char)(offset >> 8);
+    size_t code = match_len - LZ4_MIN_MATCH;
+    *token |= (unsigned char)(code >= 15 ? 15 : code);
+    if(code >= 15)
+    {
+        op = put_length(op, code - 15);
+    }
+    return op;
+}
+
+/**
+ * Compress the pending text of the encoder window into dst (at least
+ * lz4_bound(len) bytes). Matches may reach into the history before it.
+ *
+ * Return: Compressed bytes
+ */
+static size_t lz4_compress_pending(smartlog_lz4_encoder_t* enc, unsigned char* dst)
+{
+    const unsigned char* base = enc->win;
+    const unsigned char* ip = base + enc->block_start;
+    const unsigned char* anchor = ip;
+    const unsigned char* iend = base + enc->win_len;
+    unsigned char* op = dst;
+
+    if((size_t)(iend - ip) > LZ4_MF_LIMIT)
+    {
+        const unsigned char* mflimit = iend - LZ4_MF_LIMIT;
+        const unsigned char* matchlimit = iend - LZ4_LAST_LITERALS;
+
+        while(ip <= mflimit)
+        {
+            uint32_t seq = read32(ip);
+            uint32_t h = lz4_hash(seq);
+            uint32_t cur = enc->base_pos + (uint32_t)(ip - base);
+            uint32_t ref = enc->table[h];
+            enc->table[h] = cur;
+
+            if(ref < enc->base_pos || ref >= cur || cur - ref >= LZ4_WINDOW ||
+               read32(base + (ref - enc->base_pos)) != seq)
+            {
+                /* Skip faster through text that does not match */
+                ip += 1 + ((size_t)(ip - anchor) >> 6);
+                continue;
+            }
+
+            const unsigned char* match = base + (ref - enc->base_pos);
+            while(ip > anchor && match > base && ip[-1] == match[-1])
+            {
+                ip--;
+                match--;
+            }
+
+            const unsigned char* mp = ip + LZ4_MIN_MATCH;
+            const unsigned char* rp = match + LZ4_MIN_MATCH;
+            while(mp < matchlimit && *mp == *rp)
+            {
+                mp++;
+                rp++;
+            }
+
+            op = put_sequence(op, anchor, (size_t)(ip - anchor), (size_t)(ip - match), (size_t)(mp - ip));
+            ip = mp;
+            anchor = ip;
+
+            /* Index a position inside the match for the text that follows */
+            if(ip <= mflimit)
+            {
+                enc->table[lz4_hash(read32(ip - 2))] = enc->base_pos + (uint32_t)(ip - 2 - base);
+            }
+        }
+    }
+
+    op = put_sequence(op, anchor, (size_t)(iend - anchor), 0, 0);
+    return (size_t)(op - dst);
+}
+
+/* ============================================================================
+ * Encoder Helpers
+ * ============================================================================ */
+
+static int enc_reserve(smartlog_lz4_encoder_t* enc, size_t extra)
+{
+    if(enc->out_cap - enc->out_len >= extra)
+    {
+        return 0;
+    }
+
+    size_t cap = enc->out_cap != 0 ? enc->out_cap : lz4_bound(LZ4_BLOCK_MAX) + 64;
+    while(cap - enc->out_len < extra)
+    {
+        cap *= 2;
+    }
+
+    unsigned char* grown = realloc(enc->out, cap);
+    if(grown == NULL)
+    {
+        return -1;
+    }
+    enc->out = grown;
+    enc->out_cap = cap;
+    return 0;
+}
+
+/**
+ * Compress the pending text into one block and queue it.
+ */
+static int enc_emit_block(smartlog_lz4_encoder_t* enc)
+{
+    size_t len = enc->win_len - enc->block_start;
+    if(len == 0)
+    {
+        return 0;
+    }
+    if(enc_reserve(enc, 4 + lz4_bound(len)) != 0)
+    {
+        return -1;
+    }
+
+    unsigned char* hdr = enc->out + enc->out_len;
+    size_t comp = lz4_compress_pending(enc, hdr + 4);
+    if(comp >= len)
+    {
+        /* Incompressible: store it; it still serves as history */
+        memcpy(hdr + 4, enc->win + enc->block_start, len);
+        smartlog_put_le32(hdr, (uint32_t)len | LZ4_BLOCK_RAW);
+        comp = len;
+    }
+    else
+    {
+        smartlog_put_le32(hdr, (uint32_t)comp);
+    }
+
+    enc->out_len += 4 + comp;
+    enc->block_start = enc->win_len;
+    return 0;
+}
+
+/**
+ * Drop text older than the 64 KB window to make room at the end.
+ */
+static void enc_slide(smartlog_lz4_encoder_t* enc)
+{
+    size_t keep = enc->block_start < LZ4_WINDOW ? enc->block_start : LZ4_WINDOW;
+    size_t drop = enc->block_start - keep;
+    if(drop == 0)
+    {
+        return;
+    }
+
+    memmove(enc->win, enc->win + drop, enc->win_len - drop);
+    enc->win_len -= drop;
+    enc->block_start -= drop;
+
+    if(enc->base_pos > (UINT32_MAX / 2))
+    {
+        /* Restart positions long before they wrap; only costs old matches */
+        memset(enc->table, 0, sizeof(enc->table));
+        enc->base_pos = 1;
+    }
+    else
+    {
+        enc->base_pos += (uint32_t)drop;
+    }
+}
+
+/* ============================================================================
+ * Encoder API
+ * ============================================================================ */
+
+smartlog_lz4_encoder_t* smartlog_lz4_encoder_create(void)
+{
+    smartlog_lz4_encoder_t* enc = calloc(1, sizeof(*enc));
+    if(enc == NULL)
+    {
+        return NULL;
+    }
+
+    enc->win = malloc(ENC_WIN_SIZE);
+    if(enc->win == NULL)
+    {
+        free(enc);
+        errno = ENOMEM;
+        return NULL;
+    }
+    enc->base_pos = 1;
+    return enc;
+}
+
+int smartlog_lz4_encoder_begin(smartlog_lz4_encoder_t* enc)
+{
+    if(enc == NULL)
+    {
+        errno = EINVAL;
+        return 1;
+    }
+    if(enc_reserve(enc, 7) != 0)
+    {
+        return 1;
+    }
+
+    memset(enc->table, 0, sizeof(enc->table));
+    enc->base_pos = 1;
+    enc->win_len = 0;
+    enc->block_start = 0;
+    enc->in_frame = 1;
+
+    /* Version 01, linked blocks, no checksums; 64 KB max block */
+    unsigned char* hdr = enc->out + enc->out_len;
+    smartlog_put_le32(hdr, LZ4_FRAME_MAGIC);
+    hdr[4] = LZ4_FLG_VERSION;
+    hdr[5] = 0x40;
+    hdr[6] = header_checksum(hdr + 4, 2);
+    enc->out_len += 7;
+    return 0;
+}
+
+int smartlog_lz4_encoder_write(smartlog_lz4_encoder_t* enc, const void* data, size_t len)
+{
+    if(enc == NULL || (data == NULL && len != 0) || enc->in_frame == 0)
+    {
+        errno = EINVAL;
+        return 1;
+    }
+
+    const unsigned char* p = (const unsigned char*)data;
+    while(len > 0)
+    {
+        size_t take = LZ4_BLOCK_MAX - (enc->win_len - enc->block_start);
+        if(take > len)
+        {
+            take = len;
+        }
+        if(enc->win_len + take > ENC_WIN_SIZE)
+        {
+            enc_slide(enc);
+        }
+
+        memcpy(enc->win + enc->win_len, p, take);
+        enc->win_len += take;
+        p += take;
+        len -= take;
+
+        if(enc->win_len - enc->block_start == LZ4_BLOCK_MAX && enc_emit_block(enc) != 0)
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+int smartlog_lz4_encoder_flush(smartlog_lz4_encoder_t* enc)
+{
+    if(enc == NULL)
+    {
+        errno = EINVAL;
+        return 1;
+    }
+    return enc_emit_block(enc) == 0 ? 0 : 1;
+}
+
+int smartlog_lz4_encoder_end(smartlog_lz4_encoder_t* enc)
+{
+    if(enc == NULL || enc->in_frame == 0)
+    {
+        errno = EINVAL;
+        return 1;
+    }
+    if(enc_emit_block(enc) != 0 || enc_reserve(enc, 4) != 0)
+    {
+        return 1;
+    }
+
+    smartlog_put_le32(enc->out + enc->out_len, 0);
+    enc->out_len += 4;
+    enc->in_frame = 0;
+    return 0;
+}
+
+const void* smartlog_lz4_encoder_output(const smartlog_lz4_encoder_t* enc, size_t* len)
+{
+    *len = enc->out_len;
+    return enc->out;
+}
+
+void smartlog_lz4_encoder_consume(smartlog_lz4_encoder_t* enc, size_t n)
+{
+    if(n >= enc->out_len)
+    {
+        enc->out_len = 0;
+        return;
+    }
+    memmove(enc->out, enc->out + n, enc->out_len - n);
+    enc->out_len -= n;
+}
+
+size_t smartlog_lz4_encoder_pending(const smartlog_lz4_encoder_t* enc)
+{
+    return enc->win_len - enc->block_start;
+}
+
+void smartlog_lz4_encoder_destroy(smartlog_lz4_encoder_t* enc)
+{
+    if(enc == NULL)
+    {
+        return;
+    }
+    free(enc->win);
+    free(enc->out);
+    free(enc);
+}
+
+/* ============================================================================
+ * Block Decompression
+ * ============================================================================ */
+
+static int get_length(const unsigned char** ip, const unsigned char* iend, size_t* len)
+{
+    unsigned char b;
+    do
+    {
+        if(*ip >= iend)
+        {
+            return -1;
+        }
+        b = *(*ip)++;
+        *len += b;
+    } while(b == 255);
+    return 0;
+}
+
+/**
+ * Decompress one block to win + start; matches may reach back to win[0].
+ *
+ * Return: Decompressed bytes, or -1 if the block is malformed
+ */
+static long lz4_decompress_block(const unsigned char* src, size_t src_len, unsigned char* win,
+                                 size_t start, size_t out_max)
+{
+    const unsigned char* ip = src;
+    const unsigned char* iend = src + src_len;
+    unsigned char* op = win + start;
+    unsigned char* oend = op + out_max;
+
+    for(;;)
+    {
+        if(ip >= iend)
+        {
+            return -1;
+        }
+        unsigned char token = *ip++;
+
+        size_t lit = token >> 4;
+        if(lit == 15 && get_length(&ip, iend, &lit) != 0)
+        {
+            return -1;
+        }
+        if(lit > (size_t)(iend - ip) || lit > (size_t)(oend - op))
+        {
+            return -1;
+        }
+        memcpy(op, ip, lit);
+        op += lit;
+        ip += lit;
+
+        if(ip == iend)
+        {
+            break;
+        }
+
+        if(iend - ip < 2)
+        {
+            return -1;
+        }
+        size_t offset = (size_t)ip[0] | ((size_t)ip[1] << 8);
+        ip += 2;
+        if(offset == 0 || offset > (size_t)(op - win))
+        {
+            return -1;
+        }
+
+        size_t match_len = token & 15u;
+        if(match_len == 15 && get_length(&ip, iend, &match_len) != 0)
+        {
+            return -1;
+        }
+        match_len += LZ4_MIN_MATCH;
+        if(match_len > (size_t)(oend - op))
+        {
+            return -1;
+        }
+
+        /* Overlapping copies repeat the last offset bytes, so go forward */
+        const unsigned char* match = op - offset;
+        if(offset >= match_len)
+        {
+            memcpy(op, match, match_len);
+        }
+        else
+        {
+            for(size_t i = 0; i < match_len; i++)
+            {
+                op[i] = match[i];
+            }
+        }
+        op += match_len;
+    }
+
+    return (long)(op - (win + start));
+}
+
+/* ============================================================================
+ * Decoder Helpers
+ * ============================================================================ */
+
+/**
+ * Parse a frame or skippable frame header at p.
+ *
+ * Return: Header bytes consumed, 0 if more input is needed, -1 if invalid
+ */
+static long dec_header(smartlog_lz4_decoder_t* dec, const unsigned char* p, size_t avail)
+{
+    if(avail < 4)
+    {
+        return 0;
+    }
+
+    uint32_t magic = smartlog_get_le32(p);
+    if((magic & 0xFFFFFFF0u) == LZ4_SKIP_MAGIC)
+    {
+        if(avail < 8)
+        {
+            return 0;
+        }
+        dec->skip_left = smartlog_get_le32(p + 4);
+        dec->state = DEC_SKIP;
+        return 8;
+    }
+    if(magic != LZ4_FRAME_MAGIC)
+    {
+        return -1;
+    }
+    if(avail < 7)
+    {
+        return 0;
+    }
+
+    unsigned char flg = p[4];
+    unsigned char bd = p[5];
+    size_t desc_len = 2 + ((flg & LZ4_FLG_CONTENT_SIZE) != 0 ? 8 : 0) + ((flg & LZ4_FLG_DICT_ID) != 0 ? 4 : 0);
+    if(avail < 4 + desc_len + 1)
+    {
+        return 0;
+    }
+
+    unsigned int block_id = (bd >> 4) & 7u;
+    if((flg & 0xC2u) != LZ4_FLG_VERSION || (bd & 0x8Fu) != 0 || block_id < 4 ||
+       header_checksum(p + 4, desc_len) != p[4 + desc_len])
+    {
+        return -1;
+    }
+    if((flg & LZ4_FLG_DICT_ID) != 0)
+    {
+        /* External dictionaries are never written by SmartLog */
+        return -1;
+    }
+
+    size_t block_max = (size_t)1 << (8 + (2 * block_id));
+    if(dec->win_cap < LZ4_WINDOW + block_max)
+    {
+        unsigned char* grown = realloc(dec->win, LZ4_WINDOW + block_max);
+        if(grown == NULL)
+        {
+            errno = ENOMEM;
+            return -1;
+        }
+        dec->win = grown;
+        dec->win_cap = LZ4_WINDOW + block_max;
+    }
+
+    dec->independent = (flg & LZ4_FLG_INDEPENDENT) != 0;
+    dec->block_sum = (flg & LZ4_FLG_BLOCK_SUM) != 0;
+    dec->content_sum = (flg & LZ4_FLG_CONTENT_SUM) != 0;
+    dec->block_max = block_max;
+    dec->win_len = 0;
+    dec->state = DEC_BLOCK;
+    return (long)(4 + desc_len + 1);
+}
+
+/**
+ * Decode one block (or end mark) at p and write its text.
+ *
+ * Return: Bytes consumed, 0 if more input is needed, -1 on error
+ */
+static long dec_block(smartlog_lz4_decoder_t* dec, const unsigned char* p, size_t avail, int out_fd)
+{
+    if(avail < 4)
+    {
+        return 0;
+    }
+
+    uint32_t word = smartlog_get_le32(p);
+    if(word == 0)
+    {
+        size_t end_len = 4 + (dec->content_sum != 0 ? 4 : 0);
+        if(avail < end_len)
+        {
+            return 0;
+        }
+        dec->state = DEC_MAGIC;
+        return (long)end_len;
+    }
+
+    size_t size = word & ~LZ4_BLOCK_RAW;
+    size_t total = 4 + size + (dec->block_sum != 0 ? 4 : 0);
+    if(size > dec->block_max)
+    {
+        return -1;
+    }
+    if(avail < total)
+    {
+        return 0;
+    }
+    if(dec->block_sum != 0 && xxh32(p + 4, size) != smartlog_get_le32(p + 4 + size))
+    {
+        return -1;
+    }
+
+    /* Keep 64 KB of history for linked blocks, nothing for independent ones */
+    if(dec->independent != 0)
+    {
+        dec->win_len = 0;
+    }
+    else if(dec->win_len + dec->block_max > dec->win_cap)
+    {
+        size_t drop = dec->win_len - LZ4_WINDOW;
+        memmove(dec->win, dec->win + drop, LZ4_WINDOW);
+        dec->win_len = LZ4_WINDOW;
+    }
+
+    long produced;
+    if((word & LZ4_BLOCK_RAW) != 0)
+    {
+        memcpy(dec->win + dec->win_len, p + 4, size);
+        produced = (long)size;
+    }
+    else
+    {
+        produced = lz4_decompress_block(p + 4, size, dec->win, dec->win_len, dec->block_max);
+        if(produced < 0)
+        {
+            return -1;
+        }
+    }
+
+    if(smartlog_write_all(out_fd, dec->win + dec->win_len, (size_t)produced) != 0)
+    {
+        return -1;
+    }
+    dec->win_len += (size_t)produced;
+    return (long)total;
+}
+
+/* ============================================================================
+ * Decoder API
+ * ============================================================================ */
+
+smartlog_lz4_decoder_t* smartlog_lz4_decoder_create(void)
+{
+    smartlog_lz4_decoder_t* dec = calloc(1, sizeof(*dec));
+    if(dec == NULL)
+    {
+        return NULL;
+    }
+    dec->state = DEC_MAGIC;
+    return dec;
+}
+
+int smartlog_lz4_decoder_feed(smartlog_lz4_decoder_t* dec, const void* data, size_t len, int out_fd)
+{
+    if(dec == NULL || (data == NULL && len != 0))
+    {
+        errno = EINVAL;
+        return 1;
+    }
+    if(dec->state == DEC_BROKEN)
+    {
+        errno = EBADMSG;
+        return 1;
+    }
+
+    /* ====================================================================
+     * STEP 1: Append to the Held Back Input
+     * ==================================================================== */
+    if(dec->in_cap - dec->in_len < len)
+    {
+        size_t cap = dec->in_cap != 0 ? dec->in_cap : DEC_READ_SIZE;
+        while(cap - dec->in_len < len)
+        {
+            cap *= 2;
+        }
+        unsigned char* grown = realloc(dec->in, cap);
+        if(grown == NULL)
+        {
+            return 1;
+        }
+        dec->in = grown;
+        dec->in_cap = cap;
+    }
+    if(len != 0)
+    {
+        memcpy(dec->in + dec->in_len, data, len);
+        dec->in_len += len;
+    }
+
+    /* ====================================================================
+     * STEP 2: Decode Every Complete Header and Block
+     * ==================================================================== */
+    size_t pos = 0;
+    for(;;)
+    {
+        const unsigned char* p = dec->in + pos;
+        size_t avail = dec->in_len - pos;
+        long used = 0;
+
+        if(dec->state == DEC_SKIP)
+        {
+            used = (long)(avail < dec->skip_left ? avail : dec->skip_left);
+            dec->skip_left -= (uint32_t)used;
+            if(dec->skip_left == 0)
+            {
+                dec->state = DEC_MAGIC;
+            }
+            if(used == 0 && dec->state == DEC_SKIP)
+            {
+                break;
+            }
+        }
+        else
+        {
+            errno = 0;
+            used = dec->state == DEC_MAGIC ? dec_header(dec, p, avail) : dec_block(dec, p, avail, out_fd);
+            if(used < 0)
+            {
+                if(errno == 0)
+                {
+                    errno = EBADMSG;
+                }
+                dec->state = DEC_BROKEN;
+                return 1;
+            }
+            if(used == 0)
+            {
+                break;
+            }
+        }
+        pos += (size_t)used;
+    }
+
+    /* ====================================================================
+     * STEP 3: Keep the Incomplete Tail
+     * ==================================================================== */
+    memmove(dec->in, dec->in + pos, dec->in_len - pos);
+    dec->in_len -= pos;
+    return 0;
+}
+
+size_t smartlog_lz4_decoder_pending(const smartlog_lz4_decoder_t* dec)
+{
+    return dec->in_len;
+}
+
+void smartlog_lz4_decoder_destroy(smartlog_lz4_decoder_t* dec)
+{
+    if(dec == NULL)
+    {
+        return;
+    }
+    free(dec->in);
+    free(dec->win);
+    free(dec);
+}
+
+int smartlog_lz4_decode_file(const char* path, int out_fd)
+{
+    if(path == NULL)
+    {
+        errno = EINVAL;
+        return 1;
+    }
+
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if(fd < 0)
+    {
+        return 1;
+    }
+
+    smartlog_lz4_decoder_t* dec = smartlog_lz4_decoder_create();
+    unsigned char* buf = malloc(DEC_READ_SIZE);
+    int rc = (dec == NULL || buf == NULL) ? 1 : 0;
+
+    while(rc == 0)
+    {
+        ssize_t n = read(fd, buf, DEC_READ_SIZE);
+        if(n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if(n < 0)
+        {
+            rc = 1;
+            break;
+        }
+        if(n == 0)
+        {
+            /* Anything held back at EOF was cut inside a header or block */
+            if(smartlog_lz4_decoder_pending(dec) != 0)
+            {
+                errno = EBADMSG;
+                rc = 1;
+            }
+            break;
+        }
+        rc = smartlog_lz4_decoder_feed(dec, buf, (size_t)n, out_fd);
+    }
+
+    int saved_errno = errno;
+    free(buf);
+    smartlog_lz4_decoder_destroy(dec);
+    close(fd);
+    errno = saved_errno;
+    return rc;
+}
@@ -0,0 +1,420 @@
+/*
+ * src/merge.c
+ *
+ * Global ordering merge of SmartLog files.
+ *
+ * Implements:
+ *   - Rotated generation discovery (<path>.1, <path>.2, ...)
+ *   - Streaming line readers, one per input, chained across generations
+ *   - K-way merge with a min-heap ordered by (timestamp, seq, input)
+ *   - Buffered output through smartlog_write_all()
+ *
+ * Author: Aravinthraj Ganesan
+ * Version: 1.0
+ */
+
+#define _GNU_SOURCE
+#define _POSIX_C_SOURCE 199309L
+
+/* Standard includes */
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+/* Project includes */
+#include <smartlog/config.h>
+#include <smartlog/merge.h>
+#include <smartlog/smartlog_core.h>
+#include <smartlog/utils.h>
+
+/* ============================================================================
+ * Internal Types
+ * ============================================================================ */
+
+/** One input path and its generations, read as a single stream */
+typedef struct {
+    char** files;           /* Oldest first: <path>.N ... <path>.1, <path> */
+    size_t nfiles;
+    size_t next_file;
+    FILE* fp;               /* Current file (NULL between files) */
+    char* read_buf;         /* stdio buffer, SMARTLOG_MERGE_BUF bytes */
+    char* line;             /* Current line (getline buffer) */
+    size_t line_cap;
+    size_t line_len;
+    uint64_t time_ns;       /* Sort key, never goes back within the input */
+    uint64_t seq;           /* Tie-break from "[SEQ = ]", 0 if absent */
+    size_t index;           /* Position on the command line */
+} merge_input_t;
+
+typedef struct {
+    int fd;
+    char* buf;
+    size_t len;
+} merge_output_t;
+
+/* ============================================================================
+ * Heap Helpers
+ * ============================================================================ */
+
+static int input_less(const merge_input_t* a, const merge_input_t* b)
+{
+    if(a->time_ns != b->time_ns)
+    {
+        return a->time_ns < b->time_ns;
+    }
+    if(a->seq != b->seq)
+    {
+        return a->seq < b->seq;
+    }
+    return a->index < b->index;
+}
+
+static void heap_sift_down(merge_input_t** heap, size_t len, size_t i)
+{
+    merge_input_t* item = heap[i];
+    for(;;)
+    {
+        size_t child = (2 * i) + 1;
+        if(child >= len)
+        {
+            break;
+        }
+        if(child + 1 < len && input_less(heap[child + 1], heap[child]))
+        {
+            child++;
+        }
+        if(!input_less(heap[child], item))
+        {
+            break;
+        }
+        heap[i] = heap[child];
+        i = child;
+    }
+    heap[i] = item;
+}
+
+/* ============================================================================
+ * Input Helpers
+ * ============================================================================ */
+
+static char* path_join_generation(const char* path, size_t generation)
+{
+    char buf[SMARTLOG_PATH_MAX_LEN];
+    int n = generation == 0 ?
+        snprintf(buf, sizeof(buf), "%s", path) :
+        snprintf(buf, sizeof(buf), "%s.%zu", path, generation);
+    if(n < 0 || (size_t)n >= sizeof(buf))
+    {
+        errno = ENAMETOOLONG;
+        return NULL;
+    }
+    return strdup(buf);
+}
+
+/**
+ * Find <path> and its rotated generations and list them oldest first.
+ *
+ * Return: 0 on success, -1 on error (errno is set, ENOENT if none exist)
+ */
+static int input_init(merge_input_t* in, const char* path, size_t index)
+{
+    struct stat st;
+    size_t generations = 0;
+
+    memset(in, 0, sizeof(*in));
+    in->index = index;
+
+    /* Generations are contiguous from .1; the first gap ends the search */
+    for(;;)
+    {
+        char* gen = path_join_generation(path, generations + 1);
+        if(gen == NULL)
+        {
+            return -1;
+        }
+        int rc = stat(gen, &st);
+        free(gen);
+        if(rc != 0)
+        {
+            if(errno != ENOENT)
+            {
+                return -1;
+            }
+            break;
+        }
+        generations++;
+    }
+
+    int have_base = stat(path, &st) == 0;
+    if(!have_base && errno != ENOENT)
+    {
+        return -1;
+    }
+    if(!have_base && generations == 0)
+    {
+        errno = ENOENT;
+        return -1;
+    }
+
+    in->files = calloc(generations + 1, sizeof(*in->files));
+    in->read_buf = malloc(SMARTLOG_MERGE_BUF);
+    if(in->files == NULL || in->read_buf == NULL)
+    {
+        return -1;
+    }
+
+    for(size_t gen = generations; gen > 0; gen--)
+    {
+        if((in->files[in->nfiles] = path_join_generation(path, gen)) == NULL)
+        {
+            return -1;
+        }
+        in->nfiles++;
+    }
+    if(have_base)
+    {
+        if((in->files[in->nfiles] = path_join_generation(path, 0)) == NULL)
+        {
+            return -1;
+        }
+        in->nfiles++;
+    }
+
+    return 0;
+}
+
+/**
+ * Read the next line of an input, moving on to the next file at EOF.
+ *
+ * Return: 1 if a line was read, 0 when the input is exhausted, -1 on error
+ */
+static int input_next(merge_input_t* in, smartlog_merge_stats_t* stats)
+{
+    for(;;)
+    {
+        if(in->fp == NULL)
+        {
+            if(in->next_file == in->nfiles)
+            {
+                return 0;
+            }
+
+            in->fp = fopen(in->files[in->next_file++], "r");
+            if(in->fp == NULL || setvbuf(in->fp, in->read_buf, _IOFBF, SMARTLOG_MERGE_BUF) != 0)
+            {
+                return -1;
+            }
+            (void)posix_fadvise(fileno(in->fp), 0, 0, POSIX_FADV_SEQUENTIAL);
+            stats->files++;
+        }
+
+        ssize_t n = getline(&in->line, &in->line_cap, in->fp);
+        if(n < 0)
+        {
+            if(ferror(in->fp))
+            {
+                return -1;
+            }
+            fclose(in->fp);
+            in->fp = NULL;
+            continue;
+        }
+        in->line_len = (size_t)n;
+
+        /* Untimed lines (and lines from a clock that stepped back) stay put */
+        uint64_t time_ns = 0;
+        if(smartlog_line_timestamp(in->line, in->line_len, &time_ns) != 0)
+        {
+            stats->untimed++;
+            return 1;
+        }
+        if(time_ns > in->time_ns)
+        {
+            in->time_ns = time_ns;
+        }
+
+        uint64_t seq = 0;
+        in->seq = smartlog_line_seq(in->line, in->line_len, &seq) == 0 ? seq : 0;
+        return 1;
+    }
+}
+
+static void input_free(merge_input_t* in)
+{
+    if(in->fp != NULL)
+    {
+        fclose(in->fp);
+    }
+    for(size_t i = 0; i < in->nfiles; i++)
+    {
+        free(in->files[i]);
+    }
+    free(in->files);
+    free(in->read_buf);
+    free(in->line);
+}
+
+/* ============================================================================
+ * Output Helpers
+ * ============================================================================ */
+
+static int output_flush(merge_output_t* out)
+{
+    if(out->len > 0 && smartlog_write_all(out->fd, out->buf, out->len) != 0)
+    {
+        return -1;
+    }
+    out->len = 0;
+    return 0;
+}
+
+static int output_line(merge_output_t* out, const char* line, size_t len)
+{
+    int add_newline = len == 0 || line[len - 1] != '\n';
+
+    if(out->len + len + 1 > SMARTLOG_MERGE_BUF)
+    {
+        if(output_flush(out) != 0)
+        {
+            return -1;
+        }
+        if(len + 1 > SMARTLOG_MERGE_BUF)
+        {
+            if(smartlog_write_all(out->fd, line, len) != 0 ||
+               (add_newline && smartlog_write_all(out->fd, "\n", 1) != 0))
+            {
+                return -1;
+            }
+            return 0;
+        }
+    }
+
+    memcpy(out->buf + out->len, line, len);
+    out->len += len;
+    if(add_newline)
+    {
+        out->buf[out->len++] = '\n';
+    }
+    return 0;
+}
+
+/**
+ * Open the inputs and write the merged stream.
+ *
+ * Return: 0 on success, -1 on error (errno is set). *ninputs counts the
+ *         inputs to free, even on error.
+ */
+static int merge_run(
+    const char* const* paths,
+    size_t npaths,
+    merge_input_t* inputs,
+    size_t* ninputs,
+    merge_input_t** heap,
+    merge_output_t* out,
+    smartlog_merge_stats_t* stats
+)
+{
+    size_t heap_len = 0;
+
+    /* ====================================================================
+     * STEP 1: Open Every Input and Read Its First Line
+     * ==================================================================== */
+    for(size_t i = 0; i < npaths; i++)
+    {
+        (*ninputs)++;
+        if(input_init(&inputs[i], paths[i], i) != 0)
+        {
+            return -1;
+        }
+        stats->inputs++;
+
+        int next = input_next(&inputs[i], stats);
+        if(next < 0)
+        {
+            return -1;
+        }
+        if(next > 0)
+        {
+            heap[heap_len++] = &inputs[i];
+        }
+    }
+
+    for(size_t i = heap_len / 2; i > 0; i--)
+    {
+        heap_sift_down(heap, heap_len, i - 1);
+    }
+
+    /* ====================================================================
+     * STEP 2: Emit the Smallest Line, Refill From the Same Input
+     * ==================================================================== */
+    while(heap_len > 0)
+    {
+        merge_input_t* top = heap[0];
+        if(output_line(out, top->line, top->line_len) != 0)
+        {
+            return -1;
+        }
+        stats->lines++;
+
+        int next = input_next(top, stats);
+        if(next < 0)
+        {
+            return -1;
+        }
+        if(next == 0)
+        {
+            heap[0] = heap[--heap_len];
+        }
+        if(heap_len > 0)
+        {
+            heap_sift_down(heap, heap_len, 0);
+        }
+    }
+
+    return output_flush(out);
+}
+
+/* ============================================================================
+ * Public API
+ * ============================================================================ */
+
+int smartlog_merge_files(const char* const* paths, size_t npaths, int out_fd, smartlog_merge_stats_t* stats)
+{
+    if(paths == NULL || npaths == 0 || out_fd < 0)
+    {
+        errno = EINVAL;
+        return 1;
+    }
+
+    smartlog_merge_stats_t local;
+    memset(&local, 0, sizeof(local));
+
+    merge_output_t out = { out_fd, malloc(SMARTLOG_MERGE_BUF), 0 };
+    merge_input_t* inputs = calloc(npaths, sizeof(*inputs));
+    merge_input_t** heap = calloc(npaths, sizeof(*heap));
+    size_t ninputs = 0;
+
+    int rc = 1;
+    if(out.buf != NULL && inputs != NULL && heap != NULL)
+    {
+        rc = merge_run(paths, npaths, inputs, &ninputs, heap, &out, &local) == 0 ? 0 : 1;
+    }
+
+    int saved_errno = errno;
+    for(size_t i = 0; i < ninputs; i++)
+    {
+        input_free(&inputs[i]);
+    }
+    free(inputs);
+    free(heap);
+    free(out.buf);
+    if(stats != NULL)
+    {
+        *stats = local;
+    }
+    errno = saved_errno;
+    return rc;
+}
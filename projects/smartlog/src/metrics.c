@@ -0,0 +1,618 @@
+/*
+ * src/metrics.c
+ *
+ * Prometheus text exporter for SmartLog statistics.
+ *
+ * Implements:
+ *   - Snapshot of every registered sink's counters (atomic loads only),
+ *     rendered family by family as Prometheus text
+ *   - Source callbacks for other components
+ *   - Unix and loopback TCP listeners, answered one client at a time
+ *     with short I/O timeouts, plain text or HTTP/1.0
+ *   - Optional background serving thread
+ *
+ * Author: Aravinthraj Ganesan
+ * Version: 1.0
+ */
+
+#define _GNU_SOURCE
+#define _POSIX_C_SOURCE 199309L
+
+/* Standard includes */
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+/* Project includes */
+#include <smartlog/config.h>
+#include <smartlog/logger.h>
+#include <smartlog/metrics.h>
+#include <smartlog/sink.h>
+
+/* ============================================================================
+ * Internal Types
+ * ============================================================================ */
+
+#define METRICS_LABEL_MAX    128    /* Escaped logger name bytes */
+#define METRICS_REQUEST_MAX  2048   /* Request bytes read before answering */
+
+typedef struct {
+    const smartlog_logger_t* logger;    /* NULL for a callback source */
+    char name[METRICS_LABEL_MAX];       /* Escaped label value */
+    smartlog_metrics_fn fn;
+    void* arg;
+} metrics_source_t;
+
+struct smartlog_metrics_buf {
+    char* p;
+    size_t len;
+    size_t cap;
+    int failed;
+};
+
+struct smartlog_metrics {
+    pthread_mutex_t lock;               /* Source list */
+    metrics_source_t sources[SMARTLOG_METRICS_MAX_SOURCES];
+    size_t source_count;
+    int unix_fd;
+    int tcp_fd;
+    char unix_path[sizeof(((struct sockaddr_un*)0)->sun_path)];
+    pthread_t thread;
+    int thread_started;
+    atomic_int stopping;
+};
+
+/** One sink's counters, copied before anything is formatted */
+typedef struct {
+    const char* logger;
+    size_t index;
+    smartlog_sink_stats_t st;
+} sink_snapshot_t;
+
+/** One counter family of the sink stats */
+typedef struct {
+    const char* name;
+    const char* help;
+    size_t offset;      /* Of the uint64_t in smartlog_sink_stats_t */
+} sink_family_t;
+
+static const sink_family_t sink_families[] = {
+    { "smartlog_sink_records_total", "Lines accepted by the destination.",
+      offsetof(smartlog_sink_stats_t, records) },
+    { "smartlog_sink_bytes_total", "Bytes accepted by the destination.",
+      offsetof(smartlog_sink_stats_t, bytes) },
+    { "smartlog_sink_filtered_total", "Lines skipped by level or filter.",
+      offsetof(smartlog_sink_stats_t, filtered) },
+    { "smartlog_sink_dropped_total", "Lines lost: queue full or destination away.",
+      offsetof(smartlog_sink_stats_t, dropped) },
+    { "smartlog_sink_spilled_total", "Lines that went through the spill file.",
+      offsetof(smartlog_sink_stats_t, spilled) },
+    { "smartlog_sink_errors_total", "Failed write or flush calls.",
+      offsetof(smartlog_sink_stats_t, errors) },
+    { "smartlog_sink_writer_wakeups_total", "Wakeups of an idle async writer.",
+      offsetof(smartlog_sink_stats_t, wakeups) },
+};
+
+static const uint64_t sync_bucket_us[SMARTLOG_SYNC_BUCKETS] = SMARTLOG_SYNC_BUCKET_US;
+
+/* ============================================================================
+ * Rendering
+ * ============================================================================ */
+
+int smartlog_metrics_printf(smartlog_metrics_buf_t* out, const char* fmt, ...)
+{
+    if(out == NULL || out->failed)
+    {
+        return -1;
+    }
+
+    for(;;)
+    {
+        va_list ap;
+        va_start(ap, fmt);
+        int n = vsnprintf(out->p + out->len, out->cap - out->len, fmt, ap);
+        va_end(ap);
+        if(n < 0)
+        {
+            out->failed = 1;
+            return -1;
+        }
+        if((size_t)n < out->cap - out->len)
+        {
+            out->len += (size_t)n;
+            return 0;
+        }
+
+        size_t cap = out->cap * 2;
+        while(cap - out->len <= (size_t)n)
+        {
+            cap *= 2;
+        }
+        char* p = realloc(out->p, cap);
+        if(p == NULL)
+        {
+            out->failed = 1;
+            return -1;
+        }
+        out->p = p;
+        out->cap = cap;
+    }
+}
+
+/**
+ * Copy a label value with \, " and newline escaped (truncated to fit).
+ */
+static void escape_label(char* out, size_t out_sz, const char* in)
+{
+    size_t o = 0;
+    for(; *in != '\0' && o + 3 < out_sz; in++)
+    {
+        if(*in == '\\' || *in == '"')
+        {
+            out[o++] = '\\';
+            out[o++] = *in;
+        }
+        else if(*in == '\n')
+        {
+            out[o++] = '\\';
+            out[o++] = 'n';
+        }
+        else
+        {
+            out[o++] = *in;
+        }
+    }
+    out[o] = '\0';
+}
+
+static void render_sinks(smartlog_metrics_buf_t* out, const sink_snapshot_t* snaps, size_t nsnaps)
+{
+    for(size_t f = 0; f < sizeof(sink_families) / sizeof(sink_families[0]); f++)
+    {
+        const sink_family_t* fam = &sink_families[f];
+        (void)smartlog_metrics_printf(out, "# HELP %s %s\n# TYPE %s counter\n", fam->name, fam->help, fam->name);
+        for(size_t i = 0; i < nsnaps; i++)
+        {
+            uint64_t v = 0;
+            memcpy(&v, (const char*)&snaps[i].st + fam->offset, sizeof(v));
+            (void)smartlog_metrics_printf(out, "%s{logger=\"%s\",sink=\"%zu\"} %llu\n",
+                                          fam->name, snaps[i].logger, snaps[i].index, (unsigned long long)v);
+        }
+    }
+
+    (void)smartlog_metrics_printf(out,
+        "# HELP smartlog_sink_sync_seconds Durable fdatasync latency.\n"
+        "# TYPE smartlog_sink_sync_seconds histogram\n");
+    for(size_t i = 0; i < nsnaps; i++)
+    {
+        const smartlog_sync_stats_t* sync = &snaps[i].st.sync;
+        uint64_t cumulative = 0;
+        for(size_t b = 0; b < SMARTLOG_SYNC_BUCKETS; b++)
+        {
+            cumulative += sync->buckets[b];
+            (void)smartlog_metrics_printf(out, "smartlog_sink_sync_seconds_bucket{logger=\"%s\",sink=\"%zu\",le=\"%g\"} %llu\n",
+                                          snaps[i].logger, snaps[i].index, (double)sync_bucket_us[b] / 1e6,
+                                          (unsigned long long)cumulative);
+        }
+
+        /* Bucket and count are separate loads: keep +Inf >= every bucket */
+        uint64_t count = sync->count > cumulative ? sync->count : cumulative;
+        (void)smartlog_metrics_printf(out,
+            "smartlog_sink_sync_seconds_bucket{logger=\"%s\",sink=\"%zu\",le=\"+Inf\"} %llu\n"
+            "smartlog_sink_sync_seconds_sum{logger=\"%s\",sink=\"%zu\"} %.9f\n"
+            "smartlog_sink_sync_seconds_count{logger=\"%s\",sink=\"%zu\"} %llu\n",
+            snaps[i].logger, snaps[i].index, (unsigned long long)count,
+            snaps[i].logger, snaps[i].index, (double)sync->sum_ns / 1e9,
+            snaps[i].logger, snaps[i].index, (unsigned long long)count);
+    }
+}
+
+/* ============================================================================
+ * Serving
+ * ============================================================================ */
+
+static int send_all(int fd, const char* data, size_t len)
+{
+    while(len > 0)
+    {
+        ssize_t n = send(fd, data, len, MSG_NOSIGNAL);
+        if(n < 0)
+        {
+            if(errno == EINTR)
+            {
+                continue;
+            }
+            return -1;
+        }
+        data += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+/**
+ * Answer one client: read what it sends within the I/O timeout, then
+ * write the text (inside an HTTP response if it asked with GET).
+ */
+static void serve_client(smartlog_metrics_t* metrics, int fd)
+{
+    struct timeval tv = { 0, SMARTLOG_METRICS_IO_MS * 1000 };
+    (void)setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+
+    char req[METRICS_REQUEST_MAX];
+    size_t req_len = 0;
+    struct pollfd pfd = { fd, POLLIN, 0 };
+    while(req_len < sizeof(req) - 1 && poll(&pfd, 1, SMARTLOG_METRICS_IO_MS) > 0)
+    {
+        ssize_t n = recv(fd, req + req_len, sizeof(req) - 1 - req_len, MSG_DONTWAIT);
+        if(n <= 0)
+        {
+            break;
+        }
+        req_len += (size_t)n;
+        req[req_len] = '\0';
+
+        /* Plain clients send nothing; HTTP clients end headers with a blank line */
+        if(req_len >= 4 && (memcmp(req, "GET ", 4) != 0 || strstr(req, "\r\n\r\n") != NULL))
+        {
+            break;
+        }
+    }
+    int http = req_len >= 4 && memcmp(req, "GET ", 4) == 0;
+
+    char* text = NULL;
+    size_t len = 0;
+    if(smartlog_metrics_render(metrics, &text, &len) != 0)
+    {
+        if(http)
+        {
+            static const char err[] = "HTTP/1.0 500 Internal Server Error\r\nContent-Length: 0\r\n\r\n";
+            (void)send_all(fd, err, sizeof(err) - 1);
+        }
+        return;
+    }
+
+    if(http)
+    {
+        char head[256];
+        int head_len = snprintf(head, sizeof(head),
+                                "HTTP/1.0 200 OK\r\n"
+                                "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+                                "Content-Length: %zu\r\n"
+                                "Connection: close\r\n\r\n", len);
+        if(send_all(fd, head, (size_t)head_len) != 0)
+        {
+            free(text);
+            return;
+        }
+    }
+    (void)send_all(fd, text, len);
+    free(text);
+}
+
+static void* metrics_thread_main(void* arg)
+{
+    smartlog_metrics_t* metrics = (smartlog_metrics_t*)arg;
+    while(!atomic_load(&metrics->stopping))
+    {
+        (void)smartlog_metrics_serve(metrics, SMARTLOG_METRICS_IO_MS);
+    }
+    return NULL;
+}
+
+/* ============================================================================
+ * Public API
+ * ============================================================================ */
+
+smartlog_metrics_t* smartlog_metrics_create(void)
+{
+    smartlog_metrics_t* metrics = calloc(1, sizeof(*metrics));
+    if(metrics == NULL)
+    {
+        return NULL;
+    }
+
+    pthread_mutex_init(&metrics->lock, NULL);
+    metrics->unix_fd = -1;
+    metrics->tcp_fd = -1;
+    atomic_init(&metrics->stopping, 0);
+    return metrics;
+}
+
+int smartlog_metrics_add_logger(smartlog_metrics_t* metrics, const char* name, const smartlog_logger_t* logger)
+{
+    if(metrics == NULL || name == NULL || logger == NULL)
+    {
+        errno = EINVAL;
+        return 1;
+    }
+
+    pthread_mutex_lock(&metrics->lock);
+    if(metrics->source_count >= SMARTLOG_METRICS_MAX_SOURCES)
+    {
+        pthread_mutex_unlock(&metrics->lock);
+        errno = ENOSPC;
+        return 1;
+    }
+    metrics_source_t* src = &metrics->sources[metrics->source_count++];
+    memset(src, 0, sizeof(*src));
+    src->logger = logger;
+    escape_label(src->name, sizeof(src->name), name);
+    pthread_mutex_unlock(&metrics->lock);
+    return 0;
+}
+
+int smartlog_metrics_add_source(smartlog_metrics_t* metrics, smartlog_metrics_fn fn, void* arg)
+{
+    if(metrics == NULL || fn == NULL)
+    {
+        errno = EINVAL;
+        return 1;
+    }
+
+    pthread_mutex_lock(&metrics->lock);
+    if(metrics->source_count >= SMARTLOG_METRICS_MAX_SOURCES)
+    {
+        pthread_mutex_unlock(&metrics->lock);
+        errno = ENOSPC;
+        return 1;
+    }
+    metrics_source_t* src = &metrics->sources[metrics->source_count++];
+    memset(src, 0, sizeof(*src));
+    src->fn = fn;
+    src->arg = arg;
+    pthread_mutex_unlock(&metrics->lock);
+    return 0;
+}
+
+int smartlog_metrics_render(smartlog_metrics_t* metrics, char** text, size_t* len)
+{
+    if(metrics == NULL || text == NULL || len == NULL)
+    {
+        errno = EINVAL;
+        return 1;
+    }
+
+    smartlog_metrics_buf_t out;
+    memset(&out, 0, sizeof(out));
+    out.cap = 16384;
+    out.p = malloc(out.cap);
+    sink_snapshot_t* snaps = calloc(SMARTLOG_METRICS_MAX_SOURCES * SMARTLOG_MAX_SINKS, sizeof(*snaps));
+    if(out.p == NULL || snaps == NULL)
+    {
+        free(out.p);
+        free(snaps);
+        errno = ENOMEM;
+        return 1;
+    }
+
+    pthread_mutex_lock(&metrics->lock);
+
+    /* ====================================================================
+     * STEP 1: Copy Every Sink's Counters, Then Format the Copies
+     * ==================================================================== */
+    size_t nsnaps = 0;
+    for(size_t s = 0; s < metrics->source_count; s++)
+    {
+        const metrics_source_t* src = &metrics->sources[s];
+        for(size_t i = 0; src->logger != NULL && i < smartlog_logger_sink_count(src->logger); i++)
+        {
+            snaps[nsnaps].logger = src->name;
+            snaps[nsnaps].index = i;
+            smartlog_sink_get_stats(smartlog_logger_get_sink(src->logger, i), &snaps[nsnaps].st);
+            nsnaps++;
+        }
+    }
+    if(nsnaps != 0)
+    {
+        render_sinks(&out, snaps, nsnaps);
+    }
+
+    /* ====================================================================
+     * STEP 2: Other Sources
+     * ==================================================================== */
+    for(size_t s = 0; s < metrics->source_count; s++)
+    {
+        if(metrics->sources[s].fn != NULL)
+        {
+            metrics->sources[s].fn(&out, metrics->sources[s].arg);
+        }
+    }
+
+    pthread_mutex_unlock(&metrics->lock);
+    free(snaps);
+
+    if(out.failed)
+    {
+        free(out.p);
+        errno = ENOMEM;
+        return 1;
+    }
+    *text = out.p;
+    *len = out.len;
+    return 0;
+}
+
+int smartlog_metrics_listen_unix(smartlog_metrics_t* metrics, const char* path)
+{
+    if(metrics == NULL || path == NULL || metrics->unix_fd >= 0)
+    {
+        errno = EINVAL;
+        return 1;
+    }
+    if(strlen(path) >= sizeof(metrics->unix_path))
+    {
+        errno = ENAMETOOLONG;
+        return 1;
+    }
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if(fd < 0)
+    {
+        return 1;
+    }
+
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    memcpy(addr.sun_path, path, strlen(path) + 1);
+
+    struct stat st;
+    if(lstat(path, &st) == 0 && S_ISSOCK(st.st_mode))
+    {
+        (void)unlink(path);
+    }
+
+    if(bind(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 || listen(fd, SOMAXCONN) != 0)
+    {
+        int saved_errno = errno;
+        close(fd);
+        errno = saved_errno;
+        return 1;
+    }
+
+    memcpy(metrics->unix_path, path, strlen(path) + 1);
+    metrics->unix_fd = fd;
+    return 0;
+}
+
+int smartlog_metrics_listen_tcp(smartlog_metrics_t* metrics, uint16_t port)
+{
+    if(metrics == NULL || metrics->tcp_fd >= 0)
+    {
+        errno = EINVAL;
+        return 1;
+    }
+
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if(fd < 0)
+    {
+        return 1;
+    }
+
+    int one = 1;
+    (void)setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    if(bind(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 || listen(fd, SOMAXCONN) != 0)
+    {
+        int saved_errno = errno;
+        close(fd);
+        errno = saved_errno;
+        return 1;
+    }
+
+    metrics->tcp_fd = fd;
+    return 0;
+}
+
+uint16_t smartlog_metrics_tcp_port(const smartlog_metrics_t* metrics)
+{
+    if(metrics == NULL || metrics->tcp_fd < 0)
+    {
+        return 0;
+    }
+
+    struct sockaddr_in addr;
+    socklen_t addr_len = sizeof(addr);
+    if(getsockname(metrics->tcp_fd, (struct sockaddr*)&addr, &addr_len) != 0)
+    {
+        return 0;
+    }
+    return ntohs(addr.sin_port);
+}
+
+int smartlog_metrics_serve(smartlog_metrics_t* metrics, int timeout_ms)
+{
+    if(metrics == NULL)
+    {
+        errno = EINVAL;
+        return 1;
+    }
+
+    struct pollfd pfd[2] = {
+        { metrics->unix_fd, POLLIN, 0 },    /* -1 is ignored by poll() */
+        { metrics->tcp_fd, POLLIN, 0 },
+    };
+    int ready = poll(pfd, 2, timeout_ms);
+    if(ready < 0)
+    {
+        return errno == EINTR ? 0 : 1;
+    }
+
+    for(int i = 0; i < 2 && ready > 0; i++)
+    {
+        if((pfd[i].revents & POLLIN) == 0)
+        {
+            continue;
+        }
+
+        /* Listeners are non-blocking: answer everyone queued, then return */
+        int client;
+        while((client = accept4(pfd[i].fd, NULL, NULL, SOCK_CLOEXEC)) >= 0)
+        {
+            serve_client(metrics, client);
+            close(client);
+        }
+    }
+    return 0;
+}
+
+int smartlog_metrics_start(smartlog_metrics_t* metrics)
+{
+    if(metrics == NULL || metrics->thread_started)
+    {
+        errno = EINVAL;
+        return 1;
+    }
+
+    int rc = pthread_create(&metrics->thread, NULL, metrics_thread_main, metrics);
+    if(rc != 0)
+    {
+        errno = rc;
+        return 1;
+    }
+    metrics->thread_started = 1;
+    return 0;
+}
+
+void smartlog_metrics_destroy(smartlog_metrics_t* metrics)
+{
+    if(metrics == NULL)
+    {
+        return;
+    }
+
+    if(metrics->thread_started)
+    {
+        atomic_store(&metrics->stopping, 1);
+        pthread_join(metrics->thread, NULL);
+    }
+    if(metrics->unix_fd >= 0)
+    {
+        close(metrics->unix_fd);
+        (void)unlink(metrics->unix_path);
+    }
+    if(metrics->tcp_fd >= 0)
+    {
+        close(metrics->tcp_fd);
+    }
+    pthread_mutex_destroy(&metrics->lock);
+    free(metrics);
+}
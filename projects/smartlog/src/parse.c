@@ -0,0 +1,467 @@
+/*
+ * src/parse.c
+ *
+ * Parallel columnar parser for SmartLog files.
+ *
+ * Implements:
+ *   - Chunking at newline boundaries, one worker thread per chunk
+ *   - Two passes: an SSE2 newline count sizes every chunk's rows, then
+ *     each chunk parses straight into its slice of the shared columns
+ *   - An SSE2 line splitter and a fixed-layout field tokenizer
+ *   - mmap'ed input, messages referenced by offset (never copied)
+ *
+ * Author: Aravinthraj Ganesan
+ * Version: 1.0
+ */
+
+#define _GNU_SOURCE
+#define _POSIX_C_SOURCE 199309L
+
+/* Standard includes */
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define SMARTLOG_HAVE_SSE2 1
+#else
+#define SMARTLOG_HAVE_SSE2 0
+#endif
+
+/* Project includes */
+#include <smartlog/config.h>
+#include <smartlog/parse.h>
+
+/* ============================================================================
+ * Internal Types
+ * ============================================================================ */
+
+typedef struct {
+    const char* data;           /* Whole input */
+    size_t begin;               /* Chunk [begin, end), starts at a line */
+    size_t end;
+    int last;                   /* Ends at the end of the data */
+    size_t rows;                /* Pass 1: rows in the chunk */
+    size_t first_row;           /* Pass 2: row index of the first line */
+    uint64_t untimed;
+    smartlog_columns_t* cols;
+    int threaded;
+} parse_job_t;
+
+typedef void* (*parse_pass_fn)(void* arg);
+
+/* ============================================================================
+ * Vector Scanning
+ * ============================================================================ */
+
+/**
+ * Count '\n' bytes, 16 at a time.
+ */
+static size_t count_newlines(const char* p, size_t len)
+{
+    size_t count = 0;
+    size_t i = 0;
+
+#if SMARTLOG_HAVE_SSE2
+    const __m128i newline = _mm_set1_epi8('\n');
+    for(; i + 16 <= len; i += 16)
+    {
+        __m128i block = _mm_loadu_si128((const __m128i*)(const void*)(p + i));
+        unsigned int mask = (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(block, newline));
+        count += (size_t)__builtin_popcount(mask);
+    }
+#endif
+
+    for(; i < len; i++)
+    {
+        count += p[i] == '\n';
+    }
+    return count;
+}
+
+/**
+ * First '\n' in [p, end), or end.
+ */
+static const char* find_newline(const char* p, const char* end)
+{
+#if SMARTLOG_HAVE_SSE2
+    const __m128i newline = _mm_set1_epi8('\n');
+    for(; end - p >= 16; p += 16)
+    {
+        __m128i block = _mm_loadu_si128((const __m128i*)(const void*)p);
+        unsigned int mask = (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(block, newline));
+        if(mask != 0)
+        {
+            return p + __builtin_ctz(mask);
+        }
+    }
+#endif
+
+    const char* hit = memchr(p, '\n', (size_t)(end - p));
+    return hit != NULL ? hit : end;
+}
+
+/* ============================================================================
+ * Field Tokenizer
+ * ============================================================================ */
+
+static int take(const char** p, const char* end, const char* lit, size_t lit_len)
+{
+    if((size_t)(end - *p) < lit_len || memcmp(*p, lit, lit_len) != 0)
+    {
+        return 0;
+    }
+    *p += lit_len;
+    return 1;
+}
+
+/**
+ * Parse decimal digits at *p.
+ *
+ * Return: 1 if at least one digit was read, 0 otherwise
+ */
+static int take_u64(const char** p, const char* end, uint64_t* out)
+{
+    const char* start = *p;
+    uint64_t v = 0;
+    while(*p < end && **p >= '0' && **p <= '9')
+    {
+        v = (v * 10u) + (uint64_t)(**p - '0');
+        (*p)++;
+    }
+    *out = v;
+    return *p != start;
+}
+
+/**
+ * Parse one line (without its '\n') into row `row`.
+ *
+ * Return: 1 if the line was timed, 0 if it was kept as untimed text
+ */
+static int parse_line(smartlog_columns_t* cols, size_t row, const char* data, const char* line, const char* end)
+{
+    const char* p = line;
+    uint64_t time_ns = 0;
+    uint64_t value = 0;
+    int32_t pid = -1;
+    int32_t tid = -1;
+    uint64_t seq = 0;
+
+    /* Untimed unless it starts with "[<ns> ns] " */
+    cols->time_ns[row] = 0;
+    cols->pid[row] = -1;
+    cols->tid[row] = -1;
+    cols->seq[row] = 0;
+    cols->msg_offset[row] = (uint64_t)(line - data);
+    cols->msg_len[row] = (uint32_t)(end - line);
+
+    if(!take(&p, end, "[", 1) || !take_u64(&p, end, &time_ns) || !take(&p, end, " ns] ", 5))
+    {
+        return 0;
+    }
+
+    const char* msg = p;
+    while(p < end && *p == '[')
+    {
+        if(take(&p, end, "[MESSAGE = ", 11))
+        {
+            msg = p;
+            if(end > msg && end[-1] == ']')
+            {
+                end--;
+            }
+            break;
+        }
+
+        if(take(&p, end, "[PID = ", 7) && take_u64(&p, end, &value))
+        {
+            pid = (int32_t)value;
+        }
+        else if(take(&p, end, "[TID = ", 7) && take_u64(&p, end, &value))
+        {
+            tid = (int32_t)value;
+        }
+        else if(take(&p, end, "[SEQ = ", 7) && take_u64(&p, end, &value))
+        {
+            seq = value;
+        }
+        else
+        {
+            /* Field added by a newer writer: skip it */
+            const char* close = memchr(p, ']', (size_t)(end - p));
+            if(close == NULL)
+            {
+                break;
+            }
+            p = close;
+        }
+
+        if(!take(&p, end, "]", 1))
+        {
+            break;
+        }
+        (void)take(&p, end, " ", 1);
+        msg = p;
+    }
+
+    cols->time_ns[row] = time_ns;
+    cols->pid[row] = pid;
+    cols->tid[row] = tid;
+    cols->seq[row] = seq;
+    cols->msg_offset[row] = (uint64_t)(msg - data);
+    cols->msg_len[row] = (uint32_t)(end - msg);
+    return 1;
+}
+
+/* ============================================================================
+ * Workers
+ * ============================================================================ */
+
+/** Pass 1: rows in the chunk */
+static void* count_worker(void* arg)
+{
+    parse_job_t* job = (parse_job_t*)arg;
+    size_t len = job->end - job->begin;
+
+    job->rows = count_newlines(job->data + job->begin, len);
+    if(job->last && len > 0 && job->data[job->end - 1] != '\n')
+    {
+        job->rows++;
+    }
+    return NULL;
+}
+
+/** Pass 2: parse the chunk into rows first_row.. */
+static void* parse_worker(void* arg)
+{
+    parse_job_t* job = (parse_job_t*)arg;
+    const char* p = job->data + job->begin;
+    const char* end = job->data + job->end;
+    size_t row = job->first_row;
+
+    while(p < end)
+    {
+        const char* eol = find_newline(p, end);
+        if(!parse_line(job->cols, row, job->data, p, eol))
+        {
+            job->untimed++;
+        }
+        row++;
+        p = eol < end ? eol + 1 : end;
+    }
+    return NULL;
+}
+
+/**
+ * Run one pass over all chunks; chunk 0 runs on the caller, and a chunk
+ * whose thread cannot start runs here too.
+ */
+static void run_pass(parse_job_t* jobs, pthread_t* tids, size_t njobs, parse_pass_fn fn)
+{
+    for(size_t i = 1; i < njobs; i++)
+    {
+        jobs[i].threaded = pthread_create(&tids[i], NULL, fn, &jobs[i]) == 0;
+    }
+    for(size_t i = 0; i < njobs; i++)
+    {
+        if(i == 0 || !jobs[i].threaded)
+        {
+            fn(&jobs[i]);
+        }
+    }
+    for(size_t i = 1; i < njobs; i++)
+    {
+        if(jobs[i].threaded)
+        {
+            pthread_join(tids[i], NULL);
+        }
+    }
+}
+
+/* ============================================================================
+ * Public API
+ * ============================================================================ */
+
+int smartlog_parse_buffer(const char* data, size_t size, unsigned int threads, smartlog_columns_t* out)
+{
+    if(out == NULL || (data == NULL && size != 0))
+    {
+        errno = EINVAL;
+        return 1;
+    }
+    memset(out, 0, sizeof(*out));
+    out->data = data;
+    out->size = size;
+
+    if(threads == 0)
+    {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cpus > 0 ? (unsigned int)cpus : 1u;
+    }
+
+    /* ====================================================================
+     * STEP 1: Cut Chunks at Line Starts
+     * ==================================================================== */
+    size_t chunk = size / threads;
+    if(chunk < SMARTLOG_PARSE_CHUNK_MIN)
+    {
+        chunk = SMARTLOG_PARSE_CHUNK_MIN;
+    }
+    size_t njobs = size == 0 ? 1 : (size + chunk - 1) / chunk;
+
+    parse_job_t* jobs = calloc(njobs, sizeof(*jobs));
+    pthread_t* tids = calloc(njobs, sizeof(*tids));
+    if(jobs == NULL || tids == NULL)
+    {
+        free(jobs);
+        free(tids);
+        errno = ENOMEM;
+        return 1;
+    }
+
+    size_t begin = 0;
+    for(size_t i = 0; i < njobs; i++)
+    {
+        size_t end = size;
+        if(i + 1 < njobs && (i + 1) * chunk > begin)
+        {
+            const char* cut = find_newline(data + ((i + 1) * chunk), data + size);
+            end = cut < data + size ? (size_t)(cut - data) + 1 : size;
+        }
+        else if(i + 1 < njobs)
+        {
+            end = begin;
+        }
+
+        jobs[i].data = data;
+        jobs[i].begin = begin;
+        jobs[i].end = end;
+        jobs[i].last = end == size;
+        jobs[i].cols = out;
+        begin = end;
+    }
+
+    /* ====================================================================
+     * STEP 2: Count Rows per Chunk, Then Allocate the Columns Once
+     * ==================================================================== */
+    run_pass(jobs, tids, njobs, count_worker);
+
+    size_t rows = 0;
+    for(size_t i = 0; i < njobs; i++)
+    {
+        jobs[i].first_row = rows;
+        rows += jobs[i].rows;
+    }
+
+    size_t alloc_rows = rows != 0 ? rows : 1;
+    out->time_ns = malloc(alloc_rows * sizeof(*out->time_ns));
+    out->pid = malloc(alloc_rows * sizeof(*out->pid));
+    out->tid = malloc(alloc_rows * sizeof(*out->tid));
+    out->seq = malloc(alloc_rows * sizeof(*out->seq));
+    out->msg_offset = malloc(alloc_rows * sizeof(*out->msg_offset));
+    out->msg_len = malloc(alloc_rows * sizeof(*out->msg_len));
+    if(out->time_ns == NULL || out->pid == NULL || out->tid == NULL || out->seq == NULL ||
+       out->msg_offset == NULL || out->msg_len == NULL)
+    {
+        smartlog_columns_free(out);
+        free(jobs);
+        free(tids);
+        errno = ENOMEM;
+        return 1;
+    }
+
+    /* ====================================================================
+     * STEP 3: Parse Every Chunk Into Its Own Rows
+     * ==================================================================== */
+    run_pass(jobs, tids, njobs, parse_worker);
+
+    out->rows = rows;
+    for(size_t i = 0; i < njobs; i++)
+    {
+        out->untimed += jobs[i].untimed;
+    }
+
+    free(jobs);
+    free(tids);
+    return 0;
+}
+
+int smartlog_parse_file(const char* path, unsigned int threads, smartlog_columns_t* out)
+{
+    if(path == NULL || out == NULL)
+    {
+        errno = EINVAL;
+        return 1;
+    }
+
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if(fd < 0)
+    {
+        return 1;
+    }
+
+    struct stat st;
+    if(fstat(fd, &st) != 0)
+    {
+        int saved_errno = errno;
+        close(fd);
+        errno = saved_errno;
+        return 1;
+    }
+
+    size_t size = (size_t)st.st_size;
+    void* map = NULL;
+    if(size != 0)
+    {
+        map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if(map == MAP_FAILED)
+        {
+            int saved_errno = errno;
+            close(fd);
+            errno = saved_errno;
+            return 1;
+        }
+        (void)madvise(map, size, MADV_WILLNEED);
+    }
+    close(fd);
+
+    if(smartlog_parse_buffer((const char*)map, size, threads, out) != 0)
+    {
+        int saved_errno = errno;
+        if(map != NULL)
+        {
+            munmap(map, size);
+        }
+        errno = saved_errno;
+        return 1;
+    }
+
+    out->mapping = map;
+    return 0;
+}
+
+void smartlog_columns_free(smartlog_columns_t* cols)
+{
+    if(cols == NULL)
+    {
+        return;
+    }
+
+    free(cols->time_ns);
+    free(cols->pid);
+    free(cols->tid);
+    free(cols->seq);
+    free(cols->msg_offset);
+    free(cols->msg_len);
+    if(cols->mapping != NULL)
+    {
+        munmap(cols->mapping, cols->size);
+    }
+    memset(cols, 0, sizeof(*cols));
+}
@@ -0,0 +1,495 @@
+/*
+ * src/recorder.c
+ *
+ * Flight recorder for SmartLog.
+ *
+ * Implements:
+ *   - One byte ring per thread and recorder, found through a small
+ *     thread-local cache; records are a fixed header plus the line
+ *   - Rings of exited threads handed to new threads (pthread key
+ *     destructor), so thread churn does not grow memory
+ *   - Overwrite of the oldest records when a ring is full
+ *   - Dumps that empty every ring and replay the records by sequence
+ *
+ * Author: Aravinthraj Ganesan
+ * Version: 1.0
+ */
+
+#define _GNU_SOURCE
+#define _POSIX_C_SOURCE 199309L
+
+/* Standard includes */
+#include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+/* Project includes */
+#include <smartlog/config.h>
+#include <smartlog/recorder.h>
+
+/* ============================================================================
+ * Internal Types
+ * ============================================================================ */
+
+#define RECORDER_TLS_CACHE  4   /* Recorders one thread can switch between cheaply */
+
+/** Stored in front of every line in a ring */
+typedef struct {
+    uint64_t seq;
+    uint64_t time_ns;
+    int32_t pid;
+    int32_t tid;
+    uint32_t level;
+    uint32_t len;           /* Line bytes that follow */
+} ring_hdr_t;
+
+typedef struct recorder_ring {
+    struct recorder_ring* next;
+    struct smartlog_recorder* recorder;
+    pid_t owner;            /* Recording thread, 0 once it exited (recorder lock) */
+    pthread_mutex_t lock;   /* Owner thread vs dumps */
+    unsigned char* buf;
+    size_t head;            /* Oldest record */
+    size_t used;            /* Bytes from head */
+    uint64_t recorded;
+    uint64_t overwritten;
+} recorder_ring_t;
+
+struct smartlog_recorder {
+    uint64_t id;            /* Unique, so stale thread caches never match */
+    size_t ring_bytes;
+    pthread_key_t exit_key; /* Per thread: its ring, released at thread exit */
+    pthread_mutex_t lock;   /* Ring list, ring owners and dump counters */
+    recorder_ring_t* rings;
+    uint64_t rings_count;
+    uint64_t dumped;
+    uint64_t dumps;
+};
+
+typedef struct {
+    uint64_t id;
+    recorder_ring_t* ring;
+} recorder_tls_t;
+
+/** One record of a dump, pointing into the copied ring bytes */
+typedef struct {
+    ring_hdr_t hdr;
+    const char* line;
+} dump_entry_t;
+
+static atomic_uint_fast64_t next_recorder_id = 1;
+static _Thread_local recorder_tls_t tls_cache[RECORDER_TLS_CACHE];
+static _Thread_local unsigned int tls_next;
+
+/* ============================================================================
+ * Ring Helpers
+ * ============================================================================ */
+
+static void ring_put(recorder_ring_t* ring, size_t cap, size_t pos, const void* data, size_t len)
+{
+    pos %= cap;
+    size_t first = cap - pos < len ? cap - pos : len;
+    memcpy(ring->buf + pos, data, first);
+    memcpy(ring->buf, (const unsigned char*)data + first, len - first);
+}
+
+static void ring_get(const recorder_ring_t* ring, size_t cap, size_t pos, void* out, size_t len)
+{
+    pos %= cap;
+    size_t first = cap - pos < len ? cap - pos : len;
+    memcpy(out, ring->buf + pos, first);
+    memcpy((unsigned char*)out + first, ring->buf, len - first);
+}
+
+/**
+ * Thread exit: the ring is kept (its records are still dumped) and handed
+ * to the next thread that needs one.
+ */
+static void ring_release(void* value)
+{
+    recorder_ring_t* ring = (recorder_ring_t*)value;
+    pthread_mutex_lock(&ring->recorder->lock);
+    ring->owner = 0;
+    pthread_mutex_unlock(&ring->recorder->lock);
+}
+
+/**
+ * This thread's ring: from the cache, else the ring this thread already
+ * owns (evicted from the cache), else a ring left by an exited thread,
+ * else a new one.
+ *
+ * Return: Ring, or NULL on allocation failure
+ */
+static recorder_ring_t* thread_ring(smartlog_recorder_t* recorder)
+{
+    for(unsigned int i = 0; i < RECORDER_TLS_CACHE; i++)
+    {
+        if(tls_cache[i].id == recorder->id)
+        {
+            return tls_cache[i].ring;
+        }
+    }
+
+    pid_t tid = (pid_t)syscall(SYS_gettid);
+    recorder_ring_t* ring = NULL;
+    recorder_ring_t* spare = NULL;
+
+    pthread_mutex_lock(&recorder->lock);
+    for(recorder_ring_t* r = recorder->rings; r != NULL && ring == NULL; r = r->next)
+    {
+        if(r->owner == tid)
+        {
+            ring = r;
+        }
+        else if(r->owner == 0 && spare == NULL)
+        {
+            spare = r;
+        }
+    }
+    if(ring == NULL && spare != NULL)
+    {
+        /* Records of the exited thread stay until dumped or overwritten */
+        ring = spare;
+        ring->owner = tid;
+    }
+    pthread_mutex_unlock(&recorder->lock);
+
+    if(ring == NULL)
+    {
+        ring = calloc(1, sizeof(*ring));
+        if(ring == NULL || (ring->buf = malloc(recorder->ring_bytes)) == NULL)
+        {
+            free(ring);
+            errno = ENOMEM;
+            return NULL;
+        }
+        pthread_mutex_init(&ring->lock, NULL);
+        ring->recorder = recorder;
+        ring->owner = tid;
+
+        pthread_mutex_lock(&recorder->lock);
+        ring->next = recorder->rings;
+        recorder->rings = ring;
+        recorder->rings_count++;
+        pthread_mutex_unlock(&recorder->lock);
+    }
+
+    if(pthread_getspecific(recorder->exit_key) != ring &&
+       pthread_setspecific(recorder->exit_key, ring) != 0)
+    {
+        /* Without the exit hook the ring is never handed on */
+        pthread_mutex_lock(&recorder->lock);
+        ring->owner = 0;
+        pthread_mutex_unlock(&recorder->lock);
+        errno = ENOMEM;
+        return NULL;
+    }
+
+    /* An evicted ring stays linked, owned and dumped */
+    recorder_tls_t* entry = &tls_cache[tls_next++ % RECORDER_TLS_CACHE];
+    entry->id = recorder->id;
+    entry->ring = ring;
+    return ring;
+}
+
+static int entry_cmp(const void* a, const void* b)
+{
+    uint64_t sa = ((const dump_entry_t*)a)->hdr.seq;
+    uint64_t sb = ((const dump_entry_t*)b)->hdr.seq;
+    return (sa > sb) - (sa < sb);
+}
+
+/* ============================================================================
+ * Public API
+ * ============================================================================ */
+
+smartlog_recorder_t* smartlog_recorder_create(size_t ring_bytes)
+{
+    if(ring_bytes < SMARTLOG_RECORDER_MIN_RING)
+    {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    smartlog_recorder_t* recorder = calloc(1, sizeof(*recorder));
+    if(recorder == NULL)
+    {
+        return NULL;
+    }
+
+    int rc = pthread_key_create(&recorder->exit_key, ring_release);
+    if(rc != 0)
+    {
+        free(recorder);
+        errno = rc;
+        return NULL;
+    }
+
+    recorder->id = atomic_fetch_add_explicit(&next_recorder_id, 1, memory_order_relaxed);
+    recorder->ring_bytes = ring_bytes;
+    pthread_mutex_init(&recorder->lock, NULL);
+    return recorder;
+}
+
+int smartlog_recorder_add(smartlog_recorder_t* recorder, const smartlog_record_t* record)
+{
+    if(recorder == NULL || record == NULL || record->line == NULL)
+    {
+        errno = EINVAL;
+        return 1;
+    }
+
+    size_t cap = recorder->ring_bytes;
+    size_t need = sizeof(ring_hdr_t) + record->line_len;
+    if(need > cap)
+    {
+        errno = EMSGSIZE;
+        return 1;
+    }
+
+    recorder_ring_t* ring = thread_ring(recorder);
+    if(ring == NULL)
+    {
+        return 1;
+    }
+
+    ring_hdr_t hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.seq = record->seq;
+    hdr.time_ns = record->time_ns;
+    hdr.pid = (int32_t)record->pid;
+    hdr.tid = (int32_t)record->tid;
+    hdr.level = (uint32_t)record->level;
+    hdr.len = (uint32_t)record->line_len;
+
+    pthread_mutex_lock(&ring->lock);
+
+    /* Make room by dropping the oldest records */
+    while(cap - ring->used < need)
+    {
+        ring_hdr_t old;
+        ring_get(ring, cap, ring->head, &old, sizeof(old));
+        size_t old_size = sizeof(old) + old.len;
+        ring->head = (ring->head + old_size) % cap;
+        ring->used -= old_size;
+        ring->overwritten++;
+    }
+
+    size_t tail = ring->head + ring->used;
+    ring_put(ring, cap, tail, &hdr, sizeof(hdr));
+    ring_put(ring, cap, tail + sizeof(hdr), record->line, record->line_len);
+    ring->used += need;
+    ring->recorded++;
+
+    pthread_mutex_unlock(&ring->lock);
+    return 0;
+}
+
+int smartlog_recorder_dump(smartlog_recorder_t* recorder, smartlog_recorder_fn fn, void* arg, size_t* count)
+{
+    if(recorder == NULL || fn == NULL)
+    {
+        errno = EINVAL;
+        return 1;
+    }
+    if(count != NULL)
+    {
+        *count = 0;
+    }
+
+    size_t cap = recorder->ring_bytes;
+
+    /* ====================================================================
+     * STEP 1: Size the Copy (Nothing to Do When Every Ring Is Empty)
+     * ==================================================================== */
+    size_t total = 0;
+    pthread_mutex_lock(&recorder->lock);
+    for(recorder_ring_t* ring = recorder->rings; ring != NULL; ring = ring->next)
+    {
+        pthread_mutex_lock(&ring->lock);
+        total += ring->used;
+        pthread_mutex_unlock(&ring->lock);
+    }
+    if(total == 0)
+    {
+        recorder->dumps++;
+        pthread_mutex_unlock(&recorder->lock);
+        return 0;
+    }
+    pthread_mutex_unlock(&recorder->lock);
+
+    unsigned char* copy = malloc(total);
+    if(copy == NULL)
+    {
+        errno = ENOMEM;
+        return 1;
+    }
+
+    /* ====================================================================
+     * STEP 2: Copy the Rings Out and Empty Them
+     * ==================================================================== */
+    /* Whole records only, up to what was sized; newer ones wait for the next dump */
+    size_t copied = 0;
+    pthread_mutex_lock(&recorder->lock);
+    for(recorder_ring_t* ring = recorder->rings; ring != NULL; ring = ring->next)
+    {
+        pthread_mutex_lock(&ring->lock);
+        size_t take = 0;
+        while(take < ring->used)
+        {
+            ring_hdr_t hdr;
+            ring_get(ring, cap, ring->head + take, &hdr, sizeof(hdr));
+            size_t rec_size = sizeof(hdr) + hdr.len;
+            if(copied + take + rec_size > total)
+            {
+                break;
+            }
+            take += rec_size;
+        }
+        ring_get(ring, cap, ring->head, copy + copied, take);
+        copied += take;
+        ring->used -= take;
+        ring->head = ring->used != 0 ? (ring->head + take) % cap : 0;
+        pthread_mutex_unlock(&ring->lock);
+    }
+    pthread_mutex_unlock(&recorder->lock);
+
+    /* ====================================================================
+     * STEP 3: Index the Records and Sort by Sequence
+     * ==================================================================== */
+    size_t nentries = 0;
+    for(size_t pos = 0; pos < copied; nentries++)
+    {
+        ring_hdr_t hdr;
+        memcpy(&hdr, copy + pos, sizeof(hdr));
+        pos += sizeof(hdr) + hdr.len;
+    }
+
+    dump_entry_t* entries = nentries != 0 ? malloc(nentries * sizeof(*entries)) : NULL;
+    if(nentries != 0 && entries == NULL)
+    {
+        free(copy);
+        errno = ENOMEM;
+        return 1;
+    }
+    size_t pos = 0;
+    for(size_t i = 0; i < nentries; i++)
+    {
+        memcpy(&entries[i].hdr, copy + pos, sizeof(entries[i].hdr));
+        entries[i].line = (const char*)copy + pos + sizeof(ring_hdr_t);
+        pos += sizeof(ring_hdr_t) + entries[i].hdr.len;
+    }
+    if(nentries > 1)
+    {
+        qsort(entries, nentries, sizeof(*entries), entry_cmp);
+    }
+    pthread_mutex_lock(&recorder->lock);
+    recorder->dumped += nentries;
+    recorder->dumps++;
+    pthread_mutex_unlock(&recorder->lock);
+
+    /* ====================================================================
+     * STEP 4: Replay Oldest First
+     * ==================================================================== */
+    static const char msg_tag[] = "[MESSAGE = ";
+    int rc = 0;
+    int first_errno = 0;
+    for(size_t i = 0; i < nentries; i++)
+    {
+        const dump_entry_t* e = &entries[i];
+
+        /* Message as written: between the tag and the closing "]\n" */
+        char msg[SMARTLOG_LOG_BUFFER_SZ];
+        const char* tag = memmem(e->line, e->hdr.len, msg_tag, sizeof(msg_tag) - 1);
+        size_t msg_len = 0;
+        if(tag != NULL && e->hdr.len >= 2)
+        {
+            const char* start = tag + sizeof(msg_tag) - 1;
+            const char* end = e->line + e->hdr.len - 2;
+            if(end > start && (size_t)(end - start) < sizeof(msg))
+            {
+                msg_len = (size_t)(end - start);
+                memcpy(msg, start, msg_len);
+            }
+        }
+        msg[msg_len] = '\0';
+
+        smartlog_record_t record;
+        record.level = (log_level_t)e->hdr.level;
+        record.time_ns = e->hdr.time_ns;
+        record.pid = (pid_t)e->hdr.pid;
+        record.tid = (pid_t)e->hdr.tid;
+        record.seq = e->hdr.seq;
+        record.msg = msg;
+        record.line = e->line;
+        record.line_len = e->hdr.len;
+        if(fn(&record, arg) != 0 && rc == 0)
+        {
+            rc = 1;
+            first_errno = errno != 0 ? errno : EIO;
+        }
+    }
+
+    free(entries);
+    free(copy);
+    if(count != NULL)
+    {
+        *count = nentries;
+    }
+    if(rc != 0)
+    {
+        errno = first_errno;
+    }
+    return rc;
+}
+
+void smartlog_recorder_get_stats(smartlog_recorder_t* recorder, smartlog_recorder_stats_t* out)
+{
+    if(recorder == NULL || out == NULL)
+    {
+        return;
+    }
+
+    memset(out, 0, sizeof(*out));
+    pthread_mutex_lock(&recorder->lock);
+    for(recorder_ring_t* ring = recorder->rings; ring != NULL; ring = ring->next)
+    {
+        pthread_mutex_lock(&ring->lock);
+        out->recorded += ring->recorded;
+        out->overwritten += ring->overwritten;
+        pthread_mutex_unlock(&ring->lock);
+    }
+    out->dumped = recorder->dumped;
+    out->dumps = recorder->dumps;
+    out->rings = recorder->rings_count;
+    pthread_mutex_unlock(&recorder->lock);
+}
+
+void smartlog_recorder_destroy(smartlog_recorder_t* recorder)
+{
+    if(recorder == NULL)
+    {
+        return;
+    }
+
+    /* Live threads must not run ring_release() on freed rings */
+    pthread_key_delete(recorder->exit_key);
+
+    recorder_ring_t* ring = recorder->rings;
+    while(ring != NULL)
+    {
+        recorder_ring_t* next = ring->next;
+        pthread_mutex_destroy(&ring->lock);
+        free(ring->buf);
+        free(ring);
+        ring = next;
+    }
+    pthread_mutex_destroy(&recorder->lock);
+    free(recorder);
+}
@@ -0,0 +1,535 @@
+/*
+ * src/shm_ring.c
+ *
+ * Shared-memory SPSC ring implementation.
+ *
+ * Implements:
+ *   - memfd + eventfd setup and SCM_RIGHTS handshake
+ *   - Lock-free single-producer / single-consumer record ring
+ *   - Idle-only wakeups (producer checks the consumer "waiting" flag)
+ *
+ * The consumer treats the shared header as untrusted: head/tail distance
+ * and record lengths are bounds-checked before any copy. The memfd is
+ * sealed against shrinking, so the client cannot truncate it under the
+ * collector's mapping (which would SIGBUS the collector).
+ *
+ * Author: Aravinthraj Ganesan
+ * Version: 1.0
+ */
+
+#define _GNU_SOURCE
+#define _POSIX_C_SOURCE 199309L
+
+/* Standard includes */
+#include <errno.h>
+#include <fcntl.h>
+#include <stdalign.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+/* Project includes */
+#include <smartlog/config.h>
+#include <smartlog/shm_ring.h>
+
+/* ============================================================================
+ * Shared Layout
+ * ============================================================================ */
+
+#define SHM_RING_MAGIC      0x534c5247u     /* "SLRG" */
+#define SHM_RING_VERSION    1u
+#define SHM_RING_HDR_SZ     4096u           /* Data area starts on its own page */
+#define SHM_RING_REC_HDR    8u
+#define SHM_RING_PAD_MARK   UINT32_MAX
+
+/** Shared header. Producer and consumer fields live on separate lines. */
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t capacity;
+
+    alignas(SMARTLOG_CACHE_LINE) atomic_uint_fast64_t head;    /* Producer */
+    atomic_uint_fast64_t dropped;                               /* Producer */
+
+    alignas(SMARTLOG_CACHE_LINE) atomic_uint_fast64_t tail;    /* Consumer */
+
+    alignas(SMARTLOG_CACHE_LINE) atomic_uint consumer_waiting; /* Consumer */
+} shm_ring_hdr_t;
+
+_Static_assert(sizeof(shm_ring_hdr_t) <= SHM_RING_HDR_SZ, "ring header too large");
+
+/** Handshake payload sent with the two descriptors. */
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    int32_t pid;
+} shm_ring_hello_t;
+
+/* ============================================================================
+ * Internal Types
+ * ============================================================================ */
+
+struct smartlog_shm_ring {
+    shm_ring_hdr_t* hdr;
+    unsigned char* data;
+    uint64_t capacity;
+    uint64_t mask;
+    size_t map_len;
+    int memfd;
+    int eventfd;
+    int conn_fd;                /* Producer: control connection, kept open */
+
+    uint64_t local;             /* Producer: head, consumer: tail */
+    uint64_t cached_peer;       /* Producer: last seen tail */
+};
+
+static uint64_t rec_size(size_t len)
+{
+    return SHM_RING_REC_HDR + (((uint64_t)len + 7u) & ~UINT64_C(7));
+}
+
+static void ring_free(smartlog_shm_ring_t* ring)
+{
+    if(ring->hdr != NULL)
+    {
+        munmap(ring->hdr, ring->map_len);
+    }
+    if(ring->memfd >= 0)
+    {
+        close(ring->memfd);
+    }
+    if(ring->eventfd >= 0)
+    {
+        close(ring->eventfd);
+    }
+    if(ring->conn_fd >= 0)
+    {
+        close(ring->conn_fd);
+    }
+    free(ring);
+}
+
+static smartlog_shm_ring_t* ring_alloc(void)
+{
+    smartlog_shm_ring_t* ring = calloc(1, sizeof(*ring));
+    if(ring != NULL)
+    {
+        ring->memfd = -1;
+        ring->eventfd = -1;
+        ring->conn_fd = -1;
+    }
+    return ring;
+}
+
+/**
+ * Map the ring from its memfd.
+ */
+static int ring_map(smartlog_shm_ring_t* ring, uint64_t capacity)
+{
+    ring->map_len = SHM_RING_HDR_SZ + (size_t)capacity;
+    void* base = mmap(NULL, ring->map_len, PROT_READ | PROT_WRITE, MAP_SHARED, ring->memfd, 0);
+    if(base == MAP_FAILED)
+    {
+        ring->hdr = NULL;
+        return -1;
+    }
+
+    ring->hdr = (shm_ring_hdr_t*)base;
+    ring->data = (unsigned char*)base + SHM_RING_HDR_SZ;
+    ring->capacity = capacity;
+    ring->mask = capacity - 1;
+    return 0;
+}
+
+/* ============================================================================
+ * Producer Side
+ * ============================================================================ */
+
+smartlog_shm_ring_t* smartlog_shm_ring_connect(const char* control_path, size_t capacity)
+{
+    if(control_path == NULL || control_path[0] == '\0')
+    {
+        errno = EINVAL;
+        return NULL;
+    }
+    if(capacity == 0)
+    {
+        capacity = SMARTLOG_SHM_RING_DEFAULT;
+    }
+    if(capacity < 4096 || (capacity & (capacity - 1)) != 0)
+    {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    size_t path_len = strlen(control_path);
+    if(path_len >= sizeof(addr.sun_path))
+    {
+        errno = ENAMETOOLONG;
+        return NULL;
+    }
+    memcpy(addr.sun_path, control_path, path_len + 1);
+
+    smartlog_shm_ring_t* ring = ring_alloc();
+    if(ring == NULL)
+    {
+        return NULL;
+    }
+
+    /* ====================================================================
+     * STEP 1: Create and Map the Shared Ring
+     * ==================================================================== */
+    ring->memfd = memfd_create("smartlog-ring", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    ring->eventfd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if(ring->memfd < 0 || ring->eventfd < 0 ||
+       ftruncate(ring->memfd, (off_t)(SHM_RING_HDR_SZ + capacity)) != 0 ||
+       fcntl(ring->memfd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL) != 0 ||
+       ring_map(ring, capacity) != 0)
+    {
+        int saved_errno = errno;
+        ring_free(ring);
+        errno = saved_errno;
+        return NULL;
+    }
+
+    ring->hdr->magic = SHM_RING_MAGIC;
+    ring->hdr->version = SHM_RING_VERSION;
+    ring->hdr->capacity = capacity;
+    atomic_init(&ring->hdr->head, 0);
+    atomic_init(&ring->hdr->dropped, 0);
+    atomic_init(&ring->hdr->tail, 0);
+    atomic_init(&ring->hdr->consumer_waiting, 0);
+
+    /* ====================================================================
+     * STEP 2: Hand memfd + eventfd to the Collector
+     * ==================================================================== */
+    ring->conn_fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if(ring->conn_fd < 0 ||
+       connect(ring->conn_fd, (struct sockaddr*)&addr, sizeof(addr)) != 0)
+    {
+        int saved_errno = errno;
+        ring_free(ring);
+        errno = saved_errno;
+        return NULL;
+    }
+
+    shm_ring_hello_t hello;
+    hello.magic = SHM_RING_MAGIC;
+    hello.version = SHM_RING_VERSION;
+    hello.pid = (int32_t)getpid();
+
+    struct iovec iov;
+    iov.iov_base = &hello;
+    iov.iov_len = sizeof(hello);
+
+    union {
+        struct cmsghdr align;
+        char buf[CMSG_SPACE(2 * sizeof(int))];
+    } control;
+    memset(&control, 0, sizeof(control));
+
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.buf;
+    msg.msg_controllen = sizeof(control.buf);
+
+    struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(2 * sizeof(int));
+    int fds[2] = { ring->memfd, ring->eventfd };
+    memcpy(CMSG_DATA(cmsg), fds, sizeof(fds));
+
+    ssize_t sent;
+    do
+    {
+        sent = sendmsg(ring->conn_fd, &msg, MSG_NOSIGNAL);
+    } while(sent < 0 && errno == EINTR);
+
+    if(sent != (ssize_t)sizeof(hello))
+    {
+        int saved_errno = sent < 0 ? errno : EPROTO;
+        ring_free(ring);
+        errno = saved_errno;
+        return NULL;
+    }
+
+    return ring;
+}
+
+int smartlog_shm_ring_push(smartlog_shm_ring_t* ring, const void* data, size_t len)
+{
+    uint64_t need = rec_size(len);
+    if(need > ring->capacity / 2)
+    {
+        errno = EMSGSIZE;
+        return -1;
+    }
+
+    uint64_t head = ring->local;
+    uint64_t pos = head & ring->mask;
+    uint64_t to_end = ring->capacity - pos;
+    uint64_t total = need <= to_end ? need : to_end + need;
+
+    /* Only re-read the consumer's line when the cached view looks full */
+    if(total > ring->capacity - (head - ring->cached_peer))
+    {
+        ring->cached_peer = atomic_load_explicit(&ring->hdr->tail, memory_order_acquire);
+        if(total > ring->capacity - (head - ring->cached_peer))
+        {
+            atomic_fetch_add_explicit(&ring->hdr->dropped, 1, memory_order_relaxed);
+            errno = EAGAIN;
+            return -1;
+        }
+    }
+
+    if(need > to_end)
+    {
+        /* Record would wrap: mark the tail end as padding */
+        uint32_t pad = SHM_RING_PAD_MARK;
+        memcpy(ring->data + pos, &pad, sizeof(pad));
+        head += to_end;
+        pos = 0;
+    }
+
+    uint32_t len32 = (uint32_t)len;
+    memcpy(ring->data + pos, &len32, sizeof(len32));
+    memcpy(ring->data + pos + SHM_RING_REC_HDR, data, len);
+    head += need;
+    ring->local = head;
+
+    /*
+     * Publish, then check whether the consumer went idle. The seq_cst pair
+     * (head store here, waiting store in prepare_wait) guarantees that at
+     * least one side sees the other, so no wakeup is lost.
+     */
+    atomic_store_explicit(&ring->hdr->head, head, memory_order_seq_cst);
+    if(atomic_load_explicit(&ring->hdr->consumer_waiting, memory_order_seq_cst) != 0)
+    {
+        uint64_t one = 1;
+        ssize_t rc = write(ring->eventfd, &one, sizeof(one));
+        (void)rc;   /* EAGAIN means the counter is already non-zero */
+    }
+
+    return 0;
+}
+
+/* ============================================================================
+ * Consumer Side
+ * ============================================================================ */
+
+int smartlog_shm_ring_accept(int listen_fd)
+{
+    return accept4(listen_fd, NULL, NULL, SOCK_CLOEXEC | SOCK_NONBLOCK);
+}
+
+smartlog_shm_ring_t* smartlog_shm_ring_attach(int conn_fd)
+{
+    shm_ring_hello_t hello;
+    struct iovec iov;
+    iov.iov_base = &hello;
+    iov.iov_len = sizeof(hello);
+
+    union {
+        struct cmsghdr align;
+        char buf[CMSG_SPACE(2 * sizeof(int))];
+    } control;
+
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.buf;
+    msg.msg_controllen = sizeof(control.buf);
+
+    /* One non-blocking read: EAGAIN means the hello has not arrived yet */
+    ssize_t got;
+    do
+    {
+        got = recvmsg(conn_fd, &msg, MSG_CMSG_CLOEXEC | MSG_DONTWAIT);
+    } while(got < 0 && errno == EINTR);
+    if(got < 0)
+    {
+        return NULL;
+    }
+
+    int fds[2] = { -1, -1 };
+    struct cmsghdr* cmsg = got > 0 ? CMSG_FIRSTHDR(&msg) : NULL;
+    if(cmsg != NULL && cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS &&
+       cmsg->cmsg_len == CMSG_LEN(2 * sizeof(int)))
+    {
+        memcpy(fds, CMSG_DATA(cmsg), sizeof(fds));
+    }
+
+    smartlog_shm_ring_t* ring = ring_alloc();
+    if(ring == NULL)
+    {
+        if(fds[0] >= 0) close(fds[0]);
+        if(fds[1] >= 0) close(fds[1]);
+        return NULL;
+    }
+    ring->memfd = fds[0];
+    ring->eventfd = fds[1];
+
+    if(got != (ssize_t)sizeof(hello) || hello.magic != SHM_RING_MAGIC ||
+       hello.version != SHM_RING_VERSION || ring->memfd < 0 || ring->eventfd < 0)
+    {
+        ring_free(ring);
+        errno = EPROTO;
+        return NULL;
+    }
+
+    /* An unsealed memfd could be truncated under our mapping */
+    int seals = fcntl(ring->memfd, F_GET_SEALS);
+    if(seals < 0 || (seals & F_SEAL_SHRINK) == 0)
+    {
+        ring_free(ring);
+        errno = EPROTO;
+        return NULL;
+    }
+
+    /* Size comes from the memfd itself, never from the shared header */
+    struct stat st;
+    if(fstat(ring->memfd, &st) != 0 || st.st_size <= (off_t)SHM_RING_HDR_SZ)
+    {
+        ring_free(ring);
+        errno = EPROTO;
+        return NULL;
+    }
+    uint64_t capacity = (uint64_t)st.st_size - SHM_RING_HDR_SZ;
+    if((capacity & (capacity - 1)) != 0)
+    {
+        ring_free(ring);
+        errno = EPROTO;
+        return NULL;
+    }
+    if(ring_map(ring, capacity) != 0)
+    {
+        int saved_errno = errno;
+        ring_free(ring);
+        errno = saved_errno;
+        return NULL;
+    }
+    if(ring->hdr->magic != SHM_RING_MAGIC || ring->hdr->capacity != capacity)
+    {
+        ring_free(ring);
+        errno = EPROTO;
+        return NULL;
+    }
+
+    ring->local = atomic_load_explicit(&ring->hdr->tail, memory_order_acquire);
+    return ring;
+}
+
+ssize_t smartlog_shm_ring_pop(smartlog_shm_ring_t* ring, void* buf, size_t buf_sz)
+{
+    for(;;)
+    {
+        uint64_t tail = ring->local;
+        uint64_t head = atomic_load_explicit(&ring->hdr->head, memory_order_acquire);
+
+        if(head == tail)
+        {
+            return 0;
+        }
+        if(head - tail > ring->capacity)
+        {
+            errno = EPROTO;
+            return -1;
+        }
+
+        uint64_t pos = tail & ring->mask;
+        uint32_t len32 = 0;
+        memcpy(&len32, ring->data + pos, sizeof(len32));
+
+        if(len32 == SHM_RING_PAD_MARK)
+        {
+            tail += ring->capacity - pos;
+            ring->local = tail;
+            atomic_store_explicit(&ring->hdr->tail, tail, memory_order_release);
+            continue;
+        }
+
+        uint64_t need = rec_size(len32);
+        if(pos + need > ring->capacity || need > head - tail)
+        {
+            errno = EPROTO;
+            return -1;
+        }
+
+        int too_big = (size_t)len32 > buf_sz;
+        if(!too_big)
+        {
+            memcpy(buf, ring->data + pos + SHM_RING_REC_HDR, len32);
+        }
+
+        tail += need;
+        ring->local = tail;
+        atomic_store_explicit(&ring->hdr->tail, tail, memory_order_release);
+
+        if(too_big)
+        {
+            errno = EMSGSIZE;
+            return -1;
+        }
+        return (ssize_t)len32;
+    }
+}
+
+int smartlog_shm_ring_prepare_wait(smartlog_shm_ring_t* ring)
+{
+    atomic_store_explicit(&ring->hdr->consumer_waiting, 1, memory_order_seq_cst);
+    if(atomic_load_explicit(&ring->hdr->head, memory_order_seq_cst) != ring->local)
+    {
+        atomic_store_explicit(&ring->hdr->consumer_waiting, 0, memory_order_relaxed);
+        return 1;
+    }
+    return 0;
+}
+
+void smartlog_shm_ring_finish_wait(smartlog_shm_ring_t* ring)
+{
+    atomic_store_explicit(&ring->hdr->consumer_waiting, 0, memory_order_relaxed);
+
+    uint64_t value;
+    ssize_t rc = read(ring->eventfd, &value, sizeof(value));
+    (void)rc;   /* EAGAIN: nothing was signalled */
+}
+
+/* ============================================================================
+ * Common
+ * ============================================================================ */
+
+int smartlog_shm_ring_eventfd(const smartlog_shm_ring_t* ring)
+{
+    return ring == NULL ? -1 : ring->eventfd;
+}
+
+uint64_t smartlog_shm_ring_dropped(const smartlog_shm_ring_t* ring)
+{
+    if(ring == NULL || ring->hdr == NULL)
+    {
+        return 0;
+    }
+    return atomic_load_explicit(&ring->hdr->dropped, memory_order_relaxed);
+}
+
+void smartlog_shm_ring_destroy(smartlog_shm_ring_t* ring)
+{
+    if(ring != NULL)
+    {
+        ring_free(ring);
+    }
+}
@@ -0,0 +1,807 @@
+/*
+ * src/sink.c
+ *
+ * Generic sink implementation for SmartLog.
+ *
+ * Implements:
+ *   - Level and callback filtering per sink
+ *   - Direct (caller thread) delivery under a per-sink lock
+ *   - Async delivery: bounded queue plus one writer thread per sink
+ *   - Overflow policies: drop, block, or spill to a file and replay
+ *   - Signal-safe crash drain of queued lines
+ *   - Per-sink counters
+ *   - Writer CPU affinity, NUMA and huge-page placement of the queue
+ *
+ * The async queue is the lock-free MPSC queue from utils.c. Producers copy
+ * the line into a slot with no lock; the writer claims up to
+ * SMARTLOG_WRITER_BATCH slots in place, writes them, then releases them.
+ * An idle writer spins briefly, then sleeps in futex_wait; producers only
+ * issue futex_wake when the writer has advertised that it is asleep.
+ *
+ * Author: Aravinthraj Ganesan
+ * Version: 1.0
+ */
+
+#define _GNU_SOURCE
+#define _POSIX_C_SOURCE 199309L
+
+/* Standard includes */
+#include <errno.h>
+#include <limits.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+/* Project includes */
+#include <smartlog/config.h>
+#include <smartlog/crash.h>
+#include <smartlog/sink.h>
+#include <smartlog/spill.h>
+#include <smartlog/utils.h>
+
+/* ============================================================================
+ * Internal Types
+ * ============================================================================ */
+
+struct smartlog_sink {
+    const smartlog_sink_ops_t* ops;
+    void* ctx;
+
+    /* Filters */
+    log_level_t min_level;
+    smartlog_filter_fn filter;
+    void* filter_arg;
+
+    /* Direct mode: serializes calls into the ops table */
+    pthread_mutex_t write_lock;
+
+    /* Async mode */
+    int is_async;
+    overflow_policy_t policy;
+    smartlog_mpsc_t* queue;
+    smartlog_spill_t* spill;    /* OVERFLOW_SPILL only */
+    char* spill_dir;
+    atomic_int stopping;
+    atomic_uint spin_us;        /* Writer spin before futex_wait */
+    pthread_t writer;
+
+    /* Writer placement */
+    feature_state_t huge_pages; /* Back the queue with huge pages */
+    int has_affinity;
+    cpu_set_t affinity;
+    atomic_int writer_cpu;      /* Sampled once per batch */
+
+    /* Bumped after each retired batch while someone waits on it */
+    atomic_uint progress;
+    atomic_uint progress_waiters;
+
+    /* Counters */
+    atomic_uint_fast64_t records;
+    atomic_uint_fast64_t bytes;
+    atomic_uint_fast64_t filtered;
+    atomic_uint_fast64_t dropped;
+    atomic_uint_fast64_t errors;
+};
+
+/* ============================================================================
+ * Delivery Helpers
+ * ============================================================================ */
+
+/**
+ * Hand a batch of lines to the sink ops and update counters.
+ * Caller must hold write_lock (direct mode) or be the writer thread.
+ */
+static int sink_deliver(smartlog_sink_t* sink, const struct iovec* iov, int iovcnt)
+{
+    size_t total = 0;
+    for(int i = 0; i < iovcnt; i++)
+    {
+        total += iov[i].iov_len;
+    }
+
+    if(sink->ops->writev != NULL)
+    {
+        int accepted = sink->ops->writev(sink->ctx, iov, iovcnt);
+        if(accepted < 0)
+        {
+            atomic_fetch_add(&sink->errors, 1);
+            return -1;
+        }
+
+        /* Lines the destination did not take are drops, not errors */
+        if(accepted < iovcnt)
+        {
+            total = 0;
+            for(int i = 0; i < accepted; i++)
+            {
+                total += iov[i].iov_len;
+            }
+            atomic_fetch_add(&sink->dropped, (uint64_t)(iovcnt - accepted));
+        }
+        atomic_fetch_add(&sink->records, (uint64_t)accepted);
+        atomic_fetch_add(&sink->bytes, (uint64_t)total);
+        return 0;
+    }
+
+    int rc = 0;
+    for(int i = 0; i < iovcnt; i++)
+    {
+        if(sink->ops->write(sink->ctx, iov[i].iov_base, iov[i].iov_len) != 0)
+        {
+            atomic_fetch_add(&sink->errors, 1);
+            rc = -1;
+            continue;
+        }
+        atomic_fetch_add(&sink->records, 1);
+        atomic_fetch_add(&sink->bytes, (uint64_t)iov[i].iov_len);
+    }
+
+    return rc;
+}
+
+/**
+ * Call the optional flush op and count failures.
+ */
+static int sink_flush_ops(smartlog_sink_t* sink)
+{
+    if(sink->ops->flush == NULL)
+    {
+        return 0;
+    }
+    if(sink->ops->flush(sink->ctx) != 0)
+    {
+        atomic_fetch_add(&sink->errors, 1);
+        return -1;
+    }
+    return 0;
+}
+
+/* ============================================================================
+ * Progress Waits
+ * ============================================================================ */
+
+/*
+ * OVERFLOW_BLOCK producers and flushers sleep on the progress futex. The
+ * writer only bumps and wakes it when progress_waiters is non-zero, so the
+ * steady state costs the writer one load per batch.
+ */
+
+static unsigned int sink_progress_begin(smartlog_sink_t* sink)
+{
+    atomic_fetch_add(&sink->progress_waiters, 1);
+    atomic_thread_fence(memory_order_seq_cst);
+    return atomic_load(&sink->progress);
+}
+
+static void sink_progress_end(smartlog_sink_t* sink)
+{
+    atomic_fetch_sub(&sink->progress_waiters, 1);
+}
+
+static void sink_progress_signal(smartlog_sink_t* sink)
+{
+    /* Pairs with the fence in sink_progress_begin() */
+    atomic_thread_fence(memory_order_seq_cst);
+    if(atomic_load(&sink->progress_waiters) != 0)
+    {
+        atomic_fetch_add(&sink->progress, 1);
+        smartlog_futex_wake(&sink->progress, INT_MAX);
+    }
+}
+
+/* ============================================================================
+ * Async Writer Thread
+ * ============================================================================ */
+
+/**
+ * Idle writer: spin for spin_us watching the queue, then sleep in
+ * futex_wait. Producers only pay for futex_wake once we are asleep.
+ */
+static void sink_writer_idle(smartlog_sink_t* sink)
+{
+    uint64_t spin_ns = (uint64_t)atomic_load_explicit(&sink->spin_us, memory_order_relaxed) * 1000u;
+
+    if(spin_ns != 0)
+    {
+        uint64_t deadline = smartlog_monotonic_ns() + spin_ns;
+        for(unsigned int i = 1; ; i++)
+        {
+            if(smartlog_mpsc_size(sink->queue) != 0 || atomic_load(&sink->stopping) != 0)
+            {
+                return;
+            }
+            smartlog_cpu_relax();
+
+            /* Read the clock every 64 iterations only */
+            if((i & 63u) == 0 && smartlog_monotonic_ns() >= deadline)
+            {
+                break;
+            }
+        }
+    }
+
+    (void)smartlog_mpsc_wait(sink->queue, 0);
+}
+
+/**
+ * Spill replay callback: deliver one batch like a queue batch.
+ */
+static void sink_replay_batch(void* arg, const struct iovec* iov, int iovcnt)
+{
+    smartlog_sink_t* sink = (smartlog_sink_t*)arg;
+
+    (void)sink_deliver(sink, iov, iovcnt);
+    (void)sink_flush_ops(sink);
+}
+
+/**
+ * Replay spilled lines once the queue is empty.
+ *
+ * The replay end is fixed first, then the queue is checked: a line a
+ * producer queued before it spilled is then always visible here and goes
+ * out before the spill.
+ */
+static void sink_writer_replay(smartlog_sink_t* sink)
+{
+    if(smartlog_spill_mark(sink->spill) != 0)
+    {
+        atomic_fetch_add(&sink->errors, 1);
+    }
+    if(smartlog_mpsc_size(sink->queue) != 0)
+    {
+        return;
+    }
+
+    if(smartlog_spill_replay(sink->spill, sink_replay_batch, sink) < 0)
+    {
+        atomic_fetch_add(&sink->errors, 1);
+    }
+    sink_progress_signal(sink);
+}
+
+/**
+ * Writer thread: claim a batch in place, deliver it, release it.
+ */
+static void* sink_writer_main(void* arg)
+{
+    smartlog_sink_t* sink = (smartlog_sink_t*)arg;
+    const void* elems[SMARTLOG_WRITER_BATCH];
+    size_t lens[SMARTLOG_WRITER_BATCH];
+    struct iovec iov[SMARTLOG_WRITER_BATCH];
+
+    for(;;)
+    {
+        /* Claimed slots stay owned by us until release */
+        size_t batch = smartlog_mpsc_claim(sink->queue, elems, lens, SMARTLOG_WRITER_BATCH);
+        if(batch == 0)
+        {
+            if(sink->spill != NULL && smartlog_spill_active(sink->spill) != 0)
+            {
+                sink_writer_replay(sink);
+                continue;
+            }
+            if(atomic_load(&sink->stopping) != 0)
+            {
+                /* Stopping and fully drained */
+                break;
+            }
+            sink_writer_idle(sink);
+            continue;
+        }
+
+        for(size_t i = 0; i < batch; i++)
+        {
+            iov[i].iov_base = (void*)elems[i];
+            iov[i].iov_len = lens[i];
+        }
+        (void)sink_deliver(sink, iov, (int)batch);
+        atomic_store_explicit(&sink->writer_cpu, sched_getcpu(), memory_order_relaxed);
+
+        /* Batch boundary is the flush point (group commit for durable sinks) */
+        (void)sink_flush_ops(sink);
+
+        /* Retire the batch and wake blocked producers / flushers */
+        smartlog_mpsc_release(sink->queue, batch);
+        sink_progress_signal(sink);
+    }
+
+    return NULL;
+}
+
+/**
+ * Copy one line into the queue, applying the overflow policy.
+ */
+static int sink_enqueue(smartlog_sink_t* sink, const char* line, size_t len)
+{
+    if(sink->policy == OVERFLOW_SPILL)
+    {
+        /* Once spilling, keep spilling until the writer has replayed it all */
+        if(smartlog_spill_active(sink->spill) == 0 && smartlog_mpsc_push(sink->queue, line, len) == 0)
+        {
+            return 0;
+        }
+        if(smartlog_spill_append(sink->spill, line, len) != 0)
+        {
+            atomic_fetch_add(&sink->errors, 1);
+        }
+        smartlog_mpsc_wake(sink->queue);
+        return 0;
+    }
+
+    for(;;)
+    {
+        if(smartlog_mpsc_push(sink->queue, line, len) == 0)
+        {
+            return 0;
+        }
+        if(sink->policy == OVERFLOW_DROP || atomic_load(&sink->stopping) != 0)
+        {
+            atomic_fetch_add(&sink->dropped, 1);
+            return 0;
+        }
+
+        /* OVERFLOW_BLOCK: register, retry once, then sleep until a batch retires */
+        unsigned int seen = sink_progress_begin(sink);
+        if(smartlog_mpsc_push(sink->queue, line, len) == 0)
+        {
+            sink_progress_end(sink);
+            return 0;
+        }
+        (void)smartlog_futex_wait(&sink->progress, seen, 0);
+        sink_progress_end(sink);
+    }
+}
+
+/* ============================================================================
+ * Public API
+ * ============================================================================ */
+
+smartlog_sink_t* smartlog_sink_create(const smartlog_sink_ops_t* ops, void* ctx)
+{
+    if(ops == NULL || ops->write == NULL)
+    {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    smartlog_sink_t* sink = calloc(1, sizeof(*sink));
+    if(sink == NULL)
+    {
+        return NULL;
+    }
+
+    sink->ops = ops;
+    sink->ctx = ctx;
+    sink->min_level = LOG_LEVEL_DEBUG;
+    pthread_mutex_init(&sink->write_lock, NULL);
+    atomic_init(&sink->stopping, 0);
+    atomic_init(&sink->spin_us, sysconf(_SC_NPROCESSORS_ONLN) > 1 ? SMARTLOG_WRITER_SPIN_US : 0);
+    atomic_init(&sink->progress, 0);
+    atomic_init(&sink->progress_waiters, 0);
+    atomic_init(&sink->writer_cpu, -1);
+    atomic_init(&sink->records, 0);
+    atomic_init(&sink->bytes, 0);
+    atomic_init(&sink->filtered, 0);
+    atomic_init(&sink->dropped, 0);
+    atomic_init(&sink->errors, 0);
+
+    return sink;
+}
+
+int smartlog_sink_set_level(smartlog_sink_t* sink, log_level_t min_level)
+{
+    if(sink == NULL || min_level < LOG_LEVEL_DEBUG || min_level > LOG_LEVEL_ERROR)
+    {
+        errno = EINVAL;
+        return 1;
+    }
+
+    sink->min_level = min_level;
+    return 0;
+}
+
+int smartlog_sink_set_filter(smartlog_sink_t* sink, smartlog_filter_fn filter, void* arg)
+{
+    if(sink == NULL)
+    {
+        errno = EINVAL;
+        return 1;
+    }
+
+    sink->filter = filter;
+    sink->filter_arg = arg;
+    return 0;
+}
+
+int smartlog_sink_set_async(smartlog_sink_t* sink, size_t capacity, overflow_policy_t policy)
+{
+    if(sink == NULL || sink->is_async != 0 ||
+       (policy != OVERFLOW_DROP && policy != OVERFLOW_BLOCK && policy != OVERFLOW_SPILL))
+    {
+        errno = EINVAL;
+        return 1;
+    }
+
+    if(policy == OVERFLOW_SPILL)
+    {
+        sink->spill = smartlog_spill_open(sink->spill_dir);
+        if(sink->spill == NULL)
+        {
+            return 1;
+        }
+    }
+
+    if(capacity == 0)
+    {
+        capacity = SMARTLOG_QUEUE_DEFAULT_CAP;
+    }
+
+    /* The lock-free queue needs a power of two */
+    size_t slots = 2;
+    while(slots < capacity)
+    {
+        slots <<= 1;
+    }
+
+    /* A pinned writer gets its queue on its own NUMA node */
+    smartlog_mem_opts_t mem = { -1, sink->huge_pages };
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    if(sink->has_affinity != 0)
+    {
+        for(int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+        {
+            if(CPU_ISSET(cpu, &sink->affinity))
+            {
+                mem.numa_node = smartlog_cpu_numa_node(cpu);
+                break;
+            }
+        }
+        (void)pthread_attr_setaffinity_np(&attr, sizeof(sink->affinity), &sink->affinity);
+    }
+
+    sink->queue = smartlog_mpsc_create_with(slots, SMARTLOG_LOG_BUFFER_SZ, &mem);
+    if(sink->queue == NULL)
+    {
+        pthread_attr_destroy(&attr);
+        smartlog_spill_close(sink->spill);
+        sink->spill = NULL;
+        return 1;
+    }
+
+    sink->policy = policy;
+
+    int err = pthread_create(&sink->writer, &attr, sink_writer_main, sink);
+    pthread_attr_destroy(&attr);
+    if(err != 0)
+    {
+        smartlog_mpsc_destroy(sink->queue);
+        sink->queue = NULL;
+        smartlog_spill_close(sink->spill);
+        sink->spill = NULL;
+        errno = err;
+        return 1;
+    }
+
+    sink->is_async = 1;
+    return 0;
+}
+
+int smartlog_sink_set_spill_dir(smartlog_sink_t* sink, const char* dir)
+{
+    if(sink == NULL || dir == NULL || dir[0] == '\0' || sink->is_async != 0)
+    {
+        errno = EINVAL;
+        return 1;
+    }
+
+    char* copy = strdup(dir);
+    if(copy == NULL)
+    {
+        return 1;
+    }
+    free(sink->spill_dir);
+    sink->spill_dir = copy;
+    return 0;
+}
+
+int smartlog_sink_set_spin(smartlog_sink_t* sink, unsigned int spin_us)
+{
+    if(sink == NULL)
+    {
+        errno = EINVAL;
+        return 1;
+    }
+
+    atomic_store(&sink->spin_us, spin_us);
+    return 0;
+}
+
+int smartlog_sink_set_huge_pages(smartlog_sink_t* sink, feature_state_t huge_pages)
+{
+    if(sink == NULL || sink->is_async != 0 ||
+       (huge_pages != FEATURE_DISABLED && huge_pages != FEATURE_ENABLED))
+    {
+        errno = EINVAL;
+        return 1;
+    }
+
+    sink->huge_pages = huge_pages;
+    return 0;
+}
+
+int smartlog_sink_set_affinity(smartlog_sink_t* sink, const int* cpus, size_t ncpus)
+{
+    if(sink == NULL || (cpus == NULL && ncpus != 0))
+    {
+        errno = EINVAL;
+        return 1;
+    }
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for(size_t i = 0; i < ncpus; i++)
+    {
+        if(cpus[i] < 0 || cpus[i] >= CPU_SETSIZE)
+        {
+            errno = EINVAL;
+            return 1;
+        }
+        CPU_SET(cpus[i], &set);
+    }
+
+    /* ncpus == 0 lifts the pinning: allow every CPU again */
+    if(ncpus == 0)
+    {
+        for(int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+        {
+            CPU_SET(cpu, &set);
+        }
+    }
+
+    if(sink->is_async != 0)
+    {
+        int err = pthread_setaffinity_np(sink->writer, sizeof(set), &set);
+        if(err != 0)
+        {
+            errno = err;
+            return 1;
+        }
+    }
+
+    sink->affinity = set;
+    sink->has_affinity = ncpus != 0;
+    return 0;
+}
+
+int smartlog_sink_submit(smartlog_sink_t* sink, const smartlog_record_t* record)
+{
+    if(sink == NULL || record == NULL || record->line == NULL)
+    {
+        errno = EINVAL;
+        return 1;
+    }
+
+    /* Filters run on the caller thread, before any copy */
+    if(record->level < sink->min_level ||
+       (sink->filter != NULL && sink->filter(record, sink->filter_arg) == 0))
+    {
+        atomic_fetch_add(&sink->filtered, 1);
+        return 0;
+    }
+
+    if(sink->is_async != 0)
+    {
+        if(record->line_len > SMARTLOG_LOG_BUFFER_SZ)
+        {
+            errno = EMSGSIZE;
+            return 1;
+        }
+        return sink_enqueue(sink, record->line, record->line_len);
+    }
+
+    struct iovec iov;
+    iov.iov_base = (void*)record->line;
+    iov.iov_len = record->line_len;
+
+    pthread_mutex_lock(&sink->write_lock);
+    int rc = sink_deliver(sink, &iov, 1);
+    int saved_errno = errno;
+    pthread_mutex_unlock(&sink->write_lock);
+
+    errno = saved_errno;
+    return rc == 0 ? 0 : 1;
+}
+
+int smartlog_sink_write_lines(smartlog_sink_t* sink, const struct iovec* iov, int iovcnt)
+{
+    if(sink == NULL || (iov == NULL && iovcnt != 0) || iovcnt < 0)
+    {
+        errno = EINVAL;
+        return 1;
+    }
+
+    if(sink->is_async != 0)
+    {
+        for(int i = 0; i < iovcnt; i++)
+        {
+            if(iov[i].iov_len > SMARTLOG_LOG_BUFFER_SZ)
+            {
+                errno = EMSGSIZE;
+                return 1;
+            }
+            (void)sink_enqueue(sink, iov[i].iov_base, iov[i].iov_len);
+        }
+        return 0;
+    }
+
+    pthread_mutex_lock(&sink->write_lock);
+    int rc = sink_deliver(sink, iov, iovcnt);
+    int saved_errno = errno;
+    pthread_mutex_unlock(&sink->write_lock);
+
+    errno = saved_errno;
+    return rc == 0 ? 0 : 1;
+}
+
+int smartlog_sink_flush(smartlog_sink_t* sink)
+{
+    if(sink == NULL)
+    {
+        errno = EINVAL;
+        return 1;
+    }
+
+    if(sink->is_async != 0)
+    {
+        /* The writer flushes the ops after every batch; wait until it has
+         * released everything reserved (or spilled) before this call */
+        uint64_t spill_target = 0;
+        uint64_t spill_done = 0;
+        if(sink->spill != NULL)
+        {
+            smartlog_spill_counts(sink->spill, &spill_target, NULL);
+        }
+        size_t target = smartlog_mpsc_head(sink->queue);
+        for(;;)
+        {
+            unsigned int seen = sink_progress_begin(sink);
+            if(sink->spill != NULL)
+            {
+                smartlog_spill_counts(sink->spill, NULL, &spill_done);
+            }
+            if(smartlog_mpsc_tail(sink->queue) - target <= SIZE_MAX / 2 && spill_done >= spill_target)
+            {
+                sink_progress_end(sink);
+                break;
+            }
+            (void)smartlog_futex_wait(&sink->progress, seen, 0);
+            sink_progress_end(sink);
+        }
+        return 0;
+    }
+
+    pthread_mutex_lock(&sink->write_lock);
+    int rc = sink_flush_ops(sink);
+    int saved_errno = errno;
+    pthread_mutex_unlock(&sink->write_lock);
+
+    errno = saved_errno;
+    return rc == 0 ? 0 : 1;
+}
+
+size_t smartlog_sink_crash_drain(smartlog_sink_t* sink)
+{
+    if(sink == NULL || sink->is_async == 0 || sink->ops->crash_fd == NULL)
+    {
+        return 0;
+    }
+
+    int fd = sink->ops->crash_fd(sink->ctx);
+    if(fd < 0)
+    {
+        return 0;
+    }
+
+    /* Queue first (older), oldest to newest, including an in-flight batch */
+    const void* elems[SMARTLOG_WRITER_BATCH];
+    size_t lens[SMARTLOG_WRITER_BATCH];
+    size_t written = 0;
+    for(;;)
+    {
+        size_t n = smartlog_mpsc_peek(sink->queue, written, elems, lens, SMARTLOG_WRITER_BATCH);
+        if(n == 0)
+        {
+            break;
+        }
+        for(size_t i = 0; i < n; i++)
+        {
+            (void)smartlog_write_all(fd, elems[i], lens[i]);
+        }
+        written += n;
+    }
+
+    if(sink->spill != NULL)
+    {
+        smartlog_spill_crash_drain(sink->spill, fd);
+    }
+    return written;
+}
+
+void smartlog_sink_get_stats(smartlog_sink_t* sink, smartlog_sink_stats_t* out)
+{
+    if(sink == NULL || out == NULL)
+    {
+        return;
+    }
+
+    out->records = atomic_load(&sink->records);
+    out->bytes = atomic_load(&sink->bytes);
+    out->filtered = atomic_load(&sink->filtered);
+    out->dropped = atomic_load(&sink->dropped);
+    out->spilled = 0;
+    if(sink->spill != NULL)
+    {
+        smartlog_spill_counts(sink->spill, &out->spilled, NULL);
+        out->dropped += smartlog_spill_lost(sink->spill);
+    }
+    out->errors = atomic_load(&sink->errors);
+    out->wakeups = sink->is_async != 0 ? smartlog_mpsc_wakeups(sink->queue) : 0;
+    out->writer_cpu = atomic_load_explicit(&sink->writer_cpu, memory_order_relaxed);
+    out->numa_node = sink->is_async != 0 ? smartlog_mpsc_numa_node(sink->queue) : -1;
+    out->queue_pages = sink->is_async != 0 ? smartlog_mpsc_page_kind(sink->queue) : PAGES_NORMAL;
+    memset(&out->sync, 0, sizeof(out->sync));
+    if(sink->ops->sync_stats != NULL)
+    {
+        sink->ops->sync_stats(sink->ctx, &out->sync);
+    }
+    out->affinity_mask = 0;
+    for(int cpu = 0; sink->has_affinity != 0 && cpu < 64; cpu++)
+    {
+        if(CPU_ISSET(cpu, &sink->affinity))
+        {
+            out->affinity_mask |= UINT64_C(1) << cpu;
+        }
+    }
+}
+
+void smartlog_sink_destroy(smartlog_sink_t* sink)
+{
+    if(sink == NULL)
+    {
+        return;
+    }
+
+    smartlog_crash_unregister(sink);
+
+    if(sink->is_async != 0)
+    {
+        /* Writer drains everything queued before it exits */
+        atomic_store(&sink->stopping, 1);
+        smartlog_mpsc_wake(sink->queue);
+        atomic_fetch_add(&sink->progress, 1);
+        smartlog_futex_wake(&sink->progress, INT_MAX);
+        pthread_join(sink->writer, NULL);
+
+        smartlog_mpsc_destroy(sink->queue);
+        smartlog_spill_close(sink->spill);
+    }
+    else
+    {
+        (void)sink_flush_ops(sink);
+    }
+
+    if(sink->ops->close != NULL)
+    {
+        sink->ops->close(sink->ctx);
+    }
+
+    pthread_mutex_destroy(&sink->write_lock);
+    free(sink->spill_dir);
+    free(sink);
+}
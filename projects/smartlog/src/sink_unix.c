@@ -0,0 +1,255 @@
+/*
+ * src/sink_unix.c
+ *
+ * Unix domain socket sink for SmartLog.
+ *
+ * Sends each line as one datagram/packet to a local collector:
+ *   - Batches from the async writer go out with one sendmmsg()
+ *   - Socket is non-blocking; a missing or full collector drops lines
+ *     (counted) instead of stalling the writer
+ *   - Reconnect is attempted at most every SMARTLOG_RECONNECT_MS
+ *
+ * Author: Aravinthraj Ganesan
+ * Version: 1.0
+ */
+
+#define _GNU_SOURCE
+#define _POSIX_C_SOURCE 199309L
+
+/* Standard includes */
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+/* Project includes */
+#include <smartlog/config.h>
+#include <smartlog/sink.h>
+#include <smartlog/utils.h>
+
+/* ============================================================================
+ * Internal Types
+ * ============================================================================ */
+
+typedef struct {
+    struct sockaddr_un addr;
+    int sock_type;
+    int fd;                     /* -1 while disconnected */
+    uint64_t next_connect_ns;   /* Monotonic time of next reconnect try */
+} unix_sink_t;
+
+/* ============================================================================
+ * Connection Helpers
+ * ============================================================================ */
+
+static void unix_sink_disconnect(unix_sink_t* us)
+{
+    if(us->fd >= 0)
+    {
+        close(us->fd);
+        us->fd = -1;
+    }
+    us->next_connect_ns = smartlog_monotonic_ns() + (uint64_t)SMARTLOG_RECONNECT_MS * UINT64_C(1000000);
+}
+
+/**
+ * Try to (re)connect if the backoff allows it. Never blocks.
+ *
+ * Return: 0 if connected, -1 if not (caller drops the batch)
+ */
+static int unix_sink_connect(unix_sink_t* us)
+{
+    if(us->fd >= 0)
+    {
+        return 0;
+    }
+    if(smartlog_monotonic_ns() < us->next_connect_ns)
+    {
+        return -1;
+    }
+
+    int fd = socket(AF_UNIX, us->sock_type | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if(fd < 0)
+    {
+        unix_sink_disconnect(us);
+        return -1;
+    }
+
+    if(connect(fd, (const struct sockaddr*)&us->addr, sizeof(us->addr)) != 0)
+    {
+        /* ENOENT / ECONNREFUSED: collector not there; EAGAIN: backlog full */
+        close(fd);
+        unix_sink_disconnect(us);
+        return -1;
+    }
+
+    us->fd = fd;
+    return 0;
+}
+
+/**
+ * Errors that mean the collector went away and we should reconnect.
+ */
+static int unix_sink_is_peer_gone(int err)
+{
+    return err == ECONNREFUSED || err == ENOTCONN || err == EPIPE ||
+           err == ECONNRESET || err == ENOENT || err == EDESTADDRREQ;
+}
+
+/* ============================================================================
+ * Sink Operations
+ * ============================================================================ */
+
+static int unix_sink_writev(void* ctx, const struct iovec* iov, int iovcnt)
+{
+    unix_sink_t* us = (unix_sink_t*)ctx;
+
+    if(unix_sink_connect(us) != 0)
+    {
+        return 0;
+    }
+
+    struct mmsghdr msgs[SMARTLOG_WRITER_BATCH];
+    int sent_total = 0;
+
+    while(sent_total < iovcnt)
+    {
+        int chunk = iovcnt - sent_total;
+        if(chunk > SMARTLOG_WRITER_BATCH)
+        {
+            chunk = SMARTLOG_WRITER_BATCH;
+        }
+
+        memset(msgs, 0, sizeof(msgs[0]) * (size_t)chunk);
+        for(int i = 0; i < chunk; i++)
+        {
+            msgs[i].msg_hdr.msg_iov = (struct iovec*)&iov[sent_total + i];
+            msgs[i].msg_hdr.msg_iovlen = 1;
+        }
+
+        int sent = sendmmsg(us->fd, msgs, (unsigned int)chunk, MSG_DONTWAIT | MSG_NOSIGNAL);
+        if(sent < 0)
+        {
+            if(errno == EINTR)
+            {
+                continue;
+            }
+            if(errno == EAGAIN || errno == EWOULDBLOCK || errno == ENOBUFS)
+            {
+                /* Collector is behind: drop the rest of this batch */
+                return sent_total;
+            }
+            if(unix_sink_is_peer_gone(errno))
+            {
+                unix_sink_disconnect(us);
+                return sent_total;
+            }
+            return -1;
+        }
+
+        sent_total += sent;
+        if(sent < chunk)
+        {
+            /* Partial batch: retry, the next call reports why it stopped */
+            continue;
+        }
+    }
+
+    return sent_total;
+}
+
+static int unix_sink_write(void* ctx, const char* data, size_t len)
+{
+    struct iovec iov;
+    iov.iov_base = (void*)data;
+    iov.iov_len = len;
+    return unix_sink_writev(ctx, &iov, 1) < 0 ? -1 : 0;
+}
+
+static void unix_sink_close(void* ctx)
+{
+    unix_sink_t* us = (unix_sink_t*)ctx;
+    if(us->fd >= 0)
+    {
+        close(us->fd);
+    }
+    free(us);
+}
+
+static int unix_sink_crash_fd(void* ctx)
+{
+    /* Connected socket: one write() per line is one datagram */
+    return ((unix_sink_t*)ctx)->fd;
+}
+
+static const smartlog_sink_ops_t unix_sink_ops = {
+    .write = unix_sink_write,
+    .writev = unix_sink_writev,
+    .flush = NULL,
+    .close = unix_sink_close,
+    .crash_fd = unix_sink_crash_fd,
+};
+
+/* ============================================================================
+ * Public API
+ * ============================================================================ */
+
+smartlog_sink_t* smartlog_sink_unix_open(
+    const char* socket_path,
+    int sock_type,
+    size_t queue_capacity
+)
+{
+    if(socket_path == NULL || socket_path[0] == '\0' ||
+       (sock_type != SOCK_DGRAM && sock_type != SOCK_SEQPACKET))
+    {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    unix_sink_t* us = calloc(1, sizeof(*us));
+    if(us == NULL)
+    {
+        return NULL;
+    }
+
+    size_t len = strlen(socket_path);
+    if(len >= sizeof(us->addr.sun_path))
+    {
+        free(us);
+        errno = ENAMETOOLONG;
+        return NULL;
+    }
+
+    us->addr.sun_family = AF_UNIX;
+    memcpy(us->addr.sun_path, socket_path, len + 1);
+    us->sock_type = sock_type;
+    us->fd = -1;
+    us->next_connect_ns = 0;
+
+    /* First connect is best effort; the writer retries later */
+    (void)unix_sink_connect(us);
+
+    smartlog_sink_t* sink = smartlog_sink_create(&unix_sink_ops, us);
+    if(sink == NULL)
+    {
+        int saved_errno = errno;
+        unix_sink_close(us);
+        errno = saved_errno;
+        return NULL;
+    }
+
+    if(smartlog_sink_set_async(sink, queue_capacity, OVERFLOW_DROP) != 0)
+    {
+        int saved_errno = errno;
+        smartlog_sink_destroy(sink);
+        errno = saved_errno;
+        return NULL;
+    }
+
+    return sink;
+}
@@ -0,0 +1,298 @@
+/*
+ * src/smartlog_archive.c
+ *
+ * Seekable compressed archives of rotated SmartLog files.
+ *
+ * Command-line usage:
+ *   smartlog_archive train <dict_file> <sample_log> [<sample_log> ...] [--max-size <bytes>]
+ *   smartlog_archive pack <log_file> <archive> [--block-size <bytes>] [--dict <dict_file>]
+ *   smartlog_archive list <archive>
+ *   smartlog_archive query <archive> [--from <ns>] [--to <ns>] [--threads <n>] [--dict <dict_file>]
+ *
+ * Commands:
+ *   train: Build a compression dictionary from sample logs and store it
+ *          next to them, for packing small blocks
+ *   pack: Compress a plain log (e.g. "<file>.1" after rotation) into
+ *         independently compressed blocks plus a block index
+ *   list: Print the block index (offsets, sizes, timestamp ranges)
+ *   query: Print the lines in a timestamp range, decompressing only the
+ *          blocks that overlap it, in parallel
+ *
+ * Author: Aravinthraj Ganesan
+ * Version: 1.0
+ */
+
+#define _GNU_SOURCE
+#define _POSIX_C_SOURCE 199309L
+
+/* ============================================================================
+ * Standard Includes
+ * ============================================================================ */
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* ============================================================================
+ * Project Includes
+ * ============================================================================ */
+
+#include <smartlog/archive.h>
+#include <smartlog/config.h>
+#include <smartlog/utils.h>
+
+#define SMARTLOG_ARCHIVE_USAGE \
+    "Usage: ./smartlog_archive train <dict_file> <sample_log> [<sample_log> ...] [--max-size <bytes>]\n" \
+    "       ./smartlog_archive pack <log_file> <archive> [--block-size <bytes>] [--dict <dict_file>]\n" \
+    "       ./smartlog_archive list <archive>\n" \
+    "       ./smartlog_archive query <archive> [--from <ns>] [--to <ns>] [--threads <n>] [--dict <dict_file>]\n"
+
+/* ============================================================================
+ * Helper Functions
+ * ============================================================================ */
+
+static int write_usage(const char* error_msg)
+{
+    (void)smartlog_write_all(STDERR_FILENO, error_msg, strlen(error_msg));
+    return 2;
+}
+
+/**
+ * Parse an unsigned 64-bit option value.
+ *
+ * Return: 0 on success, -1 if not an integer
+ */
+static int parse_u64(const char* text, uint64_t* out)
+{
+    char* endpoint = NULL;
+    errno = 0;
+    unsigned long long value = strtoull(text, &endpoint, 10);
+    if(endpoint == text || *endpoint != '\0' || errno == ERANGE || text[0] == '-')
+    {
+        return -1;
+    }
+    *out = (uint64_t)value;
+    return 0;
+}
+
+/* ============================================================================
+ * Commands
+ * ============================================================================ */
+
+static int cmd_train(int argc, char* argv[])
+{
+    if(argc < 4)
+    {
+        return write_usage(SMARTLOG_ARCHIVE_USAGE);
+    }
+
+    const char** samples = calloc((size_t)argc, sizeof(*samples));
+    if(samples == NULL)
+    {
+        perror("calloc");
+        return 1;
+    }
+
+    size_t nsamples = 0;
+    uint64_t max_size = 0;
+    for(int arg_idx = 3; arg_idx < argc; arg_idx++)
+    {
+        if(strcmp(argv[arg_idx], "--max-size") == 0)
+        {
+            if(argc <= (arg_idx + 1) || parse_u64(argv[++arg_idx], &max_size) != 0 ||
+               max_size < 256 || max_size > SMARTLOG_DICT_MAX)
+            {
+                free(samples);
+                return write_usage("Error: --max-size requires an integer from 256 to 32768\n");
+            }
+        }
+        else
+        {
+            samples[nsamples++] = argv[arg_idx];
+        }
+    }
+
+    size_t dict_len = 0;
+    int result = 0;
+    if(nsamples == 0)
+    {
+        result = write_usage(SMARTLOG_ARCHIVE_USAGE);
+    }
+    else if(smartlog_archive_train(samples, nsamples, argv[2], (size_t)max_size, &dict_len) != 0)
+    {
+        perror("smartlog_archive_train");
+        result = 1;
+    }
+    else
+    {
+        printf("dictionary=%s bytes=%zu\n", argv[2], dict_len);
+    }
+
+    free(samples);
+    return result;
+}
+
+static int cmd_pack(int argc, char* argv[])
+{
+    if(argc < 4)
+    {
+        return write_usage(SMARTLOG_ARCHIVE_USAGE);
+    }
+
+    uint64_t block_size = 0;
+    const char* dict_path = NULL;
+    for(int arg_idx = 4; arg_idx < argc; arg_idx++)
+    {
+        if(strcmp(argv[arg_idx], "--block-size") == 0)
+        {
+            if(argc <= (arg_idx + 1) || parse_u64(argv[++arg_idx], &block_size) != 0 ||
+               block_size < 4096 || block_size > (UINT32_MAX / 2))
+                return write_usage("Error: --block-size requires an integer from 4096 to 2147483647\n");
+        }
+        else if(strcmp(argv[arg_idx], "--dict") == 0)
+        {
+            if(argc <= (arg_idx + 1))
+                return write_usage("Error: --dict requires a path\n");
+
+            dict_path = argv[++arg_idx];
+        }
+        else
+        {
+            return write_usage("Error: Unknown option.\n" SMARTLOG_ARCHIVE_USAGE);
+        }
+    }
+
+    smartlog_archive_stats_t st;
+    if(smartlog_archive_pack_dict(argv[2], argv[3], (size_t)block_size, dict_path, &st) != 0)
+    {
+        perror("smartlog_archive_pack");
+        return 1;
+    }
+
+    printf("blocks=%llu lines=%llu raw_bytes=%llu archive_bytes=%llu ratio=%.2f\n",
+           (unsigned long long)st.blocks, (unsigned long long)st.lines,
+           (unsigned long long)st.raw_bytes, (unsigned long long)st.comp_bytes,
+           st.comp_bytes != 0 ? (double)st.raw_bytes / (double)st.comp_bytes : 0.0);
+    return 0;
+}
+
+static int cmd_list(int argc, char* argv[])
+{
+    if(argc != 3)
+    {
+        return write_usage(SMARTLOG_ARCHIVE_USAGE);
+    }
+
+    smartlog_archive_t* archive = smartlog_archive_open(argv[2]);
+    if(archive == NULL)
+    {
+        perror("smartlog_archive_open");
+        return 1;
+    }
+
+    printf("%-6s %12s %10s %10s %8s %20s %20s\n", "block", "offset", "comp", "raw", "lines", "min_ns", "max_ns");
+    for(size_t i = 0; i < smartlog_archive_block_count(archive); i++)
+    {
+        smartlog_archive_block_t b;
+        (void)smartlog_archive_block_info(archive, i, &b);
+        printf("%-6zu %12llu %10u %10u %8u %20llu %20llu\n", i, (unsigned long long)b.offset,
+               b.comp_len, b.raw_len, b.lines, (unsigned long long)b.min_ns, (unsigned long long)b.max_ns);
+    }
+
+    smartlog_archive_close(archive);
+    return 0;
+}
+
+static int cmd_query(int argc, char* argv[])
+{
+    if(argc < 3)
+    {
+        return write_usage(SMARTLOG_ARCHIVE_USAGE);
+    }
+
+    uint64_t from_ns = 0;
+    uint64_t to_ns = UINT64_MAX;
+    uint64_t threads = 0;
+    const char* dict_path = NULL;
+    for(int arg_idx = 3; arg_idx < argc; arg_idx++)
+    {
+        if(strcmp(argv[arg_idx], "--from") == 0)
+        {
+            if(argc <= (arg_idx + 1) || parse_u64(argv[++arg_idx], &from_ns) != 0)
+                return write_usage("Error: --from requires an integer\n");
+        }
+        else if(strcmp(argv[arg_idx], "--to") == 0)
+        {
+            if(argc <= (arg_idx + 1) || parse_u64(argv[++arg_idx], &to_ns) != 0)
+                return write_usage("Error: --to requires an integer\n");
+        }
+        else if(strcmp(argv[arg_idx], "--threads") == 0)
+        {
+            if(argc <= (arg_idx + 1) || parse_u64(argv[++arg_idx], &threads) != 0 ||
+               threads == 0 || threads > 1024)
+                return write_usage("Error: --threads requires an integer from 1 to 1024\n");
+        }
+        else if(strcmp(argv[arg_idx], "--dict") == 0)
+        {
+            if(argc <= (arg_idx + 1))
+                return write_usage("Error: --dict requires a path\n");
+
+            dict_path = argv[++arg_idx];
+        }
+        else
+        {
+            return write_usage("Error: Unknown option.\n" SMARTLOG_ARCHIVE_USAGE);
+        }
+    }
+
+    smartlog_archive_t* archive = smartlog_archive_open_dict(argv[2], dict_path);
+    if(archive == NULL)
+    {
+        perror("smartlog_archive_open");
+        return 1;
+    }
+
+    int result = 0;
+    if(smartlog_archive_query(archive, from_ns, to_ns, (unsigned int)threads, STDOUT_FILENO) != 0)
+    {
+        perror("smartlog_archive_query");
+        result = 1;
+    }
+
+    smartlog_archive_close(archive);
+    return result;
+}
+
+/* ============================================================================
+ * Main Entry Point
+ * ============================================================================ */
+
+int main(int argc, char* argv[])
+{
+    if(argc < 2)
+    {
+        return write_usage(SMARTLOG_ARCHIVE_USAGE);
+    }
+
+    if(strcmp(argv[1], "train") == 0)
+    {
+        return cmd_train(argc, argv);
+    }
+    if(strcmp(argv[1], "pack") == 0)
+    {
+        return cmd_pack(argc, argv);
+    }
+    if(strcmp(argv[1], "list") == 0)
+    {
+        return cmd_list(argc, argv);
+    }
+    if(strcmp(argv[1], "query") == 0)
+    {
+        return cmd_query(argc, argv);
+    }
+
+    return write_usage("Error: Unknown command.\n" SMARTLOG_ARCHIVE_USAGE);
+}
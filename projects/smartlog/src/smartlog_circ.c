@@ -0,0 +1,154 @@
+/*
+ * src/smartlog_circ.c
+ *
+ * Unroll a circular SmartLog file (smartlog_sink_circ_open()).
+ *
+ * Prints the records oldest first, as plain log lines, so the output can
+ * go to the other SmartLog tools. Safe to run while a writer is active.
+ *
+ * Command-line usage:
+ *   smartlog_circ <file> [--info]
+ *
+ * Options:
+ *   --info: Print the file state (capacity, head, tail, records, wraps)
+ *           instead of the records
+ *
+ * Author: Aravinthraj Ganesan
+ * Version: 1.0
+ */
+
+#define _GNU_SOURCE
+#define _POSIX_C_SOURCE 199309L
+
+/* ============================================================================
+ * Standard Includes
+ * ============================================================================ */
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+/* ============================================================================
+ * Project Includes
+ * ============================================================================ */
+
+#include <smartlog/circfile.h>
+#include <smartlog/utils.h>
+
+#define SMARTLOG_CIRC_USAGE \
+    "Usage: ./smartlog_circ <file> [--info]\n"
+
+#define CIRC_OUT_BUF  (64u << 10)
+
+/* ============================================================================
+ * Types
+ * ============================================================================ */
+
+/** Output buffer, written to stdout when full */
+typedef struct {
+    char buf[CIRC_OUT_BUF];
+    size_t len;
+    int failed;
+} circ_out_t;
+
+/* ============================================================================
+ * Helper Functions
+ * ============================================================================ */
+
+static int write_usage(const char* error_msg)
+{
+    (void)smartlog_write_all(STDERR_FILENO, error_msg, strlen(error_msg));
+    return 2;
+}
+
+static int out_flush(circ_out_t* out)
+{
+    if(out->len != 0 && smartlog_write_all(STDOUT_FILENO, out->buf, out->len) != 0)
+    {
+        out->failed = 1;
+    }
+    out->len = 0;
+    return out->failed != 0 ? -1 : 0;
+}
+
+static int print_record(const char* line, size_t len, uint64_t number, void* arg)
+{
+    circ_out_t* out = (circ_out_t*)arg;
+    (void)number;
+
+    if(CIRC_OUT_BUF - out->len < len && out_flush(out) != 0)
+    {
+        return 1;
+    }
+    memcpy(out->buf + out->len, line, len);
+    out->len += len;
+    return 0;
+}
+
+/** --info: walk the records (to check them) without printing */
+static int skip_record(const char* line, size_t len, uint64_t number, void* arg)
+{
+    (void)line;
+    (void)len;
+    (void)number;
+    (void)arg;
+    return 0;
+}
+
+/* ============================================================================
+ * Main Entry Point
+ * ============================================================================ */
+
+int main(int argc, char* argv[])
+{
+    /* ====================================================================
+     * STEP 1: Parse Command-Line Options
+     * ==================================================================== */
+    if(argc < 2 || argc > 3)
+    {
+        return write_usage(SMARTLOG_CIRC_USAGE);
+    }
+
+    int info_only = 0;
+    if(argc == 3)
+    {
+        if(strcmp(argv[2], "--info") != 0)
+        {
+            return write_usage("Error: Unknown option.\n" SMARTLOG_CIRC_USAGE);
+        }
+        info_only = 1;
+    }
+
+    /* ====================================================================
+     * STEP 2: Unroll the File
+     * ==================================================================== */
+    static circ_out_t out;
+    smartlog_circfile_info_t info;
+    smartlog_circfile_fn fn = info_only != 0 ? skip_record : print_record;
+    if(smartlog_circfile_read(argv[1], fn, &out, &info) != 0)
+    {
+        perror("smartlog_circfile_read");
+        return 1;
+    }
+    if(out_flush(&out) != 0)
+    {
+        perror("write");
+        return 1;
+    }
+
+    if(info_only != 0)
+    {
+        printf("capacity=%llu head=%llu tail=%llu records=%llu wraps=%llu written=%llu damaged=%llu\n",
+               (unsigned long long)info.capacity, (unsigned long long)info.head,
+               (unsigned long long)info.tail, (unsigned long long)info.records,
+               (unsigned long long)info.wraps, (unsigned long long)info.written,
+               (unsigned long long)info.damaged);
+    }
+    else if(info.damaged != 0)
+    {
+        fprintf(stderr, "smartlog_circ: stopped at a damaged record, %llu records not printed\n",
+                (unsigned long long)info.damaged);
+    }
+
+    return 0;
+}
@@ -0,0 +1,404 @@
+/*
+ * src/smartlog_columns.c
+ *
+ * Columnar export of SmartLog files and queries over it.
+ *
+ * Command-line usage:
+ *   smartlog_columns export <log_file> <col_file> [--threads <n>]
+ *   smartlog_columns info <col_file>
+ *   smartlog_columns count <col_file> [--by pid|minute|pid-minute] [--from <ns>] [--to <ns>]
+ *
+ * Commands:
+ *   export: Parse a plain log in parallel and write it column by column
+ *   info: Print rows, time range and the encoded size of every column
+ *   count: Count timed lines per PID, per minute or per PID per minute
+ *          (default), decoding only the time and/or pid columns
+ *
+ * Author: Aravinthraj Ganesan
+ * Version: 1.0
+ */
+
+#define _GNU_SOURCE
+#define _POSIX_C_SOURCE 199309L
+
+/* ============================================================================
+ * Standard Includes
+ * ============================================================================ */
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* ============================================================================
+ * Project Includes
+ * ============================================================================ */
+
+#include <smartlog/columns.h>
+#include <smartlog/config.h>
+#include <smartlog/utils.h>
+
+#define SMARTLOG_COLUMNS_USAGE \
+    "Usage: ./smartlog_columns export <log_file> <col_file> [--threads <n>]\n" \
+    "       ./smartlog_columns info <col_file>\n" \
+    "       ./smartlog_columns count <col_file> [--by pid|minute|pid-minute] [--from <ns>] [--to <ns>]\n"
+
+#define NS_PER_MINUTE  60000000000ull
+
+/* ============================================================================
+ * Types
+ * ============================================================================ */
+
+/** One (minute, pid) group of the count command */
+typedef struct {
+    uint64_t minute;
+    int32_t pid;
+    int used;
+    uint64_t lines;
+} count_group_t;
+
+typedef struct {
+    count_group_t* slots;
+    size_t cap;
+    size_t used;
+} count_table_t;
+
+/* ============================================================================
+ * Helper Functions
+ * ============================================================================ */
+
+static int write_usage(const char* error_msg)
+{
+    (void)smartlog_write_all(STDERR_FILENO, error_msg, strlen(error_msg));
+    return 2;
+}
+
+/**
+ * Parse an unsigned 64-bit option value.
+ *
+ * Return: 0 on success, -1 if not an integer
+ */
+static int parse_u64(const char* text, uint64_t* out)
+{
+    char* endpoint = NULL;
+    errno = 0;
+    unsigned long long value = strtoull(text, &endpoint, 10);
+    if(endpoint == text || *endpoint != '\0' || errno == ERANGE || text[0] == '-')
+    {
+        return -1;
+    }
+    *out = (uint64_t)value;
+    return 0;
+}
+
+static size_t group_hash(uint64_t minute, int32_t pid, size_t mask)
+{
+    uint64_t h = (minute * 0x9E3779B97F4A7C15ull) ^ ((uint64_t)(uint32_t)pid * 0xC2B2AE3D27D4EB4Full);
+    return (size_t)(h >> 17) & mask;
+}
+
+/**
+ * Find or add the group of (minute, pid).
+ *
+ * Return: Group, or NULL if the table could not grow
+ */
+static count_group_t* count_group(count_table_t* t, uint64_t minute, int32_t pid)
+{
+    if((t->used + 1) * 2 > t->cap)
+    {
+        size_t cap = t->cap != 0 ? t->cap * 2 : 1024;
+        count_group_t* slots = calloc(cap, sizeof(*slots));
+        if(slots == NULL)
+        {
+            return NULL;
+        }
+        for(size_t i = 0; i < t->cap; i++)
+        {
+            if(t->slots[i].used)
+            {
+                size_t s = group_hash(t->slots[i].minute, t->slots[i].pid, cap - 1);
+                while(slots[s].used)
+                {
+                    s = (s + 1) & (cap - 1);
+                }
+                slots[s] = t->slots[i];
+            }
+        }
+        free(t->slots);
+        t->slots = slots;
+        t->cap = cap;
+    }
+
+    size_t s = group_hash(minute, pid, t->cap - 1);
+    while(t->slots[s].used && (t->slots[s].minute != minute || t->slots[s].pid != pid))
+    {
+        s = (s + 1) & (t->cap - 1);
+    }
+    if(!t->slots[s].used)
+    {
+        t->slots[s].used = 1;
+        t->slots[s].minute = minute;
+        t->slots[s].pid = pid;
+        t->used++;
+    }
+    return &t->slots[s];
+}
+
+static int group_cmp(const void* a, const void* b)
+{
+    const count_group_t* ga = (const count_group_t*)a;
+    const count_group_t* gb = (const count_group_t*)b;
+    if(ga->minute != gb->minute)
+    {
+        return ga->minute < gb->minute ? -1 : 1;
+    }
+    return (ga->pid > gb->pid) - (ga->pid < gb->pid);
+}
+
+/* ============================================================================
+ * Commands
+ * ============================================================================ */
+
+static int cmd_export(int argc, char* argv[])
+{
+    if(argc < 4)
+    {
+        return write_usage(SMARTLOG_COLUMNS_USAGE);
+    }
+
+    uint64_t threads = 0;
+    for(int arg_idx = 4; arg_idx < argc; arg_idx++)
+    {
+        if(strcmp(argv[arg_idx], "--threads") == 0)
+        {
+            if(argc <= (arg_idx + 1) || parse_u64(argv[++arg_idx], &threads) != 0 ||
+               threads == 0 || threads > 1024)
+                return write_usage("Error: --threads requires an integer from 1 to 1024\n");
+        }
+        else
+        {
+            return write_usage("Error: Unknown option.\n" SMARTLOG_COLUMNS_USAGE);
+        }
+    }
+
+    smartlog_colfile_info_t info;
+    if(smartlog_colfile_export(argv[2], argv[3], (unsigned int)threads, &info) != 0)
+    {
+        perror("smartlog_colfile_export");
+        return 1;
+    }
+
+    printf("rows=%llu untimed=%llu raw_bytes=%llu file_bytes=%llu\n",
+           (unsigned long long)info.rows, (unsigned long long)info.untimed,
+           (unsigned long long)info.raw_bytes, (unsigned long long)info.file_bytes);
+    return 0;
+}
+
+static int cmd_info(int argc, char* argv[])
+{
+    static const char* const names[SMARTLOG_COL_COUNT] = {
+        "time", "pid", "tid", "seq", "msg_offsets", "msg_blob"
+    };
+
+    if(argc != 3)
+    {
+        return write_usage(SMARTLOG_COLUMNS_USAGE);
+    }
+
+    smartlog_colfile_t* cf = smartlog_colfile_open(argv[2]);
+    if(cf == NULL)
+    {
+        perror("smartlog_colfile_open");
+        return 1;
+    }
+
+    smartlog_colfile_info_t info;
+    smartlog_colfile_get_info(cf, &info);
+    printf("rows=%llu untimed=%llu min_ns=%llu max_ns=%llu file_bytes=%llu\n",
+           (unsigned long long)info.rows, (unsigned long long)info.untimed,
+           (unsigned long long)info.min_ns, (unsigned long long)info.max_ns,
+           (unsigned long long)info.file_bytes);
+    for(int id = 0; id < SMARTLOG_COL_COUNT; id++)
+    {
+        printf("%-12s %12llu bytes %6.2f bytes/row\n", names[id], (unsigned long long)info.column_bytes[id],
+               info.rows != 0 ? (double)info.column_bytes[id] / (double)info.rows : 0.0);
+    }
+
+    smartlog_colfile_close(cf);
+    return 0;
+}
+
+static int cmd_count(int argc, char* argv[])
+{
+    if(argc < 3)
+    {
+        return write_usage(SMARTLOG_COLUMNS_USAGE);
+    }
+
+    int by_pid = 1;
+    int by_minute = 1;
+    uint64_t from_ns = 0;
+    uint64_t to_ns = UINT64_MAX;
+    for(int arg_idx = 3; arg_idx < argc; arg_idx++)
+    {
+        if(strcmp(argv[arg_idx], "--by") == 0)
+        {
+            if(argc <= (arg_idx + 1))
+                return write_usage("Error: --by requires pid, minute or pid-minute\n");
+
+            const char* by = argv[++arg_idx];
+            by_pid = strcmp(by, "pid") == 0 || strcmp(by, "pid-minute") == 0;
+            by_minute = strcmp(by, "minute") == 0 || strcmp(by, "pid-minute") == 0;
+            if(!by_pid && !by_minute)
+                return write_usage("Error: --by requires pid, minute or pid-minute\n");
+        }
+        else if(strcmp(argv[arg_idx], "--from") == 0)
+        {
+            if(argc <= (arg_idx + 1) || parse_u64(argv[++arg_idx], &from_ns) != 0)
+                return write_usage("Error: --from requires an integer\n");
+        }
+        else if(strcmp(argv[arg_idx], "--to") == 0)
+        {
+            if(argc <= (arg_idx + 1) || parse_u64(argv[++arg_idx], &to_ns) != 0)
+                return write_usage("Error: --to requires an integer\n");
+        }
+        else
+        {
+            return write_usage("Error: Unknown option.\n" SMARTLOG_COLUMNS_USAGE);
+        }
+    }
+
+    smartlog_colfile_t* cf = smartlog_colfile_open(argv[2]);
+    if(cf == NULL)
+    {
+        perror("smartlog_colfile_open");
+        return 1;
+    }
+
+    /* ====================================================================
+     * STEP 1: Decode Only the Columns the Grouping Needs
+     * ==================================================================== */
+    smartlog_colfile_info_t info;
+    smartlog_colfile_get_info(cf, &info);
+    size_t rows = (size_t)info.rows;
+    int need_time = by_minute || from_ns != 0 || to_ns != UINT64_MAX;
+    uint64_t* time_ns = need_time ? malloc((rows + 1) * sizeof(*time_ns)) : NULL;
+    int32_t* pid = by_pid ? malloc((rows + 1) * sizeof(*pid)) : NULL;
+    count_table_t table;
+    memset(&table, 0, sizeof(table));
+    int result = 1;
+
+    if((need_time && time_ns == NULL) || (by_pid && pid == NULL))
+    {
+        perror("malloc");
+        goto done;
+    }
+    if((need_time && smartlog_colfile_read_time(cf, time_ns) != 0) ||
+       (by_pid && smartlog_colfile_read_pid(cf, pid) != 0))
+    {
+        perror("smartlog_colfile_read");
+        goto done;
+    }
+
+    /* ====================================================================
+     * STEP 2: Group (Untimed Rows Are Continuations and Not Counted)
+     * ==================================================================== */
+    count_group_t* last = NULL;
+    for(size_t i = 0; i < rows; i++)
+    {
+        uint64_t minute = 0;
+        int32_t row_pid = 0;
+        if(need_time)
+        {
+            if(time_ns[i] == 0 || time_ns[i] < from_ns || time_ns[i] > to_ns)
+            {
+                continue;
+            }
+            minute = by_minute ? time_ns[i] / NS_PER_MINUTE : 0;
+        }
+        if(by_pid)
+        {
+            if(pid[i] < 0)
+            {
+                continue;
+            }
+            row_pid = pid[i];
+        }
+
+        /* Logs are mostly in time order: most rows hit the previous group */
+        if(last == NULL || last->minute != minute || last->pid != row_pid)
+        {
+            last = count_group(&table, minute, row_pid);
+            if(last == NULL)
+            {
+                perror("calloc");
+                goto done;
+            }
+        }
+        last->lines++;
+    }
+
+    /* ====================================================================
+     * STEP 3: Print Sorted by Minute, Then PID
+     * ==================================================================== */
+    size_t ngroups = 0;
+    for(size_t i = 0; i < table.cap; i++)
+    {
+        if(table.slots[i].used)
+        {
+            table.slots[ngroups++] = table.slots[i];
+        }
+    }
+    qsort(table.slots, ngroups, sizeof(*table.slots), group_cmp);
+
+    for(size_t i = 0; i < ngroups; i++)
+    {
+        const count_group_t* g = &table.slots[i];
+        if(by_minute)
+        {
+            printf("minute_ns=%llu ", (unsigned long long)(g->minute * NS_PER_MINUTE));
+        }
+        if(by_pid)
+        {
+            printf("pid=%d ", (int)g->pid);
+        }
+        printf("lines=%llu\n", (unsigned long long)g->lines);
+    }
+    result = 0;
+
+done:
+    free(table.slots);
+    free(time_ns);
+    free(pid);
+    smartlog_colfile_close(cf);
+    return result;
+}
+
+/* ============================================================================
+ * Main Entry Point
+ * ============================================================================ */
+
+int main(int argc, char* argv[])
+{
+    if(argc < 2)
+    {
+        return write_usage(SMARTLOG_COLUMNS_USAGE);
+    }
+
+    if(strcmp(argv[1], "export") == 0)
+    {
+        return cmd_export(argc, argv);
+    }
+    if(strcmp(argv[1], "info") == 0)
+    {
+        return cmd_info(argc, argv);
+    }
+    if(strcmp(argv[1], "count") == 0)
+    {
+        return cmd_count(argc, argv);
+    }
+
+    return write_usage("Error: Unknown command.\n" SMARTLOG_COLUMNS_USAGE);
+}
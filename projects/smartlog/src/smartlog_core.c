@@ -25,6 +25,7 @@
  * ============================================================================ */
 
 #include <fcntl.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdint.h>
 #include <unistd.h>
@@ -39,12 +40,21 @@
 
 #include <smartlog/utils.h>
 #include <smartlog/config.h>
+#include <smartlog/fd_cache.h>
 #include <smartlog/smartlog_core.h>
 
 /* ============================================================================
  * Internal Helpers
  * ============================================================================ */
 
+/**
+ * Rotate to "<file>.1" if this entry would cross the limit.
+ *
+ * The rename is done relative to the parent directory, which is returned
+ * open in *dir_fd (caller closes it; -1 if no rotation) so the new file
+ * can be created and the directory synced without resolving the path
+ * again.
+ */
 static int smartlog_rotate_if_needed(
     const char* file_path,
     feature_state_t max_bytes_config,
@@ -53,10 +63,10 @@ static int smartlog_rotate_if_needed(
     const struct stat* fstat_old,
     int* file1_exist,
     int* stat1_errno,
-    int* rotated
+    int* dir_fd
 )
 {
-    *rotated = 0;
+    *dir_fd = -1;
 
     if(max_bytes_config != FEATURE_ENABLED || *file1_exist != 0)
     {
@@ -83,21 +93,22 @@ static int smartlog_rotate_if_needed(
         return 1;
     }
 
-    /*
-     * Remove existing .1 backup file if it exists (we'll replace it).
-     * Ignore ENOENT error (file doesn't exist).
-     */
-    if(unlink(new_path) < 0)
+    const char* name = NULL;
+    int dir = smartlog_open_parent_dir(file_path, &name);
+    if(dir < 0)
     {
-        if(errno != ENOENT)
-        {
-            return 1;
-        }
+        return 1;
     }
 
-    /* Rename current log file to .1 backup */
-    if(rename(file_path, new_path) < 0)
+    /*
+     * Rename current log file to .1 backup. renameat() replaces an
+     * existing backup atomically, so no unlink is needed first.
+     */
+    if(renameat(dir, name, dir, new_path + (name - file_path)) < 0)
     {
+        int saved_errno = errno;
+        close(dir);
+        errno = saved_errno;
         return 1;
     }
 
@@ -107,15 +118,347 @@ static int smartlog_rotate_if_needed(
      */
     *stat1_errno = ENOENT;
     *file1_exist = -1;
-    *rotated = 1;
+    *dir_fd = dir;
 
     return 0;
 }
 
+/**
+ * Close fd and dir_fd (if open) keeping errno. Return: 1
+ */
+static int smartlog_fail_close(int fd, int dir_fd)
+{
+    int saved_errno = errno;
+    if(fd >= 0)
+    {
+        close(fd);
+    }
+    if(dir_fd >= 0)
+    {
+        close(dir_fd);
+    }
+    errno = saved_errno;
+    return 1;
+}
+
+/* ============================================================================
+ * Cached Write Path
+ * ============================================================================ */
+
+/* Serializes rotations of cached paths, so two threads never both rotate */
+static pthread_mutex_t cached_rotate_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * smartlog_write_log_entry() with the descriptor from the fd cache: no
+ * open/close per call, and the size check uses fstat() on the descriptor.
+ */
+static int write_log_entry_cached(
+    const char* file_path,
+    const char* line,
+    int log_len,
+    feature_state_t durable,
+    feature_state_t max_bytes_config,
+    unsigned long max_byte_val
+)
+{
+    smartlog_fd_ref_t ref;
+    if(smartlog_fd_cache_acquire(file_path, &ref) != 0)
+    {
+        return 1;
+    }
+    int metadata_changed = ref.created;
+    int dir_fd = -1;
+
+    /* ====================================================================
+     * STEP 1: Rotate if This Entry Would Exceed the Limit
+     * ==================================================================== */
+    if(max_bytes_config == FEATURE_ENABLED && !ref.created)
+    {
+        struct stat st;
+        if(fstat(ref.fd, &st) != 0)
+        {
+            int saved_errno = errno;
+            smartlog_fd_cache_release(&ref, 1);
+            errno = saved_errno;
+            return 1;
+        }
+
+        if((unsigned long long)st.st_size + (unsigned long long)log_len > max_byte_val)
+        {
+            pthread_mutex_lock(&cached_rotate_lock);
+
+            /* Rotate only if the path still names our file (no other thread did) */
+            struct stat cur;
+            int rc = 0;
+            if(stat(file_path, &cur) == 0 && (uint64_t)cur.st_dev == ref.dev && (uint64_t)cur.st_ino == ref.ino)
+            {
+                int file1_exist = 0;
+                int stat1_errno = 0;
+                rc = smartlog_rotate_if_needed(file_path, max_bytes_config, max_byte_val, log_len,
+                                               &st, &file1_exist, &stat1_errno, &dir_fd);
+            }
+            int saved_errno = errno;
+            smartlog_fd_cache_release(&ref, 1);
+            if(rc != 0)
+            {
+                pthread_mutex_unlock(&cached_rotate_lock);
+                errno = saved_errno;
+                return 1;
+            }
+
+            rc = smartlog_fd_cache_acquire(file_path, &ref);
+            pthread_mutex_unlock(&cached_rotate_lock);
+            if(rc != 0)
+            {
+                return smartlog_fail_close(-1, dir_fd);
+            }
+            metadata_changed = metadata_changed || dir_fd >= 0 || ref.created;
+        }
+    }
+
+    /* ====================================================================
+     * STEP 2: Write and Optionally Sync
+     * ==================================================================== */
+    int rc = smartlog_write_all(ref.fd, line, (size_t)log_len);
+    if(rc == 0 && durable == FEATURE_ENABLED)
+    {
+        /* The directory is already open after a rotation */
+        rc = fdatasync(ref.fd);
+        if(rc == 0 && metadata_changed != 0)
+        {
+            rc = dir_fd >= 0 ? fsync(dir_fd) : smartlog_fsync_parent_dir(file_path);
+        }
+    }
+
+    int saved_errno = errno;
+    smartlog_fd_cache_release(&ref, rc != 0);
+    if(dir_fd >= 0)
+    {
+        close(dir_fd);
+    }
+    errno = saved_errno;
+    return rc != 0 ? 1 : 0;
+}
+
 /* ============================================================================
  * Core Logging Implementation
  * ============================================================================ */
 
+/**
+ * Format a line, with "[TID = ] [SEQ = ]" fields when with_ids is set,
+ * followed by ctx_len bytes of encoded context fields.
+ */
+static int format_line(
+    char* out,
+    size_t out_sz,
+    uint64_t time_ns,
+    pid_t pid,
+    int with_ids,
+    pid_t tid,
+    uint64_t seq,
+    const char* ctx,
+    size_t ctx_len,
+    const char* msg
+)
+{
+    if(out == NULL || msg == NULL || msg[0] == '\0')
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    /* 
+     * Enforce message length limit - truncate if necessary and append "..."
+     * to indicate truncation.
+     */
+    char buff[SMARTLOG_MSG_MAX_LEN + 1];
+    if(strlen(msg) > SMARTLOG_MSG_MAX_LEN)
+    {
+        memcpy(buff, msg, (SMARTLOG_MSG_MAX_LEN - 3));
+        memcpy(buff + (SMARTLOG_MSG_MAX_LEN - 3), "...", 3);
+        buff[SMARTLOG_MSG_MAX_LEN] = '\0';
+        msg = buff;
+    }
+
+    int log_len;
+    if(with_ids && ctx_len != 0)
+    {
+        /* Context is already encoded: only the numbers are formatted, the
+         * context and message are copied as they are */
+        int head_len = snprintf(
+            out,
+            out_sz,
+            "[%llu ns] [PID = %ld] [TID = %ld] [SEQ = %llu] ",
+            (unsigned long long)time_ns,
+            (long)pid,
+            (long)tid,
+            (unsigned long long)seq
+        );
+        if(head_len < 0 || (size_t)head_len >= out_sz)
+        {
+            errno = EOVERFLOW;
+            return -1;
+        }
+
+        static const char msg_tag[] = "[MESSAGE = ";
+        size_t msg_len = strlen(msg);
+        size_t total = (size_t)head_len + ctx_len + (sizeof(msg_tag) - 1) + msg_len + 2;
+        if(total >= out_sz)
+        {
+            errno = EOVERFLOW;
+            return -1;
+        }
+        char* p = out + head_len;
+        memcpy(p, ctx, ctx_len);
+        p += ctx_len;
+        memcpy(p, msg_tag, sizeof(msg_tag) - 1);
+        p += sizeof(msg_tag) - 1;
+        memcpy(p, msg, msg_len);
+        p += msg_len;
+        memcpy(p, "]\n", 3);
+        log_len = (int)total;
+    }
+    else if(with_ids)
+    {
+        log_len = snprintf(
+            out,
+            out_sz,
+            "[%llu ns] [PID = %ld] [TID = %ld] [SEQ = %llu] [MESSAGE = %s]\n",
+            (unsigned long long)time_ns,
+            (long)pid,
+            (long)tid,
+            (unsigned long long)seq,
+            msg
+        );
+    }
+    else
+    {
+        log_len = snprintf(
+            out,
+            out_sz,
+            "[%llu ns] [PID = %ld] [MESSAGE = %s]\n",
+            (unsigned long long)time_ns,
+            (long)pid,
+            msg
+        );
+    }
+
+    /* Verify snprintf didn't fail or truncate output buffer */
+    if(log_len < 0 || ((size_t)log_len >= out_sz))
+    {
+        errno = EOVERFLOW;
+        return -1;
+    }
+
+    return log_len;
+}
+
+int smartlog_format_entry(
+    char* out,
+    size_t out_sz,
+    uint64_t time_ns,
+    pid_t pid,
+    const char* msg
+)
+{
+    return format_line(out, out_sz, time_ns, pid, 0, 0, 0, NULL, 0, msg);
+}
+
+int smartlog_format_record(
+    char* out,
+    size_t out_sz,
+    uint64_t time_ns,
+    pid_t pid,
+    pid_t tid,
+    uint64_t seq,
+    const char* msg
+)
+{
+    return format_line(out, out_sz, time_ns, pid, 1, tid, seq, NULL, 0, msg);
+}
+
+int smartlog_format_record_ctx(
+    char* out,
+    size_t out_sz,
+    uint64_t time_ns,
+    pid_t pid,
+    pid_t tid,
+    uint64_t seq,
+    const char* ctx,
+    size_t ctx_len,
+    const char* msg
+)
+{
+    if(ctx == NULL && ctx_len != 0)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+    return format_line(out, out_sz, time_ns, pid, 1, tid, seq, ctx, ctx_len, msg);
+}
+
+int smartlog_line_timestamp(const char* line, size_t len, uint64_t* time_ns)
+{
+    if(line == NULL || time_ns == NULL || len < 5 || line[0] != '[')
+    {
+        return -1;
+    }
+
+    uint64_t value = 0;
+    size_t pos = 1;
+    while(pos < len && line[pos] >= '0' && line[pos] <= '9')
+    {
+        value = (value * 10u) + (uint64_t)(line[pos] - '0');
+        pos++;
+    }
+
+    /* Need at least one digit followed by " ns]" */
+    if(pos == 1 || pos + 4 > len || memcmp(line + pos, " ns]", 4) != 0)
+    {
+        return -1;
+    }
+
+    *time_ns = value;
+    return 0;
+}
+
+int smartlog_line_seq(const char* line, size_t len, uint64_t* seq)
+{
+    static const char tag[] = "] [SEQ = ";
+    const size_t tag_len = sizeof(tag) - 1;
+
+    if(line == NULL || seq == NULL)
+    {
+        return -1;
+    }
+
+    /* Only look in the header, before the message text starts */
+    const char* msg = memmem(line, len, "] [MESSAGE = ", 13);
+    size_t header_len = msg != NULL ? (size_t)(msg - line) : len;
+
+    const char* field = memmem(line, header_len, tag, tag_len);
+    if(field == NULL)
+    {
+        return -1;
+    }
+
+    size_t pos = (size_t)(field - line) + tag_len;
+    size_t start = pos;
+    uint64_t value = 0;
+    while(pos < len && line[pos] >= '0' && line[pos] <= '9')
+    {
+        value = (value * 10u) + (uint64_t)(line[pos] - '0');
+        pos++;
+    }
+    if(pos == start || pos >= len || line[pos] != ']')
+    {
+        return -1;
+    }
+
+    *seq = value;
+    return 0;
+}
+
 int smartlog_write_log_entry(
     const char* file_path,
     const char* msg,
@@ -133,9 +476,6 @@ int smartlog_write_log_entry(
     /* ====================================================================
      * STEP 1: Validate Log Message and Check File Existence
      * ==================================================================== */
-    /* Extract and validate the log message */
-    size_t msg_len = strlen(msg);
-
     /* Message must not be empty - check for empty string */
     if(msg[0] == '\0')
     {
@@ -143,6 +483,24 @@ int smartlog_write_log_entry(
         return 1;
     }
 
+    /* Process-wide fd cache enabled: keep the descriptor open across calls */
+    if(smartlog_fd_cache_enabled())
+    {
+        char line[SMARTLOG_LOG_BUFFER_SZ];
+        errno = 0;
+        uint64_t now_ns = smartlog_timestamp_ns();
+        if(now_ns == 0 && errno != 0)
+        {
+            return 1;
+        }
+        int line_len = smartlog_format_entry(line, sizeof(line), now_ns, getpid(), msg);
+        if(line_len < 0)
+        {
+            return 1;
+        }
+        return write_log_entry_cached(file_path, line, line_len, durable, max_bytes_config, max_byte_val);
+    }
+
     /* 
      * Check whether the log file path already exists using stat().
      * This determines whether we're appending or creating new.
@@ -179,20 +537,6 @@ int smartlog_write_log_entry(
      * Uses buffer on the stack with SMARTLOG_LOG_BUFFER_SZ capacity.
      */
     char log_buffer[SMARTLOG_LOG_BUFFER_SZ];
-    int log_len = 0; 
-    char buff[SMARTLOG_MSG_MAX_LEN + 1];
-
-    /* 
-     * Enforce message length limit - truncate if necessary and append "..."
-     * to indicate truncation.
-     */
-    if(msg_len > SMARTLOG_MSG_MAX_LEN)
-    {
-        memcpy(buff, msg, (SMARTLOG_MSG_MAX_LEN - 3));
-        memcpy(buff + (SMARTLOG_MSG_MAX_LEN - 3), "...", 3);
-        buff[SMARTLOG_MSG_MAX_LEN] = '\0';
-        msg = buff;
-    }
 
     /* Get current timestamp in nanoseconds */
     errno = 0;
@@ -201,24 +545,13 @@ int smartlog_write_log_entry(
     {
         return 1;
     }
-    pid_t pid = getpid();   
-    
-    /* Format the complete log entry: [timestamp] [PID] [message] */
-    log_len = snprintf(
-        log_buffer,
-        sizeof(log_buffer),
-        "[%llu ns] [PID = %ld] [MESSAGE = %s]\n",
-        (unsigned long long)time_ns,
-        (long)pid,
-        msg
-    );
 
-    /* Verify snprintf didn't fail or truncate output buffer */
-    if(log_len < 0 || (log_len >= (int)sizeof(log_buffer)))
+    /* Format the complete log entry: [timestamp] [PID] [message] */
+    int log_len = smartlog_format_entry(log_buffer, sizeof(log_buffer), time_ns, getpid(), msg);
+    if(log_len < 0)
     {
-        errno = EOVERFLOW;
         return 1;
-    }   
+    }
 
     /* ====================================================================
      * STEP 3: Handle Log Rotation if Enabled
@@ -228,7 +561,7 @@ int smartlog_write_log_entry(
      * check whether adding this log entry would exceed the limit.
      * If so, rotate the log file by renaming current to .1 backup.
      */
-    int rotated = 0;
+    int dir_fd = -1;
     if(smartlog_rotate_if_needed(
         file_path,
         max_bytes_config,
@@ -237,7 +570,7 @@ int smartlog_write_log_entry(
         &fstat_old,
         &file1_exist,
         &stat1_errno,
-        &rotated
+        &dir_fd
     ) != 0)
     {
         return 1;
@@ -261,17 +594,29 @@ int smartlog_write_log_entry(
      */
     int flag = O_WRONLY | O_CREAT | O_APPEND;
 
-    /* Attempt to open the file with the specified flags and permissions */
-    int fd = open(file_path, flag, mode);
+    /*
+     * Attempt to open the file with the specified flags and permissions.
+     * After a rotation the parent is open already: create relative to it.
+     */
+    int fd;
+    if(dir_fd >= 0)
+    {
+        const char* slash = strrchr(file_path, '/');
+        fd = openat(dir_fd, slash != NULL ? slash + 1 : file_path, flag, mode);
+    }
+    else
+    {
+        fd = open(file_path, flag, mode);
+    }
 
     /* Verify open() succeeded */
     if(fd < 0)
     {
-        return 1;
+        return smartlog_fail_close(-1, dir_fd);
     }
 
     /* Parent dir sync is only needed when metadata changed (create/rename). */
-    int metadata_changed = rotated;
+    int metadata_changed = dir_fd >= 0;
     if(file1_exist != 0 && stat1_errno == ENOENT)
     {
         metadata_changed = 1;
@@ -286,10 +631,7 @@ int smartlog_write_log_entry(
      */
     if(smartlog_write_all(fd, log_buffer, (size_t)log_len) != 0)
     {
-        int saved_errno = errno;
-        close(fd);
-        errno = saved_errno;
-        return 1;
+        return smartlog_fail_close(fd, dir_fd);
     }
 
     /* ====================================================================
@@ -305,19 +647,17 @@ int smartlog_write_log_entry(
         /* Sync file data to disk */
         if(fdatasync(fd) != 0)
         {
-            int saved_errno = errno;
-            close(fd);
-            errno = saved_errno;
-            return 1;
+            return smartlog_fail_close(fd, dir_fd);
         }
 
-        /* Sync parent directory metadata only if we created/renamed entries. */
-        if(metadata_changed != 0 && smartlog_fsync_parent_dir(file_path) != 0)
+        /*
+         * Sync parent directory metadata only if we created/renamed entries
+         * (through the fd kept open by a rotation, if there was one).
+         */
+        if(metadata_changed != 0 &&
+           (dir_fd >= 0 ? fsync(dir_fd) : smartlog_fsync_parent_dir(file_path)) != 0)
         {
-            int saved_errno = errno;
-            close(fd);
-            errno = saved_errno;
-            return 1;
+            return smartlog_fail_close(fd, dir_fd);
         }
     }
 
@@ -325,6 +665,10 @@ int smartlog_write_log_entry(
      * STEP 8: Close File and Return Success
      * ==================================================================== */
     /* Close file descriptor - all operations complete */
+    if(dir_fd >= 0)
+    {
+        close(dir_fd);
+    }
     if(close(fd) < 0)
     {
         return 1;
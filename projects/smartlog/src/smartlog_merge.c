@@ -0,0 +1,139 @@
+/*
+ * src/smartlog_merge.c
+ *
+ * Merge SmartLog files into one globally ordered stream.
+ *
+ * Reads every input together with its rotated generations (<file>.N ...
+ * <file>.1, <file>) and writes one stream ordered by timestamp, using the
+ * "[SEQ = ]" field to order lines with equal timestamps. Memory use is one
+ * line and one read buffer per input, whatever the file sizes.
+ *
+ * Command-line usage:
+ *   smartlog_merge <file> [<file> ...] [--output <path>]
+ *
+ * Options:
+ *   --output <path>: Write to a file instead of stdout
+ *
+ * Author: Aravinthraj Ganesan
+ * Version: 1.0
+ */
+
+#define _GNU_SOURCE
+#define _POSIX_C_SOURCE 199309L
+
+/* ============================================================================
+ * Standard Includes
+ * ============================================================================ */
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* ============================================================================
+ * Project Includes
+ * ============================================================================ */
+
+#include <smartlog/config.h>
+#include <smartlog/merge.h>
+#include <smartlog/utils.h>
+
+#define SMARTLOG_MERGE_USAGE \
+    "Usage: ./smartlog_merge <file> [<file> ...] [--output <path>]\n"
+
+/* ============================================================================
+ * Helper Functions
+ * ============================================================================ */
+
+static int write_usage(const char* error_msg)
+{
+    (void)smartlog_write_all(STDERR_FILENO, error_msg, strlen(error_msg));
+    return 2;
+}
+
+/* ============================================================================
+ * Main Entry Point
+ * ============================================================================ */
+
+int main(int argc, char* argv[])
+{
+    /* ====================================================================
+     * STEP 1: Parse Command-Line Options
+     * ==================================================================== */
+    if(argc < 2)
+    {
+        return write_usage(SMARTLOG_MERGE_USAGE);
+    }
+
+    const char** paths = calloc((size_t)argc, sizeof(*paths));
+    if(paths == NULL)
+    {
+        perror("calloc");
+        return 1;
+    }
+
+    size_t npaths = 0;
+    const char* output_path = NULL;
+    for(int arg_idx = 1; arg_idx < argc; arg_idx++)
+    {
+        if(strcmp(argv[arg_idx], "--output") == 0)
+        {
+            if(argc <= (arg_idx + 1))
+            {
+                free(paths);
+                return write_usage("Error: --output requires a path\n");
+            }
+            output_path = argv[++arg_idx];
+        }
+        else if(strncmp(argv[arg_idx], "--", 2) == 0)
+        {
+            free(paths);
+            return write_usage("Error: Unknown option.\n" SMARTLOG_MERGE_USAGE);
+        }
+        else
+        {
+            paths[npaths++] = argv[arg_idx];
+        }
+    }
+
+    if(npaths == 0)
+    {
+        free(paths);
+        return write_usage(SMARTLOG_MERGE_USAGE);
+    }
+
+    /* ====================================================================
+     * STEP 2: Open the Output
+     * ==================================================================== */
+    int out_fd = STDOUT_FILENO;
+    if(output_path != NULL)
+    {
+        out_fd = open(output_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, SMARTLOG_FILE_MODE);
+        if(out_fd < 0)
+        {
+            perror(output_path);
+            free(paths);
+            return 1;
+        }
+    }
+
+    /* ====================================================================
+     * STEP 3: Merge
+     * ==================================================================== */
+    int result = 0;
+    if(smartlog_merge_files(paths, npaths, out_fd, NULL) != 0)
+    {
+        perror("smartlog_merge_files");
+        result = 1;
+    }
+
+    if(output_path != NULL && close(out_fd) != 0 && result == 0)
+    {
+        perror("close");
+        result = 1;
+    }
+
+    free(paths);
+    return result;
+}
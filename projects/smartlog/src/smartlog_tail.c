@@ -0,0 +1,128 @@
+/*
+ * src/smartlog_tail.c
+ *
+ * Follow a SmartLog file like `tail -F`, across rotation.
+ *
+ * Waits on inotify (no polling interval), reads the old file to EOF
+ * before switching to the new one after a rotation, and decodes LZ4
+ * files (smartlog_sink_lz4_open()) as they grow.
+ *
+ * Command-line usage:
+ *   smartlog_tail <file> [--from-start]
+ *
+ * Options:
+ *   --from-start: Print the current content first (default: only what
+ *                 is written from now on)
+ *
+ * Author: Aravinthraj Ganesan
+ * Version: 1.0
+ */
+
+#define _GNU_SOURCE
+#define _POSIX_C_SOURCE 199309L
+
+/* ============================================================================
+ * Standard Includes
+ * ============================================================================ */
+
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+/* ============================================================================
+ * Project Includes
+ * ============================================================================ */
+
+#include <smartlog/tail.h>
+#include <smartlog/utils.h>
+
+/* ============================================================================
+ * Global Variables
+ * ============================================================================ */
+
+/** Set to 1 when SIGINT/SIGTERM is caught */
+static volatile sig_atomic_t stop = 0;
+
+#define SMARTLOG_TAIL_USAGE \
+    "Usage: ./smartlog_tail <file> [--from-start]\n"
+
+/* ============================================================================
+ * Helper Functions
+ * ============================================================================ */
+
+static int write_usage(const char* error_msg)
+{
+    (void)smartlog_write_all(STDERR_FILENO, error_msg, strlen(error_msg));
+    return 2;
+}
+
+static void signal_handle(int sig)
+{
+    (void)sig;
+    stop = 1;
+}
+
+/* ============================================================================
+ * Main Entry Point
+ * ============================================================================ */
+
+int main(int argc, char* argv[])
+{
+    /* ====================================================================
+     * STEP 1: Register Signal Handlers
+     * ==================================================================== */
+    /* No SA_RESTART: poll() must return so the loop sees the stop flag */
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = signal_handle;
+    if(sigemptyset(&sa.sa_mask) != 0 ||
+       sigaction(SIGINT, &sa, NULL) != 0 ||
+       sigaction(SIGTERM, &sa, NULL) != 0)
+    {
+        perror("sigaction");
+        return 1;
+    }
+
+    /* ====================================================================
+     * STEP 2: Parse Command-Line Options
+     * ==================================================================== */
+    if(argc < 2 || argc > 3)
+    {
+        return write_usage(SMARTLOG_TAIL_USAGE);
+    }
+
+    int from_start = 0;
+    if(argc == 3)
+    {
+        if(strcmp(argv[2], "--from-start") != 0)
+        {
+            return write_usage("Error: Unknown option.\n" SMARTLOG_TAIL_USAGE);
+        }
+        from_start = 1;
+    }
+
+    /* ====================================================================
+     * STEP 3: Follow Until Stopped
+     * ==================================================================== */
+    smartlog_tail_t* tail = smartlog_tail_open(argv[1], from_start);
+    if(tail == NULL)
+    {
+        perror("smartlog_tail_open");
+        return 1;
+    }
+
+    int result = 0;
+    while(stop == 0)
+    {
+        if(smartlog_tail_poll(tail, STDOUT_FILENO, -1) != 0)
+        {
+            perror("smartlog_tail_poll");
+            result = 1;
+            break;
+        }
+    }
+
+    smartlog_tail_close(tail);
+    return result;
+}
@@ -0,0 +1,191 @@
+/*
+ * src/smartlogd.c
+ *
+ * SmartLog local collector daemon.
+ *
+ * Receives finished log lines from many local processes (see
+ * smartlog_sink_unix_open() and smartlog_sink_shm_open()) and writes them
+ * to one file:
+ *   - Lines are merged in timestamp order within a reorder window
+ *   - Output is written in batches, one fdatasync per batch (--durable)
+ *   - Only the daemon rotates the file (--max-bytes)
+ *
+ * Command-line usage:
+ *   smartlogd <socket_path> <output_file> [--durable] [--max-bytes <size>]
+ *             [--window-ms <ms>] [--ring-socket <path>] [--huge-pages]
+ *
+ * Options:
+ *   --ring-socket <path>: Also accept shared-memory ring clients here
+ *   --huge-pages: Back the line slots with huge pages when available
+ *
+ * SIGINT/SIGTERM drain everything held and exit.
+ *
+ * Author: Aravinthraj Ganesan
+ * Version: 1.0
+ */
+
+#define _GNU_SOURCE
+#define _POSIX_C_SOURCE 199309L
+
+/* ============================================================================
+ * Standard Includes
+ * ============================================================================ */
+
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* ============================================================================
+ * Project Includes
+ * ============================================================================ */
+
+#include <smartlog/collector.h>
+#include <smartlog/config.h>
+#include <smartlog/utils.h>
+
+/* ============================================================================
+ * Global Variables
+ * ============================================================================ */
+
+/** Set to 1 when SIGINT/SIGTERM is caught */
+static volatile sig_atomic_t stop = 0;
+
+#define SMARTLOGD_USAGE \
+    "Usage: ./smartlogd <socket_path> <output_file> [--durable] [--max-bytes <size>] [--window-ms <ms>] [--ring-socket <path>] [--huge-pages]\n"
+
+/* ============================================================================
+ * Helper Functions
+ * ============================================================================ */
+
+static int write_usage(const char* error_msg)
+{
+    (void)smartlog_write_all(STDERR_FILENO, error_msg, strlen(error_msg));
+    return 2;
+}
+
+static void signal_handle(int sig)
+{
+    (void)sig;
+    stop = 1;
+}
+
+/**
+ * Parse a positive unsigned long option value.
+ *
+ * Return: 0 on success, -1 if not a positive integer
+ */
+static int parse_positive(const char* text, unsigned long* out)
+{
+    char* endpoint = NULL;
+    errno = 0;
+    unsigned long value = strtoul(text, &endpoint, 10);
+    if(endpoint == text || *endpoint != '\0' || errno == ERANGE || value == 0)
+    {
+        return -1;
+    }
+    *out = value;
+    return 0;
+}
+
+/* ============================================================================
+ * Main Entry Point
+ * ============================================================================ */
+
+int main(int argc, char* argv[])
+{
+    /* ====================================================================
+     * STEP 1: Register Signal Handlers
+     * ==================================================================== */
+    /* No SA_RESTART: poll() must return so the loop sees the stop flag */
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = signal_handle;
+    if(sigemptyset(&sa.sa_mask) != 0 ||
+       sigaction(SIGINT, &sa, NULL) != 0 ||
+       sigaction(SIGTERM, &sa, NULL) != 0)
+    {
+        perror("sigaction");
+        return 1;
+    }
+
+    /* ====================================================================
+     * STEP 2: Parse Command-Line Options
+     * ==================================================================== */
+    if(argc < 3)
+    {
+        return write_usage(SMARTLOGD_USAGE);
+    }
+
+    smartlog_collector_config_t cfg;
+    smartlog_collector_config_init(&cfg);
+    cfg.socket_path = argv[1];
+    cfg.output_path = argv[2];
+
+    for(int arg_idx = 3; arg_idx < argc; arg_idx++)
+    {
+        unsigned long value = 0;
+
+        if(strcmp(argv[arg_idx], "--durable") == 0)
+        {
+            cfg.durable = FEATURE_ENABLED;
+        }
+        else if(strcmp(argv[arg_idx], "--max-bytes") == 0)
+        {
+            if(argc <= (arg_idx + 1) || parse_positive(argv[++arg_idx], &value) != 0)
+                return write_usage("Error: --max-bytes requires a positive integer\n");
+
+            cfg.max_bytes_config = FEATURE_ENABLED;
+            cfg.max_byte_val = value;
+        }
+        else if(strcmp(argv[arg_idx], "--window-ms") == 0)
+        {
+            if(argc <= (arg_idx + 1) || parse_positive(argv[++arg_idx], &value) != 0)
+                return write_usage("Error: --window-ms requires a positive integer\n");
+
+            cfg.reorder_window_ms = (unsigned int)value;
+        }
+        else if(strcmp(argv[arg_idx], "--huge-pages") == 0)
+        {
+            cfg.huge_pages = FEATURE_ENABLED;
+        }
+        else if(strcmp(argv[arg_idx], "--ring-socket") == 0)
+        {
+            if(argc <= (arg_idx + 1))
+                return write_usage("Error: --ring-socket requires a path\n");
+
+            cfg.ring_socket_path = argv[++arg_idx];
+        }
+        else
+        {
+            return write_usage("Error: Unknown option.\n" SMARTLOGD_USAGE);
+        }
+    }
+
+    /* ====================================================================
+     * STEP 3: Run the Collector Until Asked to Stop
+     * ==================================================================== */
+    smartlog_collector_t* collector = smartlog_collector_create(&cfg);
+    if(collector == NULL)
+    {
+        perror("smartlog_collector_create");
+        return 1;
+    }
+
+    int result = 0;
+    while(stop == 0)
+    {
+        if(smartlog_collector_run_once(collector, 1000) != 0)
+        {
+            perror("smartlog_collector_run_once");
+            result = 1;
+            break;
+        }
+    }
+
+    /* Destroy drains every held line before closing the file */
+    smartlog_collector_destroy(collector);
+    return result;
+}
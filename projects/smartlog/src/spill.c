@@ -0,0 +1,400 @@
+/*
+ * src/spill.c
+ *
+ * Spill file implementation for SmartLog async sinks.
+ *
+ * Implements:
+ *   - Unnamed temporary file (O_TMPFILE, or mkstemp + unlink)
+ *   - Staged appends written in large sequential chunks
+ *   - In-order replay in batches, then truncate and leave spill mode
+ *
+ * Producers only hold the lock to copy into the stage (and, once per
+ * SMARTLOG_SPILL_CHUNK, to write the stage out). Replay reads with pread()
+ * outside the lock; only the writer thread touches the read side.
+ *
+ * Author: Aravinthraj Ganesan
+ * Version: 1.0
+ */
+
+#define _GNU_SOURCE
+#define _POSIX_C_SOURCE 199309L
+
+/* Standard includes */
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* Project includes */
+#include <smartlog/config.h>
+#include <smartlog/spill.h>
+#include <smartlog/utils.h>
+
+/* ============================================================================
+ * Internal Types
+ * ============================================================================ */
+
+#define SPILL_REC_HDR sizeof(uint32_t)
+
+struct smartlog_spill {
+    int fd;
+    pthread_mutex_t lock;
+    atomic_int active;
+
+    /* Append side (under lock) */
+    char* stage;
+    size_t stage_len;
+    uint64_t stage_lines;
+    uint64_t write_off;
+
+    /* Replay side (writer only) */
+    uint64_t read_off;
+    uint64_t mark_off;
+    char* replay_buf;
+
+    /* Counters */
+    atomic_uint_fast64_t appended;
+    atomic_uint_fast64_t replayed;
+    atomic_uint_fast64_t lost;
+};
+
+/* ============================================================================
+ * Helper Functions
+ * ============================================================================ */
+
+/**
+ * Create an unnamed file in dir.
+ *
+ * Return: File descriptor, or -1 on error (errno is set)
+ */
+static int spill_create_file(const char* dir)
+{
+    int fd = open(dir, O_TMPFILE | O_RDWR | O_CLOEXEC, S_IRUSR | S_IWUSR);
+    if(fd >= 0)
+    {
+        return fd;
+    }
+
+    /* Filesystems without O_TMPFILE: create, then unlink at once */
+    char path[SMARTLOG_PATH_MAX_LEN];
+    if(snprintf(path, sizeof(path), "%s/smartlog-spill-XXXXXX", dir) >= (int)sizeof(path))
+    {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+    fd = mkostemp(path, O_CLOEXEC);
+    if(fd < 0)
+    {
+        return -1;
+    }
+    (void)unlink(path);
+    return fd;
+}
+
+/**
+ * Write the stage at write_off. Caller holds the lock.
+ *
+ * Return: 0 on success, -1 on error (staged lines are counted as lost)
+ */
+static int spill_write_stage(smartlog_spill_t* spill)
+{
+    size_t done = 0;
+    while(done < spill->stage_len)
+    {
+        ssize_t n = pwrite(spill->fd, spill->stage + done, spill->stage_len - done,
+                           (off_t)(spill->write_off + done));
+        if(n < 0)
+        {
+            if(errno == EINTR)
+            {
+                continue;
+            }
+            atomic_fetch_add(&spill->lost, spill->stage_lines);
+            spill->stage_len = 0;
+            spill->stage_lines = 0;
+            return -1;
+        }
+        done += (size_t)n;
+    }
+
+    spill->write_off += spill->stage_len;
+    spill->stage_len = 0;
+    spill->stage_lines = 0;
+    return 0;
+}
+
+/**
+ * Empty the file and leave spill mode. Caller holds the lock.
+ */
+static void spill_reset(smartlog_spill_t* spill)
+{
+    (void)ftruncate(spill->fd, 0);
+    spill->write_off = 0;
+    spill->read_off = 0;
+    spill->mark_off = 0;
+    atomic_store(&spill->active, 0);
+}
+
+/* ============================================================================
+ * Public API
+ * ============================================================================ */
+
+smartlog_spill_t* smartlog_spill_open(const char* dir)
+{
+    smartlog_spill_t* spill = calloc(1, sizeof(*spill));
+    if(spill == NULL)
+    {
+        return NULL;
+    }
+
+    spill->fd = -1;
+    pthread_mutex_init(&spill->lock, NULL);
+    atomic_init(&spill->active, 0);
+    atomic_init(&spill->appended, 0);
+    atomic_init(&spill->replayed, 0);
+    atomic_init(&spill->lost, 0);
+
+    spill->stage = malloc(SMARTLOG_SPILL_CHUNK);
+    spill->replay_buf = malloc(SMARTLOG_SPILL_CHUNK);
+    if(spill->stage == NULL || spill->replay_buf == NULL)
+    {
+        smartlog_spill_close(spill);
+        errno = ENOMEM;
+        return NULL;
+    }
+
+    spill->fd = spill_create_file(dir != NULL ? dir : SMARTLOG_SPILL_DIR);
+    if(spill->fd < 0)
+    {
+        int saved_errno = errno;
+        smartlog_spill_close(spill);
+        errno = saved_errno;
+        return NULL;
+    }
+
+    return spill;
+}
+
+int smartlog_spill_active(const smartlog_spill_t* spill)
+{
+    return atomic_load(&((smartlog_spill_t*)spill)->active);
+}
+
+int smartlog_spill_append(smartlog_spill_t* spill, const void* data, size_t len)
+{
+    if(len > SMARTLOG_LOG_BUFFER_SZ)
+    {
+        errno = EMSGSIZE;
+        return -1;
+    }
+
+    int rc = 0;
+    uint32_t rec_len = (uint32_t)len;
+
+    pthread_mutex_lock(&spill->lock);
+
+    /* Stage full: one large sequential write */
+    if(spill->stage_len + SPILL_REC_HDR + len > SMARTLOG_SPILL_CHUNK)
+    {
+        rc = spill_write_stage(spill);
+    }
+
+    memcpy(spill->stage + spill->stage_len, &rec_len, SPILL_REC_HDR);
+    memcpy(spill->stage + spill->stage_len + SPILL_REC_HDR, data, len);
+    spill->stage_len += SPILL_REC_HDR + len;
+    spill->stage_lines++;
+    atomic_fetch_add(&spill->appended, 1);
+    atomic_store(&spill->active, 1);
+
+    int saved_errno = errno;
+    pthread_mutex_unlock(&spill->lock);
+    errno = saved_errno;
+
+    return rc;
+}
+
+int smartlog_spill_mark(smartlog_spill_t* spill)
+{
+    int rc = 0;
+
+    pthread_mutex_lock(&spill->lock);
+    if(spill->stage_len != 0)
+    {
+        rc = spill_write_stage(spill);
+    }
+    spill->mark_off = spill->write_off;
+    int saved_errno = errno;
+    pthread_mutex_unlock(&spill->lock);
+    errno = saved_errno;
+
+    return rc;
+}
+
+long smartlog_spill_replay(smartlog_spill_t* spill, smartlog_spill_fn fn, void* arg)
+{
+    struct iovec iov[SMARTLOG_WRITER_BATCH];
+    long total = 0;
+
+    while(spill->read_off < spill->mark_off)
+    {
+        size_t want = spill->mark_off - spill->read_off;
+        if(want > SMARTLOG_SPILL_CHUNK)
+        {
+            want = SMARTLOG_SPILL_CHUNK;
+        }
+
+        ssize_t got = pread(spill->fd, spill->replay_buf, want, (off_t)spill->read_off);
+        if(got < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if(got <= 0)
+        {
+            goto fail;
+        }
+
+        /* Hand over every whole record in the chunk */
+        size_t pos = 0;
+        int count = 0;
+        while(pos + SPILL_REC_HDR <= (size_t)got)
+        {
+            uint32_t rec_len;
+            memcpy(&rec_len, spill->replay_buf + pos, SPILL_REC_HDR);
+            if(rec_len > SMARTLOG_LOG_BUFFER_SZ)
+            {
+                errno = EIO;
+                goto fail;
+            }
+            if(pos + SPILL_REC_HDR + rec_len > (size_t)got)
+            {
+                break;
+            }
+
+            iov[count].iov_base = spill->replay_buf + pos + SPILL_REC_HDR;
+            iov[count].iov_len = rec_len;
+            pos += SPILL_REC_HDR + rec_len;
+            if(++count == SMARTLOG_WRITER_BATCH)
+            {
+                fn(arg, iov, count);
+                atomic_fetch_add(&spill->replayed, (uint64_t)count);
+                total += count;
+                count = 0;
+            }
+        }
+        if(count != 0)
+        {
+            fn(arg, iov, count);
+            atomic_fetch_add(&spill->replayed, (uint64_t)count);
+            total += count;
+        }
+        if(pos == 0)
+        {
+            /* Not even one record in a full chunk: the file is corrupt */
+            errno = EIO;
+            goto fail;
+        }
+        spill->read_off += pos;
+    }
+
+    /* Caught up and nothing new staged: truncate and leave spill mode */
+    pthread_mutex_lock(&spill->lock);
+    if(spill->read_off == spill->write_off && spill->stage_len == 0)
+    {
+        spill_reset(spill);
+    }
+    pthread_mutex_unlock(&spill->lock);
+
+    return total;
+
+fail:
+    {
+        int saved_errno = errno != 0 ? errno : EIO;
+        pthread_mutex_lock(&spill->lock);
+        uint64_t settled = atomic_load(&spill->replayed) + atomic_load(&spill->lost);
+        atomic_fetch_add(&spill->lost, atomic_load(&spill->appended) - settled);
+        spill->stage_len = 0;
+        spill->stage_lines = 0;
+        spill_reset(spill);
+        pthread_mutex_unlock(&spill->lock);
+        errno = saved_errno;
+        return -1;
+    }
+}
+
+void smartlog_spill_counts(const smartlog_spill_t* spill, uint64_t* appended, uint64_t* settled)
+{
+    smartlog_spill_t* sp = (smartlog_spill_t*)spill;
+
+    /* Settled first: it never runs ahead of appended */
+    uint64_t done = atomic_load(&sp->replayed) + atomic_load(&sp->lost);
+    if(settled != NULL)
+    {
+        *settled = done;
+    }
+    if(appended != NULL)
+    {
+        *appended = atomic_load(&sp->appended);
+    }
+}
+
+uint64_t smartlog_spill_lost(const smartlog_spill_t* spill)
+{
+    return atomic_load(&((smartlog_spill_t*)spill)->lost);
+}
+
+void smartlog_spill_crash_drain(const smartlog_spill_t* spill, int fd)
+{
+    char line[SMARTLOG_LOG_BUFFER_SZ];
+    uint64_t off = spill->read_off;
+    uint64_t end = spill->write_off;
+
+    /* Written part: one record at a time, small stack buffer */
+    while(off + SPILL_REC_HDR <= end)
+    {
+        uint32_t rec_len;
+        if(pread(spill->fd, &rec_len, SPILL_REC_HDR, (off_t)off) != (ssize_t)SPILL_REC_HDR ||
+           rec_len > sizeof(line) ||
+           pread(spill->fd, line, rec_len, (off_t)(off + SPILL_REC_HDR)) != (ssize_t)rec_len)
+        {
+            break;
+        }
+        (void)smartlog_write_all(fd, line, rec_len);
+        off += SPILL_REC_HDR + rec_len;
+    }
+
+    /* Staged part: still in memory */
+    size_t pos = 0;
+    size_t stage_len = spill->stage_len;
+    while(pos + SPILL_REC_HDR <= stage_len && stage_len <= SMARTLOG_SPILL_CHUNK)
+    {
+        uint32_t rec_len;
+        memcpy(&rec_len, spill->stage + pos, SPILL_REC_HDR);
+        if(rec_len > SMARTLOG_LOG_BUFFER_SZ || pos + SPILL_REC_HDR + rec_len > stage_len)
+        {
+            break;
+        }
+        (void)smartlog_write_all(fd, spill->stage + pos + SPILL_REC_HDR, rec_len);
+        pos += SPILL_REC_HDR + rec_len;
+    }
+}
+
+void smartlog_spill_close(smartlog_spill_t* spill)
+{
+    if(spill == NULL)
+    {
+        return;
+    }
+
+    if(spill->fd >= 0)
+    {
+        close(spill->fd);
+    }
+    pthread_mutex_destroy(&spill->lock);
+    free(spill->stage);
+    free(spill->replay_buf);
+    free(spill);
+}
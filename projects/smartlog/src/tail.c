@@ -0,0 +1,502 @@
+/*
+ * src/tail.c
+ *
+ * Rotation-aware file follower for SmartLog.
+ *
+ * Implements:
+ *   - One inotify watch on the parent directory (writes, renames and
+ *     creates of the file all arrive there, also across rotation)
+ *   - Large pread() batches from the current inode
+ *   - Inode switch on rotation, after draining the old inode to EOF
+ *   - Restart from the beginning when the file shrinks
+ *   - LZ4 detection by magic and streaming decode
+ *
+ * Author: Aravinthraj Ganesan
+ * Version: 1.0
+ */
+
+#define _GNU_SOURCE
+#define _POSIX_C_SOURCE 199309L
+
+/* Standard includes */
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* Project includes */
+#include <smartlog/config.h>
+#include <smartlog/lz4.h>
+#include <smartlog/tail.h>
+#include <smartlog/utils.h>
+
+/* ============================================================================
+ * Internal Types
+ * ============================================================================ */
+
+#define TAIL_LZ4_MAGIC      "\x04\x22\x4D\x18"
+#define TAIL_WATCH_MASK     (IN_MODIFY | IN_CREATE | IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE | IN_CLOSE_WRITE)
+
+typedef enum {
+    TAIL_FORMAT_UNKNOWN = 0,    /* Nothing read from offset 0 yet */
+    TAIL_FORMAT_TEXT,
+    TAIL_FORMAT_LZ4
+} tail_format_t;
+
+struct smartlog_tail {
+    char path[SMARTLOG_PATH_MAX_LEN];
+    int inotify_fd;
+    int fd;                         /* Current inode (-1 = path missing) */
+    dev_t dev;
+    ino_t ino;
+    off_t offset;                   /* Next byte to read */
+    off_t skip_until;               /* Text from before this offset is not output */
+    tail_format_t format;
+    smartlog_lz4_decoder_t* dec;
+    int null_fd;                    /* LZ4 catch-up output (opened on demand) */
+    unsigned char* buf;
+    smartlog_tail_stats_t stats;
+};
+
+/* ============================================================================
+ * File Helpers
+ * ============================================================================ */
+
+/**
+ * Forget the decoder state (new file, or the file was truncated).
+ */
+static void tail_reset_format(smartlog_tail_t* tail)
+{
+    smartlog_lz4_decoder_destroy(tail->dec);
+    tail->dec = NULL;
+    tail->format = TAIL_FORMAT_UNKNOWN;
+    tail->skip_until = 0;
+}
+
+/**
+ * Decide text or LZ4 from the first bytes of the file.
+ *
+ * Return: 0 when decided, 1 if fewer than 4 bytes exist yet, -1 on error
+ */
+static int tail_detect_format(smartlog_tail_t* tail)
+{
+    unsigned char head[4];
+    ssize_t n = pread(tail->fd, head, sizeof(head), 0);
+    if(n < 0)
+    {
+        return -1;
+    }
+    if(n < (ssize_t)sizeof(head))
+    {
+        /* Could still become an LZ4 magic */
+        if(memcmp(head, TAIL_LZ4_MAGIC, (size_t)n) == 0)
+        {
+            return 1;
+        }
+        tail->format = TAIL_FORMAT_TEXT;
+        return 0;
+    }
+
+    if(memcmp(head, TAIL_LZ4_MAGIC, sizeof(head)) != 0)
+    {
+        tail->format = TAIL_FORMAT_TEXT;
+        return 0;
+    }
+
+    tail->dec = smartlog_lz4_decoder_create();
+    if(tail->dec == NULL)
+    {
+        return -1;
+    }
+    tail->format = TAIL_FORMAT_LZ4;
+    return 0;
+}
+
+/**
+ * Open the file now at the path (if any).
+ *
+ * Parameters:
+ *   from_start - 0 to skip the current content
+ *
+ * Return: 0 on success or missing file, -1 on error
+ */
+static int tail_attach(smartlog_tail_t* tail, int from_start)
+{
+    tail->fd = open(tail->path, O_RDONLY | O_CLOEXEC);
+    if(tail->fd < 0)
+    {
+        return errno == ENOENT ? 0 : -1;
+    }
+
+    struct stat st;
+    if(fstat(tail->fd, &st) != 0)
+    {
+        int saved_errno = errno;
+        close(tail->fd);
+        tail->fd = -1;
+        errno = saved_errno;
+        return -1;
+    }
+
+    tail->dev = st.st_dev;
+    tail->ino = st.st_ino;
+    tail->offset = 0;
+    tail_reset_format(tail);
+
+    if(from_start == 0 && st.st_size > 0)
+    {
+        int rc = tail_detect_format(tail);
+        if(rc < 0)
+        {
+            return -1;
+        }
+
+        /* A compressed stream can only be decoded from its start */
+        if(rc == 0 && tail->format == TAIL_FORMAT_TEXT)
+        {
+            tail->offset = st.st_size;
+        }
+        else
+        {
+            tail->skip_until = st.st_size;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Output one chunk read at tail->offset.
+ *
+ * Return: 0 on success, -1 on error
+ */
+static int tail_emit(smartlog_tail_t* tail, const unsigned char* data, size_t len, int out_fd)
+{
+    size_t skip = 0;
+    if(tail->offset < tail->skip_until)
+    {
+        skip = (size_t)(tail->skip_until - tail->offset);
+        if(skip > len)
+        {
+            skip = len;
+        }
+    }
+
+    if(tail->format != TAIL_FORMAT_LZ4)
+    {
+        return smartlog_write_all(out_fd, data + skip, len - skip);
+    }
+
+    /* Blocks that were complete before we started are decoded, not output */
+    if(skip != 0)
+    {
+        if(tail->null_fd < 0)
+        {
+            tail->null_fd = open("/dev/null", O_WRONLY | O_CLOEXEC);
+            if(tail->null_fd < 0)
+            {
+                return -1;
+            }
+        }
+        if(smartlog_lz4_decoder_feed(tail->dec, data, skip, tail->null_fd) != 0)
+        {
+            return -1;
+        }
+    }
+
+    if(skip < len && smartlog_lz4_decoder_feed(tail->dec, data + skip, len - skip, out_fd) != 0)
+    {
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * Read the current inode to EOF.
+ *
+ * Return: 0 on success, -1 on error
+ */
+static int tail_drain(smartlog_tail_t* tail, int out_fd)
+{
+    if(tail->fd < 0)
+    {
+        return 0;
+    }
+
+    /* Shrunk below our position: truncated in place, start over */
+    struct stat st;
+    if(fstat(tail->fd, &st) != 0)
+    {
+        return -1;
+    }
+    if(st.st_size < tail->offset)
+    {
+        tail->offset = 0;
+        tail_reset_format(tail);
+        tail->stats.truncations++;
+    }
+
+    for(;;)
+    {
+        if(tail->format == TAIL_FORMAT_UNKNOWN)
+        {
+            int rc = tail_detect_format(tail);
+            if(rc != 0)
+            {
+                return rc < 0 ? -1 : 0;
+            }
+        }
+
+        ssize_t n = pread(tail->fd, tail->buf, SMARTLOG_TAIL_BUF, tail->offset);
+        if(n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if(n < 0)
+        {
+            return -1;
+        }
+        if(n == 0)
+        {
+            return 0;
+        }
+
+        if(tail_emit(tail, tail->buf, (size_t)n, out_fd) != 0)
+        {
+            return -1;
+        }
+        tail->offset += n;
+        tail->stats.bytes += (uint64_t)n;
+    }
+}
+
+/**
+ * Switch to the file now at the path if it is not the one we read.
+ * The old inode is drained first.
+ *
+ * Return: 0 on success, -1 on error
+ */
+static int tail_follow_path(smartlog_tail_t* tail, int out_fd)
+{
+    struct stat st;
+    if(stat(tail->path, &st) != 0)
+    {
+        /* Renamed away and not recreated yet: keep the old inode */
+        return errno == ENOENT ? 0 : -1;
+    }
+    if(tail->fd >= 0 && st.st_dev == tail->dev && st.st_ino == tail->ino)
+    {
+        return 0;
+    }
+
+    if(tail->fd >= 0)
+    {
+        if(tail_drain(tail, out_fd) != 0)
+        {
+            return -1;
+        }
+        close(tail->fd);
+        tail->fd = -1;
+        tail->stats.rotations++;
+    }
+
+    if(tail_attach(tail, 1) != 0)
+    {
+        return -1;
+    }
+    return tail_drain(tail, out_fd);
+}
+
+/**
+ * Drain, then follow a rotation if there was one.
+ */
+static int tail_catch_up(smartlog_tail_t* tail, int out_fd)
+{
+    if(tail_drain(tail, out_fd) != 0)
+    {
+        return -1;
+    }
+    return tail_follow_path(tail, out_fd);
+}
+
+/**
+ * Read every queued inotify event. Only their arrival matters: each wake
+ * re-checks the file and the path.
+ */
+static int tail_consume_events(smartlog_tail_t* tail)
+{
+    char events[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+
+    for(;;)
+    {
+        ssize_t n = read(tail->inotify_fd, events, sizeof(events));
+        if(n > 0)
+        {
+            continue;
+        }
+        if(n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if(n < 0 && errno != EAGAIN && errno != EWOULDBLOCK)
+        {
+            return -1;
+        }
+        return 0;
+    }
+}
+
+/* ============================================================================
+ * Public API
+ * ============================================================================ */
+
+smartlog_tail_t* smartlog_tail_open(const char* path, int from_start)
+{
+    if(path == NULL || path[0] == '\0')
+    {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    size_t len = strnlen(path, SMARTLOG_PATH_MAX_LEN);
+    if(len >= SMARTLOG_PATH_MAX_LEN)
+    {
+        errno = ENAMETOOLONG;
+        return NULL;
+    }
+
+    smartlog_tail_t* tail = calloc(1, sizeof(*tail));
+    if(tail == NULL)
+    {
+        return NULL;
+    }
+    memcpy(tail->path, path, len + 1);
+    tail->fd = -1;
+    tail->inotify_fd = -1;
+    tail->null_fd = -1;
+
+    /* ====================================================================
+     * STEP 1: Watch the Parent Directory (Before Opening, So No Event Is Missed)
+     * ==================================================================== */
+    char dir[SMARTLOG_PATH_MAX_LEN];
+    memcpy(dir, path, len + 1);
+    char* slash = strrchr(dir, '/');
+    if(slash == NULL)
+    {
+        strcpy(dir, ".");
+    }
+    else if(slash == dir)
+    {
+        dir[1] = '\0';
+    }
+    else
+    {
+        *slash = '\0';
+    }
+
+    tail->buf = malloc(SMARTLOG_TAIL_BUF);
+    tail->inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if(tail->buf == NULL || tail->inotify_fd < 0 ||
+       inotify_add_watch(tail->inotify_fd, dir, TAIL_WATCH_MASK) < 0)
+    {
+        int saved_errno = tail->buf == NULL ? ENOMEM : errno;
+        smartlog_tail_close(tail);
+        errno = saved_errno;
+        return NULL;
+    }
+
+    /* ====================================================================
+     * STEP 2: Open the File If It Exists
+     * ==================================================================== */
+    if(tail_attach(tail, from_start) != 0)
+    {
+        int saved_errno = errno;
+        smartlog_tail_close(tail);
+        errno = saved_errno;
+        return NULL;
+    }
+
+    return tail;
+}
+
+int smartlog_tail_poll(smartlog_tail_t* tail, int out_fd, int timeout_ms)
+{
+    if(tail == NULL || out_fd < 0)
+    {
+        errno = EINVAL;
+        return 1;
+    }
+
+    /* ====================================================================
+     * STEP 1: Output What Is Already There
+     * ==================================================================== */
+    if(tail_catch_up(tail, out_fd) != 0)
+    {
+        return 1;
+    }
+
+    /* ====================================================================
+     * STEP 2: Wait for inotify
+     * ==================================================================== */
+    struct pollfd pfd = { tail->inotify_fd, POLLIN, 0 };
+    int ready = poll(&pfd, 1, timeout_ms);
+    if(ready < 0)
+    {
+        return errno == EINTR ? 0 : 1;
+    }
+    if(ready == 0)
+    {
+        return 0;
+    }
+    tail->stats.wakeups++;
+
+    /* ====================================================================
+     * STEP 3: Output What the Events Announced
+     * ==================================================================== */
+    if(tail_consume_events(tail) != 0 || tail_catch_up(tail, out_fd) != 0)
+    {
+        return 1;
+    }
+    return 0;
+}
+
+int smartlog_tail_fd(const smartlog_tail_t* tail)
+{
+    return tail != NULL ? tail->inotify_fd : -1;
+}
+
+void smartlog_tail_get_stats(const smartlog_tail_t* tail, smartlog_tail_stats_t* out)
+{
+    if(tail == NULL || out == NULL)
+    {
+        return;
+    }
+    *out = tail->stats;
+}
+
+void smartlog_tail_close(smartlog_tail_t* tail)
+{
+    if(tail == NULL)
+    {
+        return;
+    }
+    if(tail->fd >= 0)
+    {
+        close(tail->fd);
+    }
+    if(tail->inotify_fd >= 0)
+    {
+        close(tail->inotify_fd);
+    }
+    if(tail->null_fd >= 0)
+    {
+        close(tail->null_fd);
+    }
+    smartlog_lz4_decoder_destroy(tail->dec);
+    free(tail->buf);
+    free(tail);
+}
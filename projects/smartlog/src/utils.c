@@ -6,7 +6,11 @@
  * Implements:
  *   - Get current time in nanoseconds
  *   - Write data to file (handle interrupts)
+ *   - Gather-write a batch of buffers
  *   - Sync directory to disk
+ *   - Futex wait/wake and spin-loop hint
+ *   - NUMA-aware, huge-page capable buffer allocation
+ *   - Bounded MPSC queue with futex wait
  *
  * Author: Aravinthraj Ganesan
  * Version: 4.0
@@ -17,10 +21,18 @@
 
 /* Standard includes */
 #include <fcntl.h>
+#include <limits.h>
+#include <linux/futex.h>
+#include <stdalign.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
 #include <time.h>
 #include <unistd.h>
 #include <errno.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
@@ -56,6 +68,20 @@ uint64_t smartlog_timestamp_ns(void)
     return ((uint64_t)ts.tv_sec * UINT64_C(1000000000)) + (uint64_t)ts.tv_nsec;
 }
 
+/**
+ * Get monotonic time in nanoseconds.
+ */
+uint64_t smartlog_monotonic_ns(void)
+{
+    struct timespec ts;
+    if(clock_gettime(CLOCK_MONOTONIC, &ts) != 0)
+    {
+        return 0;
+    }
+
+    return ((uint64_t)ts.tv_sec * UINT64_C(1000000000)) + (uint64_t)ts.tv_nsec;
+}
+
 /* ============================================================================
  * Write Function
  * ============================================================================ */
@@ -104,14 +130,56 @@ int smartlog_write_all(int file_descriptor, const void* msg_buff, size_t msg_len
     return 0;
 }
 
+/**
+ * Gather-write all buffers, retry if interrupted or short.
+ */
+int smartlog_writev_all(int file_descriptor, struct iovec* iov, int iovcnt)
+{
+    errno = 0;
+
+    while(iovcnt > 0)
+    {
+        ssize_t bytes_written = writev(file_descriptor, iov, iovcnt);
+
+        if(bytes_written < 0)
+        {
+            if(errno == EINTR)
+            {
+                /* Interrupted by signal - retry */
+                continue;
+            }
+            return -1;
+        }
+        if(bytes_written == 0)
+        {
+            /* Zero bytes - unexpected */
+            errno = EIO;
+            return -1;
+        }
+
+        /* Skip fully written buffers, then trim the partial one */
+        size_t done = (size_t)bytes_written;
+        while(iovcnt > 0 && done >= iov->iov_len)
+        {
+            done -= iov->iov_len;
+            iov++;
+            iovcnt--;
+        }
+        if(iovcnt > 0)
+        {
+            iov->iov_base = (char*)iov->iov_base + done;
+            iov->iov_len -= done;
+        }
+    }
+
+    return 0;
+}
+
 /* ============================================================================
  * Directory Sync Function
  * ============================================================================ */
 
-/**
- * Sync parent directory to disk.
- */
-int smartlog_fsync_parent_dir(const char* path)
+int smartlog_open_parent_dir(const char* path, const char** name)
 {
     /* Validate input */
     if(!path || path[0] == '\0')
@@ -161,8 +229,22 @@ int smartlog_fsync_parent_dir(const char* path)
         }
     }
 
-    /* Open directory */
-    int fd_dir = open(dir_path, O_RDONLY | O_DIRECTORY);
+    if(name != NULL)
+    {
+        const char* base = strrchr(path, '/');
+        *name = base != NULL ? base + 1 : path;
+    }
+
+    /* Open directory (readable, so it can be fsync()ed) */
+    return open(dir_path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+}
+
+/**
+ * Sync parent directory to disk.
+ */
+int smartlog_fsync_parent_dir(const char* path)
+{
+    int fd_dir = smartlog_open_parent_dir(path, NULL);
     if(fd_dir < 0)
     {
         return -1;
@@ -185,3 +267,439 @@ int smartlog_fsync_parent_dir(const char* path)
 
     return 0;
 }
+
+/* ============================================================================
+ * Wait Helpers
+ * ============================================================================ */
+
+int smartlog_futex_wait(atomic_uint* addr, unsigned int expected, uint64_t timeout_ns)
+{
+    struct timespec ts;
+    struct timespec* tsp = NULL;
+    if(timeout_ns != 0)
+    {
+        ts.tv_sec = (time_t)(timeout_ns / UINT64_C(1000000000));
+        ts.tv_nsec = (long)(timeout_ns % UINT64_C(1000000000));
+        tsp = &ts;
+    }
+
+    if(syscall(SYS_futex, (unsigned int*)addr, FUTEX_WAIT_PRIVATE, expected, tsp, NULL, 0) != 0)
+    {
+        /* EAGAIN: the value changed before we slept, same as a wake */
+        return errno == EAGAIN ? 0 : -1;
+    }
+    return 0;
+}
+
+void smartlog_futex_wake(atomic_uint* addr, int count)
+{
+    (void)syscall(SYS_futex, (unsigned int*)addr, FUTEX_WAKE_PRIVATE, count, NULL, NULL, 0);
+}
+
+void smartlog_cpu_relax(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    __asm__ __volatile__("yield" ::: "memory");
+#else
+    atomic_signal_fence(memory_order_seq_cst);
+#endif
+}
+
+/* ============================================================================
+ * Memory Placement
+ * ============================================================================ */
+
+#define SMARTLOG_MPOL_PREFERRED 1   /* <linux/mempolicy.h> MPOL_PREFERRED */
+
+/**
+ * Map size bytes aligned to a huge page, by over-mapping and trimming.
+ */
+static void* region_map_aligned(size_t size)
+{
+    size_t span = size + SMARTLOG_HUGE_PAGE_SZ;
+    unsigned char* raw = mmap(NULL, span, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(raw == MAP_FAILED)
+    {
+        return NULL;
+    }
+
+    uintptr_t start = ((uintptr_t)raw + SMARTLOG_HUGE_PAGE_SZ - 1) & ~((uintptr_t)SMARTLOG_HUGE_PAGE_SZ - 1);
+    size_t lead = start - (uintptr_t)raw;
+    if(lead != 0)
+    {
+        (void)munmap(raw, lead);
+    }
+    if(span - lead - size != 0)
+    {
+        (void)munmap((unsigned char*)start + size, span - lead - size);
+    }
+    return (void*)start;
+}
+
+int smartlog_region_alloc(smartlog_region_t* region, size_t size, const smartlog_mem_opts_t* opts)
+{
+    int numa_node = opts != NULL ? opts->numa_node : -1;
+    int huge = opts != NULL && opts->huge_pages == FEATURE_ENABLED && size >= SMARTLOG_HUGE_PAGE_SZ;
+
+    if(region == NULL || size == 0)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    region->addr = NULL;
+    region->size = size;
+    region->pages = PAGES_NORMAL;
+
+    if(huge)
+    {
+        region->size = (size + SMARTLOG_HUGE_PAGE_SZ - 1) & ~((size_t)SMARTLOG_HUGE_PAGE_SZ - 1);
+
+        /* Reserved pool first: fails at once when none are configured */
+        void* addr = mmap(NULL, region->size, PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if(addr != MAP_FAILED)
+        {
+            region->addr = addr;
+            region->pages = PAGES_HUGETLB;
+        }
+        else if((region->addr = region_map_aligned(region->size)) != NULL &&
+                madvise(region->addr, region->size, MADV_HUGEPAGE) == 0)
+        {
+            region->pages = PAGES_TRANSPARENT;
+        }
+    }
+    else
+    {
+        void* addr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        region->addr = addr == MAP_FAILED ? NULL : addr;
+    }
+
+    if(region->addr == NULL)
+    {
+        return -1;
+    }
+
+    /*
+     * Set the policy before any page is touched, so the first touch
+     * allocates on the node. Preferred, not bound: if the node runs out we
+     * still get memory. Failure (no NUMA support) leaves first-touch.
+     */
+    if(numa_node >= 0 && numa_node < (int)(sizeof(unsigned long) * CHAR_BIT))
+    {
+        unsigned long nodemask = 1UL << numa_node;
+        (void)syscall(SYS_mbind, region->addr, region->size, SMARTLOG_MPOL_PREFERRED, &nodemask,
+                      sizeof(nodemask) * CHAR_BIT, 0);
+    }
+
+    return 0;
+}
+
+void smartlog_region_free(smartlog_region_t* region)
+{
+    if(region != NULL && region->addr != NULL)
+    {
+        (void)munmap(region->addr, region->size);
+        region->addr = NULL;
+    }
+}
+
+int smartlog_cpu_numa_node(int cpu)
+{
+    /* /sys/devices/system/cpu/cpuN/ holds a "nodeX" link */
+    for(int node = 0; node < 64; node++)
+    {
+        char path[96];
+        struct stat st;
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/node%d", cpu, node);
+        if(stat(path, &st) == 0)
+        {
+            return node;
+        }
+    }
+    return -1;
+}
+
+/* ============================================================================
+ * MPSC Queue
+ * ============================================================================ */
+
+/** Slot header; the element bytes follow it. */
+typedef struct {
+    atomic_size_t seq;          /* == pos: free, == pos + 1: ready */
+    uint32_t len;
+} mpsc_slot_t;
+
+struct smartlog_mpsc {
+    alignas(SMARTLOG_CACHE_LINE) atomic_size_t head;     /* Producers */
+
+    alignas(SMARTLOG_CACHE_LINE) atomic_size_t tail;     /* Consumer */
+
+    alignas(SMARTLOG_CACHE_LINE) atomic_uint sleeping;   /* Futex word */
+    atomic_uint kicked;                                  /* smartlog_mpsc_wake() */
+    atomic_uint_fast64_t wakeups;
+
+    /* Read-only after create: shared by everyone without ping-pong */
+    alignas(SMARTLOG_CACHE_LINE) size_t mask;
+    size_t elem_size;
+    size_t stride;
+    unsigned char* slots;
+    smartlog_region_t region;
+    int numa_node;
+};
+
+static mpsc_slot_t* mpsc_slot(const smartlog_mpsc_t* q, size_t pos)
+{
+    return (mpsc_slot_t*)(q->slots + ((pos & q->mask) * q->stride));
+}
+
+smartlog_mpsc_t* smartlog_mpsc_create(size_t capacity, size_t elem_size)
+{
+    return smartlog_mpsc_create_with(capacity, elem_size, NULL);
+}
+
+smartlog_mpsc_t* smartlog_mpsc_create_with(size_t capacity, size_t elem_size, const smartlog_mem_opts_t* opts)
+{
+    if(capacity < 2 || (capacity & (capacity - 1)) != 0 ||
+       elem_size == 0 || elem_size > UINT32_MAX)
+    {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    size_t stride = sizeof(mpsc_slot_t) + elem_size;
+    stride = (stride + SMARTLOG_CACHE_LINE - 1) & ~((size_t)SMARTLOG_CACHE_LINE - 1);
+    if(capacity > SIZE_MAX / stride)
+    {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    smartlog_mpsc_t* q = aligned_alloc(SMARTLOG_CACHE_LINE, sizeof(*q));
+    if(q == NULL)
+    {
+        return NULL;
+    }
+    memset(q, 0, sizeof(*q));
+
+    if(smartlog_region_alloc(&q->region, capacity * stride, opts) != 0)
+    {
+        free(q);
+        errno = ENOMEM;
+        return NULL;
+    }
+    q->slots = q->region.addr;
+    q->numa_node = opts != NULL ? opts->numa_node : -1;
+
+    q->mask = capacity - 1;
+    q->elem_size = elem_size;
+    q->stride = stride;
+    atomic_init(&q->head, 0);
+    atomic_init(&q->tail, 0);
+    atomic_init(&q->sleeping, 0);
+    atomic_init(&q->kicked, 0);
+    atomic_init(&q->wakeups, 0);
+    for(size_t i = 0; i < capacity; i++)
+    {
+        atomic_init(&mpsc_slot(q, i)->seq, i);
+        mpsc_slot(q, i)->len = 0;
+    }
+
+    return q;
+}
+
+int smartlog_mpsc_push(smartlog_mpsc_t* q, const void* data, size_t len)
+{
+    if(len > q->elem_size)
+    {
+        errno = EMSGSIZE;
+        return -1;
+    }
+
+    /* Claim a slot: CAS the head forward once its slot is free */
+    size_t pos = atomic_load_explicit(&q->head, memory_order_relaxed);
+    mpsc_slot_t* slot;
+    for(;;)
+    {
+        slot = mpsc_slot(q, pos);
+        size_t seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+        intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+
+        if(diff == 0)
+        {
+            if(atomic_compare_exchange_weak_explicit(&q->head, &pos, pos + 1,
+                                                     memory_order_relaxed, memory_order_relaxed))
+            {
+                break;
+            }
+        }
+        else if(diff < 0)
+        {
+            /* Slot still holds an element from the previous lap: full */
+            errno = EAGAIN;
+            return -1;
+        }
+        else
+        {
+            pos = atomic_load_explicit(&q->head, memory_order_relaxed);
+        }
+    }
+
+    memcpy((unsigned char*)(slot + 1), data, len);
+    slot->len = (uint32_t)len;
+    atomic_store_explicit(&slot->seq, pos + 1, memory_order_release);
+
+    /*
+     * Pairs with the fence in smartlog_mpsc_wait(): either the consumer sees
+     * this element before sleeping, or we see its sleeping flag here.
+     */
+    atomic_thread_fence(memory_order_seq_cst);
+    if(atomic_load_explicit(&q->sleeping, memory_order_relaxed) != 0 &&
+       atomic_exchange_explicit(&q->sleeping, 0, memory_order_relaxed) != 0)
+    {
+        atomic_fetch_add_explicit(&q->wakeups, 1, memory_order_relaxed);
+        smartlog_futex_wake(&q->sleeping, 1);
+    }
+
+    return 0;
+}
+
+size_t smartlog_mpsc_claim(smartlog_mpsc_t* q, const void** elems, size_t* lens, size_t max)
+{
+    return smartlog_mpsc_peek(q, 0, elems, lens, max);
+}
+
+size_t smartlog_mpsc_peek(const smartlog_mpsc_t* q, size_t skip, const void** elems, size_t* lens, size_t max)
+{
+    size_t tail = atomic_load_explicit(&((smartlog_mpsc_t*)q)->tail, memory_order_relaxed) + skip;
+    size_t n = 0;
+
+    /* Stop at the first slot that is not published yet, to keep order */
+    while(n < max && skip + n <= q->mask)
+    {
+        mpsc_slot_t* slot = mpsc_slot(q, tail + n);
+        if(atomic_load_explicit(&slot->seq, memory_order_acquire) != tail + n + 1)
+        {
+            break;
+        }
+        elems[n] = slot + 1;
+        lens[n] = slot->len;
+        n++;
+    }
+
+    return n;
+}
+
+void smartlog_mpsc_release(smartlog_mpsc_t* q, size_t count)
+{
+    size_t tail = atomic_load_explicit(&q->tail, memory_order_relaxed);
+
+    for(size_t i = 0; i < count; i++)
+    {
+        /* Mark free for the producer one lap ahead */
+        atomic_store_explicit(&mpsc_slot(q, tail + i)->seq, tail + i + q->mask + 1,
+                              memory_order_release);
+    }
+    atomic_store_explicit(&q->tail, tail + count, memory_order_release);
+}
+
+int smartlog_mpsc_pop(smartlog_mpsc_t* q, void* out, size_t out_sz, size_t* len)
+{
+    const void* elem;
+    size_t elem_len;
+
+    if(smartlog_mpsc_claim(q, &elem, &elem_len, 1) == 0)
+    {
+        return 0;
+    }
+    if(elem_len > out_sz)
+    {
+        errno = EMSGSIZE;
+        return -1;
+    }
+
+    memcpy(out, elem, elem_len);
+    if(len != NULL)
+    {
+        *len = elem_len;
+    }
+    smartlog_mpsc_release(q, 1);
+    return 1;
+}
+
+int smartlog_mpsc_wait(smartlog_mpsc_t* q, uint64_t timeout_ns)
+{
+    size_t tail = atomic_load_explicit(&q->tail, memory_order_relaxed);
+    mpsc_slot_t* slot = mpsc_slot(q, tail);
+
+    /* Advertise, then re-check: see the fence in smartlog_mpsc_push() */
+    atomic_store_explicit(&q->sleeping, 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    if(atomic_load_explicit(&slot->seq, memory_order_acquire) == tail + 1 ||
+       atomic_exchange_explicit(&q->kicked, 0, memory_order_relaxed) != 0)
+    {
+        atomic_store_explicit(&q->sleeping, 0, memory_order_relaxed);
+        return atomic_load_explicit(&slot->seq, memory_order_acquire) == tail + 1;
+    }
+
+    /* Returns at once if a producer already cleared the flag */
+    (void)smartlog_futex_wait(&q->sleeping, 1, timeout_ns);
+    atomic_store_explicit(&q->sleeping, 0, memory_order_relaxed);
+    atomic_store_explicit(&q->kicked, 0, memory_order_relaxed);
+
+    return atomic_load_explicit(&slot->seq, memory_order_acquire) == tail + 1;
+}
+
+void smartlog_mpsc_wake(smartlog_mpsc_t* q)
+{
+    /* kicked covers a consumer that has not advertised sleeping yet */
+    atomic_store_explicit(&q->kicked, 1, memory_order_seq_cst);
+    if(atomic_exchange_explicit(&q->sleeping, 0, memory_order_seq_cst) != 0)
+    {
+        smartlog_futex_wake(&q->sleeping, 1);
+    }
+}
+
+size_t smartlog_mpsc_size(const smartlog_mpsc_t* q)
+{
+    size_t head = atomic_load_explicit(&((smartlog_mpsc_t*)q)->head, memory_order_relaxed);
+    size_t tail = atomic_load_explicit(&((smartlog_mpsc_t*)q)->tail, memory_order_relaxed);
+    return head >= tail ? head - tail : 0;
+}
+
+size_t smartlog_mpsc_head(const smartlog_mpsc_t* q)
+{
+    return atomic_load_explicit(&((smartlog_mpsc_t*)q)->head, memory_order_acquire);
+}
+
+size_t smartlog_mpsc_tail(const smartlog_mpsc_t* q)
+{
+    return atomic_load_explicit(&((smartlog_mpsc_t*)q)->tail, memory_order_acquire);
+}
+
+int smartlog_mpsc_numa_node(const smartlog_mpsc_t* q)
+{
+    return q->numa_node;
+}
+
+page_kind_t smartlog_mpsc_page_kind(const smartlog_mpsc_t* q)
+{
+    return q->region.pages;
+}
+
+uint64_t smartlog_mpsc_wakeups(const smartlog_mpsc_t* q)
+{
+    return atomic_load_explicit(&((smartlog_mpsc_t*)q)->wakeups, memory_order_relaxed);
+}
+
+void smartlog_mpsc_destroy(smartlog_mpsc_t* q)
+{
+    if(q == NULL)
+    {
+        return;
+    }
+    smartlog_region_free(&q->region);
+    free(q);
+}
@@ -1,15 +1,45 @@
 #define _POSIX_C_SOURCE 200809L
 
+#include <dirent.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sched.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
 #include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
 
+#include <smartlog/circfile.h>
 #include <smartlog/config.h>
+#include <smartlog/context.h>
 #include <smartlog/smartlog_core.h>
+#include <smartlog/logger.h>
+#include <smartlog/lz4.h>
+#include <smartlog/sink.h>
+#include <smartlog/collector.h>
+#include <smartlog/archive.h>
+#include <smartlog/clock.h>
+#include <smartlog/columns.h>
+#include <smartlog/counters.h>
+#include <smartlog/crash.h>
+#include <smartlog/fd_cache.h>
+#include <smartlog/merge.h>
+#include <smartlog/metrics.h>
+#include <smartlog/parse.h>
+#include <smartlog/recorder.h>
+#include <smartlog/shm_ring.h>
+#include <smartlog/tail.h>
+#include <smartlog/utils.h>
 
 static int read_file(const char* path, char* out, size_t out_sz)
 {
@@ -33,6 +63,19 @@ static int read_file(const char* path, char* out, size_t out_sz)
     return 0;
 }
 
+static int write_text(const char* path, const char* text)
+{
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    if(fd < 0)
+    {
+        return -1;
+    }
+
+    ssize_t n = write(fd, text, strlen(text));
+    close(fd);
+    return n == (ssize_t)strlen(text) ? 0 : -1;
+}
+
 static int file_exists(const char* path)
 {
     struct stat st;
@@ -138,6 +181,204 @@ static int test_durable_write(const char* dir)
     return 0;
 }
 
+static void* fd_cache_writer(void* arg)
+{
+    const char* path = (const char*)arg;
+    for(int i = 0; i < 1000; i++)
+    {
+        if(smartlog_write_log_entry(path, "cached-thread", FEATURE_DISABLED, FEATURE_DISABLED, 0) != 0)
+        {
+            return (void*)1;
+        }
+    }
+    return NULL;
+}
+
+static int test_fd_cache(const char* dir)
+{
+    char path[512];
+    char moved[520];
+    char other[512];
+    char third[512];
+    snprintf(path, sizeof(path), "%s/fdcache.log", dir);
+    snprintf(moved, sizeof(moved), "%s.moved", path);
+    snprintf(other, sizeof(other), "%s/fdcache_other.log", dir);
+    snprintf(third, sizeof(third), "%s/fdcache_third.log", dir);
+
+    /* Second call reuses the descriptor */
+    smartlog_fd_cache_stats_t st;
+    if(smartlog_fd_cache_enable(0, 0) == 0 || smartlog_fd_cache_enable(2, 0) != 0 ||
+       smartlog_write_log_entry(path, "cached-1", FEATURE_DISABLED, FEATURE_DISABLED, 0) != 0 ||
+       smartlog_write_log_entry(path, "cached-2", FEATURE_ENABLED, FEATURE_DISABLED, 0) != 0)
+    {
+        perror("fd cache write");
+        return 1;
+    }
+    smartlog_fd_cache_get_stats(&st);
+    if(st.misses != 1 || st.hits != 1 || st.open != 1)
+    {
+        fprintf(stderr, "fd cache stats: misses=%llu hits=%llu\n",
+                (unsigned long long)st.misses, (unsigned long long)st.hits);
+        return 1;
+    }
+
+    /* Renamed away by someone else: the check opens the path again */
+    char content[1024];
+    if(rename(path, moved) != 0 ||
+       smartlog_write_log_entry(path, "cached-3", FEATURE_DISABLED, FEATURE_DISABLED, 0) != 0 ||
+       read_file(path, content, sizeof(content)) != 0 || strstr(content, "MESSAGE = cached-3") == NULL ||
+       read_file(moved, content, sizeof(content)) != 0 || strstr(content, "MESSAGE = cached-2") == NULL ||
+       strstr(content, "cached-3") != NULL)
+    {
+        fprintf(stderr, "fd cache did not follow rename\n");
+        return 1;
+    }
+    smartlog_fd_cache_get_stats(&st);
+    if(st.stale != 1)
+    {
+        fprintf(stderr, "fd cache stale count %llu\n", (unsigned long long)st.stale);
+        return 1;
+    }
+
+    /* Own rotation drops the entry at once */
+    if(smartlog_write_log_entry(path, "rotate-me", FEATURE_DISABLED, FEATURE_ENABLED, 60) != 0 ||
+       read_file(path, content, sizeof(content)) != 0 || strstr(content, "MESSAGE = rotate-me") == NULL ||
+       strstr(content, "cached-3") != NULL)
+    {
+        fprintf(stderr, "fd cache rotation mismatch\n");
+        return 1;
+    }
+
+    /* LRU: a third path evicts the oldest; directories still fail */
+    if(smartlog_write_log_entry(other, "other", FEATURE_DISABLED, FEATURE_DISABLED, 0) != 0 ||
+       smartlog_write_log_entry(third, "third", FEATURE_DISABLED, FEATURE_DISABLED, 0) != 0 ||
+       smartlog_write_log_entry(dir, "dir", FEATURE_DISABLED, FEATURE_DISABLED, 0) == 0 || errno != EISDIR)
+    {
+        perror("fd cache lru");
+        return 1;
+    }
+    smartlog_fd_cache_get_stats(&st);
+    if(st.evictions == 0 || st.open != 2)
+    {
+        fprintf(stderr, "fd cache eviction mismatch: open=%llu\n", (unsigned long long)st.open);
+        return 1;
+    }
+
+    /* Threads share one entry; every line lands */
+    if(unlink(path) != 0 || smartlog_fd_cache_enable(2, 1000) != 0)
+    {
+        perror("fd cache reset");
+        return 1;
+    }
+    smartlog_fd_cache_stats_t before;
+    smartlog_fd_cache_get_stats(&before);
+    pthread_t threads[4];
+    for(int i = 0; i < 4; i++)
+    {
+        if(pthread_create(&threads[i], NULL, fd_cache_writer, path) != 0)
+        {
+            perror("pthread_create");
+            return 1;
+        }
+    }
+    int failed = 0;
+    for(int i = 0; i < 4; i++)
+    {
+        void* ret = NULL;
+        pthread_join(threads[i], &ret);
+        failed |= ret != NULL;
+    }
+    char* big = malloc(1u << 20);
+    int fd = open(path, O_RDONLY);
+    ssize_t n = big != NULL && fd >= 0 ? read(fd, big, 1u << 20) : -1;
+    if(fd >= 0)
+    {
+        close(fd);
+    }
+    int lines = 0;
+    for(ssize_t i = 0; i < n; i++)
+    {
+        lines += big[i] == '\n';
+    }
+    free(big);
+    if(failed || lines != 4000)
+    {
+        fprintf(stderr, "fd cache threaded lines %d\n", lines);
+        return 1;
+    }
+
+    /* Threads that lost the race to open the path closed their descriptor */
+    smartlog_fd_cache_get_stats(&st);
+    if(st.misses - before.misses != 1 + (st.races - before.races))
+    {
+        fprintf(stderr, "fd cache kept duplicate entries: misses=%llu races=%llu\n",
+                (unsigned long long)(st.misses - before.misses),
+                (unsigned long long)(st.races - before.races));
+        return 1;
+    }
+
+    smartlog_fd_cache_disable();
+    smartlog_fd_cache_get_stats(&st);
+    if(smartlog_fd_cache_enabled() || st.open != 0)
+    {
+        fprintf(stderr, "fd cache still open after disable\n");
+        return 1;
+    }
+
+    return 0;
+}
+
+static int test_file_sink_dir_relative(const char* dir)
+{
+    char sub[512];
+    char moved[512];
+    char path[600];
+    char cur[600];
+    char backup[600];
+    snprintf(sub, sizeof(sub), "%s/sinkdir", dir);
+    snprintf(moved, sizeof(moved), "%s/sinkdir.moved", dir);
+    snprintf(path, sizeof(path), "%s/app.log", sub);
+    snprintf(cur, sizeof(cur), "%s/app.log", moved);
+    snprintf(backup, sizeof(backup), "%s/app.log.1", moved);
+
+    /* Parent renamed under a live sink: writes and rotation follow it */
+    smartlog_logger_t* lg = smartlog_logger_create();
+    smartlog_sink_t* sink = NULL;
+    if(mkdir(sub, 0700) != 0 || lg == NULL ||
+       (sink = smartlog_sink_file_open(path, FEATURE_ENABLED, FEATURE_ENABLED, 200)) == NULL ||
+       smartlog_logger_add_sink(lg, sink) != 0 ||
+       smartlog_logger_log(lg, LOG_LEVEL_INFO, "before-move") != 0 ||
+       rename(sub, moved) != 0 ||
+       smartlog_logger_log(lg, LOG_LEVEL_INFO, "after-move") != 0 ||
+       smartlog_logger_log(lg, LOG_LEVEL_INFO, "after-rotate") != 0)
+    {
+        perror("dir-relative sink");
+        return 1;
+    }
+    smartlog_logger_destroy(lg);
+
+    char content[1024];
+    char old[1024];
+    if(file_exists(path) || read_file(cur, content, sizeof(content)) != 0 ||
+       read_file(backup, old, sizeof(old)) != 0 ||
+       strstr(content, "MESSAGE = after-rotate") == NULL || strstr(old, "MESSAGE = before-move") == NULL ||
+       strstr(old, "MESSAGE = after-move") == NULL)
+    {
+        fprintf(stderr, "dir-relative rotation mismatch\n");
+        return 1;
+    }
+
+    /* A path naming a directory is still refused */
+    snprintf(path, sizeof(path), "%s/", moved);
+    if(smartlog_sink_file_open(path, FEATURE_DISABLED, FEATURE_DISABLED, 0) != NULL || errno != EISDIR)
+    {
+        fprintf(stderr, "file sink accepted a directory path\n");
+        return 1;
+    }
+
+    return 0;
+}
+
 static int test_empty_message_validation(const char* dir)
 {
     char path[512];
@@ -188,6 +429,3089 @@ static int test_timestamp_failure(const char* dir)
     return 0;
 }
 
+/* Sink that blocks in write() until the test opens the gate */
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    int open;
+    int received;
+} gated_sink_t;
+
+static int gated_write(void* ctx, const char* data, size_t len)
+{
+    gated_sink_t* g = (gated_sink_t*)ctx;
+    (void)data;
+    (void)len;
+
+    pthread_mutex_lock(&g->lock);
+    while(g->open == 0)
+    {
+        pthread_cond_wait(&g->cond, &g->lock);
+    }
+    g->received++;
+    pthread_mutex_unlock(&g->lock);
+    return 0;
+}
+
+static void gated_open(gated_sink_t* g)
+{
+    pthread_mutex_lock(&g->lock);
+    g->open = 1;
+    pthread_cond_broadcast(&g->cond);
+    pthread_mutex_unlock(&g->lock);
+}
+
+static const smartlog_sink_ops_t gated_ops = { .write = gated_write };
+
+static int test_logger_fanout(const char* dir)
+{
+    char all_path[512];
+    char err_path[512];
+    snprintf(all_path, sizeof(all_path), "%s/fanout.log", dir);
+    snprintf(err_path, sizeof(err_path), "%s/fanout.err", dir);
+
+    gated_sink_t gate = { PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, 0, 0 };
+
+    smartlog_logger_t* lg = smartlog_logger_create();
+    smartlog_sink_t* all = smartlog_sink_file_open(all_path, FEATURE_DISABLED, FEATURE_DISABLED, 0);
+    smartlog_sink_t* err = smartlog_sink_file_open(err_path, FEATURE_DISABLED, FEATURE_DISABLED, 0);
+    smartlog_sink_t* slow = smartlog_sink_create(&gated_ops, &gate);
+    if(lg == NULL || all == NULL || err == NULL || slow == NULL)
+    {
+        perror("fanout setup");
+        return 1;
+    }
+    if(smartlog_sink_set_level(err, LOG_LEVEL_ERROR) != 0 ||
+       smartlog_sink_set_async(slow, 16, OVERFLOW_BLOCK) != 0 ||
+       smartlog_logger_add_sink(lg, all) != 0 ||
+       smartlog_logger_add_sink(lg, err) != 0 ||
+       smartlog_logger_add_sink(lg, slow) != 0)
+    {
+        perror("fanout config");
+        return 1;
+    }
+
+    if(smartlog_logger_log(lg, LOG_LEVEL_INFO, "fan-info") != 0 ||
+       smartlog_logger_log(lg, LOG_LEVEL_ERROR, "fan-error") != 0 ||
+       smartlog_logger_log(lg, LOG_LEVEL_DEBUG, "fan-debug") != 0)
+    {
+        perror("fanout log");
+        return 1;
+    }
+
+    /* The stalled async sink must not hold back the file sinks */
+    char content[2048];
+    if(read_file(all_path, content, sizeof(content)) != 0 ||
+       strstr(content, "MESSAGE = fan-info") == NULL ||
+       strstr(content, "MESSAGE = fan-error") == NULL ||
+       strstr(content, "MESSAGE = fan-debug") == NULL)
+    {
+        fprintf(stderr, "fanout main file mismatch\n");
+        return 1;
+    }
+    if(read_file(err_path, content, sizeof(content)) != 0 ||
+       strstr(content, "MESSAGE = fan-error") == NULL ||
+       strstr(content, "MESSAGE = fan-info") != NULL)
+    {
+        fprintf(stderr, "fanout error file mismatch\n");
+        return 1;
+    }
+
+    gated_open(&gate);
+    if(smartlog_logger_flush(lg) != 0 || gate.received != 3)
+    {
+        fprintf(stderr, "fanout slow sink expected 3 records, got %d\n", gate.received);
+        return 1;
+    }
+
+    smartlog_sink_stats_t st;
+    smartlog_sink_get_stats(err, &st);
+    if(st.records != 1 || st.filtered != 2)
+    {
+        fprintf(stderr, "fanout error sink stats mismatch\n");
+        return 1;
+    }
+
+    smartlog_logger_destroy(lg);
+    return 0;
+}
+
+static int test_async_drop_policy(void)
+{
+    gated_sink_t gate = { PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, 0, 0 };
+
+    smartlog_logger_t* lg = smartlog_logger_create();
+    smartlog_sink_t* slow = smartlog_sink_create(&gated_ops, &gate);
+    if(lg == NULL || slow == NULL ||
+       smartlog_sink_set_async(slow, 2, OVERFLOW_DROP) != 0 ||
+       smartlog_logger_add_sink(lg, slow) != 0)
+    {
+        perror("drop setup");
+        return 1;
+    }
+
+    /* Queue holds 2 (claimed or not) while the writer is stuck */
+    for(int i = 0; i < 10; i++)
+    {
+        if(smartlog_logger_log(lg, LOG_LEVEL_INFO, "drop-me") != 0)
+        {
+            perror("drop log");
+            return 1;
+        }
+    }
+
+    gated_open(&gate);
+    smartlog_logger_flush(lg);
+
+    smartlog_sink_stats_t st;
+    smartlog_sink_get_stats(slow, &st);
+    if(st.dropped != 8 || st.records != 2 || gate.received != 2)
+    {
+        fprintf(stderr, "drop policy mismatch: dropped=%llu records=%llu\n",
+                (unsigned long long)st.dropped, (unsigned long long)st.records);
+        return 1;
+    }
+
+    smartlog_logger_destroy(lg);
+    return 0;
+}
+
+static void sleep_ms(long ms)
+{
+    struct timespec ts = { ms / 1000, (ms % 1000) * 1000000L };
+    nanosleep(&ts, NULL);
+}
+
+/* Stand-in collector: bound datagram socket at path */
+static int open_receiver(const char* path)
+{
+    int fd = socket(AF_UNIX, SOCK_DGRAM | SOCK_NONBLOCK, 0);
+    if(fd < 0)
+    {
+        return -1;
+    }
+
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", path);
+    unlink(path);
+    if(bind(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0)
+    {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/* Read every pending datagram, return how many contain needle */
+static int drain_receiver(int fd, const char* needle)
+{
+    char buf[2048];
+    int hits = 0;
+    for(;;)
+    {
+        ssize_t n = recv(fd, buf, sizeof(buf) - 1, 0);
+        if(n < 0)
+        {
+            break;
+        }
+        buf[n] = '\0';
+        if(strstr(buf, needle) != NULL)
+        {
+            hits++;
+        }
+    }
+    return hits;
+}
+
+/* Sink that only counts lines (thread-safe via the writer thread) */
+static int counting_write(void* ctx, const char* data, size_t len)
+{
+    (void)data;
+    (void)len;
+    (*(int*)ctx)++;
+    return 0;
+}
+
+static const smartlog_sink_ops_t counting_ops = { .write = counting_write };
+
+#define BLOCK_PRODUCERS 4
+#define BLOCK_PER_PRODUCER 2000
+
+static void* block_producer(void* arg)
+{
+    smartlog_logger_t* lg = (smartlog_logger_t*)arg;
+    for(int i = 0; i < BLOCK_PER_PRODUCER; i++)
+    {
+        smartlog_logger_log(lg, LOG_LEVEL_INFO, "block-me");
+    }
+    return NULL;
+}
+
+static int test_async_block_producers(void)
+{
+    int received = 0;
+    smartlog_logger_t* lg = smartlog_logger_create();
+    smartlog_sink_t* sk = smartlog_sink_create(&counting_ops, &received);
+    if(lg == NULL || sk == NULL ||
+       smartlog_sink_set_async(sk, 4, OVERFLOW_BLOCK) != 0 ||
+       smartlog_logger_set_writer_spin(lg, 0) != 0 ||
+       smartlog_logger_add_sink(lg, sk) != 0)
+    {
+        perror("block setup");
+        return 1;
+    }
+
+    /* Tiny queue: producers keep blocking on the writer, none may be lost */
+    pthread_t threads[BLOCK_PRODUCERS];
+    for(int t = 0; t < BLOCK_PRODUCERS; t++)
+    {
+        if(pthread_create(&threads[t], NULL, block_producer, lg) != 0)
+        {
+            fprintf(stderr, "block pthread_create failed\n");
+            return 1;
+        }
+    }
+    for(int t = 0; t < BLOCK_PRODUCERS; t++)
+    {
+        pthread_join(threads[t], NULL);
+    }
+    smartlog_logger_flush(lg);
+
+    smartlog_sink_stats_t st;
+    smartlog_sink_get_stats(sk, &st);
+    if(received != BLOCK_PRODUCERS * BLOCK_PER_PRODUCER || st.dropped != 0 ||
+       st.records != (uint64_t)received)
+    {
+        fprintf(stderr, "block policy lost lines: received=%d dropped=%llu\n",
+                received, (unsigned long long)st.dropped);
+        return 1;
+    }
+
+    /* With no spin, an idle writer sleeps and the next line wakes it */
+    sleep_ms(20);
+    smartlog_logger_log(lg, LOG_LEVEL_INFO, "wake-up");
+    smartlog_logger_flush(lg);
+    smartlog_sink_stats_t after;
+    smartlog_sink_get_stats(sk, &after);
+    if(after.wakeups <= st.wakeups || received != BLOCK_PRODUCERS * BLOCK_PER_PRODUCER + 1)
+    {
+        fprintf(stderr, "idle writer was not woken by futex\n");
+        return 1;
+    }
+
+    smartlog_logger_destroy(lg);
+    return 0;
+}
+
+static int test_writer_affinity(void)
+{
+    int received = 0;
+    int cpu0 = 0;
+    int bad_cpu = -1;
+    smartlog_logger_t* lg = smartlog_logger_create();
+    smartlog_sink_t* sk = smartlog_sink_create(&counting_ops, &received);
+    if(lg == NULL || sk == NULL)
+    {
+        perror("affinity setup");
+        return 1;
+    }
+
+    errno = 0;
+    if(smartlog_logger_set_writer_affinity(lg, &bad_cpu, 1) == 0 || errno != EINVAL)
+    {
+        fprintf(stderr, "affinity accepted a negative CPU\n");
+        return 1;
+    }
+
+    /* Pin first, then go async: the queue follows CPU 0's node */
+    if(smartlog_logger_set_writer_affinity(lg, &cpu0, 1) != 0 ||
+       smartlog_logger_add_sink(lg, sk) != 0 ||
+       smartlog_sink_set_async(sk, 16, OVERFLOW_BLOCK) != 0)
+    {
+        perror("affinity config");
+        return 1;
+    }
+
+    smartlog_logger_log(lg, LOG_LEVEL_INFO, "pinned");
+    smartlog_logger_flush(lg);
+
+    smartlog_sink_stats_t st;
+    smartlog_sink_get_stats(sk, &st);
+    if(received != 1 || st.affinity_mask != 1 || st.writer_cpu != 0 ||
+       st.numa_node != smartlog_cpu_numa_node(0))
+    {
+        fprintf(stderr, "affinity stats mismatch: mask=%llx cpu=%d node=%d\n",
+                (unsigned long long)st.affinity_mask, st.writer_cpu, st.numa_node);
+        return 1;
+    }
+
+    smartlog_logger_destroy(lg);
+    return 0;
+}
+
+static int test_huge_page_regions(void)
+{
+    /* Small requests never use huge pages */
+    smartlog_mem_opts_t opts = { -1, FEATURE_ENABLED };
+    smartlog_region_t small;
+    if(smartlog_region_alloc(&small, 4096, &opts) != 0 || small.pages != PAGES_NORMAL)
+    {
+        fprintf(stderr, "small region should use normal pages\n");
+        return 1;
+    }
+    smartlog_region_free(&small);
+
+    /* Large ones get huge pages or fall back; either way the memory works */
+    smartlog_region_t big;
+    size_t want = 2 * SMARTLOG_HUGE_PAGE_SZ + 100;
+    if(smartlog_region_alloc(&big, want, &opts) != 0 || big.size < want)
+    {
+        perror("huge region");
+        return 1;
+    }
+    if(big.pages != PAGES_NORMAL && ((uintptr_t)big.addr % SMARTLOG_HUGE_PAGE_SZ) != 0)
+    {
+        fprintf(stderr, "huge region not aligned to a huge page\n");
+        return 1;
+    }
+    memset(big.addr, 0xab, want);
+    smartlog_region_free(&big);
+
+    int received = 0;
+    smartlog_logger_t* lg = smartlog_logger_create();
+    smartlog_sink_t* sk = smartlog_sink_create(&counting_ops, &received);
+    if(lg == NULL || sk == NULL ||
+       smartlog_logger_set_huge_pages(lg, FEATURE_ENABLED) != 0 ||
+       smartlog_logger_add_sink(lg, sk) != 0 ||
+       smartlog_sink_set_async(sk, 4096, OVERFLOW_BLOCK) != 0)
+    {
+        perror("huge sink setup");
+        return 1;
+    }
+    errno = 0;
+    if(smartlog_sink_set_huge_pages(sk, FEATURE_DISABLED) == 0 || errno != EINVAL)
+    {
+        fprintf(stderr, "huge pages changed on an async sink\n");
+        return 1;
+    }
+
+    for(int i = 0; i < 5000; i++)
+    {
+        smartlog_logger_log(lg, LOG_LEVEL_INFO, "huge");
+    }
+    smartlog_logger_flush(lg);
+
+    smartlog_sink_stats_t st;
+    smartlog_sink_get_stats(sk, &st);
+    if(received != 5000 || st.queue_pages < PAGES_NORMAL || st.queue_pages > PAGES_HUGETLB)
+    {
+        fprintf(stderr, "huge page sink mismatch\n");
+        return 1;
+    }
+
+    smartlog_logger_destroy(lg);
+    return 0;
+}
+
+/* Gated sink that also checks "spill-<n>" lines arrive in order */
+typedef struct {
+    gated_sink_t gate;
+    int next;
+    int out_of_order;
+} ordered_sink_t;
+
+static int ordered_write(void* ctx, const char* data, size_t len)
+{
+    ordered_sink_t* o = (ordered_sink_t*)ctx;
+    (void)gated_write(&o->gate, data, len);
+
+    const char* tag = strstr(data, "MESSAGE = spill-");
+    if(tag != NULL)
+    {
+        if(atoi(tag + strlen("MESSAGE = spill-")) != o->next)
+        {
+            o->out_of_order++;
+        }
+        o->next++;
+    }
+    return 0;
+}
+
+static const smartlog_sink_ops_t ordered_ops = { .write = ordered_write };
+
+static int test_async_spill_policy(const char* dir)
+{
+    ordered_sink_t ord = { { PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, 0, 0 }, 0, 0 };
+
+    smartlog_logger_t* lg = smartlog_logger_create();
+    smartlog_sink_t* sk = smartlog_sink_create(&ordered_ops, &ord);
+    if(lg == NULL || sk == NULL ||
+       smartlog_sink_set_spill_dir(sk, dir) != 0 ||
+       smartlog_sink_set_async(sk, 4, OVERFLOW_SPILL) != 0 ||
+       smartlog_logger_add_sink(lg, sk) != 0)
+    {
+        perror("spill setup");
+        return 1;
+    }
+
+    /* Writer is stuck: the queue fills and the rest spills, caller never blocks */
+    const int lines = 5000;
+    for(int i = 0; i < lines; i++)
+    {
+        char msg[32];
+        snprintf(msg, sizeof(msg), "spill-%d", i);
+        if(smartlog_logger_log(lg, LOG_LEVEL_INFO, msg) != 0)
+        {
+            perror("spill log");
+            return 1;
+        }
+    }
+
+    smartlog_sink_stats_t st;
+    smartlog_sink_get_stats(sk, &st);
+    if(st.spilled < (uint64_t)(lines - 4))
+    {
+        fprintf(stderr, "spill expected >= %d spilled lines, got %llu\n",
+                lines - 4, (unsigned long long)st.spilled);
+        return 1;
+    }
+
+    /* Writer catches up: queue first, then the spill, all in order */
+    gated_open(&ord.gate);
+    smartlog_logger_flush(lg);
+    smartlog_logger_log(lg, LOG_LEVEL_INFO, "spill-5000");
+    smartlog_logger_flush(lg);
+
+    smartlog_sink_get_stats(sk, &st);
+    if(ord.gate.received != lines + 1 || ord.out_of_order != 0 ||
+       st.dropped != 0 || st.records != (uint64_t)(lines + 1))
+    {
+        fprintf(stderr, "spill replay mismatch: received=%d out_of_order=%d dropped=%llu\n",
+                ord.gate.received, ord.out_of_order, (unsigned long long)st.dropped);
+        return 1;
+    }
+
+    smartlog_logger_destroy(lg);
+    return 0;
+}
+
+/* Writer stuck forever; the crash drain writes to crash_fd instead */
+typedef struct {
+    gated_sink_t gate;
+    int fd;
+} stuck_sink_t;
+
+static int stuck_write(void* ctx, const char* data, size_t len)
+{
+    return gated_write(&((stuck_sink_t*)ctx)->gate, data, len);
+}
+
+static int stuck_crash_fd(void* ctx)
+{
+    return ((stuck_sink_t*)ctx)->fd;
+}
+
+static const smartlog_sink_ops_t stuck_ops = { .write = stuck_write, .crash_fd = stuck_crash_fd };
+
+static int test_crash_flush(const char* dir)
+{
+    char path[512];
+    snprintf(path, sizeof(path), "%s/crash.log", dir);
+
+    pid_t pid = fork();
+    if(pid < 0)
+    {
+        perror("fork");
+        return 1;
+    }
+    if(pid == 0)
+    {
+        stuck_sink_t stuck = { { PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, 0, 0 }, -1 };
+        stuck.fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+        smartlog_logger_t* lg = smartlog_logger_create();
+        smartlog_sink_t* sk = smartlog_sink_create(&stuck_ops, &stuck);
+        if(stuck.fd < 0 || lg == NULL || sk == NULL ||
+           smartlog_sink_set_async(sk, 256, OVERFLOW_DROP) != 0 ||
+           smartlog_logger_add_sink(lg, sk) != 0 ||
+           smartlog_logger_enable_crash_flush(lg) != 0)
+        {
+            _exit(3);
+        }
+        for(int i = 0; i < 100; i++)
+        {
+            char msg[32];
+            snprintf(msg, sizeof(msg), "crash-%d", i);
+            smartlog_logger_log(lg, LOG_LEVEL_INFO, msg);
+        }
+        abort();
+    }
+
+    int status = 0;
+    if(waitpid(pid, &status, 0) != pid || !WIFSIGNALED(status) || WTERMSIG(status) != SIGABRT)
+    {
+        fprintf(stderr, "crash child did not die on SIGABRT (status %d)\n", status);
+        return 1;
+    }
+
+    /* Every queued line, including the one the writer was stuck on */
+    static char content[1 << 16];
+    if(read_file(path, content, sizeof(content)) != 0 ||
+       strstr(content, "MESSAGE = crash-0]") == NULL ||
+       strstr(content, "MESSAGE = crash-99]") == NULL)
+    {
+        fprintf(stderr, "crash flush lost queued lines\n");
+        return 1;
+    }
+
+    return 0;
+}
+
+static int test_unix_sink(const char* dir)
+{
+    char sock_path[512];
+    snprintf(sock_path, sizeof(sock_path), "%s/collector.sock", dir);
+
+    smartlog_logger_t* lg = smartlog_logger_create();
+    smartlog_sink_t* sk = smartlog_sink_unix_open(sock_path, SOCK_DGRAM, 64);
+    if(lg == NULL || sk == NULL || smartlog_logger_add_sink(lg, sk) != 0)
+    {
+        perror("unix sink setup");
+        return 1;
+    }
+
+    /* No collector yet: lines are dropped, caller does not block */
+    smartlog_logger_log(lg, LOG_LEVEL_INFO, "sock-early");
+    smartlog_logger_flush(lg);
+
+    smartlog_sink_stats_t st;
+    smartlog_sink_get_stats(sk, &st);
+    if(st.dropped != 1 || st.records != 0)
+    {
+        fprintf(stderr, "unix sink expected 1 drop before collector start\n");
+        return 1;
+    }
+
+    /* Collector comes up; after the backoff the sink reconnects */
+    int rx = open_receiver(sock_path);
+    if(rx < 0)
+    {
+        perror("receiver");
+        return 1;
+    }
+    sleep_ms(SMARTLOG_RECONNECT_MS + 50);
+    smartlog_logger_log(lg, LOG_LEVEL_INFO, "sock-live");
+    smartlog_logger_log(lg, LOG_LEVEL_INFO, "sock-live");
+    smartlog_logger_flush(lg);
+    if(drain_receiver(rx, "MESSAGE = sock-live") != 2)
+    {
+        fprintf(stderr, "unix sink lines not received\n");
+        return 1;
+    }
+
+    /* Collector restarts: one line is lost, then delivery resumes */
+    close(rx);
+    rx = open_receiver(sock_path);
+    if(rx < 0)
+    {
+        perror("receiver restart");
+        return 1;
+    }
+    smartlog_logger_log(lg, LOG_LEVEL_INFO, "sock-lost");
+    smartlog_logger_flush(lg);
+    sleep_ms(SMARTLOG_RECONNECT_MS + 50);
+    smartlog_logger_log(lg, LOG_LEVEL_INFO, "sock-again");
+    smartlog_logger_flush(lg);
+    if(drain_receiver(rx, "MESSAGE = sock-again") != 1)
+    {
+        fprintf(stderr, "unix sink did not reconnect\n");
+        return 1;
+    }
+
+    smartlog_sink_get_stats(sk, &st);
+    if(st.records != 3 || st.dropped != 2 || st.errors != 0)
+    {
+        fprintf(stderr, "unix sink stats mismatch: records=%llu dropped=%llu\n",
+                (unsigned long long)st.records, (unsigned long long)st.dropped);
+        return 1;
+    }
+
+    smartlog_logger_destroy(lg);
+    close(rx);
+    return 0;
+}
+
+static int send_line(int fd, const char* path, const char* line)
+{
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", path);
+    return sendto(fd, line, strlen(line), 0, (struct sockaddr*)&addr, sizeof(addr)) < 0 ? -1 : 0;
+}
+
+static int test_collector_merge(const char* dir)
+{
+    char sock_path[512];
+    char out_path[512];
+    snprintf(sock_path, sizeof(sock_path), "%s/smartlogd.sock", dir);
+    snprintf(out_path, sizeof(out_path), "%s/merged.log", dir);
+
+    smartlog_collector_config_t cfg;
+    smartlog_collector_config_init(&cfg);
+    cfg.socket_path = sock_path;
+    cfg.output_path = out_path;
+    cfg.durable = FEATURE_ENABLED;
+
+    smartlog_collector_t* col = smartlog_collector_create(&cfg);
+    int tx = socket(AF_UNIX, SOCK_DGRAM, 0);
+    if(col == NULL || tx < 0)
+    {
+        perror("collector setup");
+        return 1;
+    }
+
+    /* Two "processes" with interleaved, out-of-order timestamps */
+    if(send_line(tx, sock_path, "[300 ns] [PID = 2] [MESSAGE = c]\n") != 0 ||
+       send_line(tx, sock_path, "[100 ns] [PID = 1] [MESSAGE = a]\n") != 0 ||
+       send_line(tx, sock_path, "[200 ns] [PID = 2] [MESSAGE = b]\n") != 0)
+    {
+        perror("collector send");
+        return 1;
+    }
+    if(smartlog_collector_run_once(col, 100) != 0)
+    {
+        perror("collector run");
+        return 1;
+    }
+
+    /* Straggler older than what was already written */
+    send_line(tx, sock_path, "[150 ns] [PID = 1] [MESSAGE = late]\n");
+    smartlog_collector_run_once(col, 100);
+
+    /* End to end: logger -> socket sink -> collector */
+    smartlog_logger_t* lg = smartlog_logger_create();
+    smartlog_sink_t* sk = smartlog_sink_unix_open(sock_path, SOCK_DGRAM, 0);
+    if(lg == NULL || sk == NULL || smartlog_logger_add_sink(lg, sk) != 0)
+    {
+        perror("collector client");
+        return 1;
+    }
+    smartlog_logger_log(lg, LOG_LEVEL_INFO, "via-daemon");
+    smartlog_logger_flush(lg);
+    smartlog_collector_run_once(col, 100);
+    if(smartlog_collector_drain(col) != 0)
+    {
+        perror("collector drain");
+        return 1;
+    }
+
+    smartlog_collector_stats_t st;
+    smartlog_collector_get_stats(col, &st);
+    smartlog_collector_destroy(col);
+    smartlog_logger_destroy(lg);
+    close(tx);
+
+    char content[2048];
+    if(read_file(out_path, content, sizeof(content)) != 0)
+    {
+        perror("read merged");
+        return 1;
+    }
+
+    const char* a = strstr(content, "MESSAGE = a]");
+    const char* b = strstr(content, "MESSAGE = b]");
+    const char* c = strstr(content, "MESSAGE = c]");
+    if(a == NULL || b == NULL || c == NULL || !(a < b && b < c) ||
+       strstr(content, "MESSAGE = via-daemon") == NULL)
+    {
+        fprintf(stderr, "collector output not merged in order\n");
+        return 1;
+    }
+    if(st.received != 5 || st.written != 5 || st.late != 1)
+    {
+        fprintf(stderr, "collector stats mismatch: received=%llu written=%llu late=%llu\n",
+                (unsigned long long)st.received, (unsigned long long)st.written,
+                (unsigned long long)st.late);
+        return 1;
+    }
+    if(file_exists(sock_path))
+    {
+        fprintf(stderr, "collector socket not removed\n");
+        return 1;
+    }
+
+    return 0;
+}
+
+static int test_shm_ring_cross_process(const char* dir)
+{
+    char sock_path[512];
+    char ring_path[512];
+    char out_path[512];
+    snprintf(sock_path, sizeof(sock_path), "%s/ringd.sock", dir);
+    snprintf(ring_path, sizeof(ring_path), "%s/ringd.ctl", dir);
+    snprintf(out_path, sizeof(out_path), "%s/ring.log", dir);
+
+    smartlog_collector_config_t cfg;
+    smartlog_collector_config_init(&cfg);
+    cfg.socket_path = sock_path;
+    cfg.ring_socket_path = ring_path;
+    cfg.output_path = out_path;
+    cfg.reorder_window_ms = 1;
+
+    smartlog_collector_t* col = smartlog_collector_create(&cfg);
+    if(col == NULL)
+    {
+        perror("ring collector");
+        return 1;
+    }
+
+    /* Two client processes, each with its own memfd ring */
+    const int lines_per_child = 2000;
+    pid_t kids[2];
+    for(int k = 0; k < 2; k++)
+    {
+        kids[k] = fork();
+        if(kids[k] < 0)
+        {
+            perror("fork");
+            return 1;
+        }
+        if(kids[k] == 0)
+        {
+            smartlog_logger_t* lg = smartlog_logger_create();
+            smartlog_sink_t* sk = smartlog_sink_shm_open(ring_path, 1u << 16);
+            if(lg == NULL || sk == NULL || smartlog_logger_add_sink(lg, sk) != 0)
+            {
+                _exit(3);
+            }
+            for(int i = 0; i < lines_per_child; i++)
+            {
+                char msg[64];
+                snprintf(msg, sizeof(msg), "ring-child-%d-%d", k, i);
+                while(1)
+                {
+                    smartlog_sink_stats_t st;
+                    smartlog_sink_get_stats(sk, &st);
+                    uint64_t before = st.dropped;
+                    smartlog_logger_log(lg, LOG_LEVEL_INFO, msg);
+                    smartlog_sink_get_stats(sk, &st);
+                    if(st.dropped == before)
+                    {
+                        break;
+                    }
+                    /* Ring full: let the collector catch up, then retry */
+                    sleep_ms(1);
+                }
+            }
+            smartlog_logger_destroy(lg);
+            _exit(0);
+        }
+    }
+
+    /* Run the collector until both children exited and detached */
+    int exited = 0;
+    int status_ok = 1;
+    for(int spins = 0; spins < 20000; spins++)
+    {
+        if(smartlog_collector_run_once(col, 10) != 0)
+        {
+            perror("ring collector run");
+            return 1;
+        }
+        for(int k = 0; k < 2; k++)
+        {
+            int status = 0;
+            if(kids[k] > 0 && waitpid(kids[k], &status, WNOHANG) == kids[k])
+            {
+                status_ok &= WIFEXITED(status) && WEXITSTATUS(status) == 0;
+                kids[k] = 0;
+                exited++;
+            }
+        }
+
+        smartlog_collector_stats_t st;
+        smartlog_collector_get_stats(col, &st);
+        if(exited == 2 && st.ring_clients == 0)
+        {
+            break;
+        }
+    }
+
+    smartlog_collector_drain(col);
+    smartlog_collector_stats_t st;
+    smartlog_collector_get_stats(col, &st);
+    smartlog_collector_destroy(col);
+
+    if(!status_ok || exited != 2)
+    {
+        fprintf(stderr, "ring children failed\n");
+        return 1;
+    }
+    if(st.received != (uint64_t)(2 * lines_per_child) || st.written != st.received)
+    {
+        fprintf(stderr, "ring transport expected %d lines, got %llu\n",
+                2 * lines_per_child, (unsigned long long)st.received);
+        return 1;
+    }
+
+    static char content[1 << 20];
+    if(read_file(out_path, content, sizeof(content)) != 0 ||
+       strstr(content, "MESSAGE = ring-child-0-1999]") == NULL ||
+       strstr(content, "MESSAGE = ring-child-1-0]") == NULL)
+    {
+        fprintf(stderr, "ring output missing lines\n");
+        return 1;
+    }
+
+    return 0;
+}
+
+static int test_collector_pending_hello(const char* dir)
+{
+    char sock_path[512];
+    char ring_path[sizeof(((struct sockaddr_un*)0)->sun_path)];
+    char out_path[512];
+    snprintf(sock_path, sizeof(sock_path), "%s/pendd.sock", dir);
+    snprintf(ring_path, sizeof(ring_path), "%s/pendd.ctl", dir);
+    snprintf(out_path, sizeof(out_path), "%s/pend.log", dir);
+
+    smartlog_collector_config_t cfg;
+    smartlog_collector_config_init(&cfg);
+    cfg.socket_path = sock_path;
+    cfg.ring_socket_path = ring_path;
+    cfg.output_path = out_path;
+    cfg.reorder_window_ms = 1;
+
+    smartlog_collector_t* col = smartlog_collector_create(&cfg);
+    if(col == NULL)
+    {
+        perror("pending collector");
+        return 1;
+    }
+
+    /* A client that connects but never sends its hello */
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", ring_path);
+    int silent = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if(silent < 0 || connect(silent, (struct sockaddr*)&addr, sizeof(addr)) != 0)
+    {
+        perror("pending connect");
+        return 1;
+    }
+
+    /* The event loop must not wait for that hello */
+    uint64_t start = smartlog_timestamp_ns();
+    if(smartlog_collector_run_once(col, 0) != 0)
+    {
+        perror("pending run");
+        return 1;
+    }
+    uint64_t took_ms = (smartlog_timestamp_ns() - start) / UINT64_C(1000000);
+
+    /* A real client registers while the silent one is still pending */
+    smartlog_sink_t* sk = smartlog_sink_shm_open(ring_path, 1u << 16);
+    smartlog_collector_stats_t st;
+    memset(&st, 0, sizeof(st));
+    for(int spins = 0; sk != NULL && spins < 100 && st.ring_clients == 0; spins++)
+    {
+        (void)smartlog_collector_run_once(col, 1);
+        smartlog_collector_get_stats(col, &st);
+    }
+
+    /* The silent client is dropped once its hello is overdue */
+    int dropped = 0;
+    for(int spins = 0; spins < 200 && !dropped; spins++)
+    {
+        (void)smartlog_collector_run_once(col, 10);
+        char byte;
+        ssize_t n = recv(silent, &byte, 1, MSG_DONTWAIT);
+        dropped = n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK);
+    }
+
+    close(silent);
+    smartlog_sink_destroy(sk);
+    smartlog_collector_destroy(col);
+
+    if(took_ms >= (uint64_t)SMARTLOG_COLLECTOR_HELLO_MS / 2)
+    {
+        fprintf(stderr, "collector blocked %llu ms on a pending hello\n", (unsigned long long)took_ms);
+        return 1;
+    }
+    if(sk == NULL || st.ring_clients != 1 || !dropped)
+    {
+        fprintf(stderr, "pending hello handling failed (clients %llu, dropped %d)\n",
+                (unsigned long long)st.ring_clients, dropped);
+        return 1;
+    }
+    return 0;
+}
+
+static int test_shm_ring_sealed(const char* dir)
+{
+    char ring_path[sizeof(((struct sockaddr_un*)0)->sun_path)];
+    snprintf(ring_path, sizeof(ring_path), "%s/sealed.ctl", dir);
+    (void)unlink(ring_path);
+
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", ring_path);
+
+    int listen_fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if(listen_fd < 0 || bind(listen_fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 ||
+       listen(listen_fd, 4) != 0)
+    {
+        perror("sealed listen");
+        return 1;
+    }
+
+    /* Accepting never waits: nothing has connected yet */
+    if(smartlog_shm_ring_accept(listen_fd) >= 0 || errno != EAGAIN)
+    {
+        fprintf(stderr, "shm ring accept did not report EAGAIN\n");
+        return 1;
+    }
+
+    smartlog_shm_ring_t* producer = smartlog_shm_ring_connect(ring_path, 1u << 16);
+    int conn_fd = producer != NULL ? smartlog_shm_ring_accept(listen_fd) : -1;
+    smartlog_shm_ring_t* consumer = conn_fd >= 0 ? smartlog_shm_ring_attach(conn_fd) : NULL;
+    if(producer == NULL || consumer == NULL)
+    {
+        perror("sealed handshake");
+        return 1;
+    }
+
+    /* Every descriptor of the ring's memfd must refuse to shrink it */
+    int checked = 0;
+    int failed = 0;
+    DIR* fds = opendir("/proc/self/fd");
+    struct dirent* de;
+    while(fds != NULL && (de = readdir(fds)) != NULL)
+    {
+        char link_path[300];
+        char target[256];
+        snprintf(link_path, sizeof(link_path), "/proc/self/fd/%s", de->d_name);
+        ssize_t n = readlink(link_path, target, sizeof(target) - 1);
+        if(n <= 0)
+        {
+            continue;
+        }
+        target[n] = '\0';
+        if(strncmp(target, "/memfd:smartlog-ring", 20) != 0)
+        {
+            continue;
+        }
+        checked++;
+        int fd = atoi(de->d_name);
+        if(ftruncate(fd, 4096) == 0 || errno != EPERM)
+        {
+            failed = 1;
+        }
+    }
+    if(fds != NULL)
+    {
+        closedir(fds);
+    }
+
+    /* The ring still works after the refused shrink */
+    char buf[64];
+    int ok = smartlog_shm_ring_push(producer, "sealed", 6) == 0 &&
+             smartlog_shm_ring_pop(consumer, buf, sizeof(buf)) == 6 &&
+             memcmp(buf, "sealed", 6) == 0;
+
+    smartlog_shm_ring_destroy(consumer);
+    smartlog_shm_ring_destroy(producer);
+    close(conn_fd);
+    close(listen_fd);
+    (void)unlink(ring_path);
+
+    if(checked < 2 || failed || !ok)
+    {
+        fprintf(stderr, "shm ring memfd not sealed (checked %d, failed %d, ok %d)\n", checked, failed, ok);
+        return 1;
+    }
+    return 0;
+}
+
+static int test_collector_corrupt_ring(const char* dir)
+{
+    char sock_path[512];
+    char ring_path[sizeof(((struct sockaddr_un*)0)->sun_path)];
+    char out_path[512];
+    snprintf(sock_path, sizeof(sock_path), "%s/corruptd.sock", dir);
+    snprintf(ring_path, sizeof(ring_path), "%s/corruptd.ctl", dir);
+    snprintf(out_path, sizeof(out_path), "%s/corrupt.log", dir);
+
+    smartlog_collector_config_t cfg;
+    smartlog_collector_config_init(&cfg);
+    cfg.socket_path = sock_path;
+    cfg.ring_socket_path = ring_path;
+    cfg.output_path = out_path;
+    cfg.reorder_window_ms = 1;
+
+    smartlog_collector_t* col = smartlog_collector_create(&cfg);
+    smartlog_shm_ring_t* producer = col != NULL ? smartlog_shm_ring_connect(ring_path, 1u << 16) : NULL;
+    if(producer == NULL)
+    {
+        perror("corrupt ring setup");
+        return 1;
+    }
+    smartlog_collector_stats_t st;
+    memset(&st, 0, sizeof(st));
+    for(int spins = 0; spins < 100 && st.ring_clients == 0; spins++)
+    {
+        (void)smartlog_collector_run_once(col, 1);
+        smartlog_collector_get_stats(col, &st);
+    }
+
+    /* Find the ring's memfd and push head far past the tail */
+    int memfd = -1;
+    DIR* fds = opendir("/proc/self/fd");
+    struct dirent* de;
+    while(fds != NULL && memfd < 0 && (de = readdir(fds)) != NULL)
+    {
+        char link_path[300];
+        char target[256];
+        snprintf(link_path, sizeof(link_path), "/proc/self/fd/%s", de->d_name);
+        ssize_t n = readlink(link_path, target, sizeof(target) - 1);
+        if(n > 0)
+        {
+            target[n] = '\0';
+            if(strncmp(target, "/memfd:smartlog-ring", 20) == 0)
+            {
+                memfd = atoi(de->d_name);
+            }
+        }
+    }
+    if(fds != NULL)
+    {
+        closedir(fds);
+    }
+    void* hdr = memfd >= 0 ? mmap(NULL, 4096, PROT_READ | PROT_WRITE, MAP_SHARED, memfd, 0) : MAP_FAILED;
+    if(st.ring_clients != 1 || hdr == MAP_FAILED)
+    {
+        fprintf(stderr, "corrupt ring: client not attached\n");
+        return 1;
+    }
+    /* head is the first field of the second cache line of the shared header */
+    uint64_t bogus = UINT64_C(1) << 40;
+    memcpy((char*)hdr + SMARTLOG_CACHE_LINE, &bogus, sizeof(bogus));
+    munmap(hdr, 4096);
+
+    /* The collector must detach it instead of spinning on it */
+    for(int spins = 0; spins < 10 && st.ring_clients != 0; spins++)
+    {
+        if(smartlog_collector_run_once(col, 0) != 0)
+        {
+            perror("corrupt ring run");
+            return 1;
+        }
+        smartlog_collector_get_stats(col, &st);
+    }
+
+    smartlog_shm_ring_destroy(producer);
+    smartlog_collector_destroy(col);
+
+    if(st.ring_clients != 0 || st.ring_errors != 1)
+    {
+        fprintf(stderr, "corrupt ring not detached (clients %llu, errors %llu)\n",
+                (unsigned long long)st.ring_clients, (unsigned long long)st.ring_errors);
+        return 1;
+    }
+    return 0;
+}
+
+static int test_mpsc_single_thread(void)
+{
+    smartlog_mpsc_t* q = smartlog_mpsc_create(4, 16);
+    if(q == NULL)
+    {
+        perror("mpsc create");
+        return 1;
+    }
+
+    char big[32] = { 0 };
+    errno = 0;
+    if(smartlog_mpsc_push(q, big, sizeof(big)) == 0 || errno != EMSGSIZE)
+    {
+        fprintf(stderr, "mpsc oversize push expected EMSGSIZE\n");
+        return 1;
+    }
+
+    for(int i = 0; i < 4; i++)
+    {
+        if(smartlog_mpsc_push(q, &i, sizeof(i)) != 0)
+        {
+            perror("mpsc push");
+            return 1;
+        }
+    }
+    errno = 0;
+    if(smartlog_mpsc_push(q, big, 1) == 0 || errno != EAGAIN)
+    {
+        fprintf(stderr, "mpsc full push expected EAGAIN\n");
+        return 1;
+    }
+
+    /* Batch claim reads in place; nothing moves until release */
+    const void* elems[8];
+    size_t lens[8];
+    if(smartlog_mpsc_claim(q, elems, lens, 8) != 4 ||
+       smartlog_mpsc_claim(q, elems, lens, 2) != 2 ||
+       *(const int*)elems[1] != 1 || lens[1] != sizeof(int))
+    {
+        fprintf(stderr, "mpsc claim mismatch\n");
+        return 1;
+    }
+    smartlog_mpsc_release(q, 2);
+
+    int value = 0;
+    int five = 5;
+    if(smartlog_mpsc_push(q, &five, sizeof(five)) != 0 ||
+       smartlog_mpsc_pop(q, &value, sizeof(value), NULL) != 1 || value != 2 ||
+       smartlog_mpsc_pop(q, &value, sizeof(value), NULL) != 1 || value != 3 ||
+       smartlog_mpsc_pop(q, &value, sizeof(value), NULL) != 1 || value != 5 ||
+       smartlog_mpsc_pop(q, &value, sizeof(value), NULL) != 0)
+    {
+        fprintf(stderr, "mpsc wraparound order mismatch\n");
+        return 1;
+    }
+
+    /* Empty queue: wait times out and reports nothing ready */
+    if(smartlog_mpsc_wait(q, 1000000) != 0 || smartlog_mpsc_size(q) != 0)
+    {
+        fprintf(stderr, "mpsc wait on empty queue mismatch\n");
+        return 1;
+    }
+
+    smartlog_mpsc_destroy(q);
+    return 0;
+}
+
+#define MPSC_PRODUCERS 4
+#define MPSC_PER_PRODUCER 20000
+
+typedef struct {
+    smartlog_mpsc_t* q;
+    int id;
+} mpsc_producer_t;
+
+static void* mpsc_producer(void* arg)
+{
+    mpsc_producer_t* p = (mpsc_producer_t*)arg;
+    for(int i = 0; i < MPSC_PER_PRODUCER; i++)
+    {
+        int item[2] = { p->id, i };
+        while(smartlog_mpsc_push(p->q, item, sizeof(item)) != 0)
+        {
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+static int test_mpsc_producers(void)
+{
+    smartlog_mpsc_t* q = smartlog_mpsc_create(64, 2 * sizeof(int));
+    if(q == NULL)
+    {
+        perror("mpsc create");
+        return 1;
+    }
+
+    pthread_t threads[MPSC_PRODUCERS];
+    mpsc_producer_t args[MPSC_PRODUCERS];
+    for(int t = 0; t < MPSC_PRODUCERS; t++)
+    {
+        args[t].q = q;
+        args[t].id = t;
+        if(pthread_create(&threads[t], NULL, mpsc_producer, &args[t]) != 0)
+        {
+            fprintf(stderr, "mpsc pthread_create failed\n");
+            return 1;
+        }
+    }
+
+    /* Every element arrives once, in order per producer */
+    int next[MPSC_PRODUCERS] = { 0 };
+    int total = 0;
+    while(total < MPSC_PRODUCERS * MPSC_PER_PRODUCER)
+    {
+        const void* elems[16];
+        size_t lens[16];
+        size_t n = smartlog_mpsc_claim(q, elems, lens, 16);
+        if(n == 0)
+        {
+            smartlog_mpsc_wait(q, 10000000);
+            continue;
+        }
+        for(size_t i = 0; i < n; i++)
+        {
+            const int* item = (const int*)elems[i];
+            if(lens[i] != 2 * sizeof(int) || item[0] < 0 || item[0] >= MPSC_PRODUCERS ||
+               item[1] != next[item[0]])
+            {
+                fprintf(stderr, "mpsc out of order element\n");
+                return 1;
+            }
+            next[item[0]]++;
+        }
+        smartlog_mpsc_release(q, n);
+        total += (int)n;
+    }
+
+    for(int t = 0; t < MPSC_PRODUCERS; t++)
+    {
+        pthread_join(threads[t], NULL);
+    }
+    if(smartlog_mpsc_size(q) != 0)
+    {
+        fprintf(stderr, "mpsc not empty after drain\n");
+        return 1;
+    }
+
+    smartlog_mpsc_destroy(q);
+    return 0;
+}
+
+static int test_record_sequence(const char* dir)
+{
+    char path[512];
+    snprintf(path, sizeof(path), "%s/seq.log", dir);
+
+    smartlog_logger_t* lg = smartlog_logger_create();
+    smartlog_sink_t* sk = smartlog_sink_file_open(path, FEATURE_DISABLED, FEATURE_DISABLED, 0);
+    if(lg == NULL || sk == NULL || smartlog_logger_add_sink(lg, sk) != 0 ||
+       smartlog_logger_log(lg, LOG_LEVEL_INFO, "first") != 0 ||
+       smartlog_logger_log(lg, LOG_LEVEL_INFO, "second") != 0)
+    {
+        perror("sequence setup");
+        return 1;
+    }
+    smartlog_logger_destroy(lg);
+
+    char content[2048];
+    char tid_field[64];
+    /* Main thread: the thread ID equals the process ID */
+    snprintf(tid_field, sizeof(tid_field), "[TID = %ld] [SEQ = 1] [MESSAGE = first]", (long)getpid());
+    if(read_file(path, content, sizeof(content)) != 0 ||
+       strstr(content, tid_field) == NULL ||
+       strstr(content, "[SEQ = 2] [MESSAGE = second]") == NULL)
+    {
+        fprintf(stderr, "records missing thread ID or sequence: %s\n", content);
+        return 1;
+    }
+
+    /* The field is only read from the header, not from the message */
+    uint64_t seq = 0;
+    const char* line = strchr(content, '\n');
+    const char* fake = "[1 ns] [PID = 1] [MESSAGE = x] [SEQ = 9]\n";
+    if(smartlog_line_seq(content, strlen(content), &seq) != 0 || seq != 1 ||
+       line == NULL || smartlog_line_seq(line + 1, strlen(line + 1), &seq) != 0 || seq != 2 ||
+       smartlog_line_seq(fake, strlen(fake), &seq) == 0)
+    {
+        fprintf(stderr, "smartlog_line_seq mismatch\n");
+        return 1;
+    }
+
+    return 0;
+}
+
+static int test_anchored_clock(const char* dir)
+{
+    /* Converted readings track CLOCK_REALTIME; only the first call anchors */
+    clock_mode_t modes[] = { CLOCK_MODE_MONOTONIC_RAW, CLOCK_MODE_TSC };
+    for(size_t i = 0; i < 2; i++)
+    {
+        smartlog_clock_t* clk = smartlog_clock_create(modes[i]);
+        if(clk == NULL)
+        {
+            if(modes[i] == CLOCK_MODE_TSC && errno == ENOTSUP && !smartlog_clock_tsc_invariant())
+            {
+                continue;
+            }
+            perror("smartlog_clock_create");
+            return 1;
+        }
+
+        smartlog_clock_anchor_t anchor;
+        int first = 0;
+        int second = 1;
+        uint64_t before = smartlog_timestamp_ns();
+        uint64_t t1 = smartlog_clock_now(clk, &anchor, &first);
+        uint64_t t2 = smartlog_clock_now(clk, &anchor, &second);
+        uint64_t after = smartlog_timestamp_ns();
+        smartlog_clock_destroy(clk);
+
+        if(first != 1 || second != 0 || t1 + 1000000 < before || t2 > after + 1000000 || t2 + 1000000 < t1)
+        {
+            fprintf(stderr, "clock mode %d off: before=%llu t1=%llu t2=%llu after=%llu\n", (int)modes[i],
+                    (unsigned long long)before, (unsigned long long)t1,
+                    (unsigned long long)t2, (unsigned long long)after);
+            return 1;
+        }
+    }
+
+    /* TSC is refused when it is not invariant */
+    smartlog_logger_t* lg = smartlog_logger_create();
+    setenv("SMARTLOG_FAKE_TSC_VARIANT", "1", 1);
+    int rc = smartlog_logger_set_clock(lg, CLOCK_MODE_TSC);
+    int saved_errno = errno;
+    unsetenv("SMARTLOG_FAKE_TSC_VARIANT");
+    if(rc == 0 || saved_errno != ENOTSUP)
+    {
+        fprintf(stderr, "variant TSC accepted\n");
+        return 1;
+    }
+
+    /* Logger writes an anchor record before the first entry */
+    char path[512];
+    snprintf(path, sizeof(path), "%s/clock.log", dir);
+    smartlog_sink_t* sk = smartlog_sink_file_open(path, FEATURE_DISABLED, FEATURE_DISABLED, 0);
+    if(sk == NULL || smartlog_logger_add_sink(lg, sk) != 0 ||
+       smartlog_logger_set_clock(lg, CLOCK_MODE_MONOTONIC_RAW) != 0 ||
+       smartlog_logger_log(lg, LOG_LEVEL_INFO, "tick") != 0 ||
+       smartlog_logger_log(lg, LOG_LEVEL_INFO, "tock") != 0)
+    {
+        perror("clock logger");
+        return 1;
+    }
+    smartlog_logger_destroy(lg);
+
+    char content[2048];
+    const char* anchor_line = NULL;
+    const char* tick = NULL;
+    if(read_file(path, content, sizeof(content)) != 0 ||
+       (anchor_line = strstr(content, "[SEQ = 1] [MESSAGE = clock anchor mode=monotonic_raw raw=")) == NULL ||
+       (tick = strstr(content, "[SEQ = 2] [MESSAGE = tick]")) == NULL ||
+       strstr(content, "[SEQ = 3] [MESSAGE = tock]") == NULL ||
+       strstr(tick, "clock anchor") != NULL)
+    {
+        fprintf(stderr, "anchor record missing: %s\n", content);
+        return 1;
+    }
+
+    /* An ERROR-only sink behind a recorder still gets the INFO entry's anchor */
+    snprintf(path, sizeof(path), "%s/clock_error_only.log", dir);
+    lg = smartlog_logger_create();
+    sk = smartlog_sink_file_open(path, FEATURE_DISABLED, FEATURE_DISABLED, 0);
+    if(lg == NULL || sk == NULL || smartlog_sink_set_level(sk, LOG_LEVEL_ERROR) != 0 ||
+       smartlog_logger_add_sink(lg, sk) != 0 ||
+       smartlog_logger_set_clock(lg, CLOCK_MODE_MONOTONIC_RAW) != 0 ||
+       smartlog_logger_enable_recorder(lg, SMARTLOG_RECORDER_MIN_RING, LOG_LEVEL_ERROR) != 0 ||
+       smartlog_logger_log(lg, LOG_LEVEL_INFO, "quiet") != 0)
+    {
+        perror("clock error-only logger");
+        return 1;
+    }
+    smartlog_logger_destroy(lg);
+    if(read_file(path, content, sizeof(content)) != 0 ||
+       strstr(content, "[MESSAGE = clock anchor mode=monotonic_raw raw=") == NULL ||
+       strstr(content, "quiet") != NULL)
+    {
+        fprintf(stderr, "anchor not delivered past sink level: %s\n", content);
+        return 1;
+    }
+
+    return 0;
+}
+
+static int test_merge_files(const char* dir)
+{
+    char a_path[512];
+    char b_path[512];
+    char gen[600];
+    char out_path[512];
+    snprintf(a_path, sizeof(a_path), "%s/merge_a.log", dir);
+    snprintf(b_path, sizeof(b_path), "%s/merge_b.log", dir);
+    snprintf(out_path, sizeof(out_path), "%s/merge_out.log", dir);
+
+    /* Input a: two rotated generations, no sequence fields, untimed tail */
+    snprintf(gen, sizeof(gen), "%s.2", a_path);
+    int rc = write_text(gen, "[100 ns] [PID = 1] [MESSAGE = a1]\n");
+    snprintf(gen, sizeof(gen), "%s.1", a_path);
+    rc |= write_text(gen, "[300 ns] [PID = 1] [MESSAGE = a2]\n");
+    rc |= write_text(a_path, "[500 ns] [PID = 1] [MESSAGE = a3]\ncontinued\n");
+
+    /* Input b: tie on 300 ns, then a clock step back */
+    rc |= write_text(b_path,
+                     "[200 ns] [PID = 2] [TID = 2] [SEQ = 1] [MESSAGE = b1]\n"
+                     "[300 ns] [PID = 2] [TID = 2] [SEQ = 2] [MESSAGE = b2]\n"
+                     "[250 ns] [PID = 2] [TID = 3] [SEQ = 3] [MESSAGE = b3]\n"
+                     "[600 ns] [PID = 2] [TID = 2] [SEQ = 4] [MESSAGE = b4]");
+    if(rc != 0)
+    {
+        perror("merge inputs");
+        return 1;
+    }
+
+    const char* paths[] = { a_path, b_path };
+    int out_fd = open(out_path, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    smartlog_merge_stats_t st;
+    if(out_fd < 0 || smartlog_merge_files(paths, 2, out_fd, &st) != 0)
+    {
+        perror("smartlog_merge_files");
+        return 1;
+    }
+    close(out_fd);
+
+    const char* expected[] = { "a1]", "b1]", "a2]", "b2]", "b3]", "a3]", "continued", "b4]" };
+    char content[2048];
+    if(read_file(out_path, content, sizeof(content)) != 0)
+    {
+        perror("read merge output");
+        return 1;
+    }
+    const char* pos = content;
+    for(size_t i = 0; i < sizeof(expected) / sizeof(expected[0]); i++)
+    {
+        pos = strstr(pos, expected[i]);
+        if(pos == NULL)
+        {
+            fprintf(stderr, "merge output out of order at %s:\n%s", expected[i], content);
+            return 1;
+        }
+    }
+    if(content[strlen(content) - 1] != '\n' ||
+       st.inputs != 2 || st.files != 4 || st.lines != 8 || st.untimed != 1)
+    {
+        fprintf(stderr, "merge stats mismatch\n");
+        return 1;
+    }
+
+    char missing[512];
+    snprintf(missing, sizeof(missing), "%s/merge_missing.log", dir);
+    const char* bad[] = { a_path, missing };
+    if(smartlog_merge_files(bad, 2, STDOUT_FILENO, NULL) == 0 || errno != ENOENT)
+    {
+        fprintf(stderr, "merge accepted a missing input\n");
+        return 1;
+    }
+
+    return 0;
+}
+
+static int test_archive_roundtrip(const char* dir)
+{
+    char log_path[512];
+    char arc_path[512];
+    char out_path[512];
+    snprintf(log_path, sizeof(log_path), "%s/archive_src.log", dir);
+    snprintf(arc_path, sizeof(arc_path), "%s/archive_src.sla", dir);
+    snprintf(out_path, sizeof(out_path), "%s/archive_query.log", dir);
+
+    /* 2000 lines at 1000 ns steps, with one untimed line after line 1500 */
+    int fd = open(log_path, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    if(fd < 0)
+    {
+        perror("archive source");
+        return 1;
+    }
+    for(int i = 1; i <= 2000; i++)
+    {
+        char line[128];
+        int n = snprintf(line, sizeof(line), "[%d ns] [PID = 1] [MESSAGE = line-%d]\n%s", i * 1000, i,
+                         i == 1500 ? "  continued-1500\n" : "");
+        if(write(fd, line, (size_t)n) != n)
+        {
+            perror("archive source write");
+            return 1;
+        }
+    }
+    close(fd);
+
+    smartlog_archive_stats_t st;
+    if(smartlog_archive_pack(log_path, arc_path, 4096, &st) != 0 || st.lines != 2001 || st.blocks < 10)
+    {
+        fprintf(stderr, "archive pack failed or stats mismatch\n");
+        return 1;
+    }
+
+    smartlog_archive_t* arc = smartlog_archive_open(arc_path);
+    if(arc == NULL || smartlog_archive_block_count(arc) != st.blocks)
+    {
+        perror("smartlog_archive_open");
+        return 1;
+    }
+
+    /* Blocks hold whole lines and ordered, non-overlapping ranges */
+    smartlog_archive_block_t prev;
+    memset(&prev, 0, sizeof(prev));
+    for(size_t i = 0; i < smartlog_archive_block_count(arc); i++)
+    {
+        smartlog_archive_block_t b;
+        char raw[8192];
+        long len = smartlog_archive_read_block(arc, i, raw, sizeof(raw));
+        if(smartlog_archive_block_info(arc, i, &b) != 0 || len != (long)b.raw_len ||
+           raw[len - 1] != '\n' || (i > 0 && b.min_ns <= prev.max_ns))
+        {
+            fprintf(stderr, "archive block %zu mismatch\n", i);
+            return 1;
+        }
+        prev = b;
+    }
+
+    /* A range in the middle, decoded by several threads */
+    fd = open(out_path, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    if(fd < 0 || smartlog_archive_query(arc, 1499000, 1502000, 4, fd) != 0)
+    {
+        perror("smartlog_archive_query");
+        return 1;
+    }
+    close(fd);
+    smartlog_archive_close(arc);
+
+    char content[2048];
+    if(read_file(out_path, content, sizeof(content)) != 0 ||
+       strcmp(content,
+              "[1499000 ns] [PID = 1] [MESSAGE = line-1499]\n"
+              "[1500000 ns] [PID = 1] [MESSAGE = line-1500]\n"
+              "  continued-1500\n"
+              "[1501000 ns] [PID = 1] [MESSAGE = line-1501]\n"
+              "[1502000 ns] [PID = 1] [MESSAGE = line-1502]\n") != 0)
+    {
+        fprintf(stderr, "archive query mismatch:\n%s", content);
+        return 1;
+    }
+
+    /* Flip one byte in the first block: the read fails its checksum */
+    fd = open(arc_path, O_RDWR);
+    unsigned char byte = 0;
+    if(fd < 0 || pread(fd, &byte, 1, 40) != 1)
+    {
+        perror("archive corrupt");
+        return 1;
+    }
+    byte ^= 0x5a;
+    if(pwrite(fd, &byte, 1, 40) != 1)
+    {
+        perror("archive corrupt");
+        return 1;
+    }
+    close(fd);
+
+    char raw[8192];
+    arc = smartlog_archive_open(arc_path);
+    if(arc == NULL || smartlog_archive_read_block(arc, 0, raw, sizeof(raw)) >= 0 || errno != EBADMSG ||
+       smartlog_archive_read_block(arc, 1, raw, sizeof(raw)) < 0)
+    {
+        fprintf(stderr, "archive corruption not contained to one block\n");
+        return 1;
+    }
+    smartlog_archive_close(arc);
+
+    if(smartlog_archive_open(log_path) != NULL || errno != EBADMSG)
+    {
+        fprintf(stderr, "plain log accepted as archive\n");
+        return 1;
+    }
+
+    return 0;
+}
+
+static int test_archive_dictionary(const char* dir)
+{
+    char log_path[512];
+    char dict_path[512];
+    char other_dict[512];
+    char plain_arc[512];
+    char dict_arc[512];
+    char out_path[512];
+    snprintf(log_path, sizeof(log_path), "%s/dict_src.log", dir);
+    snprintf(dict_path, sizeof(dict_path), "%s/dict_src.dict", dir);
+    snprintf(other_dict, sizeof(other_dict), "%s/dict_other.dict", dir);
+    snprintf(plain_arc, sizeof(plain_arc), "%s/dict_plain.sla", dir);
+    snprintf(dict_arc, sizeof(dict_arc), "%s/dict_packed.sla", dir);
+    snprintf(out_path, sizeof(out_path), "%s/dict_query.log", dir);
+
+    /* A few message templates with varying numbers, as real logs repeat */
+    int fd = open(log_path, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    if(fd < 0)
+    {
+        perror("dictionary source");
+        return 1;
+    }
+    for(int i = 1; i <= 3000; i++)
+    {
+        char line[256];
+        int n = snprintf(line, sizeof(line),
+                         "[%d ns] [PID = 77] [TID = %d] [SEQ = %d] [MESSAGE = %s %d]\n", i * 1000, 77 + (i % 4), i,
+                         (i % 3) == 0 ? "request handled, status=200 bytes=" :
+                         (i % 3) == 1 ? "cache miss, refilling session key" : "worker heartbeat, queue depth",
+                         (i * 37) % 1000);
+        if(write(fd, line, (size_t)n) != n)
+        {
+            perror("dictionary source write");
+            return 1;
+        }
+    }
+    close(fd);
+
+    const char* samples[] = { log_path };
+    size_t dict_len = 0;
+    if(smartlog_archive_train(samples, 1, dict_path, 0, &dict_len) != 0 || dict_len == 0 ||
+       dict_len > SMARTLOG_DICT_MAX)
+    {
+        perror("smartlog_archive_train");
+        return 1;
+    }
+
+    /* Small blocks are where the dictionary pays off */
+    smartlog_archive_stats_t plain_st;
+    smartlog_archive_stats_t dict_st;
+    if(smartlog_archive_pack(log_path, plain_arc, 4096, &plain_st) != 0 ||
+       smartlog_archive_pack_dict(log_path, dict_arc, 4096, dict_path, &dict_st) != 0 ||
+       dict_st.lines != 3000 || dict_st.comp_bytes >= plain_st.comp_bytes)
+    {
+        fprintf(stderr, "dictionary pack failed or not smaller\n");
+        return 1;
+    }
+
+    smartlog_archive_t* arc = smartlog_archive_open_dict(dict_arc, dict_path);
+    fd = open(out_path, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    if(arc == NULL || fd < 0 || smartlog_archive_query(arc, 2000000, 2001000, 2, fd) != 0)
+    {
+        perror("dictionary query");
+        return 1;
+    }
+    close(fd);
+    smartlog_archive_close(arc);
+
+    char content[1024];
+    if(read_file(out_path, content, sizeof(content)) != 0 ||
+       strcmp(content,
+              "[2000000 ns] [PID = 77] [TID = 77] [SEQ = 2000] [MESSAGE = worker heartbeat, queue depth 0]\n"
+              "[2001000 ns] [PID = 77] [TID = 78] [SEQ = 2001] [MESSAGE = request handled, status=200 bytes= 37]\n") != 0)
+    {
+        fprintf(stderr, "dictionary query mismatch:\n%s", content);
+        return 1;
+    }
+
+    /* The index reads without the dictionary; blocks do not */
+    char raw[8192];
+    arc = smartlog_archive_open(dict_arc);
+    if(arc == NULL || smartlog_archive_block_count(arc) != dict_st.blocks ||
+       smartlog_archive_read_block(arc, 0, raw, sizeof(raw)) >= 0 || errno != ENOKEY)
+    {
+        fprintf(stderr, "dictionary archive read without its dictionary\n");
+        return 1;
+    }
+    smartlog_archive_close(arc);
+
+    if(write_text(other_dict, "[MESSAGE = something else entirely") != 0 ||
+       smartlog_archive_open_dict(dict_arc, other_dict) != NULL || errno != ENOKEY)
+    {
+        fprintf(stderr, "wrong dictionary accepted\n");
+        return 1;
+    }
+
+    return 0;
+}
+
+static int test_lz4_sink(const char* dir)
+{
+    char lz4_path[512];
+    char out_path[512];
+    char rot_path[512];
+    snprintf(lz4_path, sizeof(lz4_path), "%s/live.log.lz4", dir);
+    snprintf(out_path, sizeof(out_path), "%s/live_decoded.log", dir);
+    snprintf(rot_path, sizeof(rot_path), "%s/live.log.lz4.1", dir);
+
+    const size_t cap = 1u << 20;
+    char* expected = malloc(cap);
+    char* content = malloc(cap);
+    if(expected == NULL || content == NULL)
+    {
+        perror("lz4 buffers");
+        return 1;
+    }
+
+    /* Two sessions on the same file: each one appends its own frame */
+    size_t expected_len = 0;
+    for(int session = 0; session < 2; session++)
+    {
+        smartlog_sink_t* sk = smartlog_sink_lz4_open(lz4_path, FEATURE_DISABLED, FEATURE_DISABLED, 0);
+        if(sk == NULL || smartlog_sink_set_async(sk, 256, OVERFLOW_BLOCK) != 0)
+        {
+            perror("lz4 sink setup");
+            return 1;
+        }
+
+        for(int i = 0; i < 3000; i++)
+        {
+            char line[128];
+            int n = snprintf(line, sizeof(line), "[%d ns] [PID = 9] [MESSAGE = session %d request %d done]\n",
+                             i * 1000, session, i);
+            struct iovec iov = { line, (size_t)n };
+            memcpy(expected + expected_len, line, (size_t)n);
+            expected_len += (size_t)n;
+            if(smartlog_sink_write_lines(sk, &iov, 1) != 0)
+            {
+                perror("lz4 sink write");
+                return 1;
+            }
+        }
+
+        /* Flushed but still open: the live file decodes up to its last block */
+        int fd = open(out_path, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+        if(smartlog_sink_flush(sk) != 0 || fd < 0 || smartlog_lz4_decode_file(lz4_path, fd) != 0)
+        {
+            perror("lz4 live decode");
+            return 1;
+        }
+        close(fd);
+
+        struct stat st;
+        if(read_file(out_path, content, cap) != 0 || strlen(content) != expected_len ||
+           memcmp(content, expected, expected_len) != 0 || stat(lz4_path, &st) != 0 ||
+           (size_t)st.st_size * 3 > expected_len)
+        {
+            fprintf(stderr, "lz4 session %d mismatch or poorly compressed\n", session);
+            return 1;
+        }
+
+        smartlog_sink_destroy(sk);
+    }
+
+    /* The decoder takes input in any pieces */
+    int in_fd = open(lz4_path, O_RDONLY);
+    int out_fd = open(out_path, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    smartlog_lz4_decoder_t* dec = smartlog_lz4_decoder_create();
+    if(in_fd < 0 || out_fd < 0 || dec == NULL)
+    {
+        perror("lz4 decoder setup");
+        return 1;
+    }
+    char piece[7];
+    ssize_t n;
+    while((n = read(in_fd, piece, sizeof(piece))) > 0)
+    {
+        if(smartlog_lz4_decoder_feed(dec, piece, (size_t)n, out_fd) != 0)
+        {
+            perror("lz4 decoder feed");
+            return 1;
+        }
+    }
+    close(in_fd);
+    close(out_fd);
+    if(smartlog_lz4_decoder_pending(dec) != 0 || read_file(out_path, content, cap) != 0 ||
+       strlen(content) != expected_len || memcmp(content, expected, expected_len) != 0)
+    {
+        fprintf(stderr, "lz4 piecewise decode mismatch\n");
+        return 1;
+    }
+
+    /* A wrong frame header checksum is rejected */
+    static const unsigned char bad_header[7] = { 0x04, 0x22, 0x4D, 0x18, 0x40, 0x40, 0x00 };
+    smartlog_lz4_decoder_destroy(dec);
+    dec = smartlog_lz4_decoder_create();
+    if(dec == NULL || smartlog_lz4_decoder_feed(dec, bad_header, sizeof(bad_header), STDERR_FILENO) == 0 ||
+       errno != EBADMSG)
+    {
+        fprintf(stderr, "lz4 bad header accepted\n");
+        return 1;
+    }
+    smartlog_lz4_decoder_destroy(dec);
+
+    /* Rotation closes the old frame, so both files decode on their own */
+    smartlog_sink_t* sk = smartlog_sink_lz4_open(lz4_path, FEATURE_DISABLED, FEATURE_ENABLED, 1024);
+    if(sk == NULL)
+    {
+        perror("lz4 rotate setup");
+        return 1;
+    }
+    for(int i = 0; i < 50; i++)
+    {
+        char line[64];
+        int len = snprintf(line, sizeof(line), "rotate-%d\n", i);
+        struct iovec iov = { line, (size_t)len };
+        memcpy(expected + expected_len, line, (size_t)len);
+        expected_len += (size_t)len;
+        if(smartlog_sink_write_lines(sk, &iov, 1) != 0 || smartlog_sink_flush(sk) != 0)
+        {
+            perror("lz4 rotate write");
+            return 1;
+        }
+    }
+    smartlog_sink_destroy(sk);
+
+    out_fd = open(out_path, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    if(out_fd < 0 || smartlog_lz4_decode_file(rot_path, out_fd) != 0 ||
+       smartlog_lz4_decode_file(lz4_path, out_fd) != 0)
+    {
+        perror("lz4 rotated decode");
+        return 1;
+    }
+    close(out_fd);
+
+    if(read_file(out_path, content, cap) != 0 || strlen(content) != expected_len ||
+       memcmp(content, expected, expected_len) != 0)
+    {
+        fprintf(stderr, "lz4 rotation lost lines\n");
+        return 1;
+    }
+
+    free(expected);
+    free(content);
+    return 0;
+}
+
+static int test_tail_follow(const char* dir)
+{
+    char log_path[512];
+    char out_path[512];
+    char lz4_path[512];
+    snprintf(log_path, sizeof(log_path), "%s/follow.log", dir);
+    snprintf(out_path, sizeof(out_path), "%s/follow_out.log", dir);
+    snprintf(lz4_path, sizeof(lz4_path), "%s/follow.log.lz4", dir);
+
+    /* Content from before the follower started is not printed */
+    if(smartlog_write_log_entry(log_path, "before-start", FEATURE_DISABLED, FEATURE_DISABLED, 0) != 0)
+    {
+        perror("follow setup");
+        return 1;
+    }
+
+    int out_fd = open(out_path, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    smartlog_tail_t* tail = smartlog_tail_open(log_path, 0);
+    if(out_fd < 0 || tail == NULL)
+    {
+        perror("smartlog_tail_open");
+        return 1;
+    }
+
+    /* Rotate every few lines; lines written before each rename come from the old inode */
+    for(int i = 0; i < 200; i++)
+    {
+        char msg[32];
+        snprintf(msg, sizeof(msg), "follow-%d", i);
+        if(smartlog_write_log_entry(log_path, msg, FEATURE_DISABLED, FEATURE_ENABLED, 300) != 0 ||
+           ((i % 3) == 2 && smartlog_tail_poll(tail, out_fd, 0) != 0))
+        {
+            perror("follow write");
+            return 1;
+        }
+    }
+    if(smartlog_tail_poll(tail, out_fd, 0) != 0)
+    {
+        perror("smartlog_tail_poll");
+        return 1;
+    }
+
+    smartlog_tail_stats_t st;
+    smartlog_tail_get_stats(tail, &st);
+    smartlog_tail_close(tail);
+    close(out_fd);
+
+    char content[32768];
+    if(read_file(out_path, content, sizeof(content)) != 0 || strstr(content, "before-start") != NULL ||
+       st.rotations == 0 || st.wakeups == 0)
+    {
+        fprintf(stderr, "follow start or stats mismatch\n");
+        return 1;
+    }
+
+    const char* cursor = content;
+    for(int i = 0; i < 200; i++)
+    {
+        char want[48];
+        snprintf(want, sizeof(want), "[MESSAGE = follow-%d]\n", i);
+        const char* hit = strstr(cursor, want);
+        if(hit == NULL)
+        {
+            fprintf(stderr, "follow lost or reordered line %d\n", i);
+            return 1;
+        }
+        cursor = hit + strlen(want);
+    }
+
+    /* LZ4 files are decoded as blocks arrive */
+    smartlog_sink_t* sk = smartlog_sink_lz4_open(lz4_path, FEATURE_DISABLED, FEATURE_DISABLED, 0);
+    out_fd = open(out_path, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    tail = smartlog_tail_open(lz4_path, 1);
+    if(sk == NULL || out_fd < 0 || tail == NULL)
+    {
+        perror("follow lz4 setup");
+        return 1;
+    }
+    for(int i = 0; i < 3; i++)
+    {
+        char line[32];
+        int n = snprintf(line, sizeof(line), "lz4-follow-%d\n", i);
+        struct iovec iov = { line, (size_t)n };
+        if(smartlog_sink_write_lines(sk, &iov, 1) != 0 || smartlog_sink_flush(sk) != 0 ||
+           smartlog_tail_poll(tail, out_fd, 0) != 0)
+        {
+            perror("follow lz4 write");
+            return 1;
+        }
+    }
+    smartlog_tail_close(tail);
+    smartlog_sink_destroy(sk);
+    close(out_fd);
+
+    if(read_file(out_path, content, sizeof(content)) != 0 ||
+       strcmp(content, "lz4-follow-0\nlz4-follow-1\nlz4-follow-2\n") != 0)
+    {
+        fprintf(stderr, "follow lz4 mismatch:\n%s", content);
+        return 1;
+    }
+
+    return 0;
+}
+
+static int test_parse_columns(const char* dir)
+{
+    char path[512];
+    snprintf(path, sizeof(path), "%s/parse.log", dir);
+
+    /* Enough lines for several SMARTLOG_PARSE_CHUNK_MIN chunks */
+    const size_t lines = 60000;
+    FILE* fp = fopen(path, "w");
+    if(fp == NULL)
+    {
+        perror("fopen parse.log");
+        return 1;
+    }
+    for(size_t i = 0; i < lines; i++)
+    {
+        if(i % 7 == 6)
+        {
+            fprintf(fp, "  continuation of %zu\n", i - 1);
+        }
+        else if(i % 7 == 5)
+        {
+            fprintf(fp, "[%zu ns] [PID = %zu] [REQ = r%zu] [MESSAGE = tagged %zu]\n", 1000 + i, i % 13, i, i);
+        }
+        else
+        {
+            fprintf(fp, "[%zu ns] [PID = %zu] [TID = %zu] [SEQ = %zu] [MESSAGE = line [%zu] of padding text]\n",
+                    1000 + i, i % 13, 100 + (i % 5), i, i);
+        }
+    }
+    fprintf(fp, "[9 ns] [PID = 4] [MESSAGE = last]");
+    fclose(fp);
+
+    smartlog_columns_t one;
+    smartlog_columns_t many;
+    if(smartlog_parse_file(path, 1, &one) != 0 || smartlog_parse_file(path, 4, &many) != 0)
+    {
+        perror("smartlog_parse_file");
+        return 1;
+    }
+    if(one.size <= 2u * SMARTLOG_PARSE_CHUNK_MIN || one.rows != lines + 1 || many.rows != one.rows ||
+       one.untimed != lines / 7 || many.untimed != one.untimed)
+    {
+        fprintf(stderr, "parse rows mismatch: %zu / %zu rows, %llu untimed\n",
+                one.rows, many.rows, (unsigned long long)one.untimed);
+        return 1;
+    }
+
+    char expect[128];
+    for(size_t i = 0; i <= lines; i++)
+    {
+        const char* msg = many.data + many.msg_offset[i];
+        size_t len = many.msg_len[i];
+        int64_t want_tid = -1;
+        uint64_t want_time = 1000 + i;
+        if(i == lines)
+        {
+            want_time = 9;
+            snprintf(expect, sizeof(expect), "last");
+        }
+        else if(i % 7 == 6)
+        {
+            want_time = 0;
+            snprintf(expect, sizeof(expect), "  continuation of %zu", i - 1);
+        }
+        else if(i % 7 == 5)
+        {
+            snprintf(expect, sizeof(expect), "tagged %zu", i);
+        }
+        else
+        {
+            want_tid = (int64_t)(100 + (i % 5));
+            snprintf(expect, sizeof(expect), "line [%zu] of padding text", i);
+        }
+
+        if(many.time_ns[i] != want_time || many.tid[i] != want_tid ||
+           len != strlen(expect) || memcmp(msg, expect, len) != 0 ||
+           one.time_ns[i] != many.time_ns[i] || one.pid[i] != many.pid[i] || one.tid[i] != many.tid[i] ||
+           one.seq[i] != many.seq[i] || one.msg_offset[i] != many.msg_offset[i] || one.msg_len[i] != many.msg_len[i])
+        {
+            fprintf(stderr, "parse row %zu mismatch: '%.*s'\n", i, (int)len, msg);
+            return 1;
+        }
+        if(want_tid >= 0 && (many.pid[i] != (int32_t)(i % 13) || many.seq[i] != i))
+        {
+            fprintf(stderr, "parse row %zu fields mismatch\n", i);
+            return 1;
+        }
+    }
+    smartlog_columns_free(&one);
+    smartlog_columns_free(&many);
+
+    smartlog_columns_t empty;
+    if(smartlog_parse_buffer("", 0, 0, &empty) != 0 || empty.rows != 0)
+    {
+        fprintf(stderr, "parse of empty buffer failed\n");
+        return 1;
+    }
+    smartlog_columns_free(&empty);
+
+    return 0;
+}
+
+static int test_colfile_roundtrip(const char* dir)
+{
+    char log_path[512];
+    char col_path[512];
+    snprintf(log_path, sizeof(log_path), "%s/colfile.log", dir);
+    snprintf(col_path, sizeof(col_path), "%s/colfile.slc", dir);
+
+    const size_t lines = 5000;
+    FILE* fp = fopen(log_path, "w");
+    if(fp == NULL)
+    {
+        perror("fopen colfile.log");
+        return 1;
+    }
+    for(size_t i = 0; i < lines; i++)
+    {
+        if(i % 100 == 99)
+        {
+            fprintf(fp, "\tat frame %zu\n", i);
+        }
+        else
+        {
+            /* Runs of 10 lines per pid, one line every 100 ms */
+            fprintf(fp, "[%llu ns] [PID = %zu] [TID = %zu] [SEQ = %zu] [MESSAGE = request %zu done]\n",
+                    1700000000000000000ull + (i * 100000000ull), 1000 + ((i / 10) % 3), 7 + (i % 2), i, i);
+        }
+    }
+    fclose(fp);
+
+    smartlog_colfile_info_t info;
+    if(smartlog_colfile_export(log_path, col_path, 2, &info) != 0)
+    {
+        perror("smartlog_colfile_export");
+        return 1;
+    }
+
+    smartlog_columns_t ref;
+    smartlog_colfile_t* cf = smartlog_colfile_open(col_path);
+    if(cf == NULL || smartlog_parse_file(log_path, 1, &ref) != 0)
+    {
+        perror("smartlog_colfile_open");
+        return 1;
+    }
+
+    /* Delta timestamps and run-length pids should be near 1 byte per row */
+    smartlog_colfile_info_t got;
+    smartlog_colfile_get_info(cf, &got);
+    if(got.rows != lines || got.untimed != lines / 100 || got.rows != info.rows || got.file_bytes != info.file_bytes ||
+       got.min_ns != 1700000000000000000ull || got.column_bytes[SMARTLOG_COL_TIME] > lines * 5 ||
+       got.column_bytes[SMARTLOG_COL_PID] > lines)
+    {
+        fprintf(stderr, "colfile info mismatch: rows %llu time %llu pid %llu\n", (unsigned long long)got.rows,
+                (unsigned long long)got.column_bytes[SMARTLOG_COL_TIME], (unsigned long long)got.column_bytes[SMARTLOG_COL_PID]);
+        return 1;
+    }
+
+    uint64_t* time_ns = malloc(lines * sizeof(*time_ns));
+    uint64_t* seq = malloc(lines * sizeof(*seq));
+    int32_t* pid = malloc(lines * sizeof(*pid));
+    int32_t* tid = malloc(lines * sizeof(*tid));
+    if(time_ns == NULL || seq == NULL || pid == NULL || tid == NULL ||
+       smartlog_colfile_read_time(cf, time_ns) != 0 || smartlog_colfile_read_seq(cf, seq) != 0 ||
+       smartlog_colfile_read_pid(cf, pid) != 0 || smartlog_colfile_read_tid(cf, tid) != 0)
+    {
+        perror("smartlog_colfile_read");
+        return 1;
+    }
+    for(size_t i = 0; i < lines; i++)
+    {
+        size_t len = 0;
+        const char* msg = smartlog_colfile_message(cf, i, &len);
+        if(time_ns[i] != ref.time_ns[i] || seq[i] != ref.seq[i] || pid[i] != ref.pid[i] || tid[i] != ref.tid[i] ||
+           msg == NULL || len != ref.msg_len[i] || memcmp(msg, ref.data + ref.msg_offset[i], len) != 0)
+        {
+            fprintf(stderr, "colfile row %zu mismatch\n", i);
+            return 1;
+        }
+    }
+    size_t len = 0;
+    if(smartlog_colfile_message(cf, lines, &len) != NULL || errno != ERANGE)
+    {
+        fprintf(stderr, "colfile message past the end accepted\n");
+        return 1;
+    }
+    smartlog_colfile_close(cf);
+    smartlog_columns_free(&ref);
+
+    /* A damaged time column is reported; other columns still read */
+    int fd = open(col_path, O_RDWR);
+    unsigned char byte = 0;
+    if(fd < 0 || pread(fd, &byte, 1, 4096) != 1)
+    {
+        perror("open colfile");
+        return 1;
+    }
+    byte ^= 0x01;
+    if(pwrite(fd, &byte, 1, 4096) != 1)
+    {
+        perror("pwrite colfile");
+        return 1;
+    }
+    close(fd);
+
+    cf = smartlog_colfile_open(col_path);
+    if(cf == NULL || smartlog_colfile_read_time(cf, time_ns) == 0 || errno != EBADMSG ||
+       smartlog_colfile_read_pid(cf, pid) != 0)
+    {
+        fprintf(stderr, "colfile damage not detected\n");
+        return 1;
+    }
+    smartlog_colfile_close(cf);
+
+    if(write_text(col_path, "SLCOLUM1 but not really a columnar file at all\n") != 0 ||
+       smartlog_colfile_open(col_path) != NULL || errno != EBADMSG)
+    {
+        fprintf(stderr, "colfile accepted a bad header\n");
+        return 1;
+    }
+
+    free(time_ns);
+    free(seq);
+    free(pid);
+    free(tid);
+    return 0;
+}
+
+typedef struct {
+    smartlog_logger_t* logger;
+    int iterations;
+} counter_worker_arg_t;
+
+static const char* const counter_tmpl = "cache miss key=%s";
+
+static void* counter_worker(void* arg)
+{
+    counter_worker_arg_t* a = (counter_worker_arg_t*)arg;
+    for(int i = 0; i < a->iterations; i++)
+    {
+        if(SMARTLOG_COUNT(a->logger, LOG_LEVEL_DEBUG, counter_tmpl) != 0)
+        {
+            return (void*)1;
+        }
+    }
+    return NULL;
+}
+
+typedef struct {
+    smartlog_counters_t* set;
+    int first_line;
+    int lines;
+} counter_lines_arg_t;
+
+static void* counter_lines_worker(void* arg)
+{
+    counter_lines_arg_t* a = (counter_lines_arg_t*)arg;
+    for(int i = 0; i < a->lines; i++)
+    {
+        if(smartlog_counters_add(a->set, LOG_LEVEL_INFO, "c", "z.c", a->first_line + i) != 0)
+        {
+            return (void*)1;
+        }
+    }
+    return NULL;
+}
+
+static int test_logger_counters(const char* dir)
+{
+    char path[512];
+    snprintf(path, sizeof(path), "%s/counters.log", dir);
+
+    /* Counter set alone: per-thread tables merged into exact totals */
+    smartlog_counters_t* set = smartlog_counters_create();
+    if(set == NULL ||
+       smartlog_counters_add(set, LOG_LEVEL_INFO, "a", "x.c", 1) != 0 ||
+       smartlog_counters_add(set, LOG_LEVEL_INFO, "a", "x.c", 1) != 0 ||
+       smartlog_counters_add(set, LOG_LEVEL_WARN, "a", "x.c", 1) != 0)
+    {
+        perror("smartlog_counters_add");
+        return 1;
+    }
+    smartlog_counter_t* keys = NULL;
+    size_t nkeys = 0;
+    uint64_t overflow = 1;
+    if(smartlog_counters_snapshot(set, &keys, &nkeys, &overflow) != 0 || nkeys != 2 || overflow != 0 ||
+       keys[0].level != LOG_LEVEL_INFO || keys[0].delta != 2 || keys[1].delta != 1)
+    {
+        fprintf(stderr, "counter snapshot mismatch (%zu keys)\n", nkeys);
+        return 1;
+    }
+    free(keys);
+    if(smartlog_counters_add(set, LOG_LEVEL_INFO, "a", "x.c", 1) != 0 ||
+       smartlog_counters_snapshot(set, &keys, &nkeys, NULL) != 0 || nkeys != 1 ||
+       keys[0].delta != 1 || keys[0].total != 3)
+    {
+        fprintf(stderr, "counter second snapshot mismatch\n");
+        return 1;
+    }
+    free(keys);
+    smartlog_counters_destroy(set);
+
+    /* More counter sets than cache entries: one thread keeps exact counts */
+    smartlog_counters_t* sets[6];
+    for(int i = 0; i < 6; i++)
+    {
+        sets[i] = smartlog_counters_create();
+        if(sets[i] == NULL)
+        {
+            perror("smartlog_counters_create");
+            return 1;
+        }
+    }
+    for(int i = 0; i < 30; i++)
+    {
+        if(smartlog_counters_add(sets[i % 6], LOG_LEVEL_INFO, "b", "y.c", 2) != 0)
+        {
+            perror("smartlog_counters_add");
+            return 1;
+        }
+    }
+    for(int i = 0; i < 6; i++)
+    {
+        int ok = smartlog_counters_snapshot(sets[i], &keys, &nkeys, NULL) == 0 && nkeys == 1 &&
+                 keys[0].delta == 5 && keys[0].total == 5;
+        free(keys);
+        smartlog_counters_destroy(sets[i]);
+        if(!ok)
+        {
+            fprintf(stderr, "counter set %d mismatch after cache misses\n", i);
+            return 1;
+        }
+    }
+
+    /* An exited thread's full table is adopted: the next thread overflows */
+    set = smartlog_counters_create();
+    counter_lines_arg_t churn[2] = { { set, 0, SMARTLOG_COUNTER_SLOTS }, { set, 0, 1 } };
+    churn[1].first_line = SMARTLOG_COUNTER_SLOTS;
+    for(int i = 0; i < 2; i++)
+    {
+        pthread_t thread;
+        void* ret = NULL;
+        if(set == NULL || pthread_create(&thread, NULL, counter_lines_worker, &churn[i]) != 0 ||
+           pthread_join(thread, &ret) != 0 || ret != NULL)
+        {
+            perror("counter churn thread");
+            return 1;
+        }
+    }
+    if(smartlog_counters_snapshot(set, &keys, &nkeys, &overflow) != 0 ||
+       nkeys != SMARTLOG_COUNTER_SLOTS || overflow != 1)
+    {
+        fprintf(stderr, "counter table not adopted (%zu keys, overflow %llu)\n",
+                nkeys, (unsigned long long)overflow);
+        return 1;
+    }
+    free(keys);
+    smartlog_counters_destroy(set);
+
+    /* Logger: four threads count, one summary record carries the sum */
+    smartlog_logger_t* lg = smartlog_logger_create();
+    smartlog_sink_t* sink = smartlog_sink_file_open(path, FEATURE_DISABLED, FEATURE_DISABLED, 0);
+    if(lg == NULL || sink == NULL || smartlog_logger_add_sink(lg, sink) != 0 ||
+       smartlog_logger_snapshot_counters(lg) == 0 || errno != ENOTSUP ||
+       smartlog_logger_enable_counters(lg, 0) != 0)
+    {
+        perror("counters setup");
+        return 1;
+    }
+
+    pthread_t threads[4];
+    counter_worker_arg_t arg = { lg, 25000 };
+    for(int i = 0; i < 4; i++)
+    {
+        if(pthread_create(&threads[i], NULL, counter_worker, &arg) != 0)
+        {
+            perror("pthread_create");
+            return 1;
+        }
+    }
+    int failed = 0;
+    for(int i = 0; i < 4; i++)
+    {
+        void* ret = NULL;
+        pthread_join(threads[i], &ret);
+        failed |= ret != NULL;
+    }
+    if(failed || SMARTLOG_LOG_COUNTED(lg, LOG_LEVEL_ERROR, "disk full", "disk full on /var") != 0 ||
+       smartlog_logger_snapshot_counters(lg) != 0)
+    {
+        perror("counters log");
+        return 1;
+    }
+
+    char content[4096];
+    if(read_file(path, content, sizeof(content)) != 0 ||
+       strstr(content, "counters snap=1 part=1") == NULL ||
+       strstr(content, "DEBUG test_smartlog.c:") == NULL ||
+       strstr(content, "\"cache miss key=%s\" +100000=100000") == NULL ||
+       strstr(content, "ERROR test_smartlog.c:") == NULL ||
+       strstr(content, "\"disk full\" +1=1") == NULL ||
+       strstr(content, "MESSAGE = disk full on /var") == NULL)
+    {
+        fprintf(stderr, "counters summary mismatch:\n%s", content);
+        return 1;
+    }
+
+    /* Nothing moved: no record; then the final summary from destroy (new call site, new key) */
+    size_t before = strlen(content);
+    if(smartlog_logger_snapshot_counters(lg) != 0 || read_file(path, content, sizeof(content)) != 0 ||
+       strlen(content) != before ||
+       SMARTLOG_COUNT(lg, LOG_LEVEL_DEBUG, counter_tmpl) != 0)
+    {
+        fprintf(stderr, "counters empty snapshot wrote a record\n");
+        return 1;
+    }
+    smartlog_logger_destroy(lg);
+    if(read_file(path, content, sizeof(content)) != 0 ||
+       strstr(content, "counters snap=2 part=1") == NULL ||
+       strstr(content, "\"cache miss key=%s\" +1=1]") == NULL)
+    {
+        fprintf(stderr, "counters final summary missing:\n%s", content);
+        return 1;
+    }
+
+    /* Periodic: a counted call after the interval writes the summary */
+    snprintf(path, sizeof(path), "%s/counters_periodic.log", dir);
+    lg = smartlog_logger_create();
+    sink = smartlog_sink_file_open(path, FEATURE_DISABLED, FEATURE_DISABLED, 0);
+    struct timespec pause = { 0, 3000000 };
+    if(lg == NULL || sink == NULL || smartlog_logger_add_sink(lg, sink) != 0 ||
+       smartlog_logger_enable_counters(lg, 1) != 0 ||
+       SMARTLOG_LOG_COUNTED(lg, LOG_LEVEL_INFO, "tick", "tick 1") != 0 ||
+       nanosleep(&pause, NULL) != 0 ||
+       SMARTLOG_LOG_COUNTED(lg, LOG_LEVEL_INFO, "tick", "tick 2") != 0 ||
+       read_file(path, content, sizeof(content)) != 0 ||
+       strstr(content, "counters snap=1 part=1") == NULL)
+    {
+        fprintf(stderr, "counters periodic summary missing:\n%s", content);
+        return 1;
+    }
+    smartlog_logger_destroy(lg);
+
+    return 0;
+}
+
+static void* context_worker(void* arg)
+{
+    smartlog_logger_t* lg = (smartlog_logger_t*)arg;
+
+    /* A new thread starts with an empty context */
+    if(smartlog_context_depth() != 0 || smartlog_context_push("REQ", "worker") != 0 ||
+       smartlog_logger_log(lg, LOG_LEVEL_INFO, "from worker") != 0)
+    {
+        return (void*)1;
+    }
+    return NULL;
+}
+
+static int test_logging_context(const char* dir)
+{
+    char path[512];
+    snprintf(path, sizeof(path), "%s/context.log", dir);
+
+    /* Bad fields, limits and pop order */
+    char big[SMARTLOG_CONTEXT_MAX_LEN];
+    memset(big, 'v', sizeof(big) - 1);
+    big[sizeof(big) - 1] = '\0';
+    if(smartlog_context_push("", "x") == 0 || errno != EINVAL ||
+       smartlog_context_push("A B", "x") == 0 || errno != EINVAL ||
+       smartlog_context_push("REQ", "a]b") == 0 || errno != EINVAL ||
+       smartlog_context_push("REQ", "a\nb") == 0 || errno != EINVAL ||
+       smartlog_context_push("REQ", big) == 0 || errno != ENOSPC ||
+       smartlog_context_pop() == 0 || errno != ENOENT)
+    {
+        fprintf(stderr, "context accepted a bad field\n");
+        return 1;
+    }
+    for(int i = 0; i < SMARTLOG_CONTEXT_MAX_DEPTH; i++)
+    {
+        if(smartlog_context_push("K", "v") != 0)
+        {
+            perror("smartlog_context_push");
+            return 1;
+        }
+    }
+    size_t len = 0;
+    if(smartlog_context_push("K", "v") == 0 || errno != ENOSPC ||
+       smartlog_context_encoded(&len) == NULL || len != SMARTLOG_CONTEXT_MAX_DEPTH * strlen("[K = v] "))
+    {
+        fprintf(stderr, "context depth limit mismatch\n");
+        return 1;
+    }
+    smartlog_context_clear();
+
+    /* Logger: fields between SEQ and MESSAGE, full message budget kept */
+    char msg[SMARTLOG_MSG_MAX_LEN + 1];
+    memset(msg, 'm', SMARTLOG_MSG_MAX_LEN);
+    msg[SMARTLOG_MSG_MAX_LEN] = '\0';
+    smartlog_logger_t* lg = smartlog_logger_create();
+    smartlog_sink_t* sink = smartlog_sink_file_open(path, FEATURE_DISABLED, FEATURE_DISABLED, 0);
+    pthread_t worker;
+    void* worker_ret = (void*)1;
+    if(lg == NULL || sink == NULL || smartlog_logger_add_sink(lg, sink) != 0 ||
+       smartlog_context_push("REQ", "4f2a") != 0 || smartlog_context_push("TENANT", "acme") != 0 ||
+       smartlog_logger_log(lg, LOG_LEVEL_INFO, "with both") != 0 ||
+       smartlog_logger_log(lg, LOG_LEVEL_INFO, msg) != 0 ||
+       smartlog_context_pop() != 0 || smartlog_context_depth() != 1 ||
+       smartlog_logger_log(lg, LOG_LEVEL_INFO, "request only") != 0 ||
+       pthread_create(&worker, NULL, context_worker, lg) != 0 ||
+       pthread_join(worker, &worker_ret) != 0 || worker_ret != NULL)
+    {
+        perror("context logging");
+        return 1;
+    }
+    smartlog_context_clear();
+    if(smartlog_logger_log(lg, LOG_LEVEL_INFO, "no context") != 0)
+    {
+        perror("context logging");
+        return 1;
+    }
+    smartlog_logger_destroy(lg);
+
+    char content[4096];
+    char want[SMARTLOG_MSG_MAX_LEN + 64];
+    snprintf(want, sizeof(want), "[REQ = 4f2a] [TENANT = acme] [MESSAGE = %s]\n", msg);
+    if(read_file(path, content, sizeof(content)) != 0 ||
+       strstr(content, "[SEQ = 1] [REQ = 4f2a] [TENANT = acme] [MESSAGE = with both]\n") == NULL ||
+       strstr(content, want) == NULL ||
+       strstr(content, "[SEQ = 3] [REQ = 4f2a] [MESSAGE = request only]\n") == NULL ||
+       strstr(content, "[SEQ = 4] [REQ = worker] [MESSAGE = from worker]\n") == NULL ||
+       strstr(content, "[SEQ = 5] [MESSAGE = no context]\n") == NULL)
+    {
+        fprintf(stderr, "context lines mismatch:\n%s", content);
+        return 1;
+    }
+
+    /* The parser skips context fields */
+    smartlog_columns_t cols;
+    if(smartlog_parse_file(path, 1, &cols) != 0 || cols.rows != 5 || cols.seq[0] != 1 ||
+       cols.msg_len[0] != strlen("with both") ||
+       memcmp(cols.data + cols.msg_offset[0], "with both", cols.msg_len[0]) != 0 ||
+       cols.msg_len[1] != SMARTLOG_MSG_MAX_LEN)
+    {
+        fprintf(stderr, "context lines do not parse\n");
+        return 1;
+    }
+    smartlog_columns_free(&cols);
+
+    return 0;
+}
+
+/** Record n of the circular file test: length and fill derived from n */
+static size_t circ_test_record(uint64_t n, char* out)
+{
+    size_t len = (size_t)((n * 37u) % SMARTLOG_LOG_BUFFER_SZ) + 1;
+    memset(out, 'a' + (int)(n % 26), len);
+    return len;
+}
+
+typedef struct {
+    uint64_t next;
+    uint64_t calls;
+    int bad;
+    char last[64];
+} circ_check_t;
+
+static int circ_check_record(const char* line, size_t len, uint64_t number, void* arg)
+{
+    circ_check_t* check = (circ_check_t*)arg;
+    char want[SMARTLOG_LOG_BUFFER_SZ];
+    if((check->calls != 0 && number != check->next) || len != circ_test_record(number, want) ||
+       memcmp(line, want, len) != 0)
+    {
+        check->bad = 1;
+    }
+    check->next = number + 1;
+    check->calls++;
+    return 0;
+}
+
+static int circ_last_line(const char* line, size_t len, uint64_t number, void* arg)
+{
+    circ_check_t* check = (circ_check_t*)arg;
+    if(check->calls != 0 && number != check->next)
+    {
+        check->bad = 1;
+    }
+    const char* msg = strstr(line, "MESSAGE = ");
+    size_t n = msg != NULL ? (size_t)(line + len - msg) : 0;
+    n = n < sizeof(check->last) ? n : sizeof(check->last) - 1;
+    memcpy(check->last, msg != NULL ? msg : "", n);
+    check->last[n] = '\0';
+    check->next = number + 1;
+    check->calls++;
+    return 0;
+}
+
+static int test_circfile(const char* dir)
+{
+    char path[512];
+    snprintf(path, sizeof(path), "%s/circ.log", dir);
+
+    /* Writer alone: varying sizes, many laps, every read is whole and in order */
+    smartlog_circfile_t* cf = smartlog_circfile_open(path, SMARTLOG_CIRC_MIN_BYTES);
+    if(smartlog_circfile_open(path, SMARTLOG_CIRC_MIN_BYTES + 4) != NULL || errno != EINVAL || cf == NULL)
+    {
+        perror("smartlog_circfile_open");
+        return 1;
+    }
+    char rec[SMARTLOG_LOG_BUFFER_SZ];
+    smartlog_circfile_info_t info;
+    for(uint64_t n = 0; n < 3000; n++)
+    {
+        size_t len = circ_test_record(n, rec);
+        if(smartlog_circfile_append(cf, rec, len) != 0)
+        {
+            perror("smartlog_circfile_append");
+            return 1;
+        }
+        if(n % 97 != 0)
+        {
+            continue;
+        }
+
+        circ_check_t check = { 0, 0, 0, "" };
+        if(smartlog_circfile_read(path, circ_check_record, &check, &info) != 0 || check.bad ||
+           check.calls != info.records || check.next != n + 1 || info.damaged != 0)
+        {
+            fprintf(stderr, "circular read mismatch after record %llu\n", (unsigned long long)n);
+            return 1;
+        }
+    }
+    struct stat sb;
+    if(stat(path, &sb) != 0 || sb.st_size != (off_t)(4096 + SMARTLOG_CIRC_MIN_BYTES) ||
+       info.wraps == 0 || info.written != 2911 || info.records == 0 || info.records >= info.written ||
+       smartlog_circfile_append(cf, rec, SMARTLOG_LOG_BUFFER_SZ + 1) == 0 || errno != EMSGSIZE)
+    {
+        fprintf(stderr, "circular file state mismatch\n");
+        return 1;
+    }
+    smartlog_circfile_close(cf);
+
+    /* Other files are not touched */
+    char other[512];
+    snprintf(other, sizeof(other), "%s/circ_other.log", dir);
+    if(write_text(other, "plain text\n") != 0 ||
+       smartlog_circfile_open(other, SMARTLOG_CIRC_MIN_BYTES) != NULL || errno != EBADMSG ||
+       smartlog_circfile_read(other, circ_check_record, NULL, NULL) == 0 || errno != EBADMSG)
+    {
+        fprintf(stderr, "circular open accepted a plain file\n");
+        return 1;
+    }
+
+    /* Sink: the logger's lines, continued across reopen */
+    snprintf(path, sizeof(path), "%s/circ_sink.log", dir);
+    for(int round = 0; round < 2; round++)
+    {
+        smartlog_logger_t* lg = smartlog_logger_create();
+        smartlog_sink_t* sink = smartlog_sink_circ_open(path, SMARTLOG_CIRC_MIN_BYTES, FEATURE_ENABLED);
+        if(lg == NULL || sink == NULL || smartlog_logger_add_sink(lg, sink) != 0)
+        {
+            perror("circular sink setup");
+            return 1;
+        }
+        for(int i = 0; i < 300; i++)
+        {
+            char msg[64];
+            snprintf(msg, sizeof(msg), "circ %d.%d", round, i);
+            if(smartlog_logger_log(lg, LOG_LEVEL_INFO, msg) != 0)
+            {
+                perror("circular sink log");
+                return 1;
+            }
+        }
+        smartlog_logger_destroy(lg);
+    }
+    circ_check_t check = { 0, 0, 0, "" };
+    if(smartlog_circfile_read(path, circ_last_line, &check, &info) != 0 || check.bad ||
+       info.written != 600 || info.wraps == 0 || check.calls != info.records ||
+       strcmp(check.last, "MESSAGE = circ 1.299]\n") != 0)
+    {
+        fprintf(stderr, "circular sink mismatch (%llu records, last \"%s\")\n",
+                (unsigned long long)check.calls, check.last);
+        return 1;
+    }
+
+    return 0;
+}
+
+typedef struct {
+    smartlog_recorder_t* rec;
+    uint64_t first_seq;
+} recorder_worker_arg_t;
+
+static int recorder_add_seq(smartlog_recorder_t* rec, uint64_t seq)
+{
+    char line[64];
+    int len = snprintf(line, sizeof(line), "[MESSAGE = rec %llu]\n", (unsigned long long)seq);
+    smartlog_record_t record;
+    memset(&record, 0, sizeof(record));
+    record.level = LOG_LEVEL_DEBUG;
+    record.seq = seq;
+    record.line = line;
+    record.line_len = (size_t)len;
+    return smartlog_recorder_add(rec, &record);
+}
+
+static void* recorder_worker(void* p)
+{
+    recorder_worker_arg_t* arg = (recorder_worker_arg_t*)p;
+    for(uint64_t seq = arg->first_seq; seq < 20; seq += 2)
+    {
+        if(recorder_add_seq(arg->rec, seq) != 0)
+        {
+            return (void*)1;
+        }
+    }
+    return NULL;
+}
+
+static void* recorder_one(void* p)
+{
+    recorder_worker_arg_t* arg = (recorder_worker_arg_t*)p;
+    return recorder_add_seq(arg->rec, arg->first_seq) != 0 ? (void*)1 : NULL;
+}
+
+typedef struct {
+    uint64_t last_seq;
+    size_t calls;
+    int bad;
+} recorder_check_t;
+
+static int recorder_check(const smartlog_record_t* record, void* p)
+{
+    recorder_check_t* check = (recorder_check_t*)p;
+    char want[32];
+    snprintf(want, sizeof(want), "rec %llu", (unsigned long long)record->seq);
+    if((check->calls != 0 && record->seq <= check->last_seq) || strcmp(record->msg, want) != 0)
+    {
+        check->bad = 1;
+    }
+    check->last_seq = record->seq;
+    check->calls++;
+    return 0;
+}
+
+static volatile sig_atomic_t prior_usr1_calls;
+
+static void prior_usr1_handler(int sig)
+{
+    (void)sig;
+    prior_usr1_calls++;
+}
+
+static int test_flight_recorder(const char* dir)
+{
+    char path[512];
+    snprintf(path, sizeof(path), "%s/recorder.log", dir);
+
+    /* Recorder alone: two threads interleave, the dump restores seq order */
+    smartlog_recorder_t* rec = smartlog_recorder_create(SMARTLOG_RECORDER_MIN_RING);
+    if(smartlog_recorder_create(16) != NULL || errno != EINVAL || rec == NULL)
+    {
+        perror("smartlog_recorder_create");
+        return 1;
+    }
+    recorder_worker_arg_t args[2] = { { rec, 0 }, { rec, 1 } };
+    pthread_t threads[2];
+    for(int i = 0; i < 2; i++)
+    {
+        if(pthread_create(&threads[i], NULL, recorder_worker, &args[i]) != 0)
+        {
+            perror("pthread_create");
+            return 1;
+        }
+    }
+    int failed = 0;
+    for(int i = 0; i < 2; i++)
+    {
+        void* ret = NULL;
+        pthread_join(threads[i], &ret);
+        failed |= ret != NULL;
+    }
+    recorder_check_t check = { 0, 0, 0 };
+    size_t count = 0;
+    smartlog_recorder_stats_t st;
+    if(failed || smartlog_recorder_dump(rec, recorder_check, &check, &count) != 0 ||
+       count != 20 || check.calls != 20 || check.bad)
+    {
+        fprintf(stderr, "recorder dump mismatch (%zu records, bad=%d)\n", count, check.bad);
+        return 1;
+    }
+    smartlog_recorder_get_stats(rec, &st);
+    if(st.recorded != 20 || st.dumped != 20 || st.dumps != 1 || st.rings == 0 || st.rings > 2 || st.overwritten != 0)
+    {
+        fprintf(stderr, "recorder stats mismatch\n");
+        return 1;
+    }
+
+    /* Full ring: the oldest records go, the newest stay */
+    for(uint64_t seq = 100; seq < 2100; seq++)
+    {
+        if(recorder_add_seq(rec, seq) != 0)
+        {
+            perror("smartlog_recorder_add");
+            return 1;
+        }
+    }
+    check.calls = 0;
+    smartlog_recorder_get_stats(rec, &st);
+    if(smartlog_recorder_dump(rec, recorder_check, &check, &count) != 0 || check.bad ||
+       count == 0 || count >= 2000 || check.last_seq != 2099 || st.overwritten != 2000 - count)
+    {
+        fprintf(stderr, "recorder overwrite mismatch (%zu kept)\n", count);
+        return 1;
+    }
+
+    /* Thread churn: exited threads hand their rings on (one more at most) */
+    smartlog_recorder_get_stats(rec, &st);
+    uint64_t rings_before = st.rings;
+    for(uint64_t seq = 0; seq < 8; seq++)
+    {
+        recorder_worker_arg_t one = { rec, seq };
+        pthread_t thread;
+        void* ret = NULL;
+        if(pthread_create(&thread, NULL, recorder_one, &one) != 0 ||
+           pthread_join(thread, &ret) != 0 || ret != NULL)
+        {
+            perror("recorder churn thread");
+            return 1;
+        }
+    }
+    check.calls = 0;
+    smartlog_recorder_get_stats(rec, &st);
+    if(st.rings > rings_before + 1 || smartlog_recorder_dump(rec, recorder_check, &check, &count) != 0 ||
+       check.bad || count != 8)
+    {
+        fprintf(stderr, "recorder churn mismatch (%llu rings, %zu records)\n",
+                (unsigned long long)st.rings, count);
+        return 1;
+    }
+
+    /* Every ring empty: the dump is a no-op that still counts */
+    check.calls = 0;
+    smartlog_recorder_get_stats(rec, &st);
+    uint64_t dumps_before = st.dumps;
+    count = 1;
+    if(smartlog_recorder_dump(rec, recorder_check, &check, &count) != 0 || count != 0 || check.calls != 0)
+    {
+        fprintf(stderr, "empty recorder dump returned %zu records\n", count);
+        return 1;
+    }
+    smartlog_recorder_get_stats(rec, &st);
+    if(st.dumps != dumps_before + 1)
+    {
+        fprintf(stderr, "empty recorder dump not counted\n");
+        return 1;
+    }
+    smartlog_recorder_destroy(rec);
+
+    /* More recorders than cache entries: each keeps one ring for this thread */
+    smartlog_recorder_t* recs[6];
+    for(int i = 0; i < 6; i++)
+    {
+        recs[i] = smartlog_recorder_create(SMARTLOG_RECORDER_MIN_RING);
+        if(recs[i] == NULL)
+        {
+            perror("smartlog_recorder_create");
+            return 1;
+        }
+    }
+    for(uint64_t seq = 0; seq < 30; seq++)
+    {
+        if(recorder_add_seq(recs[seq % 6], seq) != 0)
+        {
+            perror("smartlog_recorder_add");
+            return 1;
+        }
+    }
+    for(int i = 0; i < 6; i++)
+    {
+        smartlog_recorder_get_stats(recs[i], &st);
+        smartlog_recorder_destroy(recs[i]);
+        if(st.rings != 1 || st.recorded != 5)
+        {
+            fprintf(stderr, "recorder cache miss allocated %llu rings\n", (unsigned long long)st.rings);
+            return 1;
+        }
+    }
+
+    /* Logger: DEBUG stays in memory until an ERROR dumps it, in order */
+    smartlog_logger_t* lg = smartlog_logger_create();
+    smartlog_sink_t* sink = smartlog_sink_file_open(path, FEATURE_DISABLED, FEATURE_DISABLED, 0);
+    if(lg == NULL || sink == NULL || smartlog_logger_add_sink(lg, sink) != 0 ||
+       smartlog_logger_dump_recorder(lg) == 0 || errno != ENOTSUP ||
+       smartlog_logger_enable_recorder(lg, 64 * 1024, LOG_LEVEL_ERROR) != 0 ||
+       smartlog_logger_log(lg, LOG_LEVEL_DEBUG, "step one") != 0 ||
+       smartlog_logger_log(lg, LOG_LEVEL_WARN, "step two") != 0)
+    {
+        perror("recorder setup");
+        return 1;
+    }
+    char content[8192] = "";
+    if(file_exists(path) && (read_file(path, content, sizeof(content)) != 0 || content[0] != '\0'))
+    {
+        fprintf(stderr, "recorder wrote before the trigger:\n%s", content);
+        return 1;
+    }
+    if(smartlog_logger_log(lg, LOG_LEVEL_ERROR, "it broke") != 0 ||
+       read_file(path, content, sizeof(content)) != 0)
+    {
+        perror("recorder trigger");
+        return 1;
+    }
+    char* one = strstr(content, "MESSAGE = step one]");
+    char* two = strstr(content, "MESSAGE = step two]");
+    char* marker = strstr(content, "MESSAGE = recorder dump reason=level lines=2 lost=0]");
+    char* broke = strstr(content, "MESSAGE = it broke]");
+    if(one == NULL || two == NULL || marker == NULL || broke == NULL ||
+       !(one < two && two < marker && marker < broke))
+    {
+        fprintf(stderr, "recorder trigger dump mismatch:\n%s", content);
+        return 1;
+    }
+
+    /* Explicit dump */
+    if(smartlog_logger_log(lg, LOG_LEVEL_INFO, "step three") != 0 ||
+       smartlog_logger_dump_recorder(lg) != 0 ||
+       read_file(path, content, sizeof(content)) != 0 ||
+       strstr(content, "MESSAGE = step three]") == NULL ||
+       strstr(content, "MESSAGE = recorder dump reason=api lines=1 lost=0]") == NULL)
+    {
+        fprintf(stderr, "recorder api dump mismatch:\n%s", content);
+        return 1;
+    }
+
+    /* Signal: the handler wakes the dump thread */
+    struct sigaction prior;
+    memset(&prior, 0, sizeof(prior));
+    prior.sa_handler = prior_usr1_handler;
+    sigemptyset(&prior.sa_mask);
+    if(sigaction(SIGUSR1, &prior, NULL) != 0 ||
+       smartlog_logger_dump_recorder_on_signal(lg, SIGUSR1) != 0 ||
+       smartlog_logger_log(lg, LOG_LEVEL_DEBUG, "step four") != 0 ||
+       raise(SIGUSR1) != 0)
+    {
+        perror("recorder signal");
+        return 1;
+    }
+    int seen = 0;
+    for(int i = 0; i < 200 && !seen; i++)
+    {
+        struct timespec pause = { 0, 5000000 };
+        nanosleep(&pause, NULL);
+        seen = read_file(path, content, sizeof(content)) == 0 &&
+               strstr(content, "MESSAGE = recorder dump reason=signal lines=1 lost=0]") != NULL;
+    }
+    if(!seen || strstr(content, "MESSAGE = step four]") == NULL)
+    {
+        fprintf(stderr, "recorder signal dump missing:\n%s", content);
+        return 1;
+    }
+    smartlog_logger_destroy(lg);
+
+    /* Destroy hands the signal back to the handler that was there before */
+    struct sigaction now;
+    if(prior_usr1_calls != 0 || sigaction(SIGUSR1, NULL, &now) != 0 ||
+       now.sa_handler != prior_usr1_handler || raise(SIGUSR1) != 0 || prior_usr1_calls != 1)
+    {
+        fprintf(stderr, "recorder signal disposition not restored\n");
+        return 1;
+    }
+    signal(SIGUSR1, SIG_DFL);
+
+    /* Small ring: the marker counts what was overwritten */
+    snprintf(path, sizeof(path), "%s/recorder_lost.log", dir);
+    lg = smartlog_logger_create();
+    sink = smartlog_sink_file_open(path, FEATURE_DISABLED, FEATURE_DISABLED, 0);
+    if(lg == NULL || sink == NULL || smartlog_logger_add_sink(lg, sink) != 0 ||
+       smartlog_logger_enable_recorder(lg, SMARTLOG_RECORDER_MIN_RING, LOG_LEVEL_WARN) != 0)
+    {
+        perror("recorder small setup");
+        return 1;
+    }
+    for(int i = 0; i < 500; i++)
+    {
+        if(smartlog_logger_log(lg, LOG_LEVEL_INFO, "filler line for the small ring") != 0)
+        {
+            perror("recorder fill");
+            return 1;
+        }
+    }
+    if(smartlog_logger_log(lg, LOG_LEVEL_WARN, "trigger") != 0 ||
+       read_file(path, content, sizeof(content)) != 0 ||
+       strstr(content, "recorder dump reason=level") == NULL ||
+       strstr(content, " lost=0]") != NULL)
+    {
+        fprintf(stderr, "recorder lost count mismatch:\n%.300s", content);
+        return 1;
+    }
+    smartlog_logger_destroy(lg);
+
+    return 0;
+}
+
+static void metrics_test_source(smartlog_metrics_buf_t* out, void* arg)
+{
+    (void)smartlog_metrics_printf(out, "# TYPE test_children gauge\ntest_children %d\n", *(int*)arg);
+}
+
+/**
+ * Connect, optionally send a request, read the answer until EOF.
+ */
+static int metrics_fetch(const struct sockaddr* addr, socklen_t addr_len, const char* request,
+                         char* out, size_t out_sz)
+{
+    int fd = socket(addr->sa_family, SOCK_STREAM, 0);
+    if(fd < 0 || connect(fd, addr, addr_len) != 0)
+    {
+        return -1;
+    }
+    if(request != NULL && write(fd, request, strlen(request)) != (ssize_t)strlen(request))
+    {
+        close(fd);
+        return -1;
+    }
+
+    size_t len = 0;
+    ssize_t n;
+    while(len < out_sz - 1 && (n = read(fd, out + len, out_sz - 1 - len)) > 0)
+    {
+        len += (size_t)n;
+    }
+    out[len] = '\0';
+    close(fd);
+    return 0;
+}
+
+static int test_metrics_export(const char* dir)
+{
+    char path[512];
+    char sock_path[sizeof(((struct sockaddr_un*)0)->sun_path)];
+    snprintf(path, sizeof(path), "%s/metrics.log", dir);
+    snprintf(sock_path, sizeof(sock_path), "%s/metrics.sock", dir);
+
+    smartlog_logger_t* lg = smartlog_logger_create();
+    smartlog_sink_t* sink = smartlog_sink_file_open(path, FEATURE_ENABLED, FEATURE_DISABLED, 0);
+    if(lg == NULL || sink == NULL || smartlog_logger_add_sink(lg, sink) != 0 ||
+       smartlog_logger_log(lg, LOG_LEVEL_INFO, "metrics one") != 0 ||
+       smartlog_logger_log(lg, LOG_LEVEL_INFO, "metrics two") != 0)
+    {
+        perror("metrics logger");
+        return 1;
+    }
+
+    smartlog_sink_stats_t st;
+    smartlog_sink_get_stats(sink, &st);
+    uint64_t bucketed = 0;
+    for(size_t b = 0; b < SMARTLOG_SYNC_BUCKETS; b++)
+    {
+        bucketed += st.sync.buckets[b];
+    }
+    if(st.sync.count != 2 || st.sync.sum_ns == 0 || bucketed > st.sync.count)
+    {
+        fprintf(stderr, "sync stats mismatch: count=%llu\n", (unsigned long long)st.sync.count);
+        return 1;
+    }
+
+    int children = 3;
+    smartlog_metrics_t* m = smartlog_metrics_create();
+    char* text = NULL;
+    size_t len = 0;
+    if(m == NULL || smartlog_metrics_add_logger(m, "app\"1", lg) != 0 ||
+       smartlog_metrics_add_source(m, metrics_test_source, &children) != 0 ||
+       smartlog_metrics_render(m, &text, &len) != 0)
+    {
+        perror("metrics render");
+        return 1;
+    }
+    if(strlen(text) < len || len == 0 ||
+       strstr(text, "# TYPE smartlog_sink_records_total counter\n") == NULL ||
+       strstr(text, "smartlog_sink_records_total{logger=\"app\\\"1\",sink=\"0\"} 2\n") == NULL ||
+       strstr(text, "# TYPE smartlog_sink_sync_seconds histogram\n") == NULL ||
+       strstr(text, "smartlog_sink_sync_seconds_bucket{logger=\"app\\\"1\",sink=\"0\",le=\"+Inf\"} 2\n") == NULL ||
+       strstr(text, "smartlog_sink_sync_seconds_count{logger=\"app\\\"1\",sink=\"0\"} 2\n") == NULL ||
+       strstr(text, "test_children 3\n") == NULL)
+    {
+        fprintf(stderr, "metrics text mismatch:\n%.*s", (int)len, text);
+        return 1;
+    }
+    free(text);
+
+    /* Unix socket through the thread (HTTP), loopback TCP served inline (plain) */
+    struct sockaddr_un un;
+    memset(&un, 0, sizeof(un));
+    un.sun_family = AF_UNIX;
+    snprintf(un.sun_path, sizeof(un.sun_path), "%s", sock_path);
+    if(smartlog_metrics_listen_unix(m, sock_path) != 0 || smartlog_metrics_start(m) != 0)
+    {
+        perror("metrics unix");
+        return 1;
+    }
+    char answer[16384];
+    if(metrics_fetch((struct sockaddr*)&un, sizeof(un), "GET /metrics HTTP/1.1\r\nHost: x\r\n\r\n",
+                     answer, sizeof(answer)) != 0 ||
+       strncmp(answer, "HTTP/1.0 200 OK\r\n", 17) != 0 ||
+       strstr(answer, "version=0.0.4") == NULL ||
+       strstr(answer, "\r\n\r\n# HELP smartlog_sink_records_total") == NULL ||
+       strstr(answer, "test_children 3\n") == NULL)
+    {
+        fprintf(stderr, "metrics http answer mismatch:\n%s", answer);
+        return 1;
+    }
+    smartlog_metrics_destroy(m);
+    if(access(sock_path, F_OK) == 0)
+    {
+        fprintf(stderr, "metrics socket file left behind\n");
+        return 1;
+    }
+
+    m = smartlog_metrics_create();
+    if(m == NULL || smartlog_metrics_add_logger(m, "app", lg) != 0 ||
+       smartlog_metrics_listen_tcp(m, 0) != 0 || smartlog_metrics_tcp_port(m) == 0 ||
+       smartlog_metrics_start(m) != 0)
+    {
+        perror("metrics tcp");
+        return 1;
+    }
+    struct sockaddr_in in;
+    memset(&in, 0, sizeof(in));
+    in.sin_family = AF_INET;
+    in.sin_port = htons(smartlog_metrics_tcp_port(m));
+    in.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if(metrics_fetch((struct sockaddr*)&in, sizeof(in), NULL, answer, sizeof(answer)) != 0 ||
+       strncmp(answer, "# HELP smartlog_sink_records_total", 34) != 0 ||
+       strstr(answer, "smartlog_sink_bytes_total{logger=\"app\",sink=\"0\"}") == NULL)
+    {
+        fprintf(stderr, "metrics plain answer mismatch:\n%s", answer);
+        return 1;
+    }
+    smartlog_metrics_destroy(m);
+    smartlog_logger_destroy(lg);
+
+    return 0;
+}
+
 int main(void)
 {
     char tmp_template[] = "/tmp/smartlog_tests_XXXXXX";
@@ -201,8 +3525,39 @@ int main(void)
     if(test_basic_write(dir) != 0) return 1;
     if(test_rotation(dir) != 0) return 1;
     if(test_durable_write(dir) != 0) return 1;
+    if(test_fd_cache(dir) != 0) return 1;
+    if(test_file_sink_dir_relative(dir) != 0) return 1;
     if(test_empty_message_validation(dir) != 0) return 1;
     if(test_timestamp_failure(dir) != 0) return 1;
+    if(test_logger_fanout(dir) != 0) return 1;
+    if(test_async_drop_policy() != 0) return 1;
+    if(test_async_block_producers() != 0) return 1;
+    if(test_writer_affinity() != 0) return 1;
+    if(test_huge_page_regions() != 0) return 1;
+    if(test_async_spill_policy(dir) != 0) return 1;
+    if(test_crash_flush(dir) != 0) return 1;
+    if(test_unix_sink(dir) != 0) return 1;
+    if(test_collector_merge(dir) != 0) return 1;
+    if(test_record_sequence(dir) != 0) return 1;
+    if(test_merge_files(dir) != 0) return 1;
+    if(test_anchored_clock(dir) != 0) return 1;
+    if(test_logger_counters(dir) != 0) return 1;
+    if(test_metrics_export(dir) != 0) return 1;
+    if(test_flight_recorder(dir) != 0) return 1;
+    if(test_circfile(dir) != 0) return 1;
+    if(test_logging_context(dir) != 0) return 1;
+    if(test_archive_roundtrip(dir) != 0) return 1;
+    if(test_archive_dictionary(dir) != 0) return 1;
+    if(test_lz4_sink(dir) != 0) return 1;
+    if(test_tail_follow(dir) != 0) return 1;
+    if(test_parse_columns(dir) != 0) return 1;
+    if(test_colfile_roundtrip(dir) != 0) return 1;
+    if(test_shm_ring_cross_process(dir) != 0) return 1;
+    if(test_shm_ring_sealed(dir) != 0) return 1;
+    if(test_collector_pending_hello(dir) != 0) return 1;
+    if(test_collector_corrupt_ring(dir) != 0) return 1;
+    if(test_mpsc_single_thread() != 0) return 1;
+    if(test_mpsc_producers() != 0) return 1;
 
     return 0;
 }